@@ -0,0 +1,55 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/client/client_loop.cpp" "CMakeFiles/all_tests.dir/client/client_loop.cpp.o" "gcc" "CMakeFiles/all_tests.dir/client/client_loop.cpp.o.d"
+  "/root/repo/client/protocol.cpp" "CMakeFiles/all_tests.dir/client/protocol.cpp.o" "gcc" "CMakeFiles/all_tests.dir/client/protocol.cpp.o.d"
+  "/root/repo/client/transport.cpp" "CMakeFiles/all_tests.dir/client/transport.cpp.o" "gcc" "CMakeFiles/all_tests.dir/client/transport.cpp.o.d"
+  "/root/repo/client/util.cpp" "CMakeFiles/all_tests.dir/client/util.cpp.o" "gcc" "CMakeFiles/all_tests.dir/client/util.cpp.o.d"
+  "/root/repo/server/aof.cpp" "CMakeFiles/all_tests.dir/server/aof.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/aof.cpp.o.d"
+  "/root/repo/server/entry.cpp" "CMakeFiles/all_tests.dir/server/entry.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/entry.cpp.o.d"
+  "/root/repo/server/event_loop.cpp" "CMakeFiles/all_tests.dir/server/event_loop.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/event_loop.cpp.o.d"
+  "/root/repo/server/output_queue.cpp" "CMakeFiles/all_tests.dir/server/output_queue.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/output_queue.cpp.o.d"
+  "/root/repo/server/protocol.cpp" "CMakeFiles/all_tests.dir/server/protocol.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/protocol.cpp.o.d"
+  "/root/repo/server/replication.cpp" "CMakeFiles/all_tests.dir/server/replication.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/replication.cpp.o.d"
+  "/root/repo/server/ring_buffer.cpp" "CMakeFiles/all_tests.dir/server/ring_buffer.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/ring_buffer.cpp.o.d"
+  "/root/repo/server/score_btree.cpp" "CMakeFiles/all_tests.dir/server/score_btree.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/score_btree.cpp.o.d"
+  "/root/repo/server/server.cpp" "CMakeFiles/all_tests.dir/server/server.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/server.cpp.o.d"
+  "/root/repo/server/shard.cpp" "CMakeFiles/all_tests.dir/server/shard.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/shard.cpp.o.d"
+  "/root/repo/server/slab.cpp" "CMakeFiles/all_tests.dir/server/slab.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/slab.cpp.o.d"
+  "/root/repo/server/snapshot.cpp" "CMakeFiles/all_tests.dir/server/snapshot.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/snapshot.cpp.o.d"
+  "/root/repo/server/ttl_heap.cpp" "CMakeFiles/all_tests.dir/server/ttl_heap.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/ttl_heap.cpp.o.d"
+  "/root/repo/server/zset.cpp" "CMakeFiles/all_tests.dir/server/zset.cpp.o" "gcc" "CMakeFiles/all_tests.dir/server/zset.cpp.o.d"
+  "/root/repo/tests/alloc_test.cpp" "CMakeFiles/all_tests.dir/tests/alloc_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/alloc_test.cpp.o.d"
+  "/root/repo/tests/aof_test.cpp" "CMakeFiles/all_tests.dir/tests/aof_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/aof_test.cpp.o.d"
+  "/root/repo/tests/client_test.cpp" "CMakeFiles/all_tests.dir/tests/client_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/client_test.cpp.o.d"
+  "/root/repo/tests/connection_test.cpp" "CMakeFiles/all_tests.dir/tests/connection_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/connection_test.cpp.o.d"
+  "/root/repo/tests/entry_test.cpp" "CMakeFiles/all_tests.dir/tests/entry_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/entry_test.cpp.o.d"
+  "/root/repo/tests/event_loop_test.cpp" "CMakeFiles/all_tests.dir/tests/event_loop_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/event_loop_test.cpp.o.d"
+  "/root/repo/tests/hashtable_test.cpp" "CMakeFiles/all_tests.dir/tests/hashtable_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/hashtable_test.cpp.o.d"
+  "/root/repo/tests/output_queue_test.cpp" "CMakeFiles/all_tests.dir/tests/output_queue_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/output_queue_test.cpp.o.d"
+  "/root/repo/tests/replication_test.cpp" "CMakeFiles/all_tests.dir/tests/replication_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/replication_test.cpp.o.d"
+  "/root/repo/tests/ring_buffer_test.cpp" "CMakeFiles/all_tests.dir/tests/ring_buffer_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/ring_buffer_test.cpp.o.d"
+  "/root/repo/tests/score_btree_test.cpp" "CMakeFiles/all_tests.dir/tests/score_btree_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/score_btree_test.cpp.o.d"
+  "/root/repo/tests/server_test.cpp" "CMakeFiles/all_tests.dir/tests/server_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/server_test.cpp.o.d"
+  "/root/repo/tests/shard_test.cpp" "CMakeFiles/all_tests.dir/tests/shard_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/shard_test.cpp.o.d"
+  "/root/repo/tests/slab_test.cpp" "CMakeFiles/all_tests.dir/tests/slab_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/slab_test.cpp.o.d"
+  "/root/repo/tests/snapshot_test.cpp" "CMakeFiles/all_tests.dir/tests/snapshot_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/snapshot_test.cpp.o.d"
+  "/root/repo/tests/ttl_heap_test.cpp" "CMakeFiles/all_tests.dir/tests/ttl_heap_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/ttl_heap_test.cpp.o.d"
+  "/root/repo/tests/zset_test.cpp" "CMakeFiles/all_tests.dir/tests/zset_test.cpp.o" "gcc" "CMakeFiles/all_tests.dir/tests/zset_test.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/_deps/googletest-build/googletest/CMakeFiles/gtest.dir/DependInfo.cmake"
+  "/root/repo/_bench_build/_deps/googletest-build/googletest/CMakeFiles/gtest_main.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
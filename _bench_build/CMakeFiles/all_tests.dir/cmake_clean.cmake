@@ -0,0 +1,80 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/all_tests.dir/client/client_loop.cpp.o"
+  "CMakeFiles/all_tests.dir/client/client_loop.cpp.o.d"
+  "CMakeFiles/all_tests.dir/client/protocol.cpp.o"
+  "CMakeFiles/all_tests.dir/client/protocol.cpp.o.d"
+  "CMakeFiles/all_tests.dir/client/transport.cpp.o"
+  "CMakeFiles/all_tests.dir/client/transport.cpp.o.d"
+  "CMakeFiles/all_tests.dir/client/util.cpp.o"
+  "CMakeFiles/all_tests.dir/client/util.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/aof.cpp.o"
+  "CMakeFiles/all_tests.dir/server/aof.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/entry.cpp.o"
+  "CMakeFiles/all_tests.dir/server/entry.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/event_loop.cpp.o"
+  "CMakeFiles/all_tests.dir/server/event_loop.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/output_queue.cpp.o"
+  "CMakeFiles/all_tests.dir/server/output_queue.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/protocol.cpp.o"
+  "CMakeFiles/all_tests.dir/server/protocol.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/replication.cpp.o"
+  "CMakeFiles/all_tests.dir/server/replication.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/ring_buffer.cpp.o"
+  "CMakeFiles/all_tests.dir/server/ring_buffer.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/score_btree.cpp.o"
+  "CMakeFiles/all_tests.dir/server/score_btree.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/server.cpp.o"
+  "CMakeFiles/all_tests.dir/server/server.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/shard.cpp.o"
+  "CMakeFiles/all_tests.dir/server/shard.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/slab.cpp.o"
+  "CMakeFiles/all_tests.dir/server/slab.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/snapshot.cpp.o"
+  "CMakeFiles/all_tests.dir/server/snapshot.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/ttl_heap.cpp.o"
+  "CMakeFiles/all_tests.dir/server/ttl_heap.cpp.o.d"
+  "CMakeFiles/all_tests.dir/server/zset.cpp.o"
+  "CMakeFiles/all_tests.dir/server/zset.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/alloc_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/alloc_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/aof_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/aof_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/client_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/client_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/connection_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/connection_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/entry_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/entry_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/event_loop_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/event_loop_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/hashtable_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/hashtable_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/output_queue_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/output_queue_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/replication_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/replication_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/ring_buffer_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/ring_buffer_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/score_btree_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/score_btree_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/server_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/server_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/shard_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/shard_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/slab_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/slab_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/snapshot_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/snapshot_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/ttl_heap_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/ttl_heap_test.cpp.o.d"
+  "CMakeFiles/all_tests.dir/tests/zset_test.cpp.o"
+  "CMakeFiles/all_tests.dir/tests/zset_test.cpp.o.d"
+  "all_tests"
+  "all_tests.pdb"
+  "all_tests[1]_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/all_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/client.cpp" "CMakeFiles/cachedb_client.dir/client.cpp.o" "gcc" "CMakeFiles/cachedb_client.dir/client.cpp.o.d"
+  "/root/repo/client/client_loop.cpp" "CMakeFiles/cachedb_client.dir/client/client_loop.cpp.o" "gcc" "CMakeFiles/cachedb_client.dir/client/client_loop.cpp.o.d"
+  "/root/repo/client/protocol.cpp" "CMakeFiles/cachedb_client.dir/client/protocol.cpp.o" "gcc" "CMakeFiles/cachedb_client.dir/client/protocol.cpp.o.d"
+  "/root/repo/client/transport.cpp" "CMakeFiles/cachedb_client.dir/client/transport.cpp.o" "gcc" "CMakeFiles/cachedb_client.dir/client/transport.cpp.o.d"
+  "/root/repo/client/util.cpp" "CMakeFiles/cachedb_client.dir/client/util.cpp.o" "gcc" "CMakeFiles/cachedb_client.dir/client/util.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cachedb_client.dir/client.cpp.o"
+  "CMakeFiles/cachedb_client.dir/client.cpp.o.d"
+  "CMakeFiles/cachedb_client.dir/client/client_loop.cpp.o"
+  "CMakeFiles/cachedb_client.dir/client/client_loop.cpp.o.d"
+  "CMakeFiles/cachedb_client.dir/client/protocol.cpp.o"
+  "CMakeFiles/cachedb_client.dir/client/protocol.cpp.o.d"
+  "CMakeFiles/cachedb_client.dir/client/transport.cpp.o"
+  "CMakeFiles/cachedb_client.dir/client/transport.cpp.o.d"
+  "CMakeFiles/cachedb_client.dir/client/util.cpp.o"
+  "CMakeFiles/cachedb_client.dir/client/util.cpp.o.d"
+  "cachedb_client"
+  "cachedb_client.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cachedb_client.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,39 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cachedb_server.dir/cachedb.cpp.o"
+  "CMakeFiles/cachedb_server.dir/cachedb.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/aof.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/aof.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/entry.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/entry.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/event_loop.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/event_loop.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/output_queue.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/output_queue.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/protocol.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/protocol.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/replication.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/replication.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/ring_buffer.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/ring_buffer.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/score_btree.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/score_btree.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/server.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/server.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/shard.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/shard.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/slab.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/slab.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/snapshot.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/snapshot.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/ttl_heap.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/ttl_heap.cpp.o.d"
+  "CMakeFiles/cachedb_server.dir/server/zset.cpp.o"
+  "CMakeFiles/cachedb_server.dir/server/zset.cpp.o.d"
+  "cachedb_server"
+  "cachedb_server.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cachedb_server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,39 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/expire_bench.dir/bench/expire_bench.cpp.o"
+  "CMakeFiles/expire_bench.dir/bench/expire_bench.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/aof.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/aof.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/entry.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/entry.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/event_loop.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/event_loop.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/output_queue.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/output_queue.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/protocol.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/protocol.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/replication.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/replication.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/ring_buffer.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/ring_buffer.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/score_btree.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/score_btree.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/server.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/server.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/shard.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/shard.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/slab.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/slab.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/snapshot.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/snapshot.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/ttl_heap.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/ttl_heap.cpp.o.d"
+  "CMakeFiles/expire_bench.dir/server/zset.cpp.o"
+  "CMakeFiles/expire_bench.dir/server/zset.cpp.o.d"
+  "expire_bench"
+  "expire_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/expire_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,33 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/bench/hashtable_bench.cpp" "CMakeFiles/hashtable_bench.dir/bench/hashtable_bench.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/bench/hashtable_bench.cpp.o.d"
+  "/root/repo/server/aof.cpp" "CMakeFiles/hashtable_bench.dir/server/aof.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/aof.cpp.o.d"
+  "/root/repo/server/entry.cpp" "CMakeFiles/hashtable_bench.dir/server/entry.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/entry.cpp.o.d"
+  "/root/repo/server/event_loop.cpp" "CMakeFiles/hashtable_bench.dir/server/event_loop.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/event_loop.cpp.o.d"
+  "/root/repo/server/output_queue.cpp" "CMakeFiles/hashtable_bench.dir/server/output_queue.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/output_queue.cpp.o.d"
+  "/root/repo/server/protocol.cpp" "CMakeFiles/hashtable_bench.dir/server/protocol.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/protocol.cpp.o.d"
+  "/root/repo/server/replication.cpp" "CMakeFiles/hashtable_bench.dir/server/replication.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/replication.cpp.o.d"
+  "/root/repo/server/ring_buffer.cpp" "CMakeFiles/hashtable_bench.dir/server/ring_buffer.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/ring_buffer.cpp.o.d"
+  "/root/repo/server/score_btree.cpp" "CMakeFiles/hashtable_bench.dir/server/score_btree.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/score_btree.cpp.o.d"
+  "/root/repo/server/server.cpp" "CMakeFiles/hashtable_bench.dir/server/server.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/server.cpp.o.d"
+  "/root/repo/server/shard.cpp" "CMakeFiles/hashtable_bench.dir/server/shard.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/shard.cpp.o.d"
+  "/root/repo/server/slab.cpp" "CMakeFiles/hashtable_bench.dir/server/slab.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/slab.cpp.o.d"
+  "/root/repo/server/snapshot.cpp" "CMakeFiles/hashtable_bench.dir/server/snapshot.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/snapshot.cpp.o.d"
+  "/root/repo/server/ttl_heap.cpp" "CMakeFiles/hashtable_bench.dir/server/ttl_heap.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/ttl_heap.cpp.o.d"
+  "/root/repo/server/zset.cpp" "CMakeFiles/hashtable_bench.dir/server/zset.cpp.o" "gcc" "CMakeFiles/hashtable_bench.dir/server/zset.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
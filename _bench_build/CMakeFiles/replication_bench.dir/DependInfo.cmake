@@ -0,0 +1,33 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/bench/replication_bench.cpp" "CMakeFiles/replication_bench.dir/bench/replication_bench.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/bench/replication_bench.cpp.o.d"
+  "/root/repo/server/aof.cpp" "CMakeFiles/replication_bench.dir/server/aof.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/aof.cpp.o.d"
+  "/root/repo/server/entry.cpp" "CMakeFiles/replication_bench.dir/server/entry.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/entry.cpp.o.d"
+  "/root/repo/server/event_loop.cpp" "CMakeFiles/replication_bench.dir/server/event_loop.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/event_loop.cpp.o.d"
+  "/root/repo/server/output_queue.cpp" "CMakeFiles/replication_bench.dir/server/output_queue.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/output_queue.cpp.o.d"
+  "/root/repo/server/protocol.cpp" "CMakeFiles/replication_bench.dir/server/protocol.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/protocol.cpp.o.d"
+  "/root/repo/server/replication.cpp" "CMakeFiles/replication_bench.dir/server/replication.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/replication.cpp.o.d"
+  "/root/repo/server/ring_buffer.cpp" "CMakeFiles/replication_bench.dir/server/ring_buffer.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/ring_buffer.cpp.o.d"
+  "/root/repo/server/score_btree.cpp" "CMakeFiles/replication_bench.dir/server/score_btree.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/score_btree.cpp.o.d"
+  "/root/repo/server/server.cpp" "CMakeFiles/replication_bench.dir/server/server.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/server.cpp.o.d"
+  "/root/repo/server/shard.cpp" "CMakeFiles/replication_bench.dir/server/shard.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/shard.cpp.o.d"
+  "/root/repo/server/slab.cpp" "CMakeFiles/replication_bench.dir/server/slab.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/slab.cpp.o.d"
+  "/root/repo/server/snapshot.cpp" "CMakeFiles/replication_bench.dir/server/snapshot.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/snapshot.cpp.o.d"
+  "/root/repo/server/ttl_heap.cpp" "CMakeFiles/replication_bench.dir/server/ttl_heap.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/ttl_heap.cpp.o.d"
+  "/root/repo/server/zset.cpp" "CMakeFiles/replication_bench.dir/server/zset.cpp.o" "gcc" "CMakeFiles/replication_bench.dir/server/zset.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
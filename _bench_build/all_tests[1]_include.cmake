@@ -0,0 +1,5 @@
+if(EXISTS "/root/repo/_bench_build/all_tests[1]_tests.cmake")
+  include("/root/repo/_bench_build/all_tests[1]_tests.cmake")
+else()
+  add_test(all_tests_NOT_BUILT all_tests_NOT_BUILT)
+endif()
@@ -0,0 +1,135 @@
+add_test([=[Allocations.GetPerformsNoHeapAllocations]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Allocations.GetPerformsNoHeapAllocations]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Allocations.GetPerformsNoHeapAllocations]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Allocations.ZScorePerformsNoHeapAllocations]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Allocations.ZScorePerformsNoHeapAllocations]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Allocations.ZScorePerformsNoHeapAllocations]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Allocations.SetMaterializesOwnedCopies]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Allocations.SetMaterializesOwnedCopies]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Allocations.SetMaterializesOwnedCopies]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ProtocolSerialize.CorrectHeaderAndArgs]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ProtocolSerialize.CorrectHeaderAndArgs]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ProtocolSerialize.CorrectHeaderAndArgs]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ProtocolSerialize.ArgumentsMarshaledCorrectly]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ProtocolSerialize.ArgumentsMarshaledCorrectly]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ProtocolSerialize.ArgumentsMarshaledCorrectly]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ProtocolDeserialize.StringIntDoubleNilError]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ProtocolDeserialize.StringIntDoubleNilError]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ProtocolDeserialize.StringIntDoubleNilError]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ProtocolDeserialize.NestedArrays]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ProtocolDeserialize.NestedArrays]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ProtocolDeserialize.NestedArrays]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ProtocolDeserializeDeath.BadLengthDies]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ProtocolDeserializeDeath.BadLengthDies]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ProtocolDeserializeDeath.BadLengthDies]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ClientRepl.SingleCommandRoundTrip]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ClientRepl.SingleCommandRoundTrip]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ClientRepl.SingleCommandRoundTrip]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ClientRepl.MultipleCommandsAndEmptyLines]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ClientRepl.MultipleCommandsAndEmptyLines]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ClientRepl.MultipleCommandsAndEmptyLines]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ClientReplDeath.ResponseTooLarge]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ClientReplDeath.ResponseTooLarge]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ClientReplDeath.ResponseTooLarge]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Pipelining.AnswersEveryFrameInOrder]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Pipelining.AnswersEveryFrameInOrder]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Pipelining.AnswersEveryFrameInOrder]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Pipelining.OutputCapAppliesBackpressureWithoutLosingReplies]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Pipelining.OutputCapAppliesBackpressureWithoutLosingReplies]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Pipelining.OutputCapAppliesBackpressureWithoutLosingReplies]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Pipelining.PartialFrameWaitsForTheRest]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Pipelining.PartialFrameWaitsForTheRest]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Pipelining.PartialFrameWaitsForTheRest]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Pipelining.FramesThatWrapTheReadBufferParseCorrectly]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Pipelining.FramesThatWrapTheReadBufferParseCorrectly]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Pipelining.FramesThatWrapTheReadBufferParseCorrectly]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[HashTableInterface.MatchesReferenceUnderChurn<HashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*, std::hash<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> > > >>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=HashTableInterface/0.MatchesReferenceUnderChurn]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[HashTableInterface.MatchesReferenceUnderChurn<HashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*, std::hash<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> > > >>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[HashTableInterface.TombstonesDoNotBreakLookups<HashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*, std::hash<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> > > >>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=HashTableInterface/0.TombstonesDoNotBreakLookups]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[HashTableInterface.TombstonesDoNotBreakLookups<HashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*, std::hash<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> > > >>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[HashTableInterface.MatchesReferenceUnderChurn<FlatHashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*>>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=HashTableInterface/1.MatchesReferenceUnderChurn]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[HashTableInterface.MatchesReferenceUnderChurn<FlatHashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*>>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[HashTableInterface.TombstonesDoNotBreakLookups<FlatHashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*>>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=HashTableInterface/1.TombstonesDoNotBreakLookups]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[HashTableInterface.TombstonesDoNotBreakLookups<FlatHashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*>>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[HashTable.PutGetRemoveBasics]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=HashTable.PutGetRemoveBasics]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[HashTable.PutGetRemoveBasics]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[HashTable.StaysCorrectMidGrowMigration]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=HashTable.StaysCorrectMidGrowMigration]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[HashTable.StaysCorrectMidGrowMigration]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[HashTable.ShrinksIncrementallyAfterMassDelete]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=HashTable.ShrinksIncrementallyAfterMassDelete]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[HashTable.ShrinksIncrementallyAfterMassDelete]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[RingBuffer.AppendPeekConsumeAcrossWrap]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=RingBuffer.AppendPeekConsumeAcrossWrap]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[RingBuffer.AppendPeekConsumeAcrossWrap]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[RingBuffer.GrowsOnlyWhenDataDoesNotFit]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=RingBuffer.GrowsOnlyWhenDataDoesNotFit]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[RingBuffer.GrowsOnlyWhenDataDoesNotFit]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[RingBuffer.ReadvAndWritevUseBothRegions]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=RingBuffer.ReadvAndWritevUseBothRegions]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[RingBuffer.ReadvAndWritevUseBothRegions]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ScoreBTree.MatchesOrderedModelThroughGrowthAndShrink]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ScoreBTree.MatchesOrderedModelThroughGrowthAndShrink]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ScoreBTree.MatchesOrderedModelThroughGrowthAndShrink]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ScoreBTree.RangeFromMiddleCrossesLeaves]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ScoreBTree.RangeFromMiddleCrossesLeaves]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ScoreBTree.RangeFromMiddleCrossesLeaves]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ScoreBTree.EmptyTree]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ScoreBTree.EmptyTree]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ScoreBTree.EmptyTree]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.EmptyCommandErrors]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.EmptyCommandErrors]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.EmptyCommandErrors]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.UnknownCommandErrors]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.UnknownCommandErrors]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.UnknownCommandErrors]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.SetGetRoundTrip]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.SetGetRoundTrip]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.SetGetRoundTrip]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.GetMissingIsNil]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.GetMissingIsNil]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.GetMissingIsNil]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.DelAlwaysReturnsOne]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.DelAlwaysReturnsOne]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.DelAlwaysReturnsOne]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.KeysListsAllKeys]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.KeysListsAllKeys]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.KeysListsAllKeys]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.WrongTypeErrors]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.WrongTypeErrors]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.WrongTypeErrors]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ZAddZScoreZRem]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ZAddZScoreZRem]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ZAddZScoreZRem]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ZScoreMissingMemberIsNil]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ZScoreMissingMemberIsNil]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ZScoreMissingMemberIsNil]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ZQueryPagingAndOrdering]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ZQueryPagingAndOrdering]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ZQueryPagingAndOrdering]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ZRankZRevRankZCard]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ZRankZRevRankZCard]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ZRankZRevRankZCard]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ZRangeByRank]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ZRangeByRank]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ZRangeByRank]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.PExpirePTtl]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.PExpirePTtl]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.PExpirePTtl]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ExpiredKeysAreHiddenBeforeCollection]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ExpiredKeysAreHiddenBeforeCollection]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ExpiredKeysAreHiddenBeforeCollection]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ActiveExpireIsBounded]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ActiveExpireIsBounded]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ActiveExpireIsBounded]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ServerCommands.ArityErrors]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ServerCommands.ArityErrors]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerCommands.ArityErrors]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SpscQueue.DeliversEverythingInOrderAcrossThreads]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=SpscQueue.DeliversEverythingInOrderAcrossThreads]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SpscQueue.DeliversEverythingInOrderAcrossThreads]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ShardGroup.SpreadsKeysAcrossAllShards]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ShardGroup.SpreadsKeysAcrossAllShards]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ShardGroup.SpreadsKeysAcrossAllShards]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ShardGroup.KeysWrittenOnOneConnectionAreVisibleFromAll]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ShardGroup.KeysWrittenOnOneConnectionAreVisibleFromAll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ShardGroup.KeysWrittenOnOneConnectionAreVisibleFromAll]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ShardGroup.KeysFansOutAndGathersEveryShard]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ShardGroup.KeysFansOutAndGathersEveryShard]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ShardGroup.KeysFansOutAndGathersEveryShard]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TtlHeap.PopsInDeadlineOrderAfterUpdatesAndRemovals]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=TtlHeap.PopsInDeadlineOrderAfterUpdatesAndRemovals]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TtlHeap.PopsInDeadlineOrderAfterUpdatesAndRemovals]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TtlHeap.RemoveIsIdempotent]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=TtlHeap.RemoveIsIdempotent]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TtlHeap.RemoveIsIdempotent]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ZSetFlatEncoding.ConvertsPastMemberCount]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ZSetFlatEncoding.ConvertsPastMemberCount]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ZSetFlatEncoding.ConvertsPastMemberCount]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ZSetFlatEncoding.ConvertsOnLongMember]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=ZSetFlatEncoding.ConvertsOnLongMember]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ZSetFlatEncoding.ConvertsOnLongMember]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Backends/EventLoopBackend.ReportsReadableThenWritable/Poll  # GetParam() = 4-byte object <00-00 00-00>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Backends/EventLoopBackend.ReportsReadableThenWritable/Poll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Backends/EventLoopBackend.ReportsReadableThenWritable/Poll  # GetParam() = 4-byte object <00-00 00-00>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Backends/EventLoopBackend.ReportsReadableThenWritable/Epoll  # GetParam() = 4-byte object <01-00 00-00>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Backends/EventLoopBackend.ReportsReadableThenWritable/Epoll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Backends/EventLoopBackend.ReportsReadableThenWritable/Epoll  # GetParam() = 4-byte object <01-00 00-00>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Poll  # GetParam() = 4-byte object <00-00 00-00>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Poll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Poll  # GetParam() = 4-byte object <00-00 00-00>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Epoll  # GetParam() = 4-byte object <01-00 00-00>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Epoll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Epoll  # GetParam() = 4-byte object <01-00 00-00>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Backends/EventLoopBackend.ServerAnswersManyClients/Poll  # GetParam() = 4-byte object <00-00 00-00>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Backends/EventLoopBackend.ServerAnswersManyClients/Poll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Backends/EventLoopBackend.ServerAnswersManyClients/Poll  # GetParam() = 4-byte object <00-00 00-00>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Backends/EventLoopBackend.ServerAnswersManyClients/Epoll  # GetParam() = 4-byte object <01-00 00-00>]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Backends/EventLoopBackend.ServerAnswersManyClients/Epoll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Backends/EventLoopBackend.ServerAnswersManyClients/Epoll  # GetParam() = 4-byte object <01-00 00-00>]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Tree  # GetParam() = 0]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Tree]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Tree  # GetParam() = 0]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Converting  # GetParam() = 64]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Converting]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Converting  # GetParam() = 64]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Flat  # GetParam() = 100000]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Flat]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Flat  # GetParam() = 100000]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Tree  # GetParam() = 0]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Tree]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Tree  # GetParam() = 0]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Converting  # GetParam() = 64]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Converting]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Converting  # GetParam() = 64]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Flat  # GetParam() = 100000]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Flat]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Flat  # GetParam() = 100000]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Tree  # GetParam() = 0]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Tree]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Tree  # GetParam() = 0]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Converting  # GetParam() = 64]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Converting]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Converting  # GetParam() = 64]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Flat  # GetParam() = 100000]=]  /root/repo/_bench_build/all_tests [==[--gtest_filter=Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Flat]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Flat  # GetParam() = 100000]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_bench_build SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+set(  all_tests_TESTS Allocations.GetPerformsNoHeapAllocations Allocations.ZScorePerformsNoHeapAllocations Allocations.SetMaterializesOwnedCopies ProtocolSerialize.CorrectHeaderAndArgs ProtocolSerialize.ArgumentsMarshaledCorrectly ProtocolDeserialize.StringIntDoubleNilError ProtocolDeserialize.NestedArrays ProtocolDeserializeDeath.BadLengthDies ClientRepl.SingleCommandRoundTrip ClientRepl.MultipleCommandsAndEmptyLines ClientReplDeath.ResponseTooLarge Pipelining.AnswersEveryFrameInOrder Pipelining.OutputCapAppliesBackpressureWithoutLosingReplies Pipelining.PartialFrameWaitsForTheRest Pipelining.FramesThatWrapTheReadBufferParseCorrectly [==[HashTableInterface.MatchesReferenceUnderChurn<HashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*, std::hash<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> > > >>]==] [==[HashTableInterface.TombstonesDoNotBreakLookups<HashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*, std::hash<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> > > >>]==] [==[HashTableInterface.MatchesReferenceUnderChurn<FlatHashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*>>]==] [==[HashTableInterface.TombstonesDoNotBreakLookups<FlatHashTable<std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >, int*>>]==] HashTable.PutGetRemoveBasics HashTable.StaysCorrectMidGrowMigration HashTable.ShrinksIncrementallyAfterMassDelete RingBuffer.AppendPeekConsumeAcrossWrap RingBuffer.GrowsOnlyWhenDataDoesNotFit RingBuffer.ReadvAndWritevUseBothRegions ScoreBTree.MatchesOrderedModelThroughGrowthAndShrink ScoreBTree.RangeFromMiddleCrossesLeaves ScoreBTree.EmptyTree ServerCommands.EmptyCommandErrors ServerCommands.UnknownCommandErrors ServerCommands.SetGetRoundTrip ServerCommands.GetMissingIsNil ServerCommands.DelAlwaysReturnsOne ServerCommands.KeysListsAllKeys ServerCommands.WrongTypeErrors ServerCommands.ZAddZScoreZRem ServerCommands.ZScoreMissingMemberIsNil ServerCommands.ZQueryPagingAndOrdering ServerCommands.ZRankZRevRankZCard ServerCommands.ZRangeByRank ServerCommands.PExpirePTtl ServerCommands.ExpiredKeysAreHiddenBeforeCollection ServerCommands.ActiveExpireIsBounded ServerCommands.ArityErrors SpscQueue.DeliversEverythingInOrderAcrossThreads ShardGroup.SpreadsKeysAcrossAllShards ShardGroup.KeysWrittenOnOneConnectionAreVisibleFromAll ShardGroup.KeysFansOutAndGathersEveryShard TtlHeap.PopsInDeadlineOrderAfterUpdatesAndRemovals TtlHeap.RemoveIsIdempotent ZSetFlatEncoding.ConvertsPastMemberCount ZSetFlatEncoding.ConvertsOnLongMember [==[Backends/EventLoopBackend.ReportsReadableThenWritable/Poll  # GetParam() = 4-byte object <00-00 00-00>]==] [==[Backends/EventLoopBackend.ReportsReadableThenWritable/Epoll  # GetParam() = 4-byte object <01-00 00-00>]==] [==[Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Poll  # GetParam() = 4-byte object <00-00 00-00>]==] [==[Backends/EventLoopBackend.FlipBackToReadSeesDataThatArrivedMeanwhile/Epoll  # GetParam() = 4-byte object <01-00 00-00>]==] [==[Backends/EventLoopBackend.ServerAnswersManyClients/Poll  # GetParam() = 4-byte object <00-00 00-00>]==] [==[Backends/EventLoopBackend.ServerAnswersManyClients/Epoll  # GetParam() = 4-byte object <01-00 00-00>]==] [==[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Tree  # GetParam() = 0]==] [==[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Converting  # GetParam() = 64]==] [==[Thresholds/ZSetEncodings.RanksAndOffsetsMatchSortedModel/Flat  # GetParam() = 100000]==] [==[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Tree  # GetParam() = 0]==] [==[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Converting  # GetParam() = 64]==] [==[Thresholds/ZSetEncodings.ZQueryStartsBetweenMembers/Flat  # GetParam() = 100000]==] [==[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Tree  # GetParam() = 0]==] [==[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Converting  # GetParam() = 64]==] [==[Thresholds/ZSetEncodings.ZRangeFullAndEmpty/Flat  # GetParam() = 100000]==])
@@ -0,0 +1,75 @@
+// SET throughput with the append-only log off and under each fsync policy,
+// from many connections with one request in flight each, and how many
+// commands the group commit packs into every write() and fdatasync().
+//
+// usage: aof_bench [connections] [seconds] [path]
+
+#include "bench_util.h"
+
+// One INFO field, read from the raw reply.
+static std::string info_field(int fd, const std::string& name, std::vector<uint8_t>& scratch) {
+    std::vector<uint8_t> req;
+    append_request(req, {"info"});
+    bench_send(fd, req.data(), req.size());
+    uint32_t len = 0;
+    bench_recv(fd, (uint8_t*)&len, 4);
+    scratch.resize(len);
+    bench_recv(fd, scratch.data(), len);
+    std::string body(scratch.begin(), scratch.end());
+    size_t pos = body.find(name + ":");
+    while (pos != std::string::npos && pos > 0 && body[pos - 1] >= ' ') pos = body.find(name + ":", pos + 1);
+    if (pos == std::string::npos) return "0";
+    pos += name.size() + 1;
+    size_t end = pos;
+    while (end < body.size() && body[end] >= ' ') end++;
+    return body.substr(pos, end - pos);
+}
+
+static void run(const char* label, const ServerConfig& config, int conns, double secs) {
+    std::remove(config.aof_path.c_str());
+    BenchServer server(config);
+    std::vector<int> fds;
+    for (int i = 0; i < conns; ++i) fds.push_back(server.connect());
+    std::vector<uint8_t> scratch;
+
+    std::string value(100, 'v');
+    std::vector<std::vector<uint8_t>> reqs(conns);
+    long ops = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (seconds_since(start) < secs) {
+        for (int i = 0; i < conns; ++i) {
+            reqs[i].clear();
+            append_request(reqs[i], {"set", "key:" + std::to_string((ops + i) % 100000), value});
+            bench_send(fds[i], reqs[i].data(), reqs[i].size());
+        }
+        for (int fd : fds) bench_recv_responses(fd, 1, scratch);
+        ops += conns;
+    }
+    double elapsed = seconds_since(start);
+    double writes = std::stod(info_field(fds[0], "aof_writes", scratch));
+    double fsyncs = std::stod(info_field(fds[0], "aof_fsyncs", scratch));
+    printf("%-9s %9.0f SET/s", label, ops / elapsed);
+    if (writes) printf("  %6.1f cmds/write  %8.0f fsyncs  %6.1f cmds/fsync", ops / writes, fsyncs,
+                       fsyncs ? ops / fsyncs : 0.0);
+    printf("\n");
+    for (int fd : fds) ::close(fd);
+}
+
+int main(int argc, char** argv) {
+    int conns = argc >= 2 ? std::atoi(argv[1]) : 32;
+    double secs = argc >= 3 ? std::atof(argv[2]) : 3.0;
+    std::string path = argc >= 4 ? argv[3] : "/tmp/aof_bench.aof";
+    printf("%d connections, 100-byte values\n", conns);
+
+    ServerConfig config;
+    run("off", config, conns, secs);
+    config.aof_path = path;
+    config.appendfsync = AofFsync::NO;
+    run("no", config, conns, secs);
+    config.appendfsync = AofFsync::EVERYSEC;
+    run("everysec", config, conns, secs);
+    config.appendfsync = AofFsync::ALWAYS;
+    run("always", config, conns, secs);
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,174 @@
+#pragma once
+// Shared helpers for the socket-level benchmarks: an in-process server on an
+// ephemeral loopback port and minimal request framing.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "server/server.h"
+#include "server/shard.h"
+
+class BenchServer {
+public:
+    explicit BenchServer(const ServerConfig& config = ServerConfig()) : server_(config) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int val = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listen_fd_, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); exit(1); }
+        ::listen(listen_fd_, SOMAXCONN);
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd_, (sockaddr*)&addr, &len);
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this] { server_.run(listen_fd_); });
+    }
+
+    ~BenchServer() {
+        server_.stop();
+        thread_.join();
+        ::close(listen_fd_);
+    }
+
+    int connect() const {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("connect"); exit(1); }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+
+private:
+    Server server_;
+    int listen_fd_;
+    uint16_t port_;
+    std::thread thread_;
+};
+
+// N-shard ShardGroup on one loopback port with SO_REUSEPORT listeners.
+class BenchShardedServer {
+public:
+    BenchShardedServer(unsigned int shards, const ServerConfig& config = ServerConfig())
+        : group_(config, shards), port_(0) {
+        for (unsigned int i = 0; i < shards; ++i) {
+            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            int val = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(val));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port_);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); exit(1); }
+            ::listen(fd, SOMAXCONN);
+            socklen_t len = sizeof(addr);
+            ::getsockname(fd, (sockaddr*)&addr, &len);
+            port_ = ntohs(addr.sin_port);
+            listen_fds_.push_back(fd);
+        }
+        thread_ = std::thread([this] { group_.run(listen_fds_); });
+    }
+
+    ~BenchShardedServer() {
+        group_.stop();
+        thread_.join();
+        for (int fd : listen_fds_) ::close(fd);
+    }
+
+    int connect() const {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("connect"); exit(1); }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+
+private:
+    ShardGroup group_;
+    std::vector<int> listen_fds_;
+    uint16_t port_;
+    std::thread thread_;
+};
+
+inline void append_request(std::vector<uint8_t>& out, const std::vector<std::string>& cmd) {
+    uint32_t body = 4;
+    for (const std::string& a : cmd) body += 4 + static_cast<uint32_t>(a.size());
+    size_t off = out.size();
+    out.resize(off + 4 + body);
+    uint8_t* p = &out[off];
+    std::memcpy(p, &body, 4); p += 4;
+    uint32_t argc = static_cast<uint32_t>(cmd.size());
+    std::memcpy(p, &argc, 4); p += 4;
+    for (const std::string& a : cmd) {
+        uint32_t n = static_cast<uint32_t>(a.size());
+        std::memcpy(p, &n, 4); p += 4;
+        std::memcpy(p, a.data(), n); p += n;
+    }
+}
+
+inline void bench_send(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n <= 0) { perror("write"); exit(1); }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+inline void bench_recv(int fd, uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::read(fd, data, len);
+        if (n <= 0) { perror("read"); exit(1); }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+// Reads `count` framed responses, discarding their bodies.
+inline void bench_recv_responses(int fd, int count, std::vector<uint8_t>& scratch) {
+    for (int i = 0; i < count; ++i) {
+        uint32_t len = 0;
+        bench_recv(fd, (uint8_t*)&len, 4);
+        if (scratch.size() < len) scratch.resize(len);
+        bench_recv(fd, scratch.data(), len);
+    }
+}
+
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Benchmark keys: "key:" and i zero-padded to 12 digits, 16 bytes for any i
+// below 10^12. format_key() writes one into `buf`, which fits any long,
+// without allocating.
+inline constexpr size_t k_key_buf = 24;
+
+inline std::string_view format_key(char (&buf)[k_key_buf], long i) {
+    int n = snprintf(buf, sizeof(buf), "key:%012ld", i);
+    return std::string_view(buf, static_cast<size_t>(n));
+}
+
+inline std::string key_name(long i) {
+    char buf[k_key_buf];
+    return std::string(format_key(buf, i));
+}
@@ -0,0 +1,56 @@
+// Command dispatch cost: handle_command() called directly, without sockets,
+// for cheap commands that sit early, in the middle and late in the command
+// list, and for an unknown command. Each runs against a small keyspace, so
+// the time is mostly lookup, argument checks and the reply. Best of three
+// rounds.
+//
+// usage: dispatch_bench [iterations]
+
+#include "server/server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static double ns_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    long n = argc >= 2 ? std::atol(argv[1]) : 5000000;
+
+    Server server;
+    std::string out;
+    server.handle_command({"set", "k", "v"}, out);
+    server.handle_command({"zadd", "z", "1", "m"}, out);
+
+    const std::vector<std::vector<std::string_view>> cmds = {
+        {"get", "k"},
+        {"set", "k", "v"},
+        {"del", "missing"},
+        {"zscore", "z", "m"},
+        {"zcard", "z"},
+        {"pttl", "k"},
+        {"nosuchcommand", "k"},
+    };
+    std::vector<double> best(cmds.size(), 1e18);
+    for (int round = 0; round < 3; ++round) {
+        for (size_t c = 0; c < cmds.size(); ++c) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (long i = 0; i < n; ++i) {
+                out.clear();
+                server.handle_command(cmds[c], out);
+            }
+            best[c] = std::min(best[c], ns_since(t0) / n);
+        }
+    }
+    printf("iterations=%ld\n", n);
+    for (size_t c = 0; c < cmds.size(); ++c) {
+        printf("%-14s %6.1f ns/op\n", std::string(cmds[c][0]).c_str(), best[c]);
+    }
+    return 0;
+}
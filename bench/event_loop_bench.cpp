@@ -0,0 +1,67 @@
+// Per-wakeup cost of the event loop backends as idle connections scale.
+//
+// Registers N idle fds plus one active socketpair with the backend, then
+// repeatedly makes the active fd readable, waits, and drains it. Only the
+// active fd is ever ready, so any growth with N is pure backend overhead.
+//
+// usage: event_loop_bench [iterations]
+
+#include "server/event_loop.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+static double ns_per_wakeup(EventBackend backend, int idle, int iterations) {
+    std::unique_ptr<EventLoop> loop = EventLoop::create(backend);
+
+    // eventfds with a zero counter are never readable and cost one fd each,
+    // which lets us reach 10k idle registrations under a 20k fd limit.
+    std::vector<int> idle_fds;
+    idle_fds.reserve(idle);
+    for (int i = 0; i < idle; ++i) {
+        int fd = ::eventfd(0, EFD_NONBLOCK);
+        if (fd < 0) { perror("eventfd"); exit(1); }
+        loop->add(fd, Interest::READ);
+        idle_fds.push_back(fd);
+    }
+
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) < 0) { perror("socketpair"); exit(1); }
+    loop->add(sv[0], Interest::READ);
+
+    std::vector<IoEvent> events;
+    char byte = 'x';
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        if (::write(sv[1], &byte, 1) != 1) { perror("write"); exit(1); }
+        if (loop->wait(events, -1) != 1) { fprintf(stderr, "unexpected event count\n"); exit(1); }
+        if (::read(sv[0], &byte, 1) != 1) { perror("read"); exit(1); }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    for (int fd : idle_fds) {
+        loop->remove(fd);
+        ::close(fd);
+    }
+    ::close(sv[0]);
+    ::close(sv[1]);
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc >= 2 ? std::atoi(argv[1]) : 20000;
+
+    printf("%10s %14s %14s\n", "idle_fds", "poll ns/wake", "epoll ns/wake");
+    for (int idle : {10, 100, 1000, 10000}) {
+        double p = ns_per_wakeup(EventBackend::POLL, idle, iterations);
+        double e = ns_per_wakeup(EventBackend::EPOLL, idle, iterations);
+        printf("%10d %14.0f %14.0f\n", idle, p, e);
+    }
+    return 0;
+}
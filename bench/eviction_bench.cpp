@@ -0,0 +1,120 @@
+// Cache hit rate and throughput of each maxmemory policy under a Zipfian GET
+// workload whose key universe needs twice the configured memory. A miss is
+// followed by a SET of the key, as a read-through cache would do.
+//
+// volatile-ttl runs give every key a random TTL (far beyond the run) so the
+// policy has candidates; the others set no TTLs.
+//
+// usage: eviction_bench [keys] [ops]
+
+#include "server/server.h"
+#include "server/protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static const double k_zipf_s = 0.99;
+
+// Samples ranks 0..n-1 with P(k) proportional to 1 / (k+1)^s.
+class Zipf {
+public:
+    Zipf(size_t n, double s) : cdf_(n) {
+        double sum = 0;
+        for (size_t k = 0; k < n; ++k) {
+            sum += 1.0 / std::pow(double(k + 1), s);
+            cdf_[k] = sum;
+        }
+        for (double& c : cdf_) c /= sum;
+    }
+
+    template <typename Rng> size_t operator()(Rng& rng) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::min(cdf_.size() - 1, size_t(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin()));
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+static const std::string k_value(64, 'v');
+
+static void write_key(Server& server, const std::string& key, bool with_ttl, std::mt19937_64& rng, std::string& out) {
+    server.handle_command({"set", key, k_value}, out);
+    if (with_ttl) {
+        out.clear();
+        server.handle_command({"pexpire", key, std::to_string(3600000 + rng() % 3600000)}, out);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t keys = argc >= 2 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t ops = argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 5000000;
+
+    std::vector<std::string> names(keys);
+    for (size_t i = 0; i < keys; ++i) names[i] = "key:" + std::to_string(i);
+
+    // Size the ceiling from a server holding the whole universe.
+    size_t full;
+    {
+        Server server;
+        std::mt19937_64 rng(1);
+        std::string out;
+        for (const std::string& key : names) {
+            write_key(server, key, true, rng, out);
+            out.clear();
+        }
+        full = server.used_memory();
+    }
+    size_t maxmemory = full / 2;
+    printf("keys=%zu  ops=%zu  zipf s=%.2f  full=%.1fMB  maxmemory=%.1fMB\n", keys, ops, k_zipf_s,
+           full / 1048576.0, maxmemory / 1048576.0);
+
+    Zipf zipf(keys, k_zipf_s);
+    // The hottest ranks are spread over the keyspace rather than being the
+    // first keys loaded.
+    std::vector<size_t> rank_to_key(keys);
+    for (size_t i = 0; i < keys; ++i) rank_to_key[i] = i;
+    std::shuffle(rank_to_key.begin(), rank_to_key.end(), std::mt19937_64(7));
+
+    for (const char* name : {"allkeys-lru", "allkeys-lfu", "volatile-ttl", "noeviction"}) {
+        ServerConfig config;
+        config.maxmemory = maxmemory;
+        parse_eviction_policy(name, config.maxmemory_policy);
+        bool with_ttl = config.maxmemory_policy == EvictionPolicy::VOLATILE_TTL;
+        Server server(config);
+        std::mt19937_64 rng(42);
+        std::string out;
+
+        // Warm the cache with the same workload, then measure.
+        size_t hits = 0, misses = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int phase = 0; phase < 2; ++phase) {
+            if (phase == 1) {
+                hits = misses = 0;
+                t0 = std::chrono::steady_clock::now();
+            }
+            for (size_t i = 0; i < ops; ++i) {
+                const std::string& key = names[rank_to_key[zipf(rng)]];
+                out.clear();
+                server.handle_command({"get", key}, out);
+                if (out[0] == SER_NIL) {
+                    misses++;
+                    out.clear();
+                    write_key(server, key, with_ttl, rng, out);
+                } else {
+                    hits++;
+                }
+            }
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        printf("%-13s hit rate %5.1f%%  %8.0f ops/s  used=%.1fMB\n", name, 100.0 * hits / (hits + misses),
+               ops / secs, server.used_memory() / 1048576.0);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Request latency while a large batch of keys expires at the same moment.
+// The active expiry cycle is time-boxed per loop turn, so a probe client
+// should see the same latencies while the keys are collected as before the
+// deadline.
+//
+// usage: expire_bench [keys] [ttl_ms]
+
+#include "bench_util.h"
+
+#include <algorithm>
+
+int main(int argc, char** argv) {
+    int keys = argc >= 2 ? std::atoi(argv[1]) : 1000000;
+    // Long enough for the load to finish before anything expires.
+    int ttl_ms = argc >= 3 ? std::atoi(argv[2]) : 8000;
+
+    BenchServer server;
+    int fd = server.connect();
+    std::vector<uint8_t> scratch;
+    auto start = std::chrono::steady_clock::now();
+
+    // Load every key with the same TTL, pipelined in batches.
+    const int batch_keys = 1000;
+    for (int base = 0; base < keys; base += batch_keys) {
+        std::vector<uint8_t> batch;
+        int n = std::min(batch_keys, keys - base);
+        for (int i = base; i < base + n; ++i) {
+            std::string key = "key:" + std::to_string(i);
+            append_request(batch, {"set", key, "value"});
+            append_request(batch, {"pexpire", key, std::to_string(ttl_ms)});
+        }
+        bench_send(fd, batch.data(), batch.size());
+        bench_recv_responses(fd, 2 * n, scratch);
+    }
+    auto loaded = std::chrono::steady_clock::now();
+    // Deadlines relative to `loaded`: the first key loaded and the last.
+    double first_deadline = ttl_ms / 1000.0 - seconds_since(start);
+    double last_deadline = ttl_ms / 1000.0;
+    printf("keys=%d  ttl=%dms  load=%.2fs\n", keys, ttl_ms, seconds_since(start));
+
+    // Probe with single GETs of a key without a TTL from shortly before the
+    // first deadline until shortly after the last, recording each round trip.
+    std::vector<uint8_t> set_probe, get_probe;
+    append_request(set_probe, {"set", "probe", "v"});
+    append_request(get_probe, {"get", "probe"});
+    bench_send(fd, set_probe.data(), set_probe.size());
+    bench_recv_responses(fd, 1, scratch);
+
+    const double window = 1.0;
+    std::vector<double> before_us, during_us;
+    for (double t = 0; t < last_deadline + window; t = seconds_since(loaded)) {
+        if (t < first_deadline - window) continue;
+        auto t0 = std::chrono::steady_clock::now();
+        bench_send(fd, get_probe.data(), get_probe.size());
+        bench_recv_responses(fd, 1, scratch);
+        (t < first_deadline ? before_us : during_us).push_back(seconds_since(t0) * 1e6);
+    }
+
+    // Everything but the probe should be gone by now.
+    std::vector<uint8_t> keys_req;
+    append_request(keys_req, {"keys"});
+    bench_send(fd, keys_req.data(), keys_req.size());
+    uint32_t len = 0;
+    bench_recv(fd, (uint8_t*)&len, 4);
+    scratch.resize(len);
+    bench_recv(fd, scratch.data(), len);
+    uint32_t remaining = 0;
+    std::memcpy(&remaining, scratch.data() + 1, 4);
+
+    auto report = [](const char* name, std::vector<double>& lat_us) {
+        if (lat_us.empty()) return;
+        std::sort(lat_us.begin(), lat_us.end());
+        auto pct = [&](double p) { return lat_us[std::min(lat_us.size() - 1, (size_t)(p * lat_us.size()))]; };
+        printf("%-8s probes=%-8zu p50=%.0fus  p99=%.0fus  p99.9=%.0fus  max=%.2fms\n", name, lat_us.size(),
+               pct(0.50), pct(0.99), pct(0.999), lat_us.back() / 1000);
+    };
+    report("before", before_us);
+    report("expiry", during_us);
+    printf("keys left %.0fs after the last deadline: %u\n", window, remaining);
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Chained HashTable vs. open-addressing FlatHashTable: insert, hit and miss
+// lookup throughput with random access over tables of the given sizes.
+//
+// usage: flat_hashtable_bench [keys...]   (default: 1000000 10000000)
+
+#include "server/hashtable.h"
+#include "server/flat_hashtable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static double mops(size_t ops, std::chrono::steady_clock::time_point start) {
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ops / secs / 1e6;
+}
+
+template <typename Table>
+static void run(const char* name, const std::vector<std::string>& keys,
+                const std::vector<std::string>& hits, const std::vector<std::string>& misses) {
+    // Non-null dummy value so hits and misses are distinguishable; never deleted
+    // because the tables are leaked below.
+    static int dummy;
+    Table* table = new Table();
+
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& k : keys) table->put(k, &dummy);
+    double insert = mops(keys.size(), start);
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (const std::string& k : hits) found += table->get(k) != nullptr;
+    double hit = mops(hits.size(), start);
+
+    start = std::chrono::steady_clock::now();
+    for (const std::string& k : misses) found += table->get(k) != nullptr;
+    double miss = mops(misses.size(), start);
+
+    if (found != hits.size()) fprintf(stderr, "unexpected lookup results\n");
+    printf("%-10s %12zu %12.2f %12.2f %12.2f\n", name, keys.size(), insert, hit, miss);
+    // Skip teardown: the destructor would `delete` the shared dummy value.
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    if (sizes.empty()) sizes = {1000000, 10000000};
+
+    printf("%-10s %12s %12s %12s %12s\n", "engine", "keys", "insert M/s", "hit M/s", "miss M/s");
+    std::mt19937_64 rng(42);
+    for (size_t n : sizes) {
+        std::vector<std::string> keys, hits, misses;
+        keys.reserve(n);
+        for (size_t i = 0; i < n; ++i) keys.push_back("key:" + std::to_string(i));
+        size_t q = std::min<size_t>(n, 2000000);
+        for (size_t i = 0; i < q; ++i) {
+            hits.push_back(keys[rng() % n]);
+            misses.push_back("miss:" + std::to_string(rng() % n));
+        }
+        run<HashTable<std::string, int*>>("chained", keys, hits, misses);
+        run<FlatHashTable<std::string, int*>>("flat", keys, hits, misses);
+    }
+    return 0;
+}
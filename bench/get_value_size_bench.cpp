@@ -0,0 +1,41 @@
+// GET throughput over one loopback connection as the value size grows, with
+// a few requests pipelined so the reply path, not the round trip, dominates.
+//
+// usage: get_value_size_bench [total_bytes]
+
+#include "bench_util.h"
+
+int main(int argc, char** argv) {
+    double total_bytes = argc >= 2 ? std::atof(argv[1]) : 4e9;
+
+    BenchServer server;
+    int fd = server.connect();
+    std::vector<uint8_t> scratch;
+
+    printf("%10s %12s %12s\n", "value", "ops/sec", "MB/sec");
+    for (size_t size : {size_t(100), size_t(10) << 10, size_t(1) << 20}) {
+        std::string value(size, '\0');
+        for (size_t i = 0; i < size; ++i) value[i] = static_cast<char>('a' + i % 26);
+        std::vector<uint8_t> set;
+        append_request(set, {"set", "value", value});
+        bench_send(fd, set.data(), set.size());
+        bench_recv_responses(fd, 1, scratch);
+
+        const int depth = 8;
+        std::vector<uint8_t> batch;
+        for (int i = 0; i < depth; ++i) append_request(batch, {"get", "value"});
+
+        // At least 200k requests for small values, ~total_bytes for large ones.
+        int rounds = static_cast<int>(std::max(200000.0, total_bytes / size) / depth);
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            bench_send(fd, batch.data(), batch.size());
+            bench_recv_responses(fd, depth, scratch);
+        }
+        double secs = seconds_since(start);
+        double ops = double(rounds) * depth / secs;
+        printf("%10zu %12.0f %12.1f\n", size, ops, ops * size / 1e6);
+    }
+    ::close(fd);
+    return 0;
+}
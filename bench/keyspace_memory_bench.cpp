@@ -0,0 +1,66 @@
+// Resident memory and SET/GET/DEL throughput for a keyspace of many small
+// strings: 16-byte keys with short values, executed directly against a
+// Server (no sockets) so allocation costs are not hidden behind syscalls.
+//
+// usage: keyspace_memory_bench [keys]
+
+#include "bench_util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+static size_t rss_bytes() {
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+int main(int argc, char** argv) {
+    long keys = argc >= 2 ? std::atol(argv[1]) : 10000000;
+
+    Server server;
+    std::string out;
+    char key[k_key_buf];
+    auto key_at = [&](long i) { return format_key(key, i); };
+
+    size_t rss_empty = rss_bytes();
+    printf("keys=%ld  key=16B  value=8B\n", keys);
+
+    for (int round = 0; round < 2; ++round) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < keys; ++i) {
+            out.clear();
+            server.handle_command({"set", key_at(i), "value:00"}, out);
+        }
+        double set_secs = seconds_since(t0);
+        size_t rss_full = rss_bytes();
+
+        // Lookups in a scattered order, so each one misses the cache.
+        t0 = std::chrono::steady_clock::now();
+        for (long n = 0, i = 0; n < keys; ++n, i = (i + 7919) % keys) {
+            out.clear();
+            server.handle_command({"get", key_at(i)}, out);
+        }
+        double get_secs = seconds_since(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < keys; ++i) {
+            out.clear();
+            server.handle_command({"del", key_at(i)}, out);
+        }
+        double del_secs = seconds_since(t0);
+        size_t rss_after = rss_bytes();
+
+        printf("round %d: SET %5.2f  GET %5.2f  DEL %5.2f Mops/s  rss full %7.1f MB (%5.1f B/key)  "
+               "rss after DEL %7.1f MB\n",
+               round + 1, keys / set_secs / 1e6, keys / get_secs / 1e6, keys / del_secs / 1e6, (rss_full - rss_empty) / 1048576.0,
+               double(rss_full - rss_empty) / keys, (rss_after - rss_empty) / 1048576.0);
+    }
+    return 0;
+}
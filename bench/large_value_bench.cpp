@@ -0,0 +1,43 @@
+// SET and GET throughput for large values over one loopback connection, one
+// request in flight at a time.
+//
+// usage: large_value_bench [value_bytes] [requests]
+
+#include "bench_util.h"
+
+int main(int argc, char** argv) {
+    size_t value_bytes = argc >= 2 ? std::strtoull(argv[1], nullptr, 10) : 1 << 20;
+    int requests = argc >= 3 ? std::atoi(argv[2]) : 2000;
+
+    BenchServer server;
+    int fd = server.connect();
+    std::vector<uint8_t> scratch;
+
+    std::string value(value_bytes, '\0');
+    for (size_t i = 0; i < value_bytes; ++i) value[i] = static_cast<char>('a' + i % 26);
+    const int keys = 16;
+    std::vector<std::vector<uint8_t>> sets(keys), gets(keys);
+    for (int k = 0; k < keys; ++k) {
+        append_request(sets[k], {"set", "blob:" + std::to_string(k), value});
+        append_request(gets[k], {"get", "blob:" + std::to_string(k)});
+    }
+
+    printf("value=%zu bytes  requests=%d\n", value_bytes, requests);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; ++i) {
+        bench_send(fd, sets[i % keys].data(), sets[i % keys].size());
+        bench_recv_responses(fd, 1, scratch);
+    }
+    double secs = seconds_since(start);
+    printf("  SET %10.0f ops/s  %8.1f MB/s\n", requests / secs, requests * double(value_bytes) / secs / 1e6);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; ++i) {
+        bench_send(fd, gets[i % keys].data(), gets[i % keys].size());
+        bench_recv_responses(fd, 1, scratch);
+    }
+    secs = seconds_since(start);
+    printf("  GET %10.0f ops/s  %8.1f MB/s\n", requests / secs, requests * double(value_bytes) / secs / 1e6);
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,116 @@
+// 100-key MGET against 100 pipelined GETs over a keyspace much larger than the
+// last-level cache, so nearly every lookup misses. Runs once directly against a
+// Server (isolating lookup cost from syscalls) and once over a loopback socket.
+//
+// usage: mget_bench [keys] [batches]
+
+#include "bench_util.h"
+
+#include <random>
+
+static const int k_batch = 100;
+
+// Random key batches, shared by both variants so they touch the same keys.
+static std::vector<std::vector<std::string>> make_batches(long keys, int batches) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<long> pick(0, keys - 1);
+    std::vector<std::vector<std::string>> out(batches);
+    for (auto& batch : out)
+        for (int i = 0; i < k_batch; ++i) batch.push_back(key_name(pick(rng)));
+    return out;
+}
+
+static void report(const char* label, double secs, int batches) {
+    printf("  %-22s %8.2f Mkeys/s  %8.2f us/batch\n", label, batches * double(k_batch) / secs / 1e6,
+           secs / batches * 1e6);
+}
+
+static void run_direct(long keys, const std::vector<std::vector<std::string>>& batches) {
+    Server server;
+    std::string out;
+    for (long i = 0; i < keys; ++i) {
+        out.clear();
+        server.handle_command({"set", key_name(i), "value:00"}, out);
+    }
+
+    printf("direct:\n");
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& batch : batches) {
+        for (const std::string& key : batch) {
+            out.clear();
+            server.handle_command({"get", key}, out);
+        }
+    }
+    report("100 x GET", seconds_since(start), static_cast<int>(batches.size()));
+
+    std::vector<std::string_view> cmd;
+    start = std::chrono::steady_clock::now();
+    for (const auto& batch : batches) {
+        cmd.assign(1, "mget");
+        cmd.insert(cmd.end(), batch.begin(), batch.end());
+        out.clear();
+        server.handle_command(cmd, out);
+    }
+    report("MGET x 100", seconds_since(start), static_cast<int>(batches.size()));
+}
+
+static void run_socket(long keys, const std::vector<std::vector<std::string>>& batches) {
+    BenchServer server;
+    int fd = server.connect();
+    std::vector<uint8_t> scratch;
+
+    // Load with pipelined 50-pair MSETs.
+    const long pairs = 50;
+    const int depth = 32;
+    std::vector<uint8_t> frames;
+    int pending = 0;
+    for (long i = 0; i < keys; i += pairs) {
+        std::vector<std::string> cmd{"mset"};
+        for (long j = i; j < std::min(keys, i + pairs); ++j) {
+            cmd.push_back(key_name(j));
+            cmd.push_back("value:00");
+        }
+        append_request(frames, cmd);
+        if (++pending == depth) {
+            bench_send(fd, frames.data(), frames.size());
+            bench_recv_responses(fd, pending, scratch);
+            frames.clear();
+            pending = 0;
+        }
+    }
+    bench_send(fd, frames.data(), frames.size());
+    bench_recv_responses(fd, pending, scratch);
+
+    printf("socket:\n");
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& batch : batches) {
+        frames.clear();
+        for (const std::string& key : batch) append_request(frames, {"get", key});
+        bench_send(fd, frames.data(), frames.size());
+        bench_recv_responses(fd, k_batch, scratch);
+    }
+    report("100 pipelined GETs", seconds_since(start), static_cast<int>(batches.size()));
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& batch : batches) {
+        frames.clear();
+        std::vector<std::string> cmd{"mget"};
+        cmd.insert(cmd.end(), batch.begin(), batch.end());
+        append_request(frames, cmd);
+        bench_send(fd, frames.data(), frames.size());
+        bench_recv_responses(fd, 1, scratch);
+    }
+    report("MGET x 100", seconds_since(start), static_cast<int>(batches.size()));
+    ::close(fd);
+}
+
+int main(int argc, char** argv) {
+    long keys = argc >= 2 ? std::atol(argv[1]) : 10000000;
+    int batches = argc >= 3 ? std::atoi(argv[2]) : 20000;
+
+    printf("keys=%ld  key=16B  value=8B  batches=%d x %d keys\n", keys, batches, k_batch);
+    auto key_batches = make_batches(keys, batches);
+    run_direct(keys, key_batches);
+    run_socket(keys, key_batches);
+    return 0;
+}
@@ -0,0 +1,35 @@
+// Throughput of SET/GET over one loopback connection as the client pipeline
+// depth grows. Depth 1 is the classic request/response round trip.
+//
+// usage: pipeline_bench [total_requests]
+
+#include "bench_util.h"
+
+int main(int argc, char** argv) {
+    int total = argc >= 2 ? std::atoi(argv[1]) : 200000;
+
+    BenchServer server;
+    int fd = server.connect();
+    std::vector<uint8_t> scratch;
+
+    printf("%8s %14s\n", "depth", "ops/sec");
+    for (int depth : {1, 4, 16, 64, 256}) {
+        std::vector<uint8_t> batch;
+        for (int i = 0; i < depth; ++i) {
+            std::string key = "key:" + std::to_string(i);
+            if (i % 2) append_request(batch, {"get", key});
+            else append_request(batch, {"set", key, "value"});
+        }
+
+        int rounds = total / depth;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            bench_send(fd, batch.data(), batch.size());
+            bench_recv_responses(fd, depth, scratch);
+        }
+        double secs = seconds_since(start);
+        printf("%8d %14.0f\n", depth, rounds * depth / secs);
+    }
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,192 @@
+// Replication between two processes on loopback: the primary runs here, the
+// replica in a forked child. Times the full sync of a preloaded keyspace,
+// then keeps SETs coming from many connections and measures how far the
+// replica trails: how long a write takes to become readable on the replica
+// (a probe key, rewritten every 10 ms) and how many stream bytes it is behind
+// (INFO offsets, every 100 ms). Finally, how long it takes to catch up.
+//
+// usage: replication_bench [preload keys] [connections] [seconds]
+
+#include "bench_util.h"
+
+#include <algorithm>
+#include <csignal>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+static int open_listener(uint16_t& port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int val = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); exit(1); }
+    ::listen(fd, SOMAXCONN);
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, (sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static int connect_to(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("connect"); exit(1); }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Sends one request and returns the reply body.
+static std::string call(int fd, const std::vector<std::string>& cmd) {
+    std::vector<uint8_t> req;
+    append_request(req, cmd);
+    bench_send(fd, req.data(), req.size());
+    uint32_t len = 0;
+    bench_recv(fd, (uint8_t*)&len, 4);
+    std::string body(len, '\0');
+    bench_recv(fd, (uint8_t*)&body[0], len);
+    return body;
+}
+
+// One INFO field, read from the raw reply.
+static std::string info_field(int fd, const std::string& name) {
+    std::string body = call(fd, {"info"});
+    size_t pos = body.find(name + ":");
+    while (pos != std::string::npos && pos > 0 && body[pos - 1] >= ' ') pos = body.find(name + ":", pos + 1);
+    if (pos == std::string::npos) return "0";
+    pos += name.size() + 1;
+    size_t end = pos;
+    while (end < body.size() && body[end] >= ' ') end++;
+    return body.substr(pos, end - pos);
+}
+
+// Stream bytes the replica has yet to apply.
+static long long offset_lag(int primary, int replica) {
+    long long sent = std::stoll(info_field(primary, "repl_offset"));
+    long long applied = std::stoll(info_field(replica, "primary_repl_offset"));
+    return std::max(0LL, sent - applied);
+}
+
+static double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))];
+}
+
+int main(int argc, char** argv) {
+    long preload = argc >= 2 ? std::atol(argv[1]) : 1000000;
+    int conns = argc >= 3 ? std::atoi(argv[2]) : 32;
+    double secs = argc >= 4 ? std::atof(argv[3]) : 5.0;
+
+    uint16_t primary_port = 0, replica_port = 0;
+    int primary_fd = open_listener(primary_port);
+    int replica_fd = open_listener(replica_port);
+
+    // Fork before any thread exists; the child is the replica process.
+    pid_t child = ::fork();
+    if (child == 0) {
+        ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+        ::close(primary_fd);
+        ServerConfig config;
+        config.snapshot_path = "/tmp/replication_bench.replica.cdb";
+        Server replica(config);
+        replica.run(replica_fd);
+        ::_exit(0);
+    }
+    ::close(replica_fd);
+    ServerConfig config;
+    config.snapshot_path = "/tmp/replication_bench.primary.cdb";
+    Server primary(config);
+    std::thread loop([&] { primary.run(primary_fd); });
+
+    int p = connect_to(primary_port);
+    std::string value(100, 'v');
+    std::vector<uint8_t> req;
+    std::vector<uint8_t> scratch;
+    for (long base = 0; base < preload; base += 100) {
+        std::vector<std::string> mset{"mset"};
+        for (long i = base; i < std::min(preload, base + 100); ++i) {
+            mset.push_back("key:" + std::to_string(i));
+            mset.push_back(value);
+        }
+        req.clear();
+        append_request(req, mset);
+        bench_send(p, req.data(), req.size());
+        bench_recv_responses(p, 1, scratch);
+    }
+
+    int r = connect_to(replica_port);
+    auto start = std::chrono::steady_clock::now();
+    call(r, {"replicaof", "127.0.0.1", std::to_string(primary_port)});
+    while (info_field(r, "primary_link_status") != "up") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    printf("full sync: %ld keys, %.0f ms\n", preload, seconds_since(start) * 1e3);
+
+    std::vector<int> fds;
+    for (int i = 0; i < conns; ++i) fds.push_back(connect_to(primary_port));
+    std::vector<std::vector<uint8_t>> reqs(conns);
+    std::vector<double> probe_ms;
+    std::vector<double> lag_bytes;
+    long ops = 0, probe_seq = 0;
+    bool probe_out = false;
+    std::string probe_reply;
+    auto probe_sent = std::chrono::steady_clock::now();
+    auto last_sample = probe_sent;
+    start = std::chrono::steady_clock::now();
+    while (seconds_since(start) < secs) {
+        for (int i = 0; i < conns; ++i) {
+            reqs[i].clear();
+            append_request(reqs[i], {"set", "key:" + std::to_string((ops + i) % 100000), value});
+            bench_send(fds[i], reqs[i].data(), reqs[i].size());
+        }
+        for (int fd : fds) bench_recv_responses(fd, 1, scratch);
+        ops += conns;
+
+        if (!probe_out && seconds_since(probe_sent) >= 0.01) {
+            probe_sent = std::chrono::steady_clock::now();
+            std::string seq = std::to_string(++probe_seq);
+            call(p, {"set", "probe", seq});
+            probe_reply = call(p, {"get", "probe"});
+            probe_out = true;
+        }
+        if (probe_out && call(r, {"get", "probe"}) == probe_reply) {
+            probe_ms.push_back(seconds_since(probe_sent) * 1e3);
+            probe_out = false;
+        }
+        if (seconds_since(last_sample) >= 0.1) {
+            last_sample = std::chrono::steady_clock::now();
+            lag_bytes.push_back(static_cast<double>(offset_lag(p, r)));
+        }
+    }
+    double elapsed = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    while (offset_lag(p, r) > 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    double catch_up = seconds_since(start);
+
+    double lag_avg = 0;
+    for (double b : lag_bytes) lag_avg += b;
+    if (!lag_bytes.empty()) lag_avg /= lag_bytes.size();
+    printf("%d connections, 100-byte values: %.0f SET/s on the primary\n", conns, ops / elapsed);
+    printf("write visible on replica: p50 %.2f ms  p99 %.2f ms  max %.2f ms  (%zu probes)\n",
+           percentile(probe_ms, 0.5), percentile(probe_ms, 0.99), percentile(probe_ms, 1.0), probe_ms.size());
+    printf("stream behind: avg %.1f KB  max %.1f KB  (%zu samples)\n", lag_avg / 1e3,
+           percentile(lag_bytes, 1.0) / 1e3, lag_bytes.size());
+    printf("caught up %.2f ms after the load stopped\n", catch_up * 1e3);
+
+    for (int fd : fds) ::close(fd);
+    ::close(p);
+    ::close(r);
+    ::kill(child, SIGTERM);
+    ::waitpid(child, nullptr, 0);
+    primary.stop();
+    loop.join();
+    ::close(primary_fd);
+    return 0;
+}
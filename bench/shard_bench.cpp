@@ -0,0 +1,61 @@
+// GET/SET throughput of the shared-nothing multi-core mode as the shard count
+// grows. Each client thread drives its own connection with pipelined batches
+// of random keys, so most requests hop to another shard.
+//
+// usage: shard_bench [max_shards] [clients] [seconds]
+
+#include "bench_util.h"
+
+#include <atomic>
+#include <random>
+
+static double run(unsigned int shards, int clients, double seconds) {
+    BenchShardedServer server(shards);
+    std::atomic<bool> done{false};
+    std::vector<uint64_t> ops(clients, 0);
+    std::vector<std::thread> threads;
+
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            int fd = server.connect();
+            std::mt19937 rng(c);
+            std::vector<uint8_t> batch, scratch;
+            const int depth = 32;
+            while (!done.load(std::memory_order_relaxed)) {
+                batch.clear();
+                for (int i = 0; i < depth; ++i) {
+                    std::string key = "key:" + std::to_string(rng() % 100000);
+                    if (i % 2) append_request(batch, {"get", key});
+                    else append_request(batch, {"set", key, "value"});
+                }
+                bench_send(fd, batch.data(), batch.size());
+                bench_recv_responses(fd, depth, scratch);
+                ops[c] += depth;
+            }
+            ::close(fd);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    done = true;
+    for (std::thread& t : threads) t.join();
+    double secs = seconds_since(start);
+
+    uint64_t total = 0;
+    for (uint64_t n : ops) total += n;
+    return total / secs;
+}
+
+int main(int argc, char** argv) {
+    unsigned int max_shards = argc >= 2 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    int clients = argc >= 3 ? std::atoi(argv[2]) : 8;
+    double seconds = argc >= 4 ? std::atof(argv[3]) : 2.0;
+    if (max_shards == 0) max_shards = 1;
+
+    printf("%8s %14s\n", "shards", "ops/sec");
+    for (unsigned int n = 1; n <= max_shards; n *= 2) {
+        printf("%8u %14.0f\n", n, run(n, clients, seconds));
+    }
+    return 0;
+}
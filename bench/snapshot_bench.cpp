@@ -0,0 +1,126 @@
+// Snapshot cost on a populated keyspace: SAVE on the event loop, BGSAVE's fork
+// pause and the child's write rate, GET throughput and worst-case latency on
+// the parent while the child writes, and the time to load the file back.
+//
+// usage: snapshot_bench [keys] [path]
+
+#include "bench_util.h"
+
+#include <algorithm>
+
+// One INFO field, read from the raw reply.
+static std::string info_field(int fd, const std::string& name, std::vector<uint8_t>& scratch) {
+    std::vector<uint8_t> req;
+    append_request(req, {"info"});
+    bench_send(fd, req.data(), req.size());
+    uint32_t len = 0;
+    bench_recv(fd, (uint8_t*)&len, 4);
+    scratch.resize(len);
+    bench_recv(fd, scratch.data(), len);
+    std::string body(scratch.begin(), scratch.end());
+    size_t pos = body.find(name + ":");
+    while (pos != std::string::npos && pos > 0 && body[pos - 1] >= ' ') pos = body.find(name + ":", pos + 1);
+    if (pos == std::string::npos) return "";
+    pos += name.size() + 1;
+    size_t end = pos;
+    while (end < body.size() && body[end] >= ' ') end++;
+    return body.substr(pos, end - pos);
+}
+
+static void command(int fd, const std::vector<std::string>& cmd, std::vector<uint8_t>& scratch) {
+    std::vector<uint8_t> req;
+    append_request(req, cmd);
+    bench_send(fd, req.data(), req.size());
+    bench_recv_responses(fd, 1, scratch);
+}
+
+int main(int argc, char** argv) {
+    long keys = argc >= 2 ? std::atol(argv[1]) : 2000000;
+    ServerConfig config;
+    config.snapshot_path = argc >= 3 ? argv[2] : "/tmp/snapshot_bench.cdb";
+
+    BenchServer server(config);
+    int fd = server.connect();
+    std::vector<uint8_t> scratch;
+
+    // Strings of 16..200 bytes, every 100th key a 64-member sorted set.
+    const int batch = 1000;
+    std::string value(200, 'v');
+    for (long base = 0; base < keys; base += batch) {
+        std::vector<uint8_t> req;
+        int n = 0;
+        for (long i = base; i < std::min(keys, base + batch); ++i) {
+            if (i % 100 == 0) {
+                for (int m = 0; m < 64; ++m, ++n) {
+                    append_request(req, {"zadd", key_name(i), std::to_string(m * 1.5), "member:" + std::to_string(m)});
+                }
+            } else {
+                append_request(req, {"set", key_name(i), value.substr(0, 16 + i % 185)});
+                ++n;
+            }
+        }
+        bench_send(fd, req.data(), req.size());
+        bench_recv_responses(fd, n, scratch);
+    }
+    printf("keys: %ld, dataset: %.0f MB\n", keys, std::stod(info_field(fd, "used_memory_dataset", scratch)) / 1e6);
+
+    command(fd, {"save"}, scratch);
+    printf("SAVE:   %8.0f ms  %8.1f MB/s  %8.1f MB file\n",
+           std::stod(info_field(fd, "rdb_last_save_usec", scratch)) / 1e3,
+           std::stod(info_field(fd, "rdb_last_save_mb_per_sec", scratch)),
+           std::stod(info_field(fd, "rdb_last_save_bytes", scratch)) / 1e6);
+
+    // GET rate with nothing else going on, then while a BGSAVE child writes.
+    std::vector<uint8_t> get;
+    append_request(get, {"get", key_name(1)});
+    auto measure_gets = [&](double secs, double& max_us) {
+        long n = 0;
+        max_us = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (seconds_since(start) < secs) {
+            auto t = std::chrono::steady_clock::now();
+            bench_send(fd, get.data(), get.size());
+            bench_recv_responses(fd, 1, scratch);
+            max_us = std::max(max_us, seconds_since(t) * 1e6);
+            ++n;
+        }
+        return n / seconds_since(start);
+    };
+    double idle_max = 0;
+    double idle_rate = measure_gets(1.0, idle_max);
+
+    auto start = std::chrono::steady_clock::now();
+    command(fd, {"bgsave"}, scratch);
+    double bgsave_reply_ms = seconds_since(start) * 1e3;
+    long gets = 0;
+    double busy_max = 0;
+    double busy_secs = 0;
+    while (info_field(fd, "rdb_bgsave_in_progress", scratch) == "1") {
+        double max_us = 0;
+        double rate = measure_gets(0.1, max_us);
+        gets += static_cast<long>(rate * 0.1);
+        busy_secs += 0.1;
+        busy_max = std::max(busy_max, max_us);
+    }
+    printf("BGSAVE: fork %6.1f ms (reply after %.1f ms), child %8.0f ms  %8.1f MB/s\n",
+           std::stod(info_field(fd, "rdb_last_fork_usec", scratch)) / 1e3, bgsave_reply_ms,
+           std::stod(info_field(fd, "rdb_last_save_usec", scratch)) / 1e3,
+           std::stod(info_field(fd, "rdb_last_save_mb_per_sec", scratch)));
+    printf("GET:    idle %8.0f ops/s (max %6.0f us), during BGSAVE %8.0f ops/s (max %6.0f us)\n",
+           idle_rate, idle_max, busy_secs ? gets / busy_secs : 0.0, busy_max);
+    ::close(fd);
+
+    Server loaded(config);
+    SnapshotLoadStats stats;
+    std::string err;
+    start = std::chrono::steady_clock::now();
+    if (!loaded.load_snapshot(config.snapshot_path, stats, err)) {
+        fprintf(stderr, "load: %s\n", err.c_str());
+        return 1;
+    }
+    double secs = seconds_since(start);
+    printf("LOAD:   %8.0f ms  %8.1f MB/s  %8.2f Mkeys/s\n", secs * 1e3, stats.bytes / 1e6 / secs,
+           stats.keys / 1e6 / secs);
+    std::remove(config.snapshot_path.c_str());
+    return 0;
+}
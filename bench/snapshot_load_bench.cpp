@@ -0,0 +1,67 @@
+// Startup time from a snapshot: writes a synthetic snapshot of N keys
+// straight to disk (strings of 16..200 bytes, every 100th key a 64-member
+// sorted set, every 10th with a TTL), then times loading it into a Server
+// with one load thread per core, or `threads`.
+//
+// usage: snapshot_load_bench [keys] [threads] [path]
+
+#include "bench_util.h"
+
+#include <sys/stat.h>
+
+static bool write_dataset(const std::string& path, long keys) {
+    SnapshotHeader header;
+    header.saved_at = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.keys = static_cast<uint64_t>(keys);
+    std::string value(200, 'v');
+    std::vector<std::string> members;
+    for (int m = 0; m < 64; ++m) members.push_back("member:" + std::to_string(m));
+    std::string err;
+    uint64_t bytes = snapshot_save(path, header, [&](SnapshotWriter& w) {
+        for (long i = 0; i < keys; ++i) {
+            std::string key = key_name(i);
+            int64_t expire_at = i % 10 == 0 ? header.saved_at + 3600000 : k_snapshot_no_expiry;
+            if (i % 100 == 0) {
+                if (!w.begin_zset(key, members.size(), expire_at)) return false;
+                for (int m = 0; m < 64; ++m) {
+                    if (!w.add_member(members[m], m * 1.5)) return false;
+                }
+            } else if (!w.write_string(key, std::string_view(value).substr(0, 16 + i % 185), expire_at)) {
+                return false;
+            }
+        }
+        return true;
+    }, err);
+    if (!bytes) fprintf(stderr, "write: %s\n", err.c_str());
+    return bytes > 0;
+}
+
+int main(int argc, char** argv) {
+    long keys = argc >= 2 ? std::atol(argv[1]) : 10000000;
+    unsigned int threads = argc >= 3 ? static_cast<unsigned int>(std::atoi(argv[2])) : 0;
+    std::string path = argc >= 4 ? argv[3] : "/tmp/snapshot_load_bench.cdb";
+
+    auto start = std::chrono::steady_clock::now();
+    if (!write_dataset(path, keys)) return 1;
+    struct stat st;
+    ::stat(path.c_str(), &st);
+    printf("keys: %ld, file: %.0f MB, written in %.1f s\n", keys, st.st_size / 1e6, seconds_since(start));
+
+    ServerConfig config;
+    config.load_threads = threads ? threads : std::thread::hardware_concurrency();
+    printf("load threads: %u\n", config.load_threads);
+    Server server(config);
+    SnapshotLoadStats stats;
+    std::string err;
+    start = std::chrono::steady_clock::now();
+    if (!server.load_snapshot(path, stats, err)) {
+        fprintf(stderr, "load: %s\n", err.c_str());
+        return 1;
+    }
+    double secs = seconds_since(start);
+    printf("LOAD: %8.0f ms  %8.1f MB/s  %8.2f Mkeys/s  (%.0f MB dataset)\n", secs * 1e3,
+           stats.bytes / 1e6 / secs, stats.keys / 1e6 / secs, server.used_memory() / 1e6);
+    std::remove(path.c_str());
+    return 0;
+}
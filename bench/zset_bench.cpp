@@ -0,0 +1,40 @@
+// zquery latency at increasing offsets into one large sorted set. Skipping
+// entries one at a time makes deep pages cost O(offset); with subtree sizes
+// in the score tree every offset costs the same O(log n) seek.
+//
+// usage: zset_bench [members] [queries]
+
+#include "server/zset.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char** argv) {
+    long n = argc >= 2 ? std::atol(argv[1]) : 5000000;
+    int queries = argc >= 3 ? std::atoi(argv[2]) : 20;
+
+    ZSet z;
+    auto begin = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; ++i) {
+        // Scrambled scores so inserts do not arrive in tree order.
+        z.zadd("member:" + std::to_string(i), (double)((i * 2654435761L) % n));
+    }
+    double load = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("members=%ld  load=%.2fs\n", n, load);
+
+    printf("%10s %14s\n", "offset", "us/query");
+    for (long offset : {0L, 10000L, 1000000L}) {
+        if (offset >= n) continue;
+        size_t returned = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            returned += z.zquery(0.0, "", (int)offset, 10).size();
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        printf("%10ld %14.2f\n", offset, us / queries);
+        if (returned != (size_t)queries * 10) fprintf(stderr, "short result at offset %ld\n", offset);
+    }
+    return 0;
+}
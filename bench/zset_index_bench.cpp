@@ -0,0 +1,60 @@
+// Score index costs on one large TREE-encoded sorted set: insert, point
+// removal, and zquery range scans of 100 and 10k results from random start
+// scores.
+//
+// usage: zset_index_bench [members]
+
+#include "server/zset.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static double ns_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    long n = argc >= 2 ? std::atol(argv[1]) : 2000000;
+
+    std::mt19937_64 rng(42);
+    std::vector<std::string> members;
+    std::vector<double> scores;
+    members.reserve(n);
+    scores.reserve(n);
+    for (long i = 0; i < n; ++i) {
+        members.push_back("member:" + std::to_string(i));
+        scores.push_back((double)(rng() % (uint64_t)n));
+    }
+
+    ZSet z;
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; ++i) z.zadd(members[i], scores[i]);
+    printf("members=%ld\n", n);
+    printf("insert        %10.0f ns/op\n", ns_since(t0) / n);
+
+    for (int len : {100, 10000}) {
+        int queries = len == 100 ? 20000 : 500;
+        size_t returned = 0;
+        t0 = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            double start = (double)(rng() % (uint64_t)(n / 2));
+            returned += z.zquery(start, "", 0, len).size();
+        }
+        printf("range %-6d  %10.2f us/query\n", len, ns_since(t0) / queries / 1000);
+        if (returned != (size_t)queries * len) fprintf(stderr, "short range result\n");
+    }
+
+    long removes = std::min(n, 1000000L);
+    std::vector<long> order(n);
+    for (long i = 0; i < n; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < removes; ++i) z.zrem(members[order[i]]);
+    printf("remove        %10.0f ns/op\n", ns_since(t0) / removes);
+    return 0;
+}
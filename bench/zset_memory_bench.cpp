@@ -0,0 +1,49 @@
+// Heap bytes used by many small sorted sets in the FLAT and TREE encodings.
+//
+// usage: zset_memory_bench [sets] [members_per_set]
+
+#include "server/zset.h"
+
+#include <malloc.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static size_t heap_in_use() {
+    return mallinfo2().uordblks;
+}
+
+static void report(const char* name, size_t max_flat_members, long sets, int members) {
+    size_t before = heap_in_use();
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<ZSet*> zsets;
+    zsets.reserve(sets);
+    for (long s = 0; s < sets; ++s) {
+        ZSet* z = new ZSet(max_flat_members);
+        for (int m = 0; m < members; ++m) {
+            z->zadd("member:" + std::to_string(m), (double)((s + m * 7) % members));
+        }
+        zsets.push_back(z);
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    size_t used = heap_in_use() - before - sets * sizeof(ZSet*);
+    printf("%-6s %10.1f MB %12.1f B/member %8.2fs build\n", name, used / 1e6,
+           (double)used / ((double)sets * members), secs);
+
+    for (ZSet* z : zsets) delete z;
+}
+
+int main(int argc, char** argv) {
+    long sets = argc >= 2 ? std::atol(argv[1]) : 1000000;
+    int members = argc >= 3 ? std::atoi(argv[2]) : 16;
+
+    printf("sets=%ld  members/set=%d\n", sets, members);
+    report("flat", ZSet::k_max_flat_members, sets, members);
+    report("tree", 0, sets, members);
+    return 0;
+}
@@ -1,27 +1,188 @@
+#include <algorithm>
 #include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <string>
+#include <vector>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include "server/server.h"
+#include "server/shard.h"
 
-int main() {
+static int usage() {
+    std::cerr << "usage: cachedb_server [--port N] [--poll | --epoll] [--threads N]\n"
+                 "                      [--maxmemory BYTES[k|m|g]] [--maxmemory-policy POLICY]\n"
+                 "                      [--max-frame BYTES[k|m|g]] [--snapshot PATH] [--load-threads N]\n"
+                 "                      [--aof PATH] [--appendfsync always|everysec|no]\n"
+                 "                      [--replicaof HOST PORT] [--repl-backlog-size BYTES[k|m|g]]\n"
+                 "policies: noeviction, allkeys-lru, allkeys-lfu, volatile-ttl\n";
+    return 1;
+}
+
+// Parses a byte count with an optional k/m/g suffix. Returns false on garbage.
+static bool parse_bytes(const std::string& s, size_t& out) {
+    char* end = nullptr;
+    unsigned long long n = std::strtoull(s.c_str(), &end, 10);
+    if (end == s.c_str()) return false;
+    std::string suffix(end);
+    if (suffix == "k" || suffix == "K") n <<= 10;
+    else if (suffix == "m" || suffix == "M") n <<= 20;
+    else if (suffix == "g" || suffix == "G") n <<= 30;
+    else if (!suffix.empty()) return false;
+    out = static_cast<size_t>(n);
+    return true;
+}
+
+// Binds a listening socket on `port`. With `reuseport`, several sockets can
+// share the port and the kernel spreads incoming connections across them.
+static int open_listener(uint16_t port, bool reuseport) {
     int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (listen_fd < 0) { perror("socket"); return 1; }
+    if (listen_fd < 0) { perror("socket"); return -1; }
 
     int val = 1;
     ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+    if (reuseport) {
+        ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(val));
+    }
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(1234);
+    addr.sin_port = htons(port);
     addr.sin_addr.s_addr = htonl(0);
-    if (::bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); return 1; }
+    if (::bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); return -1; }
+
+    if (::listen(listen_fd, SOMAXCONN) < 0) { perror("listen"); return -1; }
+    return listen_fd;
+}
+
+// Reports a snapshot loaded at startup, or why it could not be.
+static bool report_load(bool ok, const SnapshotLoadStats& stats, const std::string& err,
+                        std::chrono::steady_clock::time_point start) {
+    if (!ok) {
+        std::cerr << "cannot load snapshot: " << err << "\n";
+        return false;
+    }
+    if (stats.files) {
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "loaded " << stats.keys << " keys (" << stats.expired << " expired, skipped) from "
+                  << stats.files << " snapshot file(s) in " << secs << " s (" << stats.bytes / 1e6 / secs << " MB/s)\n";
+    }
+    return true;
+}
+
+// Same for append-only logs.
+static bool report_aof_load(bool ok, const AofLoadStats& stats, const std::string& err,
+                            std::chrono::steady_clock::time_point start) {
+    if (!ok) {
+        std::cerr << "cannot load append-only log: " << err << "\n";
+        return false;
+    }
+    if (stats.truncated) {
+        std::cerr << "dropped " << stats.truncated << " bytes of a command cut short at the end of the log\n";
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "replayed " << stats.commands << " commands from " << stats.files << " log file(s) in "
+              << secs << " s (" << stats.bytes / 1e6 / secs << " MB/s)\n";
+    return true;
+}
+
+// Loads the keyspace at startup and opens the append-only log, if enabled.
+// The logs take precedence over the snapshot. When they were written for
+// another shard count, or there were none yet, fresh ones are written from
+// what was loaded and the old files removed.
+template <typename Target>
+static bool load_and_open(Target& target, const ServerConfig& config, unsigned int shards) {
+    auto start = std::chrono::steady_clock::now();
+    std::string err;
+    std::vector<std::string> found;
+    if (!config.aof_path.empty()) found = aof_files(config.aof_path);
+    if (found.empty()) {
+        SnapshotLoadStats loaded;
+        bool ok = target.load_snapshot(config.snapshot_path, loaded, err);
+        if (!report_load(ok, loaded, err, start)) return false;
+    } else {
+        AofLoadStats loaded;
+        bool ok = target.load_aof(found, loaded, err);
+        if (!report_aof_load(ok, loaded, err, start)) return false;
+    }
+    if (config.aof_path.empty()) return true;
+
+    std::vector<std::string> layout;
+    for (unsigned int i = 0; i < shards; ++i) {
+        layout.push_back(snapshot_shard_path(config.aof_path, shards == 1 ? -1 : static_cast<int>(i)));
+    }
+    bool rewrite = found != layout;
+    if (!target.start_aof(rewrite, err)) {
+        std::cerr << "cannot open append-only log: " << err << "\n";
+        return false;
+    }
+    for (const std::string& file : found) {
+        if (std::find(layout.begin(), layout.end(), file) == layout.end()) std::remove(file.c_str());
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ServerConfig config;
+    unsigned int threads = 1;
+    uint16_t port = 1234;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        else if (arg == "--poll") config.backend = EventBackend::POLL;
+        else if (arg == "--epoll") config.backend = EventBackend::EPOLL;
+        else if (arg == "--threads" && i + 1 < argc) threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--maxmemory" && i + 1 < argc) {
+            if (!parse_bytes(argv[++i], config.maxmemory)) return usage();
+        } else if (arg == "--maxmemory-policy" && i + 1 < argc) {
+            if (!parse_eviction_policy(argv[++i], config.maxmemory_policy)) return usage();
+        } else if (arg == "--max-frame" && i + 1 < argc) {
+            // Frame lengths are 32-bit on the wire.
+            if (!parse_bytes(argv[++i], config.max_frame) || config.max_frame > UINT32_MAX) return usage();
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            config.snapshot_path = argv[++i];
+        } else if (arg == "--load-threads" && i + 1 < argc) {
+            config.load_threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (arg == "--aof" && i + 1 < argc) {
+            config.aof_path = argv[++i];
+        } else if (arg == "--appendfsync" && i + 1 < argc) {
+            if (!parse_aof_fsync(argv[++i], config.appendfsync)) return usage();
+        } else if (arg == "--replicaof" && i + 2 < argc) {
+            config.replicaof_host = argv[++i];
+            config.replicaof_port = static_cast<uint16_t>(std::atoi(argv[++i]));
+            if (config.replicaof_port == 0) return usage();
+        } else if (arg == "--repl-backlog-size" && i + 1 < argc) {
+            if (!parse_bytes(argv[++i], config.repl_backlog_size) || config.repl_backlog_size == 0) return usage();
+        }
+        else return usage();
+    }
+    if (threads == 0 || port == 0) return usage();
+    if (config.replicaof_port && threads > 1) {
+        std::cerr << "replication is not supported with more than one thread\n";
+        return 1;
+    }
 
-    if (::listen(listen_fd, SOMAXCONN) < 0) { perror("listen"); return 1; }
+    if (threads == 1) {
+        int listen_fd = open_listener(port, false);
+        if (listen_fd < 0) return 1;
+        Server server(config);
+        if (!load_and_open(server, config, threads)) return 1;
+        server.run(listen_fd);
+        return 0;
+    }
 
-    Server server;
-    server.run(listen_fd);
+    std::vector<int> listen_fds;
+    for (unsigned int i = 0; i < threads; ++i) {
+        int fd = open_listener(port, true);
+        if (fd < 0) return 1;
+        listen_fds.push_back(fd);
+    }
+    ShardGroup group(config, threads);
+    if (!load_and_open(group, config, threads)) return 1;
+    group.run(listen_fds);
     return 0;
 }
@@ -1,18 +1,53 @@
 #include "client/client_loop.h"
 #include "client/transport.h"
+#include <cstdlib>
 #include <iostream>
+#include <string>
+
+static int usage() {
+    std::cerr << "usage: cachedb_client [host [port]] [--max-response BYTES[k|m|g]]\n";
+    return 1;
+}
+
+// Parses a byte count with an optional k/m/g suffix. Returns false on garbage.
+static bool parse_bytes(const std::string& s, size_t& out) {
+    char* end = nullptr;
+    unsigned long long n = std::strtoull(s.c_str(), &end, 10);
+    if (end == s.c_str()) return false;
+    std::string suffix(end);
+    if (suffix == "k" || suffix == "K") n <<= 10;
+    else if (suffix == "m" || suffix == "M") n <<= 20;
+    else if (suffix == "g" || suffix == "G") n <<= 30;
+    else if (!suffix.empty()) return false;
+    out = static_cast<size_t>(n);
+    return true;
+}
 
 int main(int argc, char** argv) {
-    const char* host = "127.0.0.1";
+    std::string host = "127.0.0.1";
     uint16_t port = 1234;
+    size_t max_response = k_default_max_response;
 
     // (Optional) allow overrides: client 127.0.0.1 1234
-    if (argc >= 2) host = argv[1];
-    if (argc >= 3) port = static_cast<uint16_t>(std::stoi(argv[2]));
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-response" && i + 1 < argc) {
+            if (!parse_bytes(argv[++i], max_response)) return usage();
+        } else if (positional == 0) {
+            host = arg;
+            positional++;
+        } else if (positional == 1) {
+            port = static_cast<uint16_t>(std::stoi(arg));
+            positional++;
+        } else {
+            return usage();
+        }
+    }
 
     TcpTransport transport;
     transport.connect(host, port);
 
     // Use std::cin/std::cout/std::cerr in production; in tests you'll pass string streams.
-    return run_client_repl(transport, std::cin, std::cout, std::cerr);
+    return run_client_repl(transport, std::cin, std::cout, std::cerr, max_response);
 }
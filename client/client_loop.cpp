@@ -11,7 +11,8 @@
 int run_client_repl(ITransport& transport,
                     std::istream& in,
                     std::ostream& out,
-                    std::ostream& err) {
+                    std::ostream& err,
+                    size_t max_response) {
 
     std::string line;
     while (true) {
@@ -36,7 +37,7 @@ int run_client_repl(ITransport& transport,
         transport.recv_all(header, 4);
         uint32_t resp_len = 0;
         std::memcpy(&resp_len, header, 4);
-        if (resp_len > 10 * 1024 * 1024) die("Response too large");
+        if (resp_len > max_response) die("Response too large");
 
         // body
         std::vector<uint8_t> body(resp_len);
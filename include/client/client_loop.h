@@ -1,10 +1,16 @@
 #pragma once
 #include "transport.h"
+#include <cstddef>
 #include <iosfwd>
 
+// Largest response the REPL accepts unless told otherwise.
+constexpr size_t k_default_max_response = 10 * 1024 * 1024;
+
 // A function that runs the interactive loop (REPL).
 // It depends on a transport and streams that can be swapped in tests.
+// A response longer than `max_response` bytes is fatal.
 int run_client_repl(ITransport& transport,
                     std::istream& in,
                     std::ostream& out,
-                    std::ostream& err);
+                    std::ostream& err,
+                    size_t max_response = k_default_max_response);
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Append-only log of the commands that changed a Server's keyspace, in the
+// request framing clients send, so replaying it is parse_request() and
+// handle_command():
+//
+//   ([len u32][argc u32]([len u32][bytes]) * argc) * commands
+//
+// Commands are logged after they ran. Deletes the server makes on its own
+// (expired and evicted keys) are logged as DEL, and PEXPIRE as PEXPIREAT with
+// a Unix-millisecond deadline, so a replay sees the keyspace change in the
+// same order and never re-runs a TTL from the start.
+//
+// A ShardGroup keeps one log per shard, `<path>.<shard>`, like snapshots.
+enum class AofFsync {
+    ALWAYS,    // a reply to a write waits until the write is on disk
+    EVERYSEC,  // sync at most once a second; a crash loses about a second
+    NO,        // leave it to the kernel
+};
+
+// Parses the Redis-style policy name ("always", "everysec", "no").
+bool parse_aof_fsync(std::string_view name, AofFsync& out);
+
+// The group commit: the event loop appends to a buffer, and end_turn() hands
+// everything one loop turn logged to a writer thread, which issues one write()
+// for it and, per the policy, one fdatasync(). The loop never waits for the
+// disk; under ALWAYS it holds replies instead, until durable_turn() reaches
+// the turn that logged their commands.
+class Aof {
+public:
+    // Takes over `fd`, opened for appending, which already holds `size`
+    // bytes. `on_durable` is called from the writer thread whenever
+    // durable_turn() advances under ALWAYS.
+    Aof(int fd, uint64_t size, AofFsync policy, std::function<void()> on_durable);
+    // Writes and syncs whatever is queued, then stops the writer.
+    ~Aof();
+
+    void append(const std::vector<std::string_view>& cmd);
+    // The turn being logged; 0 is never used, so it is always past a fresh
+    // durable_turn().
+    uint64_t turn() const { return turn_; }
+    bool turn_dirty() const { return !turn_buf_.empty(); }
+    // Queues the turn's commands for the writer and starts the next turn.
+    void end_turn();
+    // The last turn whose commands are written, and synced under ALWAYS.
+    uint64_t durable_turn() const { return durable_turn_.load(std::memory_order_acquire); }
+
+    // Compaction. While a child process writes a fresh log into `tmp`, every
+    // command appended is also kept aside. finish_rewrite() then has the writer
+    // finish the current log, append what was kept aside to `fd` (open on
+    // `tmp`), sync it and rename it over `path`; the log continues there.
+    void begin_rewrite();
+    void finish_rewrite(int fd, const std::string& tmp, const std::string& path);
+    void abort_rewrite();
+    // From begin_rewrite() until the new log has replaced the old one.
+    bool rewriting() const { return rewriting_.load(std::memory_order_acquire); }
+
+    struct Stats {
+        uint64_t size;    // bytes in the current log file
+        uint64_t writes;  // write() batches
+        uint64_t fsyncs;
+        bool last_write_ok;
+        bool last_rewrite_ok;
+    };
+    Stats stats() const;
+
+private:
+    // A finished rewrite, for the writer to switch to.
+    struct Switch {
+        int fd;
+        std::string tail;  // commands logged while the child was writing
+        std::string tmp;
+        std::string path;
+    };
+
+    void hand_off(std::unique_ptr<Switch> sw);
+    void writer_main();
+    bool write_out(int fd, std::string& data);
+    bool sync(int fd);
+    bool apply_switch(Switch& sw);
+
+    // Event loop only.
+    std::string turn_buf_;
+    std::string rewrite_buf_;
+    bool rewrite_open_ = false;
+    uint64_t turn_ = 1;
+
+    // Shared with the writer, under mu_.
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::string queued_;
+    uint64_t queued_turn_ = 0;
+    std::unique_ptr<Switch> switch_;
+    size_t switch_at_ = 0;  // bytes of queued_ that go to the old log, before switch_
+    bool stopping_ = false;
+
+    // Writer only.
+    int fd_;
+    AofFsync policy_;
+    std::function<void()> on_durable_;
+    std::string unwritten_;  // taken from queued_, kept across a failed write
+    bool unsynced_ = false;
+    std::chrono::steady_clock::time_point last_sync_;
+
+    std::atomic<uint64_t> durable_turn_{0};
+    std::atomic<bool> rewriting_{false};
+    std::atomic<uint64_t> size_;
+    std::atomic<uint64_t> writes_{0};
+    std::atomic<uint64_t> fsyncs_{0};
+    std::atomic<bool> last_write_ok_{true};
+    std::atomic<bool> last_rewrite_ok_{true};
+    std::thread writer_;
+};
+
+// Writes a log file from scratch (a rewrite) through a large buffer.
+class AofFileWriter {
+public:
+    explicit AofFileWriter(int fd) : fd_(fd) {}
+
+    bool add(const std::vector<std::string_view>& cmd);
+    // Flushes and fdatasyncs.
+    bool finish();
+    uint64_t bytes_written() const { return written_ + buf_.size(); }
+
+private:
+    bool flush();
+
+    static const size_t k_flush_at = size_t(1) << 20;
+
+    int fd_;
+    std::string buf_;
+    uint64_t written_ = 0;
+    bool failed_ = false;
+};
+
+// Writes `path` from scratch with the commands write_cmds() adds, synced
+// before it returns. Sets `bytes` to the file size, or `err` on failure.
+bool aof_write_file(const std::string& path, const std::function<bool(AofFileWriter&)>& write_cmds,
+                    uint64_t& bytes, std::string& err);
+
+// The logs under `path` that exist: a single server's `path`, then a group's
+// `path.0`, `path.1`, ... up to the first one missing.
+std::vector<std::string> aof_files(const std::string& path);
+
+struct AofLoadStats {
+    uint64_t commands = 0;
+    uint64_t bytes = 0;
+    unsigned int files = 0;
+    uint64_t truncated = 0;  // bytes of torn trailing frames dropped
+};
+
+// Replays the log at `path` through `apply`. A frame cut short at the end of
+// the file, as a crash mid-write leaves it, is dropped and the file truncated
+// to the last whole command; any other malformed frame is an error.
+bool aof_replay(const std::string& path, const std::function<void(const std::vector<std::string_view>&)>& apply,
+                AofLoadStats& stats, std::string& err);
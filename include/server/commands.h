@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "server/protocol.h"
+
+class Server;
+struct Connection;
+
+// What dispatch needs to know about a command besides how to run it.
+enum CommandFlags : uint32_t {
+    CMD_WRITE = 1u << 0,       // may change the keyspace: logged, replicated, refused on a replica
+    CMD_DENYOOM = 1u << 1,     // may grow the dataset: evicts first under maxmemory, or is refused
+    CMD_ALL_SHARDS = 1u << 2,  // spans the keyspace: runs on every shard, replies merged
+    CMD_CURSOR = 1u << 3,      // SCAN: the cursor names the shard to run on
+};
+
+// One entry of the command table (Server::k_commands, in server.cpp). Every
+// request is looked up there by name and checked against its entry before
+// its handler runs, so a check or a counter that applies to all commands
+// belongs in that one place: Server::run_command().
+struct CommandSpec {
+    using Handler = void (Server::*)(const std::vector<std::string_view>& cmd, ReplyOut out);
+    // A command that acts on the client's connection itself, like PSYNC. It
+    // runs only as a client's request, never from a log or another shard.
+    using LinkHandler = void (Server::*)(Connection* conn, const std::vector<std::string_view>& cmd);
+
+    std::string_view name;
+    // Arguments, the name included: exactly `arity`, or at least -arity when
+    // negative. Handlers check any finer shape themselves.
+    int arity;
+    uint32_t flags;
+    // Key arguments: first_key, then every key_step-th one up to last_key,
+    // -1 standing for the last argument. first_key is 0 for commands without
+    // keys. With --threads, a request whose keys live on several shards runs
+    // on each as the arguments before first_key, then its own keys, each
+    // with the key_step - 1 arguments after it.
+    int first_key;
+    int last_key;
+    int key_step;
+    Handler handler;
+    LinkHandler link_handler;
+
+    constexpr bool arity_ok(size_t argc) const {
+        return arity >= 0 ? argc == static_cast<size_t>(arity) : argc >= static_cast<size_t>(-arity);
+    }
+    // The index of the last key argument in a request of `argc` arguments.
+    constexpr size_t last_key_index(size_t argc) const {
+        return last_key < 0 ? argc - 1 : static_cast<size_t>(last_key);
+    }
+};
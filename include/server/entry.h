@@ -1,21 +1,108 @@
 #pragma once
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
 #include "zset.h"
+#include "server/value_buffer.h"
 
+// One keyspace record in a single allocation: a fixed header followed by the
+// key bytes and, for strings of up to k_max_inline_value bytes, the value.
+//
+//   [header: 32 bytes][key][inline value]
+//
+// The hash table keys its nodes on a view of the embedded key, so every key
+// is stored once. A string value has one of three encodings: INT for values
+// that are the canonical decimal form of an int64 (kept as 8 bytes in the
+// header), INLINE for other short strings, HEAP for a separate, reference-
+// counted ValueBuffer that replies can send from directly. A
+// sorted set hangs off zset_value().
+//
+// Entries are variable-sized. Create them with make_string()/make_zset() and
+// free them with a plain `delete`: a destroying operator delete sizes the slab
+// allocation from the header.
 class Entry {
 public:
     enum Type { STRING, ZSET };
-    std::string key;
-    Type type;
-    std::string str_value;   // For STRING type
-    ZSet* zset_value;        // For ZSET type
-
-    Entry(const std::string& k, const std::string& val)
-        : key(k), type(STRING), str_value(val), zset_value(nullptr) {}
-
-    ~Entry() {
-        if (type == ZSET && zset_value) {
-            delete zset_value;
-        }
-    }
+    enum Encoding { INLINE, HEAP, INT };
+
+    static constexpr size_t k_max_inline_value = 64;
+    static constexpr size_t k_max_key_len = (size_t(1) << 29) - 1;
+    // Scratch space str_value() needs to format an INT value.
+    static constexpr size_t k_max_int_chars = 20;
+
+    // Expiry deadline in monotonic milliseconds, or k_no_expiry. While set,
+    // the entry sits in its server's TtlHeap at heap_idx.
+    static constexpr int64_t k_no_expiry = -1;
+    static constexpr uint32_t k_no_heap_idx = UINT32_MAX;
+
+    // `owned`, if given, is a buffer holding a copy of `value` whose reference
+    // is handed over: a HEAP value keeps it instead of copying, anything else
+    // drops it.
+    static Entry* make_string(std::string_view key, std::string_view value, ValueBuffer* owned = nullptr);
+    static Entry* make_int(std::string_view key, int64_t value);
+    static Entry* make_zset(std::string_view key);
+
+    // Parses `s` only if it is exactly how `out` would be printed: optional
+    // '-', no leading zeros, no '+' or spaces, no overflow. Values that pass
+    // are stored INT-encoded, and GET returns the same bytes.
+    static bool parse_int(std::string_view s, int64_t& out);
+    static void operator delete(Entry* entry, std::destroying_delete_t);
+
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+
+    Type type() const { return static_cast<Type>(type_); }
+    Encoding encoding() const { return static_cast<Encoding>(encoding_); }
+    std::string_view key() const { return {data(), key_len_}; }
+    ZSet* zset_value() const { return type_ == ZSET ? zset_ : nullptr; }
+
+    // The string value; INT values are formatted into `scratch`, which must
+    // hold k_max_int_chars bytes.
+    std::string_view str_value(char* scratch) const;
+    // The buffer behind a HEAP value (str_value() views its first bytes).
+    ValueBuffer* heap_buffer() const { return encoding_ == HEAP && type_ == STRING ? heap_value_ : nullptr; }
+    bool is_int() const { return type_ == STRING && encoding_ == INT; }
+    int64_t int_value() const { return int_; }
+    void set_int(int64_t value) { int_ = value; }  // INT-encoded entries only
+
+    // Overwrites the string value in place. Returns false, leaving the entry
+    // (and `owned`) untouched, when the new value needs a differently sized
+    // record; the caller then replaces the entry with a new one. `owned` is
+    // as for make_string().
+    bool assign_value(std::string_view value, ValueBuffer* owned = nullptr);
+
+    // Bytes of this record's allocation, and of the separate value buffer
+    // (0 when inline). Neither includes a sorted set.
+    size_t record_bytes() const;
+    size_t value_heap_bytes() const;
+
+    int64_t expire_at;
+    uint32_t heap_idx;
+
+    // Access bits for eviction, read according to the maxmemory policy.
+    // LRU: low 32 bits of the last access time in ms. LFU: minutes clock of
+    // the last decay in the top 24 bits, logarithmic access counter in the
+    // low 8.
+    uint32_t access;
+
+private:
+    Entry(std::string_view key, Type type);
+    ~Entry();
+
+    static size_t record_size(size_t key_len, size_t inline_len);
+    static Encoding encoding_for(std::string_view value, int64_t& as_int);
+    size_t inline_len() const { return type_ == STRING && encoding_ == INLINE ? value_len_ : 0; }
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+
+    uint32_t key_len_ : 29;
+    uint32_t type_ : 1;
+    uint32_t encoding_ : 2;  // STRING only
+    uint32_t value_len_;     // INLINE and HEAP
+    union {
+        ValueBuffer* heap_value_;  // HEAP
+        int64_t int_;       // INT
+        ZSet* zset_;        // ZSET
+    };
 };
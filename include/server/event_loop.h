@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <poll.h>
+#include <sys/epoll.h>
+
+enum class EventBackend {
+    POLL,
+    EPOLL
+};
+
+// What a registered fd is waiting for. Connections flip between the two as
+// their ConnectionState flips between STATE_REQ and STATE_RES.
+enum class Interest {
+    READ,
+    WRITE
+};
+
+struct IoEvent {
+    int fd;
+    bool readable;
+    bool writable;
+    bool error;
+};
+
+// Readiness notification backend used by Server::run. Interest is registered
+// once per fd and only changed through modify(), so a wakeup costs O(ready fds)
+// with epoll instead of O(total fds).
+class EventLoop {
+public:
+    virtual ~EventLoop() = default;
+
+    virtual void add(int fd, Interest interest) = 0;
+    virtual void modify(int fd, Interest interest) = 0;
+    virtual void remove(int fd) = 0;
+
+    // Blocks for at most timeout_ms (-1 = forever) and fills `events` with the
+    // ready fds. Returns the number of events, or -1 on error (errno is set).
+    virtual int wait(std::vector<IoEvent>& events, int timeout_ms) = 0;
+
+    static std::unique_ptr<EventLoop> create(EventBackend backend);
+};
+
+// Level-triggered poll(2) fallback. Keeps one persistent pollfd array instead of
+// rebuilding it every iteration; removal swaps the last slot into the hole.
+class PollLoop : public EventLoop {
+public:
+    void add(int fd, Interest interest) override;
+    void modify(int fd, Interest interest) override;
+    void remove(int fd) override;
+    int wait(std::vector<IoEvent>& events, int timeout_ms) override;
+
+private:
+    std::vector<pollfd> pollfds_;
+    std::vector<int> fd2slot_;  // -1 when fd is not registered
+};
+
+// Edge-triggered epoll(7) backend. Handlers must drain reads/writes until EAGAIN.
+class EpollLoop : public EventLoop {
+public:
+    EpollLoop();
+    ~EpollLoop() override;
+
+    void add(int fd, Interest interest) override;
+    void modify(int fd, Interest interest) override;
+    void remove(int fd) override;
+    int wait(std::vector<IoEvent>& events, int timeout_ms) override;
+
+private:
+    int epfd_;
+    std::vector<epoll_event> ready_;
+};
@@ -0,0 +1,415 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "server/hashtable.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Open-addressing hash table in the Swiss-table style, with the same interface
+// as HashTable, heterogeneous lookup through `Hash` included.
+//
+// Slots live in one flat array next to a parallel array of control bytes. A
+// control byte is either EMPTY, DELETED (a tombstone) or the low 7 bits of the
+// key's hash (H2). Lookups probe one aligned group of 16 control bytes at a
+// time: a single SSE2 compare against H2 yields a bitmask of candidate slots,
+// so most probes touch one cache line of metadata and at most one slot key.
+// Growing rehashes the whole table at once, unlike HashTable's incremental
+// migration, so rehash_step() has nothing to do and the table never shrinks.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class FlatHashTable {
+public:
+    struct Slot {
+        K key;
+        V value;
+    };
+    // What one entry costs besides its control byte, named as in HashTable.
+    using Node = Slot;
+
+    FlatHashTable(unsigned int size = 1024);
+    ~FlatHashTable();
+
+    FlatHashTable(const FlatHashTable&) = delete;
+    FlatHashTable& operator=(const FlatHashTable&) = delete;
+
+    template <typename Q> V get(const Q& key) const;
+    // get() for keys[0..n) at once, into out[0..n). Every key is hashed and
+    // its first control group and slots prefetched before any is probed.
+    template <typename Q> void get_many(const Q* keys, size_t n, V* out) const;
+    void put(const K& key, V value);
+    // Adds `key` unless it is present, in which case nothing changes and the
+    // caller keeps `value`. Returns whether it was added.
+    bool insert(const K& key, V value);
+    // insert() for keys[0..n), recording each outcome in inserted[0..n),
+    // prefetching in groups as get_many() does.
+    void insert_many(const K* keys, const V* values, size_t n, bool* inserted);
+    // Grows now so that `n` keys fit without insert() or put() rehashing.
+    void reserve(size_t n);
+    template <typename Q> bool remove(const Q& key);
+    template <typename Q> bool contains(const Q& key) const;
+    std::vector<K> keys() const;
+    // Calls visit(key, value) once for every entry. The table must not change
+    // during the walk.
+    template <typename F> void for_each(F&& visit) const;
+    // Calls visit(key, value) for up to `count` entries from consecutive
+    // groups, starting at a group picked by `seed` and giving up after
+    // count * 10 groups.
+    template <typename F> unsigned int sample(uint64_t seed, unsigned int count, F&& visit) const;
+    // Calls visit(key, value) for every entry whose home group is the one at
+    // `cursor`, and returns the cursor to resume from; 0 once the whole
+    // table has been walked. As in HashTable the cursor counts up in
+    // reverse-binary order over groups, so every entry present for the whole
+    // walk is visited at least once even if the table grows between calls.
+    template <typename F> size_t scan(size_t cursor, F&& visit) const;
+
+    unsigned int size() const { return current_size; }
+    unsigned int bucket_count() const { return capacity; }
+
+    // Rehashing is never in progress.
+    bool rehash_step(unsigned int) { return false; }
+    bool is_rehashing() const { return false; }
+
+private:
+    static const unsigned int k_group_size = 16;
+    static const int8_t k_empty = -128;   // 0b10000000
+    static const int8_t k_deleted = -2;   // 0b11111110
+
+    template <typename Q> static size_t hash(const Q& key);
+    static int8_t h2(size_t h) { return static_cast<int8_t>(h & 0x7F); }
+    size_t h1(size_t h) const { return (h >> 7) & (num_groups() - 1); }
+    unsigned int num_groups() const { return capacity / k_group_size; }
+
+    static uint32_t match_byte(const int8_t* group, int8_t b);
+
+    // Index of the slot holding `key`, or -1.
+    template <typename Q> long find(const Q& key, size_t h) const;
+    void rehash(unsigned int new_capacity);
+    // Makes room for one more key, rehashing if the load would pass the limit.
+    void grow_for_one();
+    void insert_new(K key, V value, size_t h);
+    void prefetch(size_t h) const;
+
+private:
+    int8_t* ctrl;
+    Slot* slots;
+    unsigned int capacity;      // number of slots, a power of two >= 16
+    unsigned int current_size;
+    unsigned int tombstones;
+    // Grow once live + deleted slots pass 7/8 of capacity.
+    static const unsigned int k_max_load_num = 7;
+    static const unsigned int k_max_load_den = 8;
+};
+
+
+template <typename K, typename V, typename Hash>
+FlatHashTable<K,V,Hash>::FlatHashTable(unsigned int size)
+    : ctrl(nullptr), slots(nullptr), capacity(0), current_size(0), tombstones(0) {
+    unsigned int cap = k_group_size;
+    while (cap < size) cap <<= 1;
+    rehash(cap);
+}
+
+template <typename K, typename V, typename Hash>
+FlatHashTable<K,V,Hash>::~FlatHashTable() {
+    for (unsigned int i = 0; i < capacity; ++i) {
+        if (ctrl[i] >= 0) {
+            delete slots[i].value; // If V is a pointer, delete the object it points to
+            slots[i].~Slot();
+        }
+    }
+    std::free(ctrl);
+    std::free(slots);
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+size_t FlatHashTable<K,V,Hash>::hash(const Q& key) {
+    // Mix so that weak hashes (std::hash is the identity for integers) still
+    // spread entropy into the low 7 bits used as H2.
+    uint64_t h = Hash()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+}
+
+template <typename K, typename V, typename Hash>
+uint32_t FlatHashTable<K,V,Hash>::match_byte(const int8_t* group, int8_t b) {
+#if defined(__SSE2__)
+    __m128i ctrl_bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_bytes, _mm_set1_epi8(b))));
+#else
+    uint32_t mask = 0;
+    for (unsigned int i = 0; i < k_group_size; ++i) {
+        if (group[i] == b) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+long FlatHashTable<K,V,Hash>::find(const Q& key, size_t h) const {
+    const int8_t tag = h2(h);
+    size_t g = h1(h);
+    // Triangular probing over groups visits every group once when the group
+    // count is a power of two.
+    for (unsigned int step = 1; step <= num_groups(); ++step) {
+        const int8_t* group = ctrl + g * k_group_size;
+        uint32_t candidates = match_byte(group, tag);
+        while (candidates) {
+            unsigned int i = __builtin_ctz(candidates);
+            size_t idx = g * k_group_size + i;
+            if (slots[idx].key == key) return static_cast<long>(idx);
+            candidates &= candidates - 1;
+        }
+        if (match_byte(group, k_empty)) return -1;
+        g = (g + step) & (num_groups() - 1);
+    }
+    return -1;
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+V FlatHashTable<K,V,Hash>::get(const Q& key) const {
+    long idx = find(key, hash(key));
+    return idx >= 0 ? slots[idx].value : nullptr; // nullptr: key not found
+}
+
+template <typename K, typename V, typename Hash>
+void FlatHashTable<K,V,Hash>::prefetch(size_t h) const {
+    size_t first = h1(h) * k_group_size;
+    __builtin_prefetch(ctrl + first);
+    __builtin_prefetch(slots + first);
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+void FlatHashTable<K,V,Hash>::get_many(const Q* keys, size_t n, V* out) const {
+    const size_t k_batch = 16;
+    size_t hashes[k_batch];
+    for (size_t base = 0; base < n; base += k_batch) {
+        size_t m = n - base < k_batch ? n - base : k_batch;
+        for (size_t i = 0; i < m; ++i) {
+            hashes[i] = hash(keys[base + i]);
+            prefetch(hashes[i]);
+        }
+        for (size_t i = 0; i < m; ++i) {
+            long idx = find(keys[base + i], hashes[i]);
+            out[base + i] = idx >= 0 ? slots[idx].value : V{};
+        }
+    }
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+bool FlatHashTable<K,V,Hash>::contains(const Q& key) const {
+    return find(key, hash(key)) >= 0;
+}
+
+template <typename K, typename V, typename Hash>
+void FlatHashTable<K,V,Hash>::insert_new(K key, V value, size_t h) {
+    size_t g = h1(h);
+    for (unsigned int step = 1;; ++step) {
+        int8_t* group = ctrl + g * k_group_size;
+        uint32_t free_slots = match_byte(group, k_empty) | match_byte(group, k_deleted);
+        if (free_slots) {
+            size_t idx = g * k_group_size + __builtin_ctz(free_slots);
+            if (ctrl[idx] == k_deleted) tombstones--;
+            ctrl[idx] = h2(h);
+            new (&slots[idx]) Slot{std::move(key), value};
+            current_size++;
+            return;
+        }
+        g = (g + step) & (num_groups() - 1);
+    }
+}
+
+template <typename K, typename V, typename Hash>
+void FlatHashTable<K,V,Hash>::put(const K& key, V value) {
+    size_t h = hash(key);
+    long idx = find(key, h);
+    if (idx >= 0) {
+        delete slots[idx].value; // If V is a pointer, delete the old object
+        // The new key compares equal, but a view key must now point into
+        // the new value.
+        slots[idx].key = key;
+        slots[idx].value = value;
+        return;
+    }
+    grow_for_one();
+    insert_new(key, value, h);
+}
+
+template <typename K, typename V, typename Hash>
+void FlatHashTable<K,V,Hash>::grow_for_one() {
+    if ((current_size + tombstones + 1) * k_max_load_den > capacity * k_max_load_num) {
+        // Double when live keys fill over half the slots; otherwise the load is
+        // mostly tombstones and a same-size rehash reclaims them.
+        rehash(current_size * 2 + 2 > capacity ? capacity * 2 : capacity);
+    }
+}
+
+template <typename K, typename V, typename Hash>
+bool FlatHashTable<K,V,Hash>::insert(const K& key, V value) {
+    size_t h = hash(key);
+    if (find(key, h) >= 0) return false;
+    grow_for_one();
+    insert_new(key, value, h);
+    return true;
+}
+
+template <typename K, typename V, typename Hash>
+void FlatHashTable<K,V,Hash>::insert_many(const K* keys, const V* values, size_t n, bool* inserted) {
+    const size_t k_batch = 16;
+    size_t hashes[k_batch];
+    for (size_t base = 0; base < n; base += k_batch) {
+        size_t m = n - base < k_batch ? n - base : k_batch;
+        for (size_t i = 0; i < m; ++i) {
+            hashes[i] = hash(keys[base + i]);
+            prefetch(hashes[i]);
+        }
+        for (size_t i = 0; i < m; ++i) {
+            size_t h = hashes[i];
+            inserted[base + i] = find(keys[base + i], h) < 0;
+            if (!inserted[base + i]) continue;
+            unsigned int before = capacity;
+            grow_for_one();
+            insert_new(keys[base + i], values[base + i], h);
+            // A rehash moved everything the rest of the batch prefetched.
+            if (capacity != before) {
+                for (size_t j = i + 1; j < m; ++j) prefetch(hashes[j]);
+            }
+        }
+    }
+}
+
+template <typename K, typename V, typename Hash>
+void FlatHashTable<K,V,Hash>::reserve(size_t n) {
+    size_t want = k_group_size;
+    while ((n + tombstones) * k_max_load_den > want * k_max_load_num) want <<= 1;
+    if (want > capacity) rehash(static_cast<unsigned int>(want));
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+bool FlatHashTable<K,V,Hash>::remove(const Q& key) {
+    long idx = find(key, hash(key));
+    if (idx < 0) {
+        return false;
+    }
+
+    // A group that still has an EMPTY slot never made a probe sequence
+    // continue past it, so the slot can go straight back to EMPTY.
+    const int8_t* group = ctrl + (idx / k_group_size) * k_group_size;
+    if (match_byte(group, k_empty)) {
+        ctrl[idx] = k_empty;
+    } else {
+        ctrl[idx] = k_deleted;
+        tombstones++;
+    }
+    delete slots[idx].value; // Delete the value if V is a pointer
+    slots[idx].~Slot();
+    current_size--;
+    return true;
+}
+
+template <typename K, typename V, typename Hash>
+std::vector<K> FlatHashTable<K,V,Hash>::keys() const {
+    std::vector<K> result;
+    result.reserve(current_size);
+    for (unsigned int i = 0; i < capacity; ++i) {
+        if (ctrl[i] >= 0) {
+            result.push_back(slots[i].key);
+        }
+    }
+    return result;
+}
+
+template <typename K, typename V, typename Hash>
+template <typename F>
+void FlatHashTable<K,V,Hash>::for_each(F&& visit) const {
+    for (unsigned int i = 0; i < capacity; ++i) {
+        if (ctrl[i] >= 0) visit(slots[i].key, slots[i].value);
+    }
+}
+
+template <typename K, typename V, typename Hash>
+template <typename F>
+unsigned int FlatHashTable<K,V,Hash>::sample(uint64_t seed, unsigned int count, F&& visit) const {
+    size_t g = static_cast<size_t>(seed) & (num_groups() - 1);
+    unsigned int visited = 0;
+    for (unsigned int steps = 0; steps < count * 10 && visited < count; ++steps) {
+        for (size_t i = g * k_group_size; i < (g + 1) * k_group_size && visited < count; ++i) {
+            if (ctrl[i] < 0) continue;
+            visit(slots[i].key, slots[i].value);
+            visited++;
+        }
+        g = (g + 1) & (num_groups() - 1);
+    }
+    return visited;
+}
+
+template <typename K, typename V, typename Hash>
+template <typename F>
+size_t FlatHashTable<K,V,Hash>::scan(size_t cursor, F&& visit) const {
+    // A key lives on the probe sequence from its home group, no further than
+    // the first group with an EMPTY slot, as find() relies on. Growing keeps
+    // the low bits of every home group, like a chained table's buckets.
+    size_t mask = num_groups() - 1;
+    size_t home = cursor & mask;
+    size_t g = home;
+    for (unsigned int step = 1; step <= num_groups(); ++step) {
+        const int8_t* group = ctrl + g * k_group_size;
+        for (size_t i = g * k_group_size; i < (g + 1) * k_group_size; ++i) {
+            if (ctrl[i] >= 0 && h1(hash(slots[i].key)) == home) visit(slots[i].key, slots[i].value);
+        }
+        if (match_byte(group, k_empty)) break;
+        g = (g + step) & mask;
+    }
+    return scan_next(cursor, mask);
+}
+
+template <typename K, typename V, typename Hash>
+void FlatHashTable<K,V,Hash>::rehash(unsigned int new_capacity) {
+    // aligned_alloc keeps every 16-byte control group aligned for _mm_load_si128.
+    // Both arrays are allocated before anything changes, so a failure leaves
+    // the table as it was.
+    int8_t* new_ctrl = static_cast<int8_t*>(std::aligned_alloc(k_group_size, new_capacity));
+    Slot* new_slots = static_cast<Slot*>(std::malloc(sizeof(Slot) * new_capacity));
+    if (!new_ctrl || !new_slots) {
+        std::free(new_ctrl);
+        std::free(new_slots);
+        throw std::bad_alloc();
+    }
+    std::memset(new_ctrl, k_empty, new_capacity);
+
+    int8_t* old_ctrl = ctrl;
+    Slot* old_slots = slots;
+    unsigned int old_capacity = capacity;
+    ctrl = new_ctrl;
+    slots = new_slots;
+    capacity = new_capacity;
+    current_size = 0;
+    tombstones = 0;
+
+    for (unsigned int i = 0; i < old_capacity; ++i) {
+        if (old_ctrl[i] >= 0) {
+            Slot& s = old_slots[i];
+            // Hashed before the key is moved into insert_new's parameter.
+            size_t h = hash(s.key);
+            insert_new(std::move(s.key), s.value, h);
+            s.~Slot();
+        }
+    }
+    std::free(old_ctrl);
+    std::free(old_slots);
+}
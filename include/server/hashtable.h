@@ -1,12 +1,38 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include "server/slab.h"
 
-template <typename K, typename V>
+// Hashes std::string and std::string_view identically, so a table keyed by
+// std::string can be probed with a view into a request buffer without
+// materializing the key first.
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+
+// Chained hash table with incremental (progressive) rehashing.
+//
+// A grow or shrink allocates the new bucket array and then migrates a bounded
+// number of buckets per put/remove (and per rehash_step() call from the event
+// loop), so no single operation pays for a full O(n) rehash. While a migration
+// is in progress lookups consult both arrays; new keys always go to the new one.
+//
+// get/contains/remove accept any key type that `Hash` can hash and that
+// compares equal to K (heterogeneous lookup); only put materializes a K.
+template <typename K, typename V, typename Hash = std::hash<K>>
 class HashTable {
 public:
-    struct Node {
+    struct Node : SlabAllocated {
         K key;
         V value;
         Node* next;
@@ -17,161 +43,465 @@ public:
     HashTable(unsigned int size = 1024);
     ~HashTable();
 
-    V get(const K& key) const;
+    template <typename Q> V get(const Q& key) const;
+    // get() for keys[0..n) at once, into out[0..n). Every key is hashed and
+    // its bucket prefetched, then every chain head (and the object a pointer
+    // value refers to), before any key is compared, so the cache misses of
+    // independent lookups overlap instead of running back to back.
+    template <typename Q> void get_many(const Q* keys, size_t n, V* out) const;
     void put(const K& key, V value);
-    bool remove(const K& key);
-    bool contains(const K& key) const;
+    // Adds `key` unless it is present, in which case nothing changes and the
+    // caller keeps `value`. Returns whether it was added. One lookup, where
+    // contains() and put() would take two.
+    bool insert(const K& key, V value);
+    // insert() for keys[0..n), recording each outcome in inserted[0..n); the
+    // buckets and chain heads are prefetched in groups as in get_many().
+    void insert_many(const K* keys, const V* values, size_t n, bool* inserted);
+    // Grows the bucket array now, finishing any migration, so that `n` keys
+    // fit without insert() or put() ever starting a resize.
+    void reserve(size_t n);
+    template <typename Q> bool remove(const Q& key);
+    template <typename Q> bool contains(const Q& key) const;
     std::vector<K> keys() const;
+    // Calls visit(key, value) once for every entry. The table must not change
+    // during the walk.
+    template <typename F> void for_each(F&& visit) const;
+
+    // Calls visit(key, value) for up to `count` entries from consecutive
+    // buckets, starting at a bucket picked by `seed` and giving up after
+    // count * 10 buckets. Lets callers pick random-ish candidates (e.g. for
+    // eviction) without keeping a global order over the entries.
+    template <typename F> unsigned int sample(uint64_t seed, unsigned int count, F&& visit) const;
+
+    // Calls visit(key, value) for every entry of the bucket(s) at `cursor` and
+    // returns the cursor to resume from; 0 once the whole table has been
+    // walked (start with 0). The cursor counts up in reverse-binary order, so
+    // every entry present for the whole walk is visited at least once even if
+    // the table grows, shrinks or migrates between calls; entries may repeat.
+    template <typename F> size_t scan(size_t cursor, F&& visit) const;
 
     unsigned int size() const { return current_size; }
 
+    // Migrates up to `n` buckets of an in-progress resize. Returns true while
+    // there is still work left.
+    bool rehash_step(unsigned int n);
+    bool is_rehashing() const { return rehash_idx >= 0; }
+    unsigned int bucket_count() const { return num_buckets[0] + num_buckets[1]; }
+
 private:
-    unsigned int hash(const K& key) const;
-    void resize();
+    static Node** alloc_buckets(unsigned int n);
+    static void free_buckets(Node** buckets, unsigned int n);
+    template <typename Q> unsigned int hash(const Q& key, int t) const;
+    template <typename Q> Node** find(const Q& key) const { return find(key, Hash()(key)); }
+    template <typename Q> Node** find(const Q& key, size_t key_hash) const;
+    bool insert_hashed(const K& key, V value, size_t key_hash);
+    void start_resize(unsigned int new_num_buckets);
+    void maybe_grow();
+    void maybe_shrink();
 
 private:
-    Node** table;
-    unsigned int num_buckets;
+    // table[1] is only allocated during a migration from table[0].
+    Node** table[2];
+    unsigned int num_buckets[2];
+    long rehash_idx;  // next bucket of table[0] to migrate, -1 when idle
     unsigned int current_size;
+    unsigned int min_buckets;
     const float load_factor_threshold = 0.75;
+    const float shrink_load_factor = 0.1;
+    static const unsigned int k_rehash_buckets_per_op = 1;
 };
 
 
-template <typename K, typename V>
-HashTable<K,V>::HashTable(unsigned int size) {
-    this->num_buckets = size;
+static inline unsigned int round_up_pow2(unsigned int n) {
+    unsigned int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+template <typename K, typename V, typename Hash>
+HashTable<K,V,Hash>::HashTable(unsigned int size) {
+    this->num_buckets[0] = round_up_pow2(size ? size : 1);
+    this->num_buckets[1] = 0;
+    this->min_buckets = num_buckets[0];
     this->current_size = 0;
-    
-    table = new Node*[num_buckets];
-    std::memset(table, 0, num_buckets * sizeof(Node*));
+    this->rehash_idx = -1;
+
+    table[0] = alloc_buckets(num_buckets[0]);
+    table[1] = nullptr;
 }
 
-template <typename K, typename V>
-HashTable<K,V>::~HashTable() {
-    for (unsigned int i = 0; i < num_buckets; ++i) {
-        Node* entry = table[i];
-        while (entry) {
-            Node* prev = entry;
-            entry = entry->next;
-            delete prev->value; // If V is a pointer, delete the object it points to
-            delete prev;
+template <typename K, typename V, typename Hash>
+HashTable<K,V,Hash>::~HashTable() {
+    for (int t = 0; t < 2; ++t) {
+        for (unsigned int i = 0; i < num_buckets[t]; ++i) {
+            Node* entry = table[t][i];
+            while (entry) {
+                Node* prev = entry;
+                entry = entry->next;
+                delete prev->value; // If V is a pointer, delete the object it points to
+                delete prev;
+            }
         }
+        free_buckets(table[t], num_buckets[t]);
     }
-    delete[] table;
 }
 
-template <typename K, typename V>
-void HashTable<K,V>::put(const K& key, V value) {
-    if ((float)current_size / num_buckets > load_factor_threshold) {
-        resize();
+template <typename K, typename V, typename Hash>
+void HashTable<K,V,Hash>::put(const K& key, V value) {
+    if (is_rehashing()) {
+        rehash_step(k_rehash_buckets_per_op);
     }
 
-    unsigned int index = hash(key);
-    Node* entry = table[index];
-    Node* prev = nullptr;
+    Node** slot = find(key);
+    if (*slot) {
+        delete (*slot)->value; // If V is a pointer, delete the old object
+        // The new key compares equal, but a view key must now point into
+        // the new value.
+        (*slot)->key = key;
+        (*slot)->value = value;
+        return;
+    }
+
+    maybe_grow();
+    int t = is_rehashing() ? 1 : 0;
+    unsigned int index = hash(key, t);
+    Node* entry = new Node(key, value);
+    entry->next = table[t][index];
+    table[t][index] = entry;
+    current_size++;
+}
+
+template <typename K, typename V, typename Hash>
+bool HashTable<K,V,Hash>::insert(const K& key, V value) {
+    return insert_hashed(key, value, Hash()(key));
+}
 
-    while (entry && entry->key != key) {
-        prev = entry;
-        entry = entry->next;
+template <typename K, typename V, typename Hash>
+bool HashTable<K,V,Hash>::insert_hashed(const K& key, V value, size_t key_hash) {
+    if (is_rehashing()) {
+        rehash_step(k_rehash_buckets_per_op);
     }
+    if (*find(key, key_hash)) return false;
 
-    if (!entry) {
-        entry = new Node(key, value);
-        if (!prev) {
-            table[index] = entry;
-        } else {
-            prev->next = entry;
+    maybe_grow();
+    int t = is_rehashing() ? 1 : 0;
+    unsigned int index = key_hash & (num_buckets[t] - 1);
+    Node* entry = new Node(key, value);
+    entry->next = table[t][index];
+    table[t][index] = entry;
+    current_size++;
+    return true;
+}
+
+template <typename K, typename V, typename Hash>
+void HashTable<K,V,Hash>::insert_many(const K* keys, const V* values, size_t n, bool* inserted) {
+    const size_t k_group = 16;
+    size_t hashes[k_group];
+    for (size_t base = 0; base < n; base += k_group) {
+        size_t m = n - base < k_group ? n - base : k_group;
+        for (size_t i = 0; i < m; ++i) {
+            hashes[i] = Hash()(keys[base + i]);
+            for (int t = 0; t < 2 && table[t]; ++t) {
+                __builtin_prefetch(&table[t][hashes[i] & (num_buckets[t] - 1)]);
+            }
+        }
+        for (size_t i = 0; i < m; ++i) {
+            for (int t = 0; t < 2 && table[t]; ++t) {
+                Node* head = table[t][hashes[i] & (num_buckets[t] - 1)];
+                if (!head) continue;
+                __builtin_prefetch(head);
+                if constexpr (std::is_pointer_v<V>) __builtin_prefetch(head->value);
+            }
+        }
+        for (size_t i = 0; i < m; ++i) {
+            inserted[base + i] = insert_hashed(keys[base + i], values[base + i], hashes[i]);
         }
-        current_size++;
-    } else {
-        delete entry->value; // If V is a pointer, delete the old object
-        entry->value = value;
     }
 }
 
-template <typename K, typename V>
-V HashTable<K,V>::get(const K& key) const {
-    unsigned int index = hash(key);
-    Node* entry = table[index];
+template <typename K, typename V, typename Hash>
+void HashTable<K,V,Hash>::reserve(size_t n) {
+    while (rehash_step(1024)) {}
+    unsigned int want = round_up_pow2(static_cast<unsigned int>(n / load_factor_threshold) + 1);
+    if (want <= num_buckets[0]) return;
+    start_resize(want);
+    while (rehash_step(1024)) {}
+}
 
-    while (entry) {
-        if (entry->key == key) {
-            return entry->value;
+template <typename K, typename V, typename Hash>
+template <typename Q>
+V HashTable<K,V,Hash>::get(const Q& key) const {
+    Node* entry = *find(key);
+    return entry ? entry->value : nullptr; // nullptr: key not found
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+void HashTable<K,V,Hash>::get_many(const Q* keys, size_t n, V* out) const {
+    // Small groups keep the in-flight prefetches within what the core can
+    // track; the per-key state lives on the stack.
+    const size_t k_group = 16;
+    size_t hashes[k_group];
+    Node* heads[2][k_group];
+    for (size_t base = 0; base < n; base += k_group) {
+        size_t m = n - base < k_group ? n - base : k_group;
+        for (size_t i = 0; i < m; ++i) {
+            hashes[i] = Hash()(keys[base + i]);
+            for (int t = 0; t < 2 && table[t]; ++t) {
+                __builtin_prefetch(&table[t][hashes[i] & (num_buckets[t] - 1)]);
+            }
+        }
+        for (size_t i = 0; i < m; ++i) {
+            for (int t = 0; t < 2; ++t) {
+                heads[t][i] = table[t] ? table[t][hashes[i] & (num_buckets[t] - 1)] : nullptr;
+                if (heads[t][i]) __builtin_prefetch(heads[t][i]);
+            }
+        }
+        if constexpr (std::is_pointer_v<V>) {
+            for (size_t i = 0; i < m; ++i) {
+                for (int t = 0; t < 2; ++t) {
+                    if (heads[t][i]) __builtin_prefetch(heads[t][i]->value);
+                }
+            }
+        }
+        for (size_t i = 0; i < m; ++i) {
+            V found{};
+            for (int t = 0; t < 2 && !found; ++t) {
+                for (Node* node = heads[t][i]; node; node = node->next) {
+                    if (node->key == keys[base + i]) {
+                        found = node->value;
+                        break;
+                    }
+                }
+            }
+            out[base + i] = found;
         }
-        entry = entry->next;
     }
-    return nullptr; // Key not found
 }
 
-template <typename K, typename V>
-bool HashTable<K,V>::remove(const K& key) {
-    unsigned int index = hash(key);
-    Node* entry = table[index];
-    Node* prev = nullptr;
-
-    while (entry && entry->key != key) {
-        prev = entry;
-        entry = entry->next;
+template <typename K, typename V, typename Hash>
+template <typename Q>
+bool HashTable<K,V,Hash>::remove(const Q& key) {
+    if (is_rehashing()) {
+        rehash_step(k_rehash_buckets_per_op);
     }
 
+    Node** slot = find(key);
+    Node* entry = *slot;
     if (!entry) {
         return false;
     }
-
-    if (!prev) {
-        table[index] = entry->next;
-    } else {
-        prev->next = entry->next;
-    }
+    *slot = entry->next;
 
     delete entry->value; // Delete the value if V is a pointer
     delete entry;
     current_size--;
+    maybe_shrink();
     return true;
 }
 
-template <typename K, typename V>
-bool HashTable<K,V>::contains(const K& key) const {
+template <typename K, typename V, typename Hash>
+template <typename Q>
+bool HashTable<K,V,Hash>::contains(const Q& key) const {
     return get(key) != nullptr;
 }
 
-template <typename K, typename V>
-std::vector<K> HashTable<K,V>::keys() const {
+template <typename K, typename V, typename Hash>
+template <typename F>
+void HashTable<K,V,Hash>::for_each(F&& visit) const {
+    for (int t = 0; t < 2; ++t) {
+        for (unsigned int i = 0; i < num_buckets[t]; ++i) {
+            for (Node* entry = table[t][i]; entry; entry = entry->next) {
+                visit(entry->key, entry->value);
+            }
+        }
+    }
+}
+
+template <typename K, typename V, typename Hash>
+std::vector<K> HashTable<K,V,Hash>::keys() const {
     std::vector<K> result;
-    for (unsigned int i = 0; i < num_buckets; ++i) {
-        Node* entry = table[i];
-        while (entry) {
-            result.push_back(entry->key);
-            entry = entry->next;
+    result.reserve(current_size);
+    for (int t = 0; t < 2; ++t) {
+        for (unsigned int i = 0; i < num_buckets[t]; ++i) {
+            Node* entry = table[t][i];
+            while (entry) {
+                result.push_back(entry->key);
+                entry = entry->next;
+            }
         }
     }
     return result;
 }
 
-template <typename K, typename V>
-unsigned int HashTable<K,V>::hash(const K& key) const {
-    size_t key_hash = std::hash<K>()(key);
-    return key_hash % num_buckets;
+template <typename K, typename V, typename Hash>
+template <typename F>
+unsigned int HashTable<K,V,Hash>::sample(uint64_t seed, unsigned int count, F&& visit) const {
+    // During a migration, index both arrays at the same position of the
+    // larger one; buckets table[0] has already handed over are empty.
+    unsigned int span = num_buckets[0] > num_buckets[1] ? num_buckets[0] : num_buckets[1];
+    unsigned int idx = static_cast<unsigned int>(seed) & (span - 1);
+    unsigned int visited = 0;
+    for (unsigned int steps = 0; steps < count * 10 && visited < count; ++steps) {
+        for (int t = 0; t < 2 && visited < count; ++t) {
+            if (!table[t] || idx >= num_buckets[t]) continue;
+            for (Node* entry = table[t][idx]; entry && visited < count; entry = entry->next) {
+                visit(entry->key, entry->value);
+                visited++;
+            }
+        }
+        idx = (idx + 1) & (span - 1);
+    }
+    return visited;
+}
+
+static inline uint64_t reverse_bits(uint64_t v) {
+    v = __builtin_bswap64(v);
+    v = ((v >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((v & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+    v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+    return v;
+}
+
+// Advances a reverse-binary cursor over a table of mask + 1 buckets: the bits
+// above the mask are set so the increment carries from the top bucket bit
+// down.
+static inline size_t scan_next(size_t cursor, size_t mask) {
+    return reverse_bits(reverse_bits(cursor | ~mask) + 1);
+}
+
+template <typename K, typename V, typename Hash>
+template <typename F>
+size_t HashTable<K,V,Hash>::scan(size_t cursor, F&& visit) const {
+    auto visit_chain = [&](Node* entry) {
+        for (; entry; entry = entry->next) visit(entry->key, entry->value);
+    };
+    if (!table[1]) {
+        size_t mask = num_buckets[0] - 1;
+        visit_chain(table[0][cursor & mask]);
+        return scan_next(cursor, mask);
+    }
+
+    // Mid-migration: visit the bucket of the smaller array, then every bucket
+    // of the larger one that its entries can map to. These all share the low
+    // bits of the cursor, which is why the cursor increments from the top.
+    int small = num_buckets[0] <= num_buckets[1] ? 0 : 1;
+    int large = 1 - small;
+    size_t small_mask = num_buckets[small] - 1;
+    size_t large_mask = num_buckets[large] - 1;
+    visit_chain(table[small][cursor & small_mask]);
+    do {
+        visit_chain(table[large][cursor & large_mask]);
+        cursor = scan_next(cursor, large_mask);
+    } while (cursor & (small_mask ^ large_mask));
+    return cursor;
+}
+
+template <typename K, typename V, typename Hash>
+template <typename Q>
+unsigned int HashTable<K,V,Hash>::hash(const Q& key, int t) const {
+    size_t key_hash = Hash()(key);
+    return key_hash & (num_buckets[t] - 1);
+}
+
+// Returns the link that points at `key`'s node (or the null link terminating
+// its chain), so callers can unlink without tracking a `prev` pointer.
+template <typename K, typename V, typename Hash>
+template <typename Q>
+typename HashTable<K,V,Hash>::Node** HashTable<K,V,Hash>::find(const Q& key, size_t key_hash) const {
+    Node** slot = nullptr;
+    for (int t = 0; t < 2 && table[t]; ++t) {
+        slot = &table[t][key_hash & (num_buckets[t] - 1)];
+        while (*slot && (*slot)->key != key) {
+            slot = &(*slot)->next;
+        }
+        if (*slot) return slot;
+    }
+    return slot;
 }
 
-template <typename K, typename V>
-void HashTable<K,V>::resize() {
-    unsigned int new_num_buckets = num_buckets * 2;
-    Node** new_table = new Node*[new_num_buckets];
-    std::memset(new_table, 0, new_num_buckets * sizeof(Node*));
+// Large arrays are mapped directly rather than left to calloc. Fresh mappings
+// are zero pages, so starting a resize does not touch the whole new array,
+// and the request never reaches malloc's heap: once glibc has raised its
+// dynamic mmap threshold, a large heap allocation first consolidates every
+// freed node, which after a mass delete stalled the shrink for ~30ms.
+static const size_t k_mmap_buckets_bytes = 1 << 20;
 
-    for (unsigned int i = 0; i < num_buckets; ++i) {
-        Node* entry = table[i];
+template <typename K, typename V, typename Hash>
+typename HashTable<K,V,Hash>::Node** HashTable<K,V,Hash>::alloc_buckets(unsigned int n) {
+    size_t bytes = n * sizeof(Node*);
+    if (bytes < k_mmap_buckets_bytes) {
+        return static_cast<Node**>(std::calloc(n, sizeof(Node*)));
+    }
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) throw std::bad_alloc();
+    return static_cast<Node**>(p);
+}
+
+template <typename K, typename V, typename Hash>
+void HashTable<K,V,Hash>::free_buckets(Node** buckets, unsigned int n) {
+    if (!buckets) return;
+    size_t bytes = n * sizeof(Node*);
+    if (bytes < k_mmap_buckets_bytes) std::free(buckets);
+    else ::munmap(buckets, bytes);
+}
+
+template <typename K, typename V, typename Hash>
+void HashTable<K,V,Hash>::start_resize(unsigned int new_num_buckets) {
+    num_buckets[1] = new_num_buckets;
+    table[1] = alloc_buckets(new_num_buckets);
+    rehash_idx = 0;
+}
+
+template <typename K, typename V, typename Hash>
+void HashTable<K,V,Hash>::maybe_grow() {
+    if (!is_rehashing() && (float)current_size / num_buckets[0] > load_factor_threshold) {
+        start_resize(num_buckets[0] * 2);
+    }
+}
+
+template <typename K, typename V, typename Hash>
+void HashTable<K,V,Hash>::maybe_shrink() {
+    if (!is_rehashing() && num_buckets[0] > min_buckets &&
+        (float)current_size / num_buckets[0] < shrink_load_factor) {
+        unsigned int target = round_up_pow2(current_size * 2);
+        start_resize(target < min_buckets ? min_buckets : target);
+    }
+}
+
+template <typename K, typename V, typename Hash>
+bool HashTable<K,V,Hash>::rehash_step(unsigned int n) {
+    if (!is_rehashing()) return false;
+
+    // Bound the number of empty buckets visited too, so a sparse table after
+    // mass deletes cannot turn one step into a long scan.
+    unsigned int empty_visits = n * 10;
+    while (n > 0 && (unsigned long)rehash_idx < num_buckets[0]) {
+        Node* entry = table[0][rehash_idx];
+        if (!entry) {
+            rehash_idx++;
+            if (--empty_visits == 0) break;
+            continue;
+        }
         while (entry) {
             Node* next = entry->next;
-            unsigned int new_index = hash(entry->key) % new_num_buckets;
-            entry->next = new_table[new_index];
-            new_table[new_index] = entry;
+            unsigned int new_index = hash(entry->key, 1);
+            entry->next = table[1][new_index];
+            table[1][new_index] = entry;
             entry = next;
         }
+        table[0][rehash_idx] = nullptr;
+        rehash_idx++;
+        n--;
     }
 
-    delete[] table;
-    table = new_table;
-    num_buckets = new_num_buckets;
-}
\ No newline at end of file
+    if ((unsigned long)rehash_idx < num_buckets[0]) return true;
+
+    free_buckets(table[0], num_buckets[0]);
+    table[0] = table[1];
+    num_buckets[0] = num_buckets[1];
+    table[1] = nullptr;
+    num_buckets[1] = 0;
+    rehash_idx = -1;
+    return false;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Heap footprint estimates for memory accounting. They model glibc malloc
+// (16-byte size classes including an 8-byte chunk header, 32-byte minimum)
+// and libstdc++ std::string, which keeps up to 15 characters inline. Objects
+// from the slab pools are sized with slab_object_size() instead.
+inline size_t alloc_size(size_t n) {
+    size_t chunk = (n + 8 + 15) & ~static_cast<size_t>(15);
+    return chunk < 32 ? 32 : chunk;
+}
+
+// Heap bytes behind a string of length `len` (0 while it fits inline).
+inline size_t string_heap_size(size_t len) {
+    return len > 15 ? alloc_size(len + 1) : 0;
+}
+
+inline size_t string_heap_size(const std::string& s) {
+    return s.capacity() > 15 ? alloc_size(s.capacity() + 1) : 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <sys/types.h>
+#include "server/ring_buffer.h"
+#include "server/value_buffer.h"
+
+// A connection's pending output: serialized replies in a RingBuffer, with
+// long values spliced in by reference instead of being copied. write_to()
+// hands ring bytes and shared values to one writev(2) in stream order.
+//
+// Replies are serialized in place: begin_frame() reserves the 4-byte length
+// prefix and end_frame() fills it in once the reply is complete.
+class OutputQueue {
+public:
+    // Values shorter than this are copied; the bookkeeping of a shared
+    // segment is not worth it for them.
+    static const size_t k_min_shared = 4096;
+
+    explicit OutputQueue(size_t capacity) : ring_(capacity) {}
+    ~OutputQueue();
+
+    OutputQueue(const OutputQueue&) = delete;
+    OutputQueue& operator=(const OutputQueue&) = delete;
+
+    // Bytes waiting to be written, shared values included.
+    size_t size() const { return ring_.size() + shared_bytes_; }
+    bool empty() const { return size() == 0; }
+    // Capacity of the ring; shared values belong to the keyspace.
+    size_t capacity() const { return ring_.capacity(); }
+
+    void append(const void* data, size_t n) { ring_.append(data, n); }
+    // Queues the first `len` bytes of `buf`, taking a reference until they
+    // have been written. Short values are copied instead.
+    void append_shared(ValueBuffer* buf, size_t len);
+
+    struct FrameMark {
+        size_t ring_offset;  // where the length prefix sits in the ring
+        size_t size;         // size() just after the prefix
+    };
+    FrameMark begin_frame();
+    void end_frame(FrameMark mark);
+
+    // writev(2) as much as possible, consuming whatever was written. Same
+    // return convention as write(2).
+    ssize_t write_to(int fd);
+
+private:
+    struct Shared {
+        uint64_t at;  // ring stream position the value follows
+        ValueBuffer* buf;
+        size_t len;
+        size_t sent;
+    };
+
+    // Ring position of the next byte written and of the byte after the
+    // last one appended, counted since the queue was created.
+    uint64_t ring_written() const { return ring_consumed_; }
+    uint64_t ring_end() const { return ring_consumed_ + ring_.size(); }
+    void consume(size_t n);
+
+    RingBuffer ring_;
+    std::deque<Shared> shared_;
+    size_t shared_bytes_ = 0;     // unsent bytes of shared_
+    uint64_t ring_consumed_ = 0;  // ring bytes written so far
+};
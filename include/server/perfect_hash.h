@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Collision-free lookup over a fixed set of strings, built at compile time.
+//
+// Hash and displace: one FNV-1a pass over a key picks a bucket (about two
+// keys each), and the bucket's displacement, found by the constructor, moves
+// its keys into slots no other key uses in a power-of-two table of at least
+// 2N. Buckets are placed largest first, so each search is short. find() then
+// costs one hash of the probe and one comparison against the only key that
+// can match. Construct it in a constant expression: a key set that cannot be
+// placed, such as one holding a key twice, then fails to compile.
+template <size_t N>
+class PerfectHash {
+public:
+    static_assert(N > 0 && N < 255, "slots hold key indexes as uint8_t");
+    static constexpr size_t k_slots = [] {
+        size_t n = 1;
+        while (n < 2 * N) n <<= 1;
+        return n;
+    }();
+    static constexpr size_t k_buckets = k_slots >= 8 ? k_slots / 4 : 1;
+    static constexpr uint32_t k_max_displacement = 1u << 16;
+
+    constexpr explicit PerfectHash(const std::array<std::string_view, N>& keys) : keys_(keys) {
+        std::array<uint64_t, N> hashes{};
+        std::array<size_t, k_buckets> sizes{};
+        size_t largest = 0;
+        for (size_t i = 0; i < N; ++i) {
+            hashes[i] = hash(keys_[i]);
+            size_t& size = sizes[bucket_of(hashes[i])];
+            if (++size > largest) largest = size;
+        }
+        slots_.fill(k_empty);
+        for (size_t size = largest; size > 0; --size) {
+            for (size_t b = 0; b < k_buckets; ++b) {
+                if (sizes[b] == size) place(b, hashes);
+            }
+        }
+    }
+
+    // The index of `s` among the keys, or -1.
+    constexpr int find(std::string_view s) const {
+        uint64_t h = hash(s);
+        uint8_t index = slots_[slot_of(h, displacement_[bucket_of(h)])];
+        return index != k_empty && keys_[index] == s ? index : -1;
+    }
+
+private:
+    static constexpr uint8_t k_empty = 0xff;
+
+    static constexpr uint64_t hash(std::string_view s) {
+        uint64_t h = 14695981039346656037ull;
+        for (char c : s) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+    static constexpr uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        return h ^ (h >> 33);
+    }
+    static constexpr size_t bucket_of(uint64_t h) { return (mix(h) >> 32) & (k_buckets - 1); }
+    static constexpr size_t slot_of(uint64_t h, uint32_t displacement) {
+        return mix(h ^ (displacement * 0x9e3779b97f4a7c15ull)) & (k_slots - 1);
+    }
+
+    // Finds a displacement that puts every key of bucket `b` in a free slot
+    // of its own.
+    constexpr void place(size_t b, const std::array<uint64_t, N>& hashes) {
+        for (uint32_t d = 0; d < k_max_displacement; ++d) {
+            size_t placed = 0;
+            bool ok = true;
+            for (size_t i = 0; i < N && ok; ++i) {
+                if (bucket_of(hashes[i]) != b) continue;
+                uint8_t& slot = slots_[slot_of(hashes[i], d)];
+                if (slot == k_empty) {
+                    slot = static_cast<uint8_t>(i);
+                    placed++;
+                } else {
+                    ok = false;
+                }
+            }
+            if (ok) {
+                displacement_[b] = d;
+                return;
+            }
+            // Undo this attempt's slots.
+            for (size_t i = 0; i < N && placed > 0; ++i) {
+                if (bucket_of(hashes[i]) != b) continue;
+                slots_[slot_of(hashes[i], d)] = k_empty;
+                placed--;
+            }
+        }
+        throw "PerfectHash: cannot place the keys; is one of them there twice?";
+    }
+
+    std::array<std::string_view, N> keys_;
+    std::array<uint8_t, k_slots> slots_{};
+    std::array<uint32_t, k_buckets> displacement_{};
+};
@@ -1,17 +1,50 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "common/serialization.h"
+#include "server/output_queue.h"
+
+// Where a reply is serialized: a plain string, or straight into a
+// connection's OutputQueue. Cheap to copy; the out_* helpers take it by value
+// so a std::string converts implicitly.
+class ReplyOut {
+public:
+    ReplyOut(std::string& str) : str_(&str), queue_(nullptr) {}
+    explicit ReplyOut(OutputQueue& queue) : str_(nullptr), queue_(&queue) {}
+
+    void push_back(char c) { append(&c, 1); }
+    void append(const void* data, size_t n) {
+        if (str_) str_->append(static_cast<const char*>(data), n);
+        else queue_->append(data, n);
+    }
+    void append(std::string_view s) { append(s.data(), s.size()); }
+    // The first `len` bytes of `buf`: shared with an OutputQueue, copied into
+    // a string.
+    void append_shared(ValueBuffer* buf, size_t len) {
+        if (str_) str_->append(buf->data(), len);
+        else queue_->append_shared(buf, len);
+    }
+
+private:
+    std::string* str_;
+    OutputQueue* queue_;
+};
 
 // Serialization helpers (same behavior/signatures as before)
-void out_string(std::string& out, const std::string& str);
-void out_nil(std::string& out);
-void out_int(std::string& out, int64_t val);
-void out_error(std::string& out, const std::string& msg);
-void out_ok(std::string& out);
-void out_array(std::string& out, const std::vector<std::string>& arr);
-void out_double(std::string& out, double val);
+void out_string(ReplyOut out, std::string_view str);
+// A string reply whose bytes are the first `len` of `buf`, sent without a
+// copy when `out` is a connection's queue.
+void out_shared_string(ReplyOut out, ValueBuffer* buf, size_t len);
+void out_nil(ReplyOut out);
+void out_int(ReplyOut out, int64_t val);
+void out_error(ReplyOut out, std::string_view msg);
+void out_ok(ReplyOut out);
+void out_array(ReplyOut out, const std::vector<std::string>& arr);
+void out_double(ReplyOut out, double val);
 
-// Request parsing (same behavior as before)
-int parse_request(const uint8_t* data, size_t len, std::vector<std::string>& out);
+// Request parsing. The views point into `data`, which must outlive them.
+int parse_request(const uint8_t* data, size_t len, std::vector<std::string_view>& out);
+// The inverse: appends the whole frame for `cmd`, length prefix included.
+void append_request_frame(std::string& out, const std::vector<std::string_view>& cmd);
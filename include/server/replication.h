@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+// Primary/replica replication. A replica connects to its primary like any
+// client and sends
+//
+//   PSYNC <repl-id> <offset>     ("?" and -1 the first time)
+//
+// The replication stream is every command the primary logs (see
+// server/aof.h), in the same request framing, and an offset counts bytes of
+// it. If the id is the primary's and the backlog still holds the offset, the
+// reply is CONTINUE and the stream resumes right there. Otherwise the reply is
+// FULLRESYNC <repl-id> <offset>, followed by
+//
+//   [size u64][snapshot file, `size` bytes]
+//
+// taken by a forked child at that offset, and then the stream from it. The
+// replica applies the stream the way a log is replayed, sends
+// REPLCONF ACK <offset> back at most every k_repl_ack_ms, and gets no replies
+// from the primary beyond the one to PSYNC.
+
+// Recent replication stream, so a replica that lost its connection can
+// resume without a new snapshot. A ring of fixed size: appends overwrite the
+// oldest bytes.
+class ReplBacklog {
+public:
+    explicit ReplBacklog(size_t capacity) : buf_(capacity) {}
+
+    void append(std::string_view data);
+    // The stream offset just past the last byte appended.
+    uint64_t end_offset() const { return end_; }
+    // The oldest offset still held.
+    uint64_t start_offset() const { return end_ - std::min<uint64_t>(end_, buf_.size()); }
+    bool covers(uint64_t offset) const { return offset >= start_offset() && offset <= end_; }
+    // Appends the stream from `offset`, which covers() must hold, to the end.
+    void copy_from(uint64_t offset, std::string& out) const;
+    size_t capacity() const { return buf_.size(); }
+
+private:
+    std::vector<char> buf_;
+    uint64_t end_ = 0;
+};
+
+// A random 40-hex-digit id for a new replication stream.
+std::string new_repl_id();
+
+// The primary's side of a connection that became a replica with PSYNC.
+struct ReplicaLink {
+    enum Phase {
+        WAIT_FORK,      // needs a snapshot; the fork happens at the end of the turn
+        WAIT_SNAPSHOT,  // the child is writing it
+        SEND_SNAPSHOT,  // the file is going out with sendfile()
+        ONLINE,         // streaming
+    };
+    Phase phase = WAIT_FORK;
+    // The stream from the snapshot's offset on, held back until the snapshot
+    // has been sent.
+    std::string held;
+    uint64_t sync_offset = 0;
+    int snapshot_fd = -1;
+    off_t snapshot_pos = 0;
+    uint64_t snapshot_left = 0;
+    // The last REPLCONF ACK, and when it came.
+    uint64_t ack_offset = 0;
+    int64_t ack_ms = 0;
+
+    ~ReplicaLink();
+};
+
+// A replica's connection to its primary.
+struct PrimaryLink {
+    enum Phase {
+        DOWN,        // waiting to reconnect at retry_ms
+        CONNECTING,  // non-blocking connect() in progress
+        HANDSHAKE,   // PSYNC sent, waiting for the reply
+        SNAPSHOT,    // receiving the snapshot into snapshot_tmp
+        STREAM,      // applying commands
+    };
+    std::string host;
+    uint16_t port;
+    int fd = -1;
+    Phase phase = DOWN;
+    int64_t retry_ms = 0;
+    int64_t last_io_ms = 0;
+
+    // The primary's stream as applied here; empty until the first full sync
+    // has been loaded.
+    std::string repl_id;
+    uint64_t offset = 0;
+    // Given by FULLRESYNC; taken over once the snapshot is loaded.
+    std::string sync_id;
+    uint64_t sync_offset = 0;
+
+    std::string rbuf;  // received, not yet consumed
+    std::string wbuf;  // ACKs the socket did not take yet
+    std::string snapshot_tmp;
+    int snapshot_fd = -1;
+    bool snapshot_sized = false;
+    uint64_t snapshot_left = 0;
+
+    int64_t ack_ms = 0;
+    uint64_t acked = 0;
+    uint64_t full_syncs = 0;
+    uint64_t partial_syncs = 0;
+
+    PrimaryLink(std::string host_, uint16_t port_) : host(std::move(host_)), port(port_) {}
+    ~PrimaryLink();
+};
+
+// How long a replica waits before reconnecting, and the most often it ACKs.
+static const int64_t k_repl_retry_ms = 1000;
+static const int64_t k_repl_ack_ms = 100;
+// Output a replica may have queued, stream and held bytes together, before
+// the primary drops it; it then resyncs, partially if the backlog allows.
+static const size_t k_max_replica_output = size_t(256) << 20;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// Fixed-capacity circular byte buffer used for connection I/O.
+//
+// Socket reads and writes go straight into / out of the free and used regions
+// with readv/writev (at most two iovecs each), and consuming a frame only moves
+// the head index, so the hot path never memmoves or reallocates. Capacity is a
+// power of two and only grows through reserve(), i.e. when a single frame does
+// not fit.
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    size_t free_space() const { return capacity_ - size_; }
+    bool empty() const { return size_ == 0; }
+
+    // readv(2) into the free space. Same return convention as read(2).
+    ssize_t read_from(int fd);
+    // writev(2) from the used bytes, consuming whatever was written.
+    ssize_t write_to(int fd);
+
+    // Appends `n` bytes, growing the buffer if they do not fit.
+    void append(const void* data, size_t n);
+    // Copies `n` bytes starting `offset` bytes past the head into `out`.
+    void peek(size_t offset, void* out, size_t n) const;
+    // Pointer to `n` bytes starting `offset` bytes past the head, or nullptr if
+    // that range wraps around the end of the storage.
+    const uint8_t* contiguous(size_t offset, size_t n) const;
+    // Overwrites `n` used bytes starting `offset` bytes past the head.
+    void overwrite(size_t offset, const void* data, size_t n);
+    // Describes `n` bytes starting `offset` bytes past the head as one or two
+    // iovecs in `out`. Returns how many were filled (0 when n is 0).
+    int segments(size_t offset, size_t n, iovec* out) const;
+    void consume(size_t n);
+    void clear() { head_ = 0; size_ = 0; }
+
+    // Grows capacity to at least `n` bytes, preserving contents.
+    void reserve(size_t n);
+
+private:
+    size_t mask(size_t i) const { return i & (capacity_ - 1); }
+
+    uint8_t* data_;
+    size_t capacity_;
+    size_t head_;  // index of the first used byte
+    size_t size_;  // number of used bytes
+};
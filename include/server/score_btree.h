@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "server/slab.h"
+
+// B+tree over (score, member) pairs, used as the score index of a TREE-encoded
+// ZSet.
+//
+// Entries live only in the leaves, which are linked in order so range scans
+// walk leaf to leaf instead of re-descending. Every node keeps its scores in
+// one contiguous array (searched with SSE2 two doubles at a time), with the
+// members in a parallel array that is only consulted to break score ties.
+// Inner nodes also record how many entries sit under each child, so rank
+// lookups and seeks to the n-th entry are a single O(log n) descent.
+//
+// Inner node key i is a lower bound for child i's subtree: no greater than any
+// entry under it and greater than every entry under child i-1.
+class ScoreBTree {
+public:
+    ScoreBTree();
+    ~ScoreBTree();
+
+    ScoreBTree(const ScoreBTree&) = delete;
+    ScoreBTree& operator=(const ScoreBTree&) = delete;
+
+    // The pair must not already be present.
+    void insert(double score, std::string_view member);
+    // Builds an empty tree from `n` distinct pairs in ascending order, bottom
+    // up: leaves are filled left to right and each level of inner nodes is
+    // made from the one below, all nodes evenly and nearly full.
+    void load_sorted(const std::pair<std::string_view, double>* items, size_t n);
+    bool remove(double score, std::string_view member);
+
+    size_t size() const { return total; }
+    // Estimated heap bytes held by the nodes and long member strings.
+    size_t memory_usage() const;
+    // Number of entries ordered strictly before (score, member).
+    size_t count_less(double score, std::string_view member) const;
+    // Appends up to `limit` entries in order, starting at rank `start`.
+    void range(size_t start, size_t limit, std::vector<std::pair<std::string, double>>& out) const;
+    // Calls visit(member, score) for every entry in order, without copying.
+    template <typename F> void for_each(F&& visit) const;
+
+private:
+    static const int k_leaf_cap = 32;
+    static const int k_inner_cap = 32;
+
+    struct Node : SlabAllocated {
+        bool leaf;
+        int count;
+        explicit Node(bool is_leaf) : leaf(is_leaf), count(0) {}
+    };
+
+    struct Leaf : Node {
+        Leaf* next;
+        double scores[k_leaf_cap];
+        std::string members[k_leaf_cap];
+        Leaf() : Node(true), next(nullptr) {}
+    };
+
+    struct Inner : Node {
+        double scores[k_inner_cap];
+        std::string members[k_inner_cap];
+        size_t sizes[k_inner_cap];   // entries under each child
+        Node* children[k_inner_cap];
+        Inner() : Node(false) {}
+    };
+
+    // Result of inserting into a subtree that had to split.
+    struct Split {
+        Node* right;
+        double score;
+        std::string member;
+    };
+
+    static int lower_bound(const double* scores, const std::string* members, int n,
+                           double score, std::string_view member);
+    static int child_for(const Inner* node, double score, std::string_view member);
+    static size_t subtree_size(const Node* node);
+
+    bool insert(Node* node, double score, std::string_view member, Split& split);
+    bool remove(Node* node, double score, std::string_view member);
+    void fix_underflow(Inner* parent, int i);
+    void merge(Inner* parent, int i);
+    void borrow_from_left(Inner* parent, int i);
+    void borrow_from_right(Inner* parent, int i);
+    void destroy(Node* node);
+
+private:
+    Node* root;
+    size_t total;
+    size_t leaves;
+    size_t inners;
+    size_t member_heap;  // string_heap_size() of every entry's member
+};
+
+template <typename F>
+void ScoreBTree::for_each(F&& visit) const {
+    if (!root) return;
+    const Node* node = root;
+    while (!node->leaf) node = static_cast<const Inner*>(node)->children[0];
+    for (const Leaf* leaf = static_cast<const Leaf*>(node); leaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; ++i) visit(std::string_view(leaf->members[i]), leaf->scores[i]);
+    }
+}
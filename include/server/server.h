@@ -1,10 +1,28 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <sys/types.h>
+#include "server/aof.h"
+#include "server/commands.h"
 #include "server/hashtable.h"
 #include "server/entry.h"
+#include "server/event_loop.h"
+#include "server/output_queue.h"
+#include "server/protocol.h"
+#include "server/replication.h"
+#include "server/ring_buffer.h"
+#include "server/shard.h"
+#include "server/snapshot.h"
+#include "server/ttl_heap.h"
+
+struct LoadedChunk;
 
 enum ConnectionState {
     STATE_REQ,
@@ -14,38 +32,392 @@ enum ConnectionState {
 
 struct Connection {
     int fd;
+    uint64_t id;  // unique per shard, so late cross-shard replies can't hit a reused fd
     ConnectionState state;
-    std::vector<uint8_t> rbuf;
-    std::vector<uint8_t> wbuf;
-    size_t wbuf_sent;
+    RingBuffer rbuf;
+    OutputQueue wbuf;
+    // Holds a request frame that wraps around the end of rbuf so it can be
+    // parsed from contiguous memory. Unused on the common path.
+    std::vector<uint8_t> frame_scratch;
+
+    // Replies that cannot be written yet because they, or an earlier request,
+    // are still running on another shard. Sequence numbers are contiguous from
+    // the front, and replies leave for wbuf strictly in that order.
+    struct PendingReply {
+        uint64_t seq;
+        unsigned int awaiting;           // shard replies still outstanding
+        std::vector<std::string> parts;  // replies gathered so far
+        // For a multi-key command split across shards: the shard of each
+        // key, in request order. `parts` is then indexed by shard.
+        std::vector<unsigned int> key_shards;
+    };
+    std::deque<PendingReply> pending;
+    uint64_t next_seq;
+    // Under appendfsync always, the log turn that must reach the disk before
+    // the replies in wbuf may be sent; 0 when nothing was logged for them.
+    uint64_t aof_turn = 0;
+
+    // A frame longer than k_max_rbuf_frame is not assembled in rbuf. Each
+    // argument is received into its own buffer, allocated once its length
+    // prefix arrives, and large stretches are read from the socket straight
+    // into it. A SET can then keep that buffer as the stored value.
+    struct BulkRequest {
+        enum Phase { ARGC, LEN, DATA, DONE };
+        Phase phase = ARGC;
+        uint32_t remaining;    // frame bytes not yet received
+        uint32_t argc = 0;
+        uint32_t filled = 0;   // bytes of the current prefix or argument so far
+        uint8_t prefix[4];
+        std::vector<ValueBufferPtr> args;
+        std::vector<uint32_t> lens;
+        size_t bytes = 0;      // sum of lens
+
+        explicit BulkRequest(uint32_t len) : remaining(len) {}
+    };
+    std::unique_ptr<BulkRequest> bulk;
+
+    // Set once the peer sent PSYNC: from then on it is fed the replication
+    // stream and only sends ACKs.
+    std::unique_ptr<ReplicaLink> replica;
+
+    // Frames up to this size are parsed in place from rbuf.
+    static const size_t k_max_rbuf_frame = 4096;
+    // Pipelined requests stop being executed once this much output is queued;
+    // the rest wait in rbuf until wbuf has been flushed.
+    static const size_t k_max_wbuf = 16 * 1024;
+    // Requests one connection may have in flight on other shards.
+    static const size_t k_max_pending = 1024;
+
+    Connection(int fd_, uint64_t id_)
+        : fd(fd_), id(id_), state(STATE_REQ), rbuf(4 + k_max_rbuf_frame), wbuf(2 * k_max_wbuf),
+          next_seq(0) {}
+};
 
-    static const size_t k_max_msg = 4096;
+// What to do when a write would take memory past ServerConfig::maxmemory.
+enum class EvictionPolicy {
+    NOEVICTION,    // reject the write with an OOM error
+    ALLKEYS_LRU,   // evict the least recently used key, approximately
+    ALLKEYS_LFU,   // evict the least frequently used key, approximately
+    VOLATILE_TTL,  // evict the key with a TTL closest to expiring
+};
+
+// Parses the Redis-style policy name ("allkeys-lru", ...).
+bool parse_eviction_policy(std::string_view name, EvictionPolicy& out);
+
+// Running byte totals per category, estimated from allocation sizes (see
+// server/memory.h). Bucket arrays and the TTL heap are not listed: their size
+// follows directly from the table and heap.
+struct MemoryStats {
+    size_t table_nodes = 0;  // HashTable nodes, one per key
+    size_t entries = 0;      // Entry record headers and slab rounding
+    size_t keys = 0;         // key bytes embedded in the records
+    size_t strings = 0;      // string values, inline or in their own buffer
+    size_t zsets = 0;        // ZSet objects and their encodings
+    size_t connections = 0;  // Connection objects and their I/O buffers
+
+    size_t keyspace() const { return table_nodes + entries + keys + strings + zsets; }
+    void add(const MemoryStats& o, bool subtract);
+};
 
-    explicit Connection(int fd_)
-        : fd(fd_), state(STATE_REQ), wbuf_sent(0) {
-        rbuf.reserve(4 + k_max_msg);
-        wbuf.reserve(4 + k_max_msg);
-    }
+struct ServerConfig {
+    EventBackend backend = EventBackend::EPOLL;
+    // Estimated dataset size (see Server::used_memory()) above which writes
+    // evict keys per `maxmemory_policy`; 0 means unlimited.
+    size_t maxmemory = 0;
+    EvictionPolicy maxmemory_policy = EvictionPolicy::NOEVICTION;
+    // Largest request frame accepted; a longer one closes the connection.
+    size_t max_frame = size_t(512) << 20;
+    // Where SAVE and BGSAVE write the keyspace, and where it is loaded from
+    // at startup (see server/snapshot.h).
+    std::string snapshot_path = "dump.cdb";
+    // Threads that verify and decode a snapshot at startup; 0 for one per
+    // core.
+    unsigned int load_threads = 0;
+    // Append-only log of every write (see server/aof.h), replayed at startup
+    // in place of the snapshot; empty to disable.
+    std::string aof_path;
+    AofFsync appendfsync = AofFsync::EVERYSEC;
+    // Primary to replicate from (see server/replication.h); port 0 for none.
+    // REPLICAOF changes it at run time.
+    std::string replicaof_host;
+    uint16_t replicaof_port = 0;
+    // Bytes of recent replication stream kept for replicas that reconnect.
+    size_t repl_backlog_size = size_t(1) << 20;
 };
 
 class Server {
 public:
-    Server();
+    // With a `group`, this Server is shard `shard_id` of a multi-core
+    // ShardGroup and forwards commands for keys it does not own.
+    explicit Server(const ServerConfig& config = ServerConfig(),
+                    ShardGroup* group = nullptr, unsigned int shard_id = 0);
     ~Server();
 
-    // Runs the poll loop on an already-bound+listening socket.
+    // Runs the event loop on an already-bound+listening socket until stop().
     void run(int listen_fd);
 
-    void handle_command(const std::vector<std::string>& cmd, std::string& out);
+    // Makes run() return after the current loop iteration. Safe to call from
+    // another thread.
+    void stop();
+
+    // Interrupts a blocking wait in run(). Safe to call from another thread.
+    void wake();
+
+    // `cmd` views the request buffer; only inserts copy keys and values out.
+    // `out` is usually a std::string; the event loop serializes straight into
+    // the connection's output queue.
+    void handle_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+
+    // Deletes keys whose TTL has passed, oldest deadline first, until none are
+    // due or `budget_us` microseconds have been spent. Returns the number
+    // deleted. run() calls this once per loop turn.
+    size_t active_expire(int64_t budget_us);
+
+    // Estimated bytes held by the keyspace: entries, their values, and the
+    // hash table and TTL heap that index them. Connection buffers are not
+    // included, so clients cannot cause evictions.
+    size_t used_memory() const;
+    const MemoryStats& memory_stats() const { return mem_; }
+
+    // Loads the newest snapshot saved under `path`, if there is one, into an
+    // empty keyspace. Call before run(). Returns false, with `err` set, when
+    // the snapshot is corrupt or holds a key twice. Keys whose TTL has passed
+    // since are skipped.
+    bool load_snapshot(const std::string& path, SnapshotLoadStats& stats, std::string& err);
+    // load_snapshot() into several servers, each key going to
+    // servers[route(key)]: a ShardGroup's shards. Chunks are checked and
+    // decoded into entries on ServerConfig::load_threads threads; then each
+    // server's table, sized for its share up front, takes its entries on a
+    // thread of its own. A corrupt file is found before any key is added.
+    static bool load_snapshot(const std::string& path, const std::vector<Server*>& servers,
+                              const std::function<unsigned int(std::string_view)>& route,
+                              SnapshotLoadStats& stats, std::string& err);
+
+    // Replays append-only logs (see aof_files()) into the keyspace. Call
+    // before start_aof(). Returns false, with `err` set, on a corrupt log.
+    bool load_aof(const std::vector<std::string>& files, AofLoadStats& stats, std::string& err);
+    // Runs one logged command with expiry and eviction suspended, so every
+    // command sees the keyspace it saw when it was logged.
+    void replay(const std::vector<std::string_view>& cmd);
+    // Opens ServerConfig::aof_path for appending and starts logging. With
+    // `rewrite` the log is first written afresh from the keyspace, for when
+    // it was loaded from elsewhere. run() calls this itself if nobody has.
+    bool start_aof(bool rewrite, std::string& err);
 
 private:
-    void accept_new_connection(int listen_fd);
+    void accept_new_connections(int listen_fd);
     void close_connection(Connection* conn);
+    void service_connection(Connection* conn);
     void handle_connection_io(Connection* conn);
     void handle_read(Connection* conn);
     void handle_write(Connection* conn);
+    void process_requests(Connection* conn);
+    int receive_bulk(Connection* conn);
+    void execute_request(Connection* conn, const std::vector<std::string_view>& cmd,
+                         const uint8_t* frame, uint32_t len, std::string& response);
+    void queue_reply(Connection* conn, const std::string& response);
+    void append_frame(Connection* conn, std::string_view reply);
+    void append_output(Connection* conn, std::string_view data);
+    int next_timeout_ms() const;
+
+    // Keyspace access that honors TTLs: lookup() deletes and hides an expired
+    // entry; delete_entry() also drops it from the TTL heap.
+    Entry* lookup(std::string_view key);
+    void delete_entry(Entry* entry);
+    // `owned`, if given, is a buffer holding `value` that the entry may keep
+    // instead of copying (see take_bulk_arg()).
+    Entry* assign_string(Entry* entry, std::string_view value, ValueBuffer* owned = nullptr);
+    bool set_string(std::string_view key, std::string_view value);
+    ValueBuffer* take_bulk_arg(std::string_view value);
+
+    // Memory accounting: every change to an entry is bracketed by
+    // uncharge_entry() before and charge_entry() after.
+    MemoryStats entry_breakdown(const Entry* entry) const;
+    size_t entry_memory(const Entry* entry) const { return entry_breakdown(entry).keyspace(); }
+    void charge_entry(const Entry* entry);
+    void uncharge_entry(const Entry* entry);
+    static size_t connection_memory(const Connection* conn);
+
+    // The command table: every command with its handler, arity, flags and
+    // key positions, looked up by name through a perfect hash. run_command()
+    // checks a request against its entry and calls the handler; it is the
+    // one path every command takes, from a client, a log or another shard.
+    static const CommandSpec k_commands[];
+    static const CommandSpec* find_command(std::string_view name);
+    void run_command(const CommandSpec* spec, const std::vector<std::string_view>& cmd, ReplyOut out);
+    // Handlers, each for the command of the same name (see CommandSpec).
+    void get_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void set_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void mget_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void mset_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void incr_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void decr_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void incrby_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void incrbyfloat_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void del_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void keys_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void scan_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void info_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void memory_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zadd_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zrem_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zscore_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zquery_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zrank_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zrevrank_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zrange_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void zcard_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void pexpire_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void pexpireat_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void pttl_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void incr_by(std::string_view key, int64_t delta, ReplyOut out);
+    void zrank_of(const std::vector<std::string_view>& cmd, bool reverse, ReplyOut out);
+
+    // SAVE writes the snapshot from the event loop; BGSAVE forks and lets the
+    // child write the copy-on-write image while this process keeps serving.
+    uint64_t write_snapshot(const std::string& path, std::string& err) const;
+    std::string snapshot_file_path() const;
+    void save_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void bgsave_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void finish_save(bool ok, uint64_t bytes, int64_t usec);
+    // Second half of load_snapshot(): links this server's share of the
+    // decoded chunks into the keyspace.
+    void adopt_loaded(std::vector<LoadedChunk>& chunks, unsigned int index, std::string& err);
+    // Runs `work` in a forked child; reap_child() collects it.
+    enum class ChildJob { NONE, SAVE, REWRITE, SYNC };
+    bool fork_child(ChildJob job, const std::function<bool(uint64_t& bytes, std::string& err)>& work,
+                    std::string& err);
+    void reap_child();
+    const char* child_busy_error() const;
+
+    // Append-only log: what gets logged, replies held for it under
+    // appendfsync always, and BGREWRITEAOF.
+    std::string aof_file_path() const;
+    void log_command(const std::vector<std::string_view>& cmd);
+    void evict_entry(Entry* entry);
+    // Hands a logged command to the log and to replicas.
+    void propagate(const std::vector<std::string_view>& cmd);
+    void hold_for_aof(Connection* conn);
+    void release_aof_waiters();
+    bool write_aof_rewrite(const std::string& path, uint64_t& bytes, std::string& err) const;
+    void bgrewriteaof_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void finish_rewrite(bool ok);
+
+    // Replication, primary side: PSYNC turns a connection into a replica,
+    // which is fed the stream at the end of every loop turn.
+    void psync_command(Connection* conn, const std::vector<std::string_view>& cmd);
+    void replconf_command(Connection* conn, const std::vector<std::string_view>& cmd);
+    void feed_replicas(const std::vector<std::string_view>& cmd);
+    void fork_sync();
+    void finish_sync(bool ok);
+    bool send_snapshot(Connection* conn);
+    void flush_replicas();
+    void drop_replicas();
+    std::string sync_snapshot_path() const;
+    // Replica side: the link to the primary, driven from run().
+    void replicaof_command(const std::vector<std::string_view>& cmd, ReplyOut out);
+    void replication_cron();
+    void connect_to_primary();
+    void service_primary();
+    bool consume_primary_input();
+    bool finish_full_sync();
+    void send_to_primary(const std::vector<std::string_view>& cmd);
+    void primary_link_down(const std::string& reason);
+    void clear_keyspace();
+
+    // maxmemory enforcement.
+    void touch(Entry* entry);
+    uint32_t initial_access() const;
+    uint64_t eviction_score(const Entry* entry, int64_t now) const;
+    bool evict_for_write();
+    bool evict_one();
+    uint64_t next_random();
+
+    // Cross-shard forwarding (multi-core mode only).
+    bool dispatch_remote(Connection* conn, const CommandSpec* spec, const std::vector<std::string_view>& cmd,
+                         const uint8_t* frame, uint32_t len, std::string& response);
+    void dispatch_split(Connection* conn, const CommandSpec* spec, const std::vector<std::string_view>& cmd);
+    void send_to_shard(unsigned int shard, ShardMessage&& msg);
+    void drain_shard_queues();
+    bool flush_outbox();
+    void deliver_reply(ShardMessage& msg);
+    void flush_pending(Connection* conn);
 
 private:
-    HashTable<std::string, Entry*> db_;
+    ServerConfig config_;
+    // Keys view the bytes embedded in each Entry.
+    HashTable<std::string_view, Entry*, StringHash> db_;
+    TtlHeap ttl_;
+    MemoryStats mem_;
+    uint64_t rng_;
+
+    // Best eviction candidates seen so far, ascending by eviction score.
+    struct EvictionCandidate {
+        uint64_t score;
+        std::string key;
+    };
+    std::vector<EvictionCandidate> eviction_pool_;
+    // Scratch for MGET/MSET, kept to avoid allocating per request.
+    std::vector<std::string_view> batch_keys_;
+    std::vector<Entry*> batch_entries_;
+    // Argument buffers of the bulk request being executed, if any.
+    std::vector<ValueBufferPtr>* bulk_args_ = nullptr;
+
+    // Snapshot persistence. A background child (BGSAVE or BGREWRITEAOF, one at
+    // a time) reports through child_report_, a shared anonymous mapping that
+    // survives its exit.
+    struct ChildReport {
+        uint64_t bytes;
+        int64_t usec;
+    };
+    ChildReport* child_report_ = nullptr;
+    pid_t child_pid_ = -1;
+    ChildJob child_job_ = ChildJob::NONE;
+    bool last_save_ok_ = true;
+    int64_t last_save_time_ = 0;  // Unix seconds of the last successful save
+    uint64_t last_save_bytes_ = 0;
+    int64_t last_save_usec_ = 0;
+    int64_t last_fork_usec_ = 0;
+
+    std::unique_ptr<Aof> aof_;
+    bool loading_ = false;  // replaying a log
+    // What the last PEXPIRE or PEXPIREAT did, for log_command().
+    enum class ExpireOutcome { NONE, SET, DELETED };
+    ExpireOutcome expire_outcome_ = ExpireOutcome::NONE;
+    // Connections whose replies wait for the log (appendfsync always), and
+    // replies to other shards' requests held for the same reason.
+    struct AofWaiter {
+        int fd;
+        uint64_t conn_id;
+    };
+    std::vector<AofWaiter> aof_waiters_;
+    struct HeldReply {
+        uint64_t turn;
+        unsigned int shard;
+        ShardMessage msg;
+    };
+    std::deque<HeldReply> aof_held_;
+    // Replication. The stream's id and backlog exist once a replica asked
+    // for them; primary_ while this server is a replica itself.
+    std::string repl_id_;
+    std::unique_ptr<ReplBacklog> backlog_;
+    std::vector<Connection*> replicas_;
+    std::string repl_frame_;
+    int64_t sync_retry_ms_ = 0;
+    uint64_t repl_full_syncs_ = 0;
+    uint64_t repl_partial_syncs_ = 0;
+    std::unique_ptr<PrimaryLink> primary_;
+
     std::vector<Connection*> fd2conn_;
+    std::unique_ptr<EventLoop> loop_;
+    int wake_fd_;
+    std::atomic<bool> stopping_;
+
+    ShardGroup* group_;
+    unsigned int shard_id_;
+    uint64_t next_conn_id_;
+    // Messages that did not fit their SPSC queue, and shards to wake at the end
+    // of this loop turn; both indexed by destination shard.
+    std::vector<std::deque<ShardMessage>> outbox_;
+    std::vector<bool> notify_;
 };
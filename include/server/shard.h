@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "server/spsc_queue.h"
+
+class Server;
+struct ServerConfig;
+struct SnapshotLoadStats;
+struct AofLoadStats;
+
+// A unit of cross-shard work. REQUEST carries the raw request frame body (the
+// same bytes parse_request understands) to the shard that owns its key; REPLY
+// carries the serialized response back to the connection that asked.
+struct ShardMessage {
+    enum Kind { REQUEST, REPLY };
+
+    Kind kind = REQUEST;
+    unsigned int from_shard = 0;
+    int fd = -1;             // connection on the originating shard
+    uint64_t conn_id = 0;    // guards against the fd having been reused
+    uint64_t seq = 0;        // which of the connection's pending replies this is
+    std::string payload;
+};
+
+// Shared-nothing multi-core mode: N Servers, one event-loop thread each, every
+// one owning the slice of the keyspace that hashes to it. Shards never share
+// data; they talk only through one SPSC queue per ordered (from, to) pair and
+// wake each other through their eventfds.
+class ShardGroup {
+public:
+    ShardGroup(const ServerConfig& config, unsigned int num_shards);
+    ~ShardGroup();
+
+    unsigned int size() const { return num_shards_; }
+    unsigned int shard_of(std::string_view key) const;
+    Server& shard(unsigned int i) { return *servers_[i]; }
+
+    SpscQueue<ShardMessage>& queue(unsigned int from, unsigned int to) {
+        return *queues_[from * num_shards_ + to];
+    }
+    void notify(unsigned int shard);
+
+    // Server::load_snapshot() for the whole group: every key goes to the
+    // shard that owns it, whatever shard count the snapshot was saved with.
+    bool load_snapshot(const std::string& path, SnapshotLoadStats& stats, std::string& err);
+    // Server::load_aof() for the whole group: each command is replayed on the
+    // shard that owns its key, an MSET split into one SET per key.
+    bool load_aof(const std::vector<std::string>& files, AofLoadStats& stats, std::string& err);
+    // Server::start_aof() for every shard.
+    bool start_aof(bool rewrite, std::string& err);
+
+    // Runs shard i's event loop on listen_fds[i] (sockets bound to the same
+    // port with SO_REUSEPORT). Shard 0 runs on the calling thread; returns
+    // once stop() has been called and every shard has exited.
+    void run(const std::vector<int>& listen_fds);
+    void stop();
+
+private:
+    unsigned int num_shards_;
+    std::vector<std::unique_ptr<Server>> servers_;
+    std::vector<std::unique_ptr<SpscQueue<ShardMessage>>> queues_;
+};
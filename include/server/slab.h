@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// Size-class slab allocator for the keyspace's small fixed-size objects
+// (hash table nodes, entries, sorted set tree nodes).
+//
+// Sizes are rounded up to 16-byte classes. Each class carves 64KB slabs into
+// equal objects and threads the free ones onto an intrusive list, so an
+// allocation or free is a pointer pop or push with no chunk header and no
+// locking. The free lists are thread-local: each shard thread recycles its own
+// objects. An object may be freed on a different thread than the one that
+// allocated it; it then simply joins that thread's list.
+//
+// Slabs are never returned to the system. Memory freed by deleting keys is
+// reused by later inserts of any key, but RSS does not shrink.
+static const size_t k_slab_class_bytes = 16;
+static const size_t k_slab_max_object = 2048;
+static const size_t k_slab_bytes = 64 * 1024;
+static const size_t k_slab_classes = k_slab_max_object / k_slab_class_bytes + 1;
+
+struct SlabFreeObject {
+    SlabFreeObject* next;
+};
+
+inline thread_local SlabFreeObject* slab_free_lists[k_slab_classes];
+
+// Refills class `cls` from a new slab and returns one object of it.
+void* slab_refill(size_t cls);
+
+// Bytes an object of `n` bytes occupies in its slab.
+inline size_t slab_object_size(size_t n) {
+    return (n + k_slab_class_bytes - 1) & ~(k_slab_class_bytes - 1);
+}
+
+inline void* slab_alloc(size_t n) {
+    if (n > k_slab_max_object) return ::operator new(n);
+    size_t cls = (n + k_slab_class_bytes - 1) / k_slab_class_bytes;
+    SlabFreeObject* obj = slab_free_lists[cls];
+    if (!obj) return slab_refill(cls);
+    slab_free_lists[cls] = obj->next;
+    return obj;
+}
+
+inline void slab_free(void* p, size_t n) {
+    if (!p) return;
+    if (n > k_slab_max_object) {
+        ::operator delete(p);
+        return;
+    }
+    size_t cls = (n + k_slab_class_bytes - 1) / k_slab_class_bytes;
+    SlabFreeObject* obj = static_cast<SlabFreeObject*>(p);
+    obj->next = slab_free_lists[cls];
+    slab_free_lists[cls] = obj;
+}
+
+// Base class routing a type's new/delete through the slab pools. Deleting
+// through a pointer to a different type than was allocated is not supported
+// (the sized delete would pick the wrong class).
+struct SlabAllocated {
+    static void* operator new(size_t n) { return slab_alloc(n); }
+    static void operator delete(void* p, size_t n) { slab_free(p, n); }
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Point-in-time copy of a keyspace on disk.
+//
+//   [magic "CDBSNAP\0"][version u32][shard u32][shards u32][saved_at i64][keys u64]
+//   ([records u32][crc32c u32][bytes u64] [record] * records) * chunks
+//   [0 u32][crc32c u32 of the header][0 u64]
+//
+// Records are grouped into chunks of about a megabyte that end on a record
+// boundary, each with its own checksum of the `bytes` that follow its header,
+// so a loader can verify and decode the chunks of a file on every core at
+// once. A chunk header counting no records ends the file.
+//
+// A record is a type byte, with k_snapshot_has_expiry set when an absolute expiry
+// follows, then the key and its value:
+//
+//   STRING  [type][expiry i64]? [key][value]
+//   INT     [type][expiry i64]? [key][zigzag varint]
+//   ZSET    [type][expiry i64]? [key][count varint] ([member][score f64]) * count
+//
+// Strings are a varint length and the bytes; members come in ascending
+// (score, member) order. Fixed-width fields are little-endian, like the wire
+// protocol. Expiries are Unix milliseconds, so they survive a restart.
+//
+// A ShardGroup writes one file per shard, `<path>.<shard>`, each holding the
+// keys of that shard; loading sends every key to whichever shard owns it now,
+// so a snapshot can be loaded with a different shard count.
+enum SnapshotRecordType : uint8_t {
+    SNAP_STRING = 0,
+    SNAP_INT = 1,
+    SNAP_ZSET = 2,
+};
+
+static const uint32_t k_snapshot_version = 2;
+static const uint8_t k_snapshot_has_expiry = 0x80;
+static const int64_t k_snapshot_no_expiry = -1;
+
+struct SnapshotHeader {
+    uint32_t version = k_snapshot_version;
+    uint32_t shard = 0;   // which shard's keys this file holds
+    uint32_t shards = 1;  // files in the set
+    int64_t saved_at = 0; // Unix milliseconds
+    uint64_t keys = 0;
+};
+
+// One key read back from a snapshot. Views point into the reader's mapping.
+struct SnapshotRecord {
+    SnapshotRecordType type;
+    std::string_view key;
+    std::string_view str;  // STRING
+    int64_t int_value;     // INT
+    std::vector<std::pair<std::string_view, double>> members;  // ZSET, in order
+    int64_t expire_at;     // Unix milliseconds, or k_snapshot_no_expiry
+};
+
+// Streams records to a file descriptor through a large buffer, closing a
+// chunk at the first record boundary past k_chunk_bytes. A chunk's header is
+// filled in when it closes: in the buffer if it is still there, with pwrite()
+// if a large value or sorted set already pushed it out to the file.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(int fd);
+
+    bool begin(const SnapshotHeader& header);
+    bool write_string(std::string_view key, std::string_view value, int64_t expire_at);
+    bool write_int(std::string_view key, int64_t value, int64_t expire_at);
+    // Followed by exactly `count` add_member() calls.
+    bool begin_zset(std::string_view key, size_t count, int64_t expire_at);
+    bool add_member(std::string_view member, double score);
+    // Closes the last chunk, writes the end marker and flushes; the writer is
+    // done after this.
+    bool finish();
+
+    uint64_t bytes_written() const { return written_ + buf_.size(); }
+
+    static const size_t k_chunk_bytes = size_t(1) << 20;
+
+private:
+    void put_u8(uint8_t v) { buf_.push_back(static_cast<char>(v)); }
+    void put_fixed(const void* v, size_t n) { buf_.append(static_cast<const char*>(v), n); }
+    void put_varint(uint64_t v);
+    void put_str(std::string_view s);
+    bool begin_record(SnapshotRecordType type, std::string_view key, int64_t expire_at);
+    bool end_record();
+    void open_chunk();
+    void close_chunk();
+    void checksum_buffer();
+    bool flush_if_full() { return buf_.size() < k_flush_at || flush(); }
+    bool flush();
+
+    // Past a chunk, so that chunks usually close before the buffer flushes.
+    static const size_t k_flush_at = 4 * k_chunk_bytes;
+
+    int fd_;
+    std::string buf_;
+    uint64_t written_ = 0;
+    uint32_t header_crc_ = 0;
+    bool chunk_open_ = false;
+    uint64_t chunk_start_ = 0;  // file offset of the open chunk's header
+    uint32_t chunk_records_ = 0;
+    uint32_t crc_ = 0;          // of the open chunk's bytes up to crc_pos_
+    size_t crc_pos_ = 0;        // buffer offset not yet checksummed
+    size_t members_left_ = 0;   // of the sorted set being written
+    bool failed_ = false;
+};
+
+// Maps a snapshot file and checks its header and the layout of its chunks.
+// Chunk checksums are verified as each chunk is read, so different threads
+// can verify and decode different chunks at the same time.
+class SnapshotReader {
+public:
+    SnapshotReader() = default;
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool open(const std::string& path, std::string& err);
+    const std::string& path() const { return path_; }
+    const SnapshotHeader& header() const { return header_; }
+    size_t file_size() const { return size_; }
+    size_t chunk_count() const { return chunks_.size(); }
+    uint32_t chunk_records(size_t i) const { return chunks_[i].records; }
+    // Verifies chunk `i` and calls visit(rec) for each of its records in
+    // order. Returns false, with `err` set, on a checksum mismatch or a
+    // malformed record; nothing is visited if the checksum fails.
+    bool read_chunk(size_t i, const std::function<void(const SnapshotRecord&)>& visit, std::string& err) const;
+
+private:
+    struct Chunk {
+        size_t offset;  // of the first record
+        uint64_t bytes;
+        uint32_t records;
+        uint32_t crc;
+    };
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<Chunk> chunks_;
+    SnapshotHeader header_;
+};
+
+// CRC-32C (Castagnoli) of `n` bytes, continuing from `crc` (0 to start).
+uint32_t crc32c(uint32_t crc, const void* data, size_t n);
+
+// `path` for a single server (shard < 0), `path.<shard>` for a group's shard.
+std::string snapshot_shard_path(const std::string& path, int shard);
+
+// Writes a snapshot atomically: into `path.tmp.<pid>`, fsync'd, then renamed
+// over `path`. `write_keys` emits the records; the header must already count
+// them. Returns the bytes written, or 0 with `err` set.
+uint64_t snapshot_save(const std::string& path, const SnapshotHeader& header,
+                       const std::function<bool(SnapshotWriter&)>& write_keys, std::string& err);
+
+struct SnapshotLoadStats {
+    uint64_t keys = 0;     // loaded
+    uint64_t expired = 0;  // skipped, their deadline already past
+    uint64_t bytes = 0;
+    unsigned int files = 0;
+};
+
+// Opens the newest snapshot saved under `path`, either a single server's
+// `path` or a group's `path.0` ... `path.<n-1>`, into `files`, which stays
+// empty if there is none: a missing snapshot is not an error. Headers and
+// chunk layouts are checked here; the checksums by read_chunk().
+bool snapshot_open(const std::string& path, std::vector<std::unique_ptr<SnapshotReader>>& files,
+                   std::string& err);
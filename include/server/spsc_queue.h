@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer queue.
+//
+// Used for shard-to-shard messages: exactly one event-loop thread pushes and
+// exactly one pops. head_ and tail_ live on separate cache lines, and each
+// side caches the other's index so the common case touches no shared line.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side. Returns false (leaving `item` untouched) when full.
+    bool push(T&& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) return false;
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when empty.
+    bool pop(T& out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+
+    alignas(64) std::atomic<size_t> head_{0};  // next slot to pop
+    size_t cached_tail_ = 0;                   // consumer's view of tail_
+
+    alignas(64) std::atomic<size_t> tail_{0};  // next slot to fill
+    size_t cached_head_ = 0;                   // producer's view of head_
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "server/entry.h"
+
+// Min-heap of entries ordered by expiry deadline.
+//
+// Each Entry records its own position in the heap (heap_idx), so changing or
+// clearing a deadline is O(log n) without searching. The heap only borrows the
+// entries: callers must remove() an entry before deleting it.
+class TtlHeap {
+public:
+    // Inserts `entry`, or restores heap order after its expire_at changed.
+    void update(Entry* entry);
+    void remove(Entry* entry);
+
+    Entry* top() const { return heap_.empty() ? nullptr : heap_[0]; }
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+    size_t memory_usage() const;
+
+private:
+    void set(size_t idx, Entry* entry);
+    void sift_up(size_t idx);
+    void sift_down(size_t idx);
+
+private:
+    std::vector<Entry*> heap_;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+// Heap storage for a long string value: a reference count followed by the
+// bytes. The owning Entry holds one reference and each reply still waiting
+// to send the value with writev holds another, so overwriting or deleting
+// the key never frees bytes that are queued on a socket.
+//
+// Counts are not atomic: a buffer never leaves the shard that created it
+// (replies forwarded between shards are copied).
+class ValueBuffer {
+public:
+    // A buffer for `len` bytes with one reference. The bytes are not
+    // initialized, so a large buffer's pages are only touched when written.
+    static ValueBuffer* create(size_t len) {
+        return new (::operator new(sizeof(ValueBuffer) + len)) ValueBuffer();
+    }
+    static void ref(ValueBuffer* buf) { buf->refs_++; }
+    static void unref(ValueBuffer* buf) {
+        if (buf && --buf->refs_ == 0) ::operator delete(buf);
+    }
+    // Bytes allocated for a buffer holding `len` bytes.
+    static size_t alloc_bytes(size_t len) { return sizeof(ValueBuffer) + len; }
+
+    bool shared() const { return refs_ > 1; }
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+
+private:
+    ValueBuffer() : refs_(1) {}
+
+    size_t refs_;
+};
+
+struct ValueBufferUnref {
+    void operator()(ValueBuffer* buf) const { ValueBuffer::unref(buf); }
+};
+using ValueBufferPtr = std::unique_ptr<ValueBuffer, ValueBufferUnref>;
@@ -1,27 +1,32 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "server/score_btree.h"
+#include "server/slab.h"
 
-class ZSet {
-private:
-    // Node structure for tree_by_score
-    class ScoreNode {
-    public:
-        double score;
-        std::string member;
-        int height;
-        ScoreNode* left;
-        ScoreNode* right;
-
-        ScoreNode(double s, const std::string& m)
-            : score(s), member(m), height(1), left(nullptr), right(nullptr) {}
-    };
+// Sorted set with two encodings.
+//
+// FLAT keeps every (score, member) pair in one contiguous buffer sorted by
+// (score, member), with no per-member allocation or pointers; lookups scan it
+// linearly. Sets start FLAT and convert once to TREE when they grow past
+// `max_flat_members` or receive a member longer than `max_flat_member_len`.
+// TREE indexes members twice: a B+tree by (score, member) that also answers
+// rank queries, and an AVL tree by member.
+class ZSet : public SlabAllocated {
+public:
+    enum Encoding { FLAT, TREE };
+    static const size_t k_max_flat_members = 64;
+    static const size_t k_max_flat_member_len = 64;
 
+private:
     // Node structure for tree_by_member
-    class MemberNode {
+    class MemberNode : public SlabAllocated {
     public:
         std::string member;
         double score;
@@ -29,34 +34,70 @@ private:
         MemberNode* left;
         MemberNode* right;
 
-        MemberNode(const std::string& m, double s)
+        MemberNode(std::string_view m, double s)
             : member(m), score(s), height(1), left(nullptr), right(nullptr) {}
     };
 
-    ScoreNode* tree_by_score;
+    ScoreBTree tree_by_score;
     MemberNode* tree_by_member;
 
+    // FLAT encoding: entries of [score: 8 bytes][len: 1 byte][member: len bytes].
+    Encoding encoding;
+    std::string flat;
+    size_t flat_count;
+    size_t max_flat_members;
+    size_t max_flat_member_len;
+    size_t member_heap;  // string_heap_size() of every member in tree_by_member
+
 public:
-    ZSet();
+    ZSet(size_t max_flat_members = k_max_flat_members, size_t max_flat_member_len = k_max_flat_member_len);
     ~ZSet();
 
-    bool zadd(const std::string& member, double score);
-    bool zrem(const std::string& member);
-    bool zscore(const std::string& member, double& out_score);
-    std::vector<std::pair<std::string, double>> zquery(double min_score, const std::string& min_member, int offset, int limit);
+    ZSet(const ZSet&) = delete;
+    ZSet& operator=(const ZSet&) = delete;
+
+    Encoding encoding_type() const { return encoding; }
+    // Estimated heap bytes held by this set, including the ZSet itself.
+    size_t memory_usage() const;
+
+    bool zadd(std::string_view member, double score);
+    // Fills an empty set from members in ascending (score, member) order, as
+    // a snapshot stores them: FLAT is written out in one pass and TREE built
+    // bottom up, both trees in O(n). Members out of order or repeated are
+    // added one by one with zadd() instead.
+    void load_sorted(const std::vector<std::pair<std::string_view, double>>& members);
+    bool zrem(std::string_view member);
+    bool zscore(std::string_view member, double& out_score);
+    std::vector<std::pair<std::string, double>> zquery(double min_score, std::string_view min_member, int offset, int limit);
+
+    size_t zcard() const { return encoding == FLAT ? flat_count : tree_by_score.size(); }
+    // 0-based position of `member` in ascending (score, member) order.
+    bool zrank(std::string_view member, size_t& out_rank);
+    // Members at ranks [start, stop], inclusive. Negative indexes count back
+    // from the highest rank (-1 is the last member).
+    std::vector<std::pair<std::string, double>> zrange(int64_t start, int64_t stop);
+    // Calls visit(member, score) for every member in ascending (score,
+    // member) order, without copying.
+    template <typename F> void for_each(F&& visit) const {
+        if (encoding == FLAT) {
+            for (size_t pos = 0; pos < flat.size(); pos = flatNext(pos)) visit(flatMember(pos), flatScore(pos));
+        } else {
+            tree_by_score.for_each(visit);
+        }
+    }
 
 private:
-    // AVL tree functions for ScoreNode
-    int height(ScoreNode* node);
-    void updateHeight(ScoreNode* node);
-    int balanceFactor(ScoreNode* node);
-    ScoreNode* rotateLeft(ScoreNode* x);
-    ScoreNode* rotateRight(ScoreNode* y);
-    ScoreNode* balance(ScoreNode* node);
-    ScoreNode* insert(ScoreNode* node, double score, const std::string& member);
-    ScoreNode* remove(ScoreNode* node, double score, const std::string& member);
-    void inorder(ScoreNode* node, double min_score, const std::string& min_member, int& offset, int limit, std::vector<std::pair<std::string, double>>& result);
-    void destroy(ScoreNode* node);
+    // FLAT encoding helpers; positions are byte offsets into `flat`.
+    static const size_t k_flat_header = sizeof(double) + 1;
+    double flatScore(size_t pos) const;
+    std::string_view flatMember(size_t pos) const;
+    size_t flatNext(size_t pos) const { return pos + k_flat_header + (uint8_t)flat[pos + sizeof(double)]; }
+    size_t flatFind(std::string_view member) const;
+    size_t flatLowerBound(double score, std::string_view member, size_t& rank) const;
+    void flatInsert(double score, std::string_view member);
+    void flatErase(size_t pos);
+    void flatCollect(size_t pos, size_t limit, std::vector<std::pair<std::string, double>>& result) const;
+    void convertToTree();
 
     // AVL tree functions for MemberNode
     int height(MemberNode* node);
@@ -65,9 +106,11 @@ private:
     MemberNode* rotateLeft(MemberNode* x);
     MemberNode* rotateRight(MemberNode* y);
     MemberNode* balance(MemberNode* node);
-    MemberNode* insert(MemberNode* node, const std::string& member, double score);
-    MemberNode* remove(MemberNode* node, const std::string& member);
-    MemberNode* find(MemberNode* node, const std::string& member);
+    MemberNode* insert(MemberNode* node, std::string_view member, double score);
+    MemberNode* remove(MemberNode* node, std::string_view member);
+    MemberNode* find(MemberNode* node, std::string_view member);
+    MemberNode* buildBalanced(const std::vector<std::pair<std::string_view, double>>& members,
+                              const uint32_t* by_member, size_t n);
     void destroy(MemberNode* node);
 };
 
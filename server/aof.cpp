@@ -0,0 +1,319 @@
+#include "server/aof.h"
+#include "server/protocol.h"
+#include "server/snapshot.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool parse_aof_fsync(std::string_view name, AofFsync& out) {
+    if (name == "always") out = AofFsync::ALWAYS;
+    else if (name == "everysec") out = AofFsync::EVERYSEC;
+    else if (name == "no") out = AofFsync::NO;
+    else return false;
+    return true;
+}
+
+// ===== Aof =====
+
+Aof::Aof(int fd, uint64_t size, AofFsync policy, std::function<void()> on_durable)
+    : fd_(fd), policy_(policy), on_durable_(std::move(on_durable)),
+      last_sync_(std::chrono::steady_clock::now()), size_(size) {
+    writer_ = std::thread([this] { writer_main(); });
+}
+
+Aof::~Aof() {
+    end_turn();
+    if (rewrite_open_) abort_rewrite();
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    writer_.join();
+    ::close(fd_);
+}
+
+void Aof::append(const std::vector<std::string_view>& cmd) {
+    size_t start = turn_buf_.size();
+    append_request_frame(turn_buf_, cmd);
+    if (rewrite_open_) rewrite_buf_.append(turn_buf_, start, std::string::npos);
+}
+
+void Aof::end_turn() {
+    if (!turn_buf_.empty()) hand_off(nullptr);
+}
+
+// Moves the turn's commands, and a rewrite to switch to after them, to the
+// writer. Swapping keeps both buffers' capacity in use. Turns queued behind a
+// switch the writer has not taken yet are in neither its tail nor the old
+// log once it is replaced, so the writer puts them in the new log.
+void Aof::hand_off(std::unique_ptr<Switch> sw) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (queued_.empty()) queued_.swap(turn_buf_);
+        else queued_ += turn_buf_;
+        queued_turn_ = turn_;
+        if (sw) {
+            switch_ = std::move(sw);
+            switch_at_ = queued_.size();
+        }
+    }
+    turn_buf_.clear();
+    cv_.notify_one();
+    turn_++;
+}
+
+void Aof::begin_rewrite() {
+    rewrite_buf_.clear();
+    rewrite_open_ = true;
+    rewriting_.store(true, std::memory_order_release);
+}
+
+void Aof::finish_rewrite(int fd, const std::string& tmp, const std::string& path) {
+    auto sw = std::make_unique<Switch>(Switch{fd, std::move(rewrite_buf_), tmp, path});
+    rewrite_buf_ = std::string();
+    rewrite_open_ = false;
+    hand_off(std::move(sw));
+}
+
+void Aof::abort_rewrite() {
+    rewrite_buf_ = std::string();
+    rewrite_open_ = false;
+    last_rewrite_ok_.store(false, std::memory_order_relaxed);
+    rewriting_.store(false, std::memory_order_release);
+}
+
+Aof::Stats Aof::stats() const {
+    return Stats{size_.load(std::memory_order_relaxed), writes_.load(std::memory_order_relaxed),
+                 fsyncs_.load(std::memory_order_relaxed), last_write_ok_.load(std::memory_order_relaxed),
+                 last_rewrite_ok_.load(std::memory_order_relaxed)};
+}
+
+void Aof::writer_main() {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+        // A batch, or at least a tick a second so EVERYSEC syncs a log that
+        // went quiet.
+        cv_.wait_for(lock, std::chrono::seconds(1), [this] { return stopping_ || !queued_.empty() || switch_; });
+        size_t switch_at = unwritten_.size() + switch_at_;
+        if (unwritten_.empty()) {
+            unwritten_.swap(queued_);
+        } else {
+            unwritten_ += queued_;
+            queued_.clear();
+        }
+        uint64_t turn = queued_turn_;
+        std::unique_ptr<Switch> sw = std::move(switch_);
+        // What was logged after the switch goes to whichever log is in use
+        // once it has been applied.
+        std::string after_switch;
+        if (sw) {
+            after_switch.assign(unwritten_, switch_at, std::string::npos);
+            unwritten_.resize(switch_at);
+        }
+        bool stopping = stopping_;
+        lock.unlock();
+
+        bool ok = write_out(fd_, unwritten_);
+        bool sync_now = policy_ == AofFsync::ALWAYS || stopping || sw ||
+                        (policy_ == AofFsync::EVERYSEC &&
+                         std::chrono::steady_clock::now() - last_sync_ >= std::chrono::seconds(1));
+        if (ok && unsynced_ && sync_now) ok = sync(fd_);
+        // The new log holds everything, so it also makes up for a failed
+        // write to the old one.
+        if (sw && apply_switch(*sw)) {
+            unwritten_.clear();
+            ok = true;
+        }
+        if (!after_switch.empty()) {
+            unwritten_ += after_switch;
+            ok = write_out(fd_, unwritten_);
+            if (ok && unsynced_ && sync_now) ok = sync(fd_);
+        }
+        last_write_ok_.store(ok, std::memory_order_relaxed);
+        if (ok && turn > durable_turn_.load(std::memory_order_relaxed)) {
+            durable_turn_.store(turn, std::memory_order_release);
+            if (policy_ == AofFsync::ALWAYS && on_durable_) on_durable_();
+        }
+
+        lock.lock();
+        if (stopping_ && ((queued_.empty() && !switch_) || !ok)) break;
+        // Keep what failed to go out and try again in a second.
+        if (!ok) cv_.wait_for(lock, std::chrono::seconds(1), [this] { return stopping_; });
+    }
+}
+
+// Writes all of `data` with as few write() calls as the kernel allows. On
+// failure the part not written stays in `data`.
+bool Aof::write_out(int fd, std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            data.erase(0, done);
+            return false;
+        }
+        done += static_cast<size_t>(n);
+        size_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    }
+    if (done) {
+        writes_.fetch_add(1, std::memory_order_relaxed);
+        unsynced_ = true;
+    }
+    data.clear();
+    return true;
+}
+
+bool Aof::sync(int fd) {
+    if (::fdatasync(fd) < 0) return false;
+    fsyncs_.fetch_add(1, std::memory_order_relaxed);
+    unsynced_ = false;
+    last_sync_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+// Completes a rewrite: the child's file gets the commands logged since the
+// fork, is synced, and replaces the log. Until the rename the old log stays
+// complete, so a failure anywhere leaves it in use.
+bool Aof::apply_switch(Switch& sw) {
+    struct stat st;
+    bool ok = write_out(sw.fd, sw.tail) && ::fdatasync(sw.fd) == 0 && ::fstat(sw.fd, &st) == 0 &&
+              ::rename(sw.tmp.c_str(), sw.path.c_str()) == 0;
+    if (ok) {
+        ::close(fd_);
+        fd_ = sw.fd;
+        size_.store(static_cast<uint64_t>(st.st_size), std::memory_order_relaxed);
+        fsyncs_.fetch_add(1, std::memory_order_relaxed);
+        unsynced_ = false;
+    } else {
+        ::close(sw.fd);
+        ::unlink(sw.tmp.c_str());
+    }
+    last_rewrite_ok_.store(ok, std::memory_order_relaxed);
+    rewriting_.store(false, std::memory_order_release);
+    return ok;
+}
+
+// ===== Rewrite files =====
+
+bool AofFileWriter::add(const std::vector<std::string_view>& cmd) {
+    append_request_frame(buf_, cmd);
+    return buf_.size() < k_flush_at || flush();
+}
+
+bool AofFileWriter::flush() {
+    const char* data = buf_.data();
+    size_t n = buf_.size();
+    while (!failed_ && n > 0) {
+        ssize_t rv = ::write(fd_, data, n);
+        if (rv < 0) {
+            if (errno != EINTR) failed_ = true;
+            continue;
+        }
+        data += rv;
+        n -= static_cast<size_t>(rv);
+    }
+    written_ += buf_.size();
+    buf_.clear();
+    return !failed_;
+}
+
+bool AofFileWriter::finish() {
+    return flush() && ::fdatasync(fd_) == 0;
+}
+
+bool aof_write_file(const std::string& path, const std::function<bool(AofFileWriter&)>& write_cmds,
+                    uint64_t& bytes, std::string& err) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        err = "cannot create " + path + ": " + strerror(errno);
+        return false;
+    }
+    AofFileWriter writer(fd);
+    bool ok = write_cmds(writer) && writer.finish();
+    int saved_errno = errno;
+    ::close(fd);
+    if (!ok) {
+        err = "cannot write " + path + ": " + strerror(saved_errno);
+        ::unlink(path.c_str());
+        return false;
+    }
+    bytes = writer.bytes_written();
+    return true;
+}
+
+// ===== Loading =====
+
+std::vector<std::string> aof_files(const std::string& path) {
+    std::vector<std::string> files;
+    if (::access(path.c_str(), F_OK) == 0) files.push_back(path);
+    for (int shard = 0;; ++shard) {
+        std::string shard_path = snapshot_shard_path(path, shard);
+        if (::access(shard_path.c_str(), F_OK) != 0) break;
+        files.push_back(shard_path);
+    }
+    return files;
+}
+
+bool aof_replay(const std::string& path, const std::function<void(const std::vector<std::string_view>&)>& apply,
+                AofLoadStats& stats, std::string& err) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        err = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        err = "cannot stat " + path + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    const uint8_t* data = nullptr;
+    if (size > 0) {
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            err = "cannot map " + path + ": " + strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        ::madvise(map, size, MADV_SEQUENTIAL);
+        data = static_cast<const uint8_t*>(map);
+    }
+
+    bool ok = true;
+    size_t pos = 0;
+    std::vector<std::string_view> cmd;
+    while (size - pos >= 4) {
+        uint32_t len = 0;
+        std::memcpy(&len, data + pos, 4);
+        if (len > size - pos - 4) break;  // torn
+        cmd.clear();
+        if (parse_request(data + pos + 4, len, cmd) != 0 || cmd.empty()) {
+            err = path + ": malformed command at offset " + std::to_string(pos);
+            ok = false;
+            break;
+        }
+        apply(cmd);
+        stats.commands++;
+        pos += 4 + len;
+    }
+    if (data) ::munmap(const_cast<uint8_t*>(data), size);
+
+    if (ok && pos < size) {
+        if (::ftruncate(fd, static_cast<off_t>(pos)) < 0) {
+            err = "cannot truncate " + path + ": " + strerror(errno);
+            ok = false;
+        }
+        stats.truncated += size - pos;
+    }
+    ::close(fd);
+    stats.bytes += pos;
+    stats.files++;
+    return ok;
+}
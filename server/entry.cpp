@@ -0,0 +1,151 @@
+#include "server/entry.h"
+#include "server/memory.h"
+#include "server/slab.h"
+
+#include <cassert>
+#include <charconv>
+#include <cstring>
+
+static_assert(sizeof(Entry) == 32, "Entry header should stay at 32 bytes");
+
+Entry::Entry(std::string_view key, Type type)
+    : expire_at(k_no_expiry), heap_idx(k_no_heap_idx), access(0),
+      key_len_(static_cast<uint32_t>(key.size())), type_(type), encoding_(INLINE), value_len_(0),
+      heap_value_(nullptr) {
+    // key_len_ is 29 bits; commands refuse longer keys before they get here.
+    assert(key.size() <= k_max_key_len);
+    std::memcpy(data(), key.data(), key.size());
+}
+
+Entry::~Entry() {
+    if (type_ == ZSET) delete zset_;
+    else if (encoding_ == HEAP) ValueBuffer::unref(heap_value_);
+}
+
+size_t Entry::record_size(size_t key_len, size_t inline_len) {
+    return sizeof(Entry) + key_len + inline_len;
+}
+
+// Bytes actually reserved for a record of `n` bytes: a slab object, or an
+// exact-size heap block past the largest slab class.
+static size_t record_capacity(size_t n) {
+    return n <= k_slab_max_object ? slab_object_size(n) : n;
+}
+
+bool Entry::parse_int(std::string_view s, int64_t& out) {
+    if (s.empty() || s.size() > k_max_int_chars) return false;
+    size_t digits = s[0] == '-' ? 1 : 0;
+    // "0" is canonical; "00", "01", "-0" and "-" are not.
+    if (digits == s.size() || (s[digits] == '0' && (s.size() > 1))) return false;
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return ec == std::errc() && ptr == s.data() + s.size();
+}
+
+Entry::Encoding Entry::encoding_for(std::string_view value, int64_t& as_int) {
+    if (parse_int(value, as_int)) return INT;
+    return value.size() <= k_max_inline_value ? INLINE : HEAP;
+}
+
+Entry* Entry::make_string(std::string_view key, std::string_view value, ValueBuffer* owned) {
+    int64_t as_int = 0;
+    Encoding encoding = encoding_for(value, as_int);
+    if (encoding != HEAP) ValueBuffer::unref(owned);
+    if (encoding == INT) return make_int(key, as_int);
+
+    void* mem = slab_alloc(record_size(key.size(), encoding == INLINE ? value.size() : 0));
+    Entry* entry = new (mem) Entry(key, STRING);
+    entry->encoding_ = encoding;
+    entry->value_len_ = static_cast<uint32_t>(value.size());
+    if (encoding == INLINE) {
+        std::memcpy(entry->data() + key.size(), value.data(), value.size());
+    } else if (owned) {
+        entry->heap_value_ = owned;
+    } else {
+        entry->heap_value_ = ValueBuffer::create(value.size());
+        std::memcpy(entry->heap_value_->data(), value.data(), value.size());
+    }
+    return entry;
+}
+
+Entry* Entry::make_int(std::string_view key, int64_t value) {
+    void* mem = slab_alloc(record_size(key.size(), 0));
+    Entry* entry = new (mem) Entry(key, STRING);
+    entry->encoding_ = INT;
+    entry->int_ = value;
+    return entry;
+}
+
+Entry* Entry::make_zset(std::string_view key) {
+    void* mem = slab_alloc(record_size(key.size(), 0));
+    Entry* entry = new (mem) Entry(key, ZSET);
+    entry->zset_ = new ZSet();
+    return entry;
+}
+
+void Entry::operator delete(Entry* entry, std::destroying_delete_t) {
+    size_t bytes = record_size(entry->key_len_, entry->inline_len());
+    entry->~Entry();
+    slab_free(entry, bytes);
+}
+
+std::string_view Entry::str_value(char* scratch) const {
+    switch (encoding_) {
+        case INLINE: return {data() + key_len_, value_len_};
+        case HEAP: return {heap_value_->data(), value_len_};
+        default: {
+            char* end = std::to_chars(scratch, scratch + k_max_int_chars, int_).ptr;
+            return {scratch, static_cast<size_t>(end - scratch)};
+        }
+    }
+}
+
+bool Entry::assign_value(std::string_view value, ValueBuffer* owned) {
+    if (type_ != STRING) return false;
+    int64_t as_int = 0;
+    Encoding encoding = encoding_for(value, as_int);
+    // Only within the same allocation size, so the delete still finds the
+    // right free list.
+    size_t new_inline = encoding == INLINE ? value.size() : 0;
+    if (record_capacity(record_size(key_len_, new_inline)) !=
+        record_capacity(record_size(key_len_, inline_len()))) {
+        return false;
+    }
+
+    // A HEAP buffer of the right size is reused unless one is handed over,
+    // or a queued reply is still sending it; anything else is dropped.
+    if (encoding != HEAP) ValueBuffer::unref(owned);
+    ValueBuffer* buffer = nullptr;
+    if (encoding_ == HEAP) {
+        bool reusable = encoding == HEAP && value.size() == value_len_ && !owned && !heap_value_->shared();
+        if (reusable) buffer = heap_value_;
+        else ValueBuffer::unref(heap_value_);
+    }
+    encoding_ = encoding;
+    value_len_ = encoding == INT ? 0 : static_cast<uint32_t>(value.size());
+    switch (encoding) {
+        case INT:
+            int_ = as_int;
+            break;
+        case INLINE:
+            std::memcpy(data() + key_len_, value.data(), value.size());
+            break;
+        case HEAP:
+            if (owned) {
+                heap_value_ = owned;
+                break;
+            }
+            heap_value_ = buffer ? buffer : ValueBuffer::create(value.size());
+            std::memcpy(heap_value_->data(), value.data(), value.size());
+            break;
+    }
+    return true;
+}
+
+size_t Entry::record_bytes() const {
+    size_t n = record_size(key_len_, inline_len());
+    return n <= k_slab_max_object ? slab_object_size(n) : alloc_size(n);
+}
+
+size_t Entry::value_heap_bytes() const {
+    return type_ == STRING && encoding_ == HEAP ? alloc_size(ValueBuffer::alloc_bytes(value_len_)) : 0;
+}
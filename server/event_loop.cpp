@@ -0,0 +1,115 @@
+#include "server/event_loop.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+std::unique_ptr<EventLoop> EventLoop::create(EventBackend backend) {
+    if (backend == EventBackend::POLL) {
+        return std::make_unique<PollLoop>();
+    }
+    return std::make_unique<EpollLoop>();
+}
+
+// ===== poll(2) =====
+
+static short poll_events(Interest interest) {
+    return (interest == Interest::READ ? POLLIN : POLLOUT) | POLLERR;
+}
+
+void PollLoop::add(int fd, Interest interest) {
+    if (fd2slot_.size() <= (size_t)fd) {
+        fd2slot_.resize(fd + 1, -1);
+    }
+    fd2slot_[fd] = static_cast<int>(pollfds_.size());
+    pollfds_.push_back({fd, poll_events(interest), 0});
+}
+
+void PollLoop::modify(int fd, Interest interest) {
+    pollfds_[fd2slot_[fd]].events = poll_events(interest);
+}
+
+void PollLoop::remove(int fd) {
+    if ((size_t)fd >= fd2slot_.size() || fd2slot_[fd] < 0) return;
+    int slot = fd2slot_[fd];
+    pollfds_[slot] = pollfds_.back();
+    fd2slot_[pollfds_[slot].fd] = slot;
+    pollfds_.pop_back();
+    fd2slot_[fd] = -1;
+}
+
+int PollLoop::wait(std::vector<IoEvent>& events, int timeout_ms) {
+    events.clear();
+    int rv = ::poll(pollfds_.data(), pollfds_.size(), timeout_ms);
+    if (rv <= 0) return rv;
+
+    for (const pollfd& pfd : pollfds_) {
+        if (!pfd.revents) continue;
+        events.push_back({pfd.fd,
+                          (pfd.revents & POLLIN) != 0,
+                          (pfd.revents & POLLOUT) != 0,
+                          (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0});
+        if ((int)events.size() == rv) break;
+    }
+    return static_cast<int>(events.size());
+}
+
+// ===== epoll(7), edge-triggered =====
+
+static uint32_t epoll_events(Interest interest) {
+    return (interest == Interest::READ ? EPOLLIN : EPOLLOUT) | EPOLLET;
+}
+
+EpollLoop::EpollLoop() : epfd_(::epoll_create1(EPOLL_CLOEXEC)) {
+    if (epfd_ < 0) {
+        perror("epoll_create1");
+        exit(1);
+    }
+    ready_.resize(256);
+}
+
+EpollLoop::~EpollLoop() {
+    ::close(epfd_);
+}
+
+void EpollLoop::add(int fd, Interest interest) {
+    epoll_event ev{};
+    ev.events = epoll_events(interest);
+    ev.data.fd = fd;
+    if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("epoll_ctl(ADD)");
+    }
+}
+
+void EpollLoop::modify(int fd, Interest interest) {
+    // EPOLL_CTL_MOD re-evaluates readiness, so an fd that became readable while
+    // we were only waiting for POLLOUT still produces an edge after the flip.
+    epoll_event ev{};
+    ev.events = epoll_events(interest);
+    ev.data.fd = fd;
+    if (::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        perror("epoll_ctl(MOD)");
+    }
+}
+
+void EpollLoop::remove(int fd) {
+    ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EpollLoop::wait(std::vector<IoEvent>& events, int timeout_ms) {
+    events.clear();
+    int rv = ::epoll_wait(epfd_, ready_.data(), static_cast<int>(ready_.size()), timeout_ms);
+    if (rv <= 0) return rv;
+
+    for (int i = 0; i < rv; ++i) {
+        const epoll_event& ev = ready_[i];
+        events.push_back({ev.data.fd,
+                          (ev.events & EPOLLIN) != 0,
+                          (ev.events & EPOLLOUT) != 0,
+                          (ev.events & (EPOLLERR | EPOLLHUP)) != 0});
+    }
+    if (rv == (int)ready_.size()) {
+        ready_.resize(ready_.size() * 2);
+    }
+    return rv;
+}
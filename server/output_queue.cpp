@@ -0,0 +1,86 @@
+#include "server/output_queue.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <sys/uio.h>
+
+// iovecs per writev; shared values past this wait for the next call.
+static const int k_max_iov = std::min(IOV_MAX, 64);
+
+OutputQueue::~OutputQueue() {
+    for (Shared& s : shared_) ValueBuffer::unref(s.buf);
+}
+
+void OutputQueue::append_shared(ValueBuffer* buf, size_t len) {
+    if (len < k_min_shared) {
+        ring_.append(buf->data(), len);
+        return;
+    }
+    ValueBuffer::ref(buf);
+    shared_.push_back({ring_end(), buf, len, 0});
+    shared_bytes_ += len;
+}
+
+OutputQueue::FrameMark OutputQueue::begin_frame() {
+    FrameMark mark{ring_.size(), 0};
+    uint32_t placeholder = 0;
+    ring_.append(&placeholder, 4);
+    mark.size = size();
+    return mark;
+}
+
+void OutputQueue::end_frame(FrameMark mark) {
+    uint32_t len = static_cast<uint32_t>(size() - mark.size);
+    ring_.overwrite(mark.ring_offset, &len, 4);
+}
+
+ssize_t OutputQueue::write_to(int fd) {
+    iovec iov[k_max_iov];
+    int count = 0;
+    size_t offset = 0;  // into the ring
+    bool all_shared = true;
+    for (const Shared& s : shared_) {
+        // Up to two ring iovecs before the value, plus the value itself.
+        if (count + 3 > k_max_iov) {
+            all_shared = false;
+            break;
+        }
+        size_t until = static_cast<size_t>(s.at - ring_written());
+        count += ring_.segments(offset, until - offset, iov + count);
+        offset = until;
+        iov[count++] = {s.buf->data() + s.sent, s.len - s.sent};
+    }
+    // Ring bytes past a value that is not in this batch must wait for it.
+    if (all_shared && count + 2 <= k_max_iov) {
+        count += ring_.segments(offset, ring_.size() - offset, iov + count);
+    }
+
+    ssize_t n = ::writev(fd, iov, count);
+    if (n > 0) consume(static_cast<size_t>(n));
+    return n;
+}
+
+// Consumes `n` written bytes in stream order: ring bytes up to the next
+// shared value, then that value, and so on.
+void OutputQueue::consume(size_t n) {
+    while (n > 0) {
+        size_t before = shared_.empty() ? ring_.size()
+                                        : static_cast<size_t>(shared_.front().at - ring_written());
+        size_t take = std::min(n, before);
+        ring_.consume(take);
+        ring_consumed_ += take;
+        n -= take;
+        if (n == 0 || shared_.empty()) break;
+
+        Shared& s = shared_.front();
+        take = std::min(n, s.len - s.sent);
+        s.sent += take;
+        shared_bytes_ -= take;
+        n -= take;
+        if (s.sent == s.len) {
+            ValueBuffer::unref(s.buf);
+            shared_.pop_front();
+        }
+    }
+}
@@ -1,49 +1,56 @@
 #include "server/protocol.h"
 #include <cstring>
 
-void out_string(std::string& out, const std::string& str) {
+void out_string(ReplyOut out, std::string_view str) {
     out.push_back(SER_STR);
     uint32_t len = static_cast<uint32_t>(str.size());
-    out.append((char*)&len, 4);
+    out.append(&len, 4);
     out.append(str);
 }
 
-void out_nil(std::string& out) {
+void out_shared_string(ReplyOut out, ValueBuffer* buf, size_t len) {
+    out.push_back(SER_STR);
+    uint32_t n = static_cast<uint32_t>(len);
+    out.append(&n, 4);
+    out.append_shared(buf, len);
+}
+
+void out_nil(ReplyOut out) {
     out.push_back(SER_NIL);
 }
 
-void out_int(std::string& out, int64_t val) {
+void out_int(ReplyOut out, int64_t val) {
     out.push_back(SER_INT);
-    out.append((char*)&val, 8);
+    out.append(&val, 8);
 }
 
-void out_error(std::string& out, const std::string& msg) {
+void out_error(ReplyOut out, std::string_view msg) {
     out.push_back(SER_ERR);
     uint32_t len = static_cast<uint32_t>(msg.size());
-    out.append((char*)&len, 4);
+    out.append(&len, 4);
     out.append(msg);
 }
 
-void out_ok(std::string& out) {
+void out_ok(ReplyOut out) {
     out_string(out, "OK");
 }
 
-void out_array(std::string& out, const std::vector<std::string>& arr) {
+void out_array(ReplyOut out, const std::vector<std::string>& arr) {
     out.push_back(SER_ARR);
     uint32_t len = static_cast<uint32_t>(arr.size());
-    out.append((char*)&len, 4);
+    out.append(&len, 4);
     for (const std::string& s : arr) {
         out_string(out, s);
     }
 }
 
-void out_double(std::string& out, double val) {
+void out_double(ReplyOut out, double val) {
     out.push_back(SER_DBL);
-    out.append((char*)&val, 8);
+    out.append(&val, 8);
 }
 
-// Parsing request from client (unchanged)
-int parse_request(const uint8_t* data, size_t len, std::vector<std::string>& out) {
+// Parsing request from client. Arguments are views into `data`; nothing is copied.
+int parse_request(const uint8_t* data, size_t len, std::vector<std::string_view>& out) {
     if (len < 4) return -1;
     uint32_t argc = 0;
     std::memcpy(&argc, data, 4);
@@ -56,9 +63,22 @@ int parse_request(const uint8_t* data, size_t len, std::vector<std::string>& out
         std::memcpy(&arg_len, data + pos, 4);
         pos += 4;
         if (pos + arg_len > len) return -1;
-        out.emplace_back((char*)data + pos, arg_len);
+        out.emplace_back((const char*)data + pos, arg_len);
         pos += arg_len;
     }
     if (pos != len) return -1;
     return 0;
 }
+
+void append_request_frame(std::string& out, const std::vector<std::string_view>& cmd) {
+    uint32_t len = 4;
+    for (std::string_view arg : cmd) len += 4 + static_cast<uint32_t>(arg.size());
+    uint32_t argc = static_cast<uint32_t>(cmd.size());
+    out.append((const char*)&len, 4);
+    out.append((const char*)&argc, 4);
+    for (std::string_view arg : cmd) {
+        uint32_t n = static_cast<uint32_t>(arg.size());
+        out.append((const char*)&n, 4);
+        out.append(arg);
+    }
+}
@@ -0,0 +1,49 @@
+#include "server/replication.h"
+
+#include <cstring>
+#include <random>
+#include <unistd.h>
+
+void ReplBacklog::append(std::string_view data) {
+    size_t cap = buf_.size();
+    // Only the last `cap` bytes can survive.
+    if (data.size() > cap) {
+        end_ += data.size() - cap;
+        data.remove_prefix(data.size() - cap);
+    }
+    size_t at = static_cast<size_t>(end_ % cap);
+    size_t first = std::min(data.size(), cap - at);
+    std::memcpy(buf_.data() + at, data.data(), first);
+    std::memcpy(buf_.data(), data.data() + first, data.size() - first);
+    end_ += data.size();
+}
+
+void ReplBacklog::copy_from(uint64_t offset, std::string& out) const {
+    size_t cap = buf_.size();
+    size_t n = static_cast<size_t>(end_ - offset);
+    size_t at = static_cast<size_t>(offset % cap);
+    size_t first = std::min(n, cap - at);
+    out.append(buf_.data() + at, first);
+    out.append(buf_.data(), n - first);
+}
+
+std::string new_repl_id() {
+    static const char k_hex[] = "0123456789abcdef";
+    std::random_device rd;
+    std::mt19937_64 rng((uint64_t(rd()) << 32) ^ rd());
+    std::string id(40, '0');
+    for (char& c : id) c = k_hex[rng() & 15];
+    return id;
+}
+
+ReplicaLink::~ReplicaLink() {
+    if (snapshot_fd >= 0) ::close(snapshot_fd);
+}
+
+PrimaryLink::~PrimaryLink() {
+    if (fd >= 0) ::close(fd);
+    if (snapshot_fd >= 0) {
+        ::close(snapshot_fd);
+        ::unlink(snapshot_tmp.c_str());
+    }
+}
@@ -0,0 +1,108 @@
+#include "server/ring_buffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/uio.h>
+
+static size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+RingBuffer::RingBuffer(size_t capacity)
+    : data_(nullptr), capacity_(round_up_pow2(capacity ? capacity : 1)), head_(0), size_(0) {
+    data_ = static_cast<uint8_t*>(std::malloc(capacity_));
+    if (!data_) throw std::bad_alloc();
+}
+
+RingBuffer::~RingBuffer() {
+    std::free(data_);
+}
+
+ssize_t RingBuffer::read_from(int fd) {
+    size_t tail = mask(head_ + size_);
+    size_t free_bytes = free_space();
+    size_t first = std::min(free_bytes, capacity_ - tail);
+
+    iovec iov[2];
+    iov[0] = {data_ + tail, first};
+    iov[1] = {data_, free_bytes - first};
+    int iovcnt = iov[1].iov_len ? 2 : 1;
+
+    ssize_t n = ::readv(fd, iov, iovcnt);
+    if (n > 0) size_ += static_cast<size_t>(n);
+    return n;
+}
+
+ssize_t RingBuffer::write_to(int fd) {
+    size_t first = std::min(size_, capacity_ - head_);
+
+    iovec iov[2];
+    iov[0] = {data_ + head_, first};
+    iov[1] = {data_, size_ - first};
+    int iovcnt = iov[1].iov_len ? 2 : 1;
+
+    ssize_t n = ::writev(fd, iov, iovcnt);
+    if (n > 0) consume(static_cast<size_t>(n));
+    return n;
+}
+
+void RingBuffer::append(const void* data, size_t n) {
+    if (n > free_space()) reserve(size_ + n);
+    size_t tail = mask(head_ + size_);
+    size_t first = std::min(n, capacity_ - tail);
+    std::memcpy(data_ + tail, data, first);
+    std::memcpy(data_, static_cast<const uint8_t*>(data) + first, n - first);
+    size_ += n;
+}
+
+void RingBuffer::peek(size_t offset, void* out, size_t n) const {
+    size_t start = mask(head_ + offset);
+    size_t first = std::min(n, capacity_ - start);
+    std::memcpy(out, data_ + start, first);
+    std::memcpy(static_cast<uint8_t*>(out) + first, data_, n - first);
+}
+
+void RingBuffer::overwrite(size_t offset, const void* data, size_t n) {
+    size_t start = mask(head_ + offset);
+    size_t first = std::min(n, capacity_ - start);
+    std::memcpy(data_ + start, data, first);
+    std::memcpy(data_, static_cast<const uint8_t*>(data) + first, n - first);
+}
+
+int RingBuffer::segments(size_t offset, size_t n, iovec* out) const {
+    if (n == 0) return 0;
+    size_t start = mask(head_ + offset);
+    size_t first = std::min(n, capacity_ - start);
+    out[0] = {data_ + start, first};
+    if (first == n) return 1;
+    out[1] = {data_, n - first};
+    return 2;
+}
+
+const uint8_t* RingBuffer::contiguous(size_t offset, size_t n) const {
+    size_t start = mask(head_ + offset);
+    return start + n <= capacity_ ? data_ + start : nullptr;
+}
+
+void RingBuffer::consume(size_t n) {
+    head_ = mask(head_ + n);
+    size_ -= n;
+    // Rewind when empty so the next frame is likely to land contiguously.
+    if (size_ == 0) head_ = 0;
+}
+
+void RingBuffer::reserve(size_t n) {
+    if (n <= capacity_) return;
+    size_t new_capacity = round_up_pow2(n);
+    uint8_t* new_data = static_cast<uint8_t*>(std::malloc(new_capacity));
+    if (!new_data) throw std::bad_alloc();
+    peek(0, new_data, size_);
+    std::free(data_);
+    data_ = new_data;
+    capacity_ = new_capacity;
+    head_ = 0;
+}
@@ -0,0 +1,469 @@
+#include "server/score_btree.h"
+#include "server/memory.h"
+
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The root leaf is allocated on first insert, so an unused index costs nothing.
+ScoreBTree::ScoreBTree() : root(nullptr), total(0), leaves(0), inners(0), member_heap(0) {}
+
+ScoreBTree::~ScoreBTree() {
+    if (root) destroy(root);
+}
+
+void ScoreBTree::destroy(Node* node) {
+    if (node->leaf) {
+        delete static_cast<Leaf*>(node);
+        return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (int i = 0; i < inner->count; ++i) {
+        destroy(inner->children[i]);
+    }
+    delete inner;
+}
+
+// First index whose (score, member) is >= the target. Scores are sorted, so
+// the number of scores below the target is that index; SSE2 counts them two
+// at a time without branching, and members are only compared on a tie.
+int ScoreBTree::lower_bound(const double* scores, const std::string* members, int n,
+                           double score, std::string_view member) {
+    int i = 0;
+#if defined(__SSE2__)
+    __m128d target = _mm_set1_pd(score);
+    int below = 0;
+    for (; i + 2 <= n; i += 2) {
+        below += __builtin_popcount(_mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(scores + i), target)));
+    }
+    for (; i < n; ++i) {
+        below += scores[i] < score;
+    }
+    i = below;
+#else
+    while (i < n && scores[i] < score) ++i;
+#endif
+    while (i < n && scores[i] == score && members[i] < member) ++i;
+    return i;
+}
+
+// Index of the child whose subtree would hold (score, member).
+int ScoreBTree::child_for(const Inner* node, double score, std::string_view member) {
+    int j = 1 + lower_bound(node->scores + 1, node->members + 1, node->count - 1, score, member);
+    if (j < node->count && node->scores[j] == score && node->members[j] == member) {
+        return j;
+    }
+    return j - 1;
+}
+
+size_t ScoreBTree::subtree_size(const Node* node) {
+    if (node->leaf) return node->count;
+    const Inner* inner = static_cast<const Inner*>(node);
+    size_t n = 0;
+    for (int i = 0; i < inner->count; ++i) n += inner->sizes[i];
+    return n;
+}
+
+// ===== Insert =====
+
+void ScoreBTree::insert(double score, std::string_view member) {
+    if (!root) {
+        root = new Leaf();
+        leaves++;
+    }
+    Split split;
+    if (insert(root, score, member, split)) {
+        Inner* new_root = new Inner();
+        inners++;
+        new_root->children[0] = root;
+        new_root->sizes[0] = subtree_size(root);
+        new_root->scores[0] = -HUGE_VAL;
+        new_root->children[1] = split.right;
+        new_root->sizes[1] = subtree_size(split.right);
+        new_root->scores[1] = split.score;
+        new_root->members[1] = std::move(split.member);
+        new_root->count = 2;
+        root = new_root;
+    }
+    total++;
+    member_heap += string_heap_size(member.size());
+}
+
+// Returns true if `node` split; `split` then describes the new right sibling.
+bool ScoreBTree::insert(Node* node, double score, std::string_view member, Split& split) {
+    if (node->leaf) {
+        Leaf* leaf = static_cast<Leaf*>(node);
+        int pos = lower_bound(leaf->scores, leaf->members, leaf->count, score, member);
+
+        Leaf* target = leaf;
+        Leaf* right = nullptr;
+        if (leaf->count == k_leaf_cap) {
+            right = new Leaf();
+            leaves++;
+            const int mid = k_leaf_cap / 2;
+            for (int k = mid; k < k_leaf_cap; ++k) {
+                right->scores[k - mid] = leaf->scores[k];
+                right->members[k - mid] = std::move(leaf->members[k]);
+            }
+            right->count = k_leaf_cap - mid;
+            leaf->count = mid;
+
+            right->next = leaf->next;
+            leaf->next = right;
+
+            if (pos > mid) {
+                target = right;
+                pos -= mid;
+            }
+        }
+
+        for (int k = target->count; k > pos; --k) {
+            target->scores[k] = target->scores[k - 1];
+            target->members[k] = std::move(target->members[k - 1]);
+        }
+        target->scores[pos] = score;
+        target->members[pos].assign(member);
+        target->count++;
+
+        if (!right) return false;
+        split = Split{right, right->scores[0], right->members[0]};
+        return true;
+    }
+
+    Inner* inner = static_cast<Inner*>(node);
+    int c = child_for(inner, score, member);
+    inner->sizes[c]++;
+    Split child_split;
+    if (!insert(inner->children[c], score, member, child_split)) {
+        return false;
+    }
+
+    // Child c split: its new right half becomes child c + 1.
+    size_t right_size = subtree_size(child_split.right);
+    inner->sizes[c] -= right_size;
+
+    Inner* target = inner;
+    Inner* right = nullptr;
+    int pos = c + 1;
+    if (inner->count == k_inner_cap) {
+        right = new Inner();
+        inners++;
+        const int mid = k_inner_cap / 2;
+        for (int k = mid; k < k_inner_cap; ++k) {
+            right->scores[k - mid] = inner->scores[k];
+            right->members[k - mid] = std::move(inner->members[k]);
+            right->sizes[k - mid] = inner->sizes[k];
+            right->children[k - mid] = inner->children[k];
+        }
+        right->count = k_inner_cap - mid;
+        inner->count = mid;
+        if (pos > mid) {
+            target = right;
+            pos -= mid;
+        }
+    }
+
+    for (int k = target->count; k > pos; --k) {
+        target->scores[k] = target->scores[k - 1];
+        target->members[k] = std::move(target->members[k - 1]);
+        target->sizes[k] = target->sizes[k - 1];
+        target->children[k] = target->children[k - 1];
+    }
+    target->scores[pos] = child_split.score;
+    target->members[pos] = std::move(child_split.member);
+    target->sizes[pos] = right_size;
+    target->children[pos] = child_split.right;
+    target->count++;
+
+    if (!right) return false;
+    split = Split{right, right->scores[0], right->members[0]};
+    return true;
+}
+
+// ===== Bulk load =====
+
+void ScoreBTree::load_sorted(const std::pair<std::string_view, double>* items, size_t n) {
+    if (n == 0) return;
+    // Split `count` slots over as few nodes of `cap` as possible, evenly, so
+    // that every node is over half full and far from an underflow.
+    auto spread = [](size_t count, int cap, size_t& nodes, size_t& base, size_t& extra) {
+        nodes = (count + cap - 1) / cap;
+        base = count / nodes;
+        extra = count % nodes;
+    };
+
+    std::vector<Node*> level;
+    size_t nodes, base, extra;
+    spread(n, k_leaf_cap, nodes, base, extra);
+    level.reserve(nodes);
+    Leaf* prev = nullptr;
+    for (size_t i = 0, pos = 0; i < nodes; ++i) {
+        Leaf* leaf = new Leaf();
+        leaf->count = static_cast<int>(base + (i < extra));
+        for (int k = 0; k < leaf->count; ++k, ++pos) {
+            leaf->scores[k] = items[pos].second;
+            leaf->members[k].assign(items[pos].first);
+            member_heap += string_heap_size(items[pos].first.size());
+        }
+        if (prev) prev->next = leaf;
+        prev = leaf;
+        level.push_back(leaf);
+    }
+    leaves = nodes;
+
+    // Inner key i is the first entry under child i.
+    auto first_entry = [](const Node* node, double& score, const std::string*& member) {
+        while (!node->leaf) node = static_cast<const Inner*>(node)->children[0];
+        const Leaf* leaf = static_cast<const Leaf*>(node);
+        score = leaf->scores[0];
+        member = &leaf->members[0];
+    };
+    while (level.size() > 1) {
+        std::vector<Node*> up;
+        spread(level.size(), k_inner_cap, nodes, base, extra);
+        up.reserve(nodes);
+        for (size_t i = 0, pos = 0; i < nodes; ++i) {
+            Inner* inner = new Inner();
+            inner->count = static_cast<int>(base + (i < extra));
+            for (int k = 0; k < inner->count; ++k, ++pos) {
+                const std::string* member;
+                first_entry(level[pos], inner->scores[k], member);
+                inner->members[k] = *member;
+                inner->sizes[k] = subtree_size(level[pos]);
+                inner->children[k] = level[pos];
+            }
+            up.push_back(inner);
+        }
+        inners += nodes;
+        level.swap(up);
+    }
+    root = level[0];
+    if (!root->leaf) static_cast<Inner*>(root)->scores[0] = -HUGE_VAL;
+    total = n;
+}
+
+// ===== Remove =====
+
+bool ScoreBTree::remove(double score, std::string_view member) {
+    if (!root || !remove(root, score, member)) return false;
+    total--;
+    member_heap -= string_heap_size(member.size());
+    if (!root->leaf && root->count == 1) {
+        Inner* old_root = static_cast<Inner*>(root);
+        root = old_root->children[0];
+        delete old_root;
+        inners--;
+    }
+    return true;
+}
+
+bool ScoreBTree::remove(Node* node, double score, std::string_view member) {
+    if (node->leaf) {
+        Leaf* leaf = static_cast<Leaf*>(node);
+        int pos = lower_bound(leaf->scores, leaf->members, leaf->count, score, member);
+        if (pos == leaf->count || leaf->scores[pos] != score || leaf->members[pos] != member) {
+            return false;
+        }
+        for (int k = pos; k + 1 < leaf->count; ++k) {
+            leaf->scores[k] = leaf->scores[k + 1];
+            leaf->members[k] = std::move(leaf->members[k + 1]);
+        }
+        leaf->count--;
+        leaf->members[leaf->count].clear();
+        return true;
+    }
+
+    Inner* inner = static_cast<Inner*>(node);
+    int c = child_for(inner, score, member);
+    if (!remove(inner->children[c], score, member)) return false;
+    inner->sizes[c]--;
+    fix_underflow(inner, c);
+    return true;
+}
+
+// Keeps child i at least a quarter full by merging it with a sibling, or by
+// taking one entry from a sibling too full to merge with.
+void ScoreBTree::fix_underflow(Inner* parent, int i) {
+    Node* child = parent->children[i];
+    const int cap = child->leaf ? k_leaf_cap : k_inner_cap;
+    if (child->count >= cap / 4) return;
+
+    if (i > 0) {
+        Node* left = parent->children[i - 1];
+        if (left->count + child->count <= cap) merge(parent, i - 1);
+        else borrow_from_left(parent, i);
+    } else {
+        Node* right = parent->children[1];
+        if (right->count + child->count <= cap) merge(parent, 0);
+        else borrow_from_right(parent, 0);
+    }
+}
+
+// Folds child i + 1 into child i.
+void ScoreBTree::merge(Inner* parent, int i) {
+    Node* left = parent->children[i];
+    Node* right = parent->children[i + 1];
+
+    if (left->leaf) {
+        Leaf* l = static_cast<Leaf*>(left);
+        Leaf* r = static_cast<Leaf*>(right);
+        for (int k = 0; k < r->count; ++k) {
+            l->scores[l->count + k] = r->scores[k];
+            l->members[l->count + k] = std::move(r->members[k]);
+        }
+        l->count += r->count;
+        l->next = r->next;
+        delete r;
+        leaves--;
+    } else {
+        Inner* l = static_cast<Inner*>(left);
+        Inner* r = static_cast<Inner*>(right);
+        for (int k = 0; k < r->count; ++k) {
+            l->scores[l->count + k] = r->scores[k];
+            l->members[l->count + k] = std::move(r->members[k]);
+            l->sizes[l->count + k] = r->sizes[k];
+            l->children[l->count + k] = r->children[k];
+        }
+        l->count += r->count;
+        delete r;
+        inners--;
+    }
+
+    parent->sizes[i] += parent->sizes[i + 1];
+    for (int k = i + 1; k + 1 < parent->count; ++k) {
+        parent->scores[k] = parent->scores[k + 1];
+        parent->members[k] = std::move(parent->members[k + 1]);
+        parent->sizes[k] = parent->sizes[k + 1];
+        parent->children[k] = parent->children[k + 1];
+    }
+    parent->count--;
+    parent->members[parent->count].clear();
+}
+
+// Moves the last entry (or child) of child i - 1 to the front of child i.
+void ScoreBTree::borrow_from_left(Inner* parent, int i) {
+    Node* left = parent->children[i - 1];
+    Node* child = parent->children[i];
+    size_t moved = 1;
+
+    if (child->leaf) {
+        Leaf* l = static_cast<Leaf*>(left);
+        Leaf* c = static_cast<Leaf*>(child);
+        for (int k = c->count; k > 0; --k) {
+            c->scores[k] = c->scores[k - 1];
+            c->members[k] = std::move(c->members[k - 1]);
+        }
+        c->scores[0] = l->scores[l->count - 1];
+        c->members[0] = std::move(l->members[l->count - 1]);
+        parent->scores[i] = c->scores[0];
+        parent->members[i] = c->members[0];
+    } else {
+        Inner* l = static_cast<Inner*>(left);
+        Inner* c = static_cast<Inner*>(child);
+        for (int k = c->count; k > 0; --k) {
+            c->scores[k] = c->scores[k - 1];
+            c->members[k] = std::move(c->members[k - 1]);
+            c->sizes[k] = c->sizes[k - 1];
+            c->children[k] = c->children[k - 1];
+        }
+        int last = l->count - 1;
+        c->scores[0] = l->scores[last];
+        c->members[0] = std::move(l->members[last]);
+        c->sizes[0] = l->sizes[last];
+        c->children[0] = l->children[last];
+        moved = l->sizes[last];
+        parent->scores[i] = c->scores[0];
+        parent->members[i] = c->members[0];
+    }
+    left->count--;
+    child->count++;
+    parent->sizes[i - 1] -= moved;
+    parent->sizes[i] += moved;
+}
+
+// Moves the first entry (or child) of child i + 1 to the end of child i.
+void ScoreBTree::borrow_from_right(Inner* parent, int i) {
+    Node* child = parent->children[i];
+    Node* right = parent->children[i + 1];
+    size_t moved = 1;
+
+    if (child->leaf) {
+        Leaf* c = static_cast<Leaf*>(child);
+        Leaf* r = static_cast<Leaf*>(right);
+        c->scores[c->count] = r->scores[0];
+        c->members[c->count] = std::move(r->members[0]);
+        for (int k = 0; k + 1 < r->count; ++k) {
+            r->scores[k] = r->scores[k + 1];
+            r->members[k] = std::move(r->members[k + 1]);
+        }
+        parent->scores[i + 1] = r->scores[0];
+        parent->members[i + 1] = r->members[0];
+    } else {
+        Inner* c = static_cast<Inner*>(child);
+        Inner* r = static_cast<Inner*>(right);
+        c->scores[c->count] = r->scores[0];
+        c->members[c->count] = std::move(r->members[0]);
+        c->sizes[c->count] = r->sizes[0];
+        c->children[c->count] = r->children[0];
+        moved = r->sizes[0];
+        for (int k = 0; k + 1 < r->count; ++k) {
+            r->scores[k] = r->scores[k + 1];
+            r->members[k] = std::move(r->members[k + 1]);
+            r->sizes[k] = r->sizes[k + 1];
+            r->children[k] = r->children[k + 1];
+        }
+        parent->scores[i + 1] = r->scores[0];
+        parent->members[i + 1] = r->members[0];
+    }
+    child->count++;
+    right->count--;
+    parent->sizes[i] += moved;
+    parent->sizes[i + 1] -= moved;
+}
+
+// ===== Queries =====
+
+size_t ScoreBTree::memory_usage() const {
+    return leaves * slab_object_size(sizeof(Leaf)) + inners * slab_object_size(sizeof(Inner)) + member_heap;
+}
+
+size_t ScoreBTree::count_less(double score, std::string_view member) const {
+    if (!root) return 0;
+    size_t n = 0;
+    const Node* node = root;
+    while (!node->leaf) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        int c = child_for(inner, score, member);
+        for (int k = 0; k < c; ++k) n += inner->sizes[k];
+        node = inner->children[c];
+    }
+    const Leaf* leaf = static_cast<const Leaf*>(node);
+    return n + lower_bound(leaf->scores, leaf->members, leaf->count, score, member);
+}
+
+void ScoreBTree::range(size_t start, size_t limit, std::vector<std::pair<std::string, double>>& out) const {
+    if (start >= total || limit == 0) return;
+
+    const Node* node = root;
+    while (!node->leaf) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        int i = 0;
+        while (i + 1 < inner->count && start >= inner->sizes[i]) {
+            start -= inner->sizes[i];
+            i++;
+        }
+        node = inner->children[i];
+    }
+
+    size_t end = out.size() + limit;
+    int idx = static_cast<int>(start);
+    for (const Leaf* leaf = static_cast<const Leaf*>(node); leaf && out.size() < end; leaf = leaf->next) {
+        for (; idx < leaf->count && out.size() < end; ++idx) {
+            out.emplace_back(leaf->members[idx], leaf->scores[idx]);
+        }
+        idx = 0;
+    }
+}
@@ -1,98 +1,1610 @@
 #include "server/server.h"
 #include "server/protocol.h"
+#include "server/memory.h"
+#include "server/perfect_hash.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <chrono>
 #include <iostream>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <csignal>
+#include <iterator>
+#include <thread>
 #include <unistd.h>
 #include <fcntl.h>
+#include <netdb.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
-#include <poll.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+Server::Server(const ServerConfig& config, ShardGroup* group, unsigned int shard_id)
+    : config_(config),
+      rng_(0x9E3779B97F4A7C15ULL * (shard_id + 1)),
+      loop_(EventLoop::create(config.backend)),
+      wake_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      stopping_(false),
+      group_(group),
+      shard_id_(shard_id),
+      next_conn_id_(1) {
+    if (group_) {
+        outbox_.resize(group_->size());
+        notify_.resize(group_->size(), false);
+    }
+    repl_id_ = new_repl_id();
+    if (config_.replicaof_port && !group_) {
+        primary_ = std::make_unique<PrimaryLink>(config_.replicaof_host, config_.replicaof_port);
+    }
+}
+
+Server::~Server() {
+    // The writer may still wake us while it flushes.
+    aof_.reset();
+    primary_.reset();
+    for (Connection* conn : fd2conn_) {
+        if (conn) {
+            ::close(conn->fd);
+            delete conn;
+        }
+    }
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    // Let a running BGSAVE finish rather than leave a half-written file; a
+    // rewrite nobody will switch to is thrown away.
+    if (child_pid_ > 0) ::waitpid(child_pid_, nullptr, 0);
+    if (child_job_ == ChildJob::REWRITE) ::unlink((aof_file_path() + ".rewrite").c_str());
+    if (child_job_ == ChildJob::SYNC) ::unlink(sync_snapshot_path().c_str());
+    if (child_report_) ::munmap(child_report_, sizeof(ChildReport));
+}
+
+// Buckets migrated per loop tick while the keyspace is being resized, on top
+// of the one bucket every put/remove already moves.
+static const unsigned int k_rehash_buckets_per_tick = 1000;
+
+// Time the active expiry cycle may spend per loop turn, so a mass expiry is
+// spread over many turns instead of stalling connections.
+static const int64_t k_expire_budget_us = 1000;
 
-Server::Server() = default;
-Server::~Server() = default;
+// How often run() checks whether a BGSAVE or BGREWRITEAOF child has exited.
+static const int k_child_poll_ms = 100;
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Wall-clock time, for what outlives the process (snapshot and log expiries).
+static int64_t unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static int64_t usec_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Interest interest_for(ConnectionState state) {
+    return state == STATE_RES ? Interest::WRITE : Interest::READ;
+}
 
 void Server::run(int listen_fd) {
+    std::string err;
+    if (!config_.aof_path.empty() && !aof_ && !start_aof(false, err)) {
+        std::cerr << "cannot open append-only log: " << err << "\n";
+        exit(1);
+    }
     fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+    loop_->add(listen_fd, Interest::READ);
+    loop_->add(wake_fd_, Interest::READ);
+
+    std::vector<IoEvent> events;
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        // Don't sleep while a resize is pending so idle time finishes it, or
+        // while messages for other shards are still queued in the outbox.
+        bool busy = db_.is_rehashing() || (group_ && flush_outbox());
+        int timeout_ms = busy ? 0 : next_timeout_ms();
+        if (child_pid_ > 0) timeout_ms = std::min(timeout_ms, k_child_poll_ms);
+        if (primary_ || !replicas_.empty()) timeout_ms = std::min(timeout_ms, static_cast<int>(k_repl_ack_ms));
+        int rv = loop_->wait(events, timeout_ms);
+        if (rv < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            exit(1);
+        }
+
+        for (const IoEvent& ev : events) {
+            if (ev.fd == listen_fd) {
+                accept_new_connections(listen_fd);
+                continue;
+            }
+            if (ev.fd == wake_fd_) {
+                uint64_t drained;
+                while (::read(wake_fd_, &drained, sizeof(drained)) > 0) {}
+                continue;
+            }
+            if (primary_ && ev.fd == primary_->fd) {
+                service_primary();
+                continue;
+            }
+
+            Connection* conn = (size_t)ev.fd < fd2conn_.size() ? fd2conn_[ev.fd] : nullptr;
+            if (conn) service_connection(conn);
+        }
+
+        if (group_) drain_shard_queues();
+        db_.rehash_step(k_rehash_buckets_per_tick);
+        // A replica's keys expire when the primary's DEL arrives, so both
+        // delete them at the same point in the stream.
+        if (!primary_) active_expire(k_expire_budget_us);
+        if (child_pid_ > 0) reap_child();
+        if (aof_) {
+            // Replies released here may log more; this turn's end takes it.
+            release_aof_waiters();
+            aof_->end_turn();
+        }
+        if (primary_ || !replicas_.empty()) replication_cron();
+    }
+
+    loop_->remove(wake_fd_);
+    loop_->remove(listen_fd);
+}
+
+// Sleep until the earliest TTL deadline, but at most a second; 0 while keys
+// are already due.
+int Server::next_timeout_ms() const {
+    Entry* next = ttl_.top();
+    if (!next) return 1000;
+    int64_t wait = next->expire_at - now_ms();
+    return wait <= 0 ? 0 : (int)std::min<int64_t>(wait, 1000);
+}
+
+size_t Server::active_expire(int64_t budget_us) {
+    auto start = std::chrono::steady_clock::now();
+    int64_t now = now_ms();
+    size_t expired = 0;
+    for (Entry* entry = ttl_.top(); entry && entry->expire_at <= now; entry = ttl_.top()) {
+        evict_entry(entry);
+        // Reading the clock costs about as much as a small delete; sample it.
+        if (++expired % 32 == 0 &&
+            std::chrono::steady_clock::now() - start >= std::chrono::microseconds(budget_us)) {
+            break;
+        }
+    }
+    return expired;
+}
+
+Entry* Server::lookup(std::string_view key) {
+    Entry* entry = db_.get(key);
+    if (entry && entry->expire_at != Entry::k_no_expiry && entry->expire_at <= now_ms() && !loading_) {
+        // A replica only hides it until the primary's DEL arrives.
+        if (!primary_) evict_entry(entry);
+        return nullptr;
+    }
+    if (entry) touch(entry);
+    return entry;
+}
+
+void Server::delete_entry(Entry* entry) {
+    ttl_.remove(entry);
+    uncharge_entry(entry);
+    // remove() is done comparing keys before it frees the entry this views.
+    db_.remove(entry->key());
+}
+
+// Stores `value` in a string entry, moving it to a new record when it no
+// longer fits the old one. Keeps the TTL. Returns the entry now holding the
+// key.
+Entry* Server::assign_string(Entry* entry, std::string_view value, ValueBuffer* owned) {
+    uncharge_entry(entry);
+    if (!entry->assign_value(value, owned)) {
+        Entry* resized = Entry::make_string(entry->key(), value, owned);
+        resized->access = entry->access;
+        resized->expire_at = entry->expire_at;
+        ttl_.remove(entry);
+        db_.put(resized->key(), resized);  // frees `entry`
+        if (resized->expire_at != Entry::k_no_expiry) ttl_.update(resized);
+        entry = resized;
+    }
+    charge_entry(entry);
+    return entry;
+}
+
+// SET: stores a string under `key`, clearing any TTL. Returns false if the
+// key holds another type.
+bool Server::set_string(std::string_view key, std::string_view value) {
+    Entry* entry = lookup(key);
+    if (entry) {
+        if (entry->type() != Entry::STRING) return false;
+        // Like Redis, overwriting a value clears its TTL.
+        ttl_.remove(entry);
+        entry->expire_at = Entry::k_no_expiry;
+        assign_string(entry, value, take_bulk_arg(value));
+    } else {
+        entry = Entry::make_string(key, value, take_bulk_arg(value));
+        entry->access = initial_access();
+        db_.put(entry->key(), entry);
+        charge_entry(entry);
+    }
+    return true;
+}
+
+// Releases the buffer of a bulk request argument that is exactly `value`, so
+// a large value is stored without another copy. Returns nullptr otherwise.
+ValueBuffer* Server::take_bulk_arg(std::string_view value) {
+    if (!bulk_args_ || value.size() <= Entry::k_max_inline_value) return nullptr;
+    for (ValueBufferPtr& arg : *bulk_args_) {
+        if (arg && arg->data() == value.data()) return arg.release();
+    }
+    return nullptr;
+}
+
+void MemoryStats::add(const MemoryStats& o, bool subtract) {
+    auto apply = [subtract](size_t& total, size_t n) { total = subtract ? total - n : total + n; };
+    apply(table_nodes, o.table_nodes);
+    apply(entries, o.entries);
+    apply(keys, o.keys);
+    apply(strings, o.strings);
+    apply(zsets, o.zsets);
+    apply(connections, o.connections);
+}
+
+MemoryStats Server::entry_breakdown(const Entry* entry) const {
+    MemoryStats mem;
+    char scratch[Entry::k_max_int_chars];
+    size_t inline_value = entry->type() == Entry::STRING && entry->encoding() == Entry::INLINE
+                              ? entry->str_value(scratch).size() : 0;
+    mem.table_nodes = slab_object_size(sizeof(decltype(db_)::Node));
+    mem.keys = entry->key().size();
+    mem.strings = inline_value + entry->value_heap_bytes();
+    mem.entries = entry->record_bytes() - mem.keys - inline_value;
+    if (ZSet* zset = entry->zset_value()) mem.zsets = zset->memory_usage();
+    return mem;
+}
+
+void Server::charge_entry(const Entry* entry) {
+    mem_.add(entry_breakdown(entry), false);
+}
+
+void Server::uncharge_entry(const Entry* entry) {
+    mem_.add(entry_breakdown(entry), true);
+}
+
+size_t Server::connection_memory(const Connection* conn) {
+    size_t bytes = alloc_size(sizeof(Connection)) + alloc_size(conn->rbuf.capacity()) +
+                   alloc_size(conn->wbuf.capacity());
+    if (conn->frame_scratch.capacity()) bytes += alloc_size(conn->frame_scratch.capacity());
+    if (conn->bulk) bytes += alloc_size(sizeof(Connection::BulkRequest)) + conn->bulk->bytes;
+    return bytes;
+}
+
+size_t Server::used_memory() const {
+    return mem_.keyspace() + db_.bucket_count() * sizeof(void*) + ttl_.memory_usage();
+}
+
+// INFO reply: one "field:value" string per line, so a ShardGroup can
+// concatenate the shards' arrays.
+void Server::info_command(const std::vector<std::string_view>&, ReplyOut out) {
+    std::vector<std::string> lines;
+    auto add = [&](const char* name, auto value) { lines.push_back(std::string(name) + ":" + std::to_string(value)); };
+    if (group_) {
+        add("shard", shard_id_);
+    }
+    add("used_memory", used_memory() + mem_.connections);
+    add("used_memory_dataset", used_memory());
+    add("mem_table_buckets", static_cast<size_t>(db_.bucket_count()) * sizeof(void*));
+    add("mem_table_nodes", mem_.table_nodes);
+    add("mem_entries", mem_.entries);
+    add("mem_keys", mem_.keys);
+    add("mem_strings", mem_.strings);
+    add("mem_zsets", mem_.zsets);
+    add("mem_ttl_heap", ttl_.memory_usage());
+    add("mem_connections", mem_.connections);
+    add("maxmemory", config_.maxmemory);
+    add("keys", db_.size());
+    add("expires", ttl_.size());
+    add("table_buckets", db_.bucket_count());
+    char load[32];
+    snprintf(load, sizeof(load), "%.3f", db_.bucket_count() ? double(db_.size()) / db_.bucket_count() : 0.0);
+    lines.push_back(std::string("table_load_factor:") + load);
+    add("table_rehashing", db_.is_rehashing() ? 1 : 0);
+    size_t clients = 0;
+    for (const Connection* conn : fd2conn_) clients += conn != nullptr;
+    add("connected_clients", clients);
+    add("rdb_bgsave_in_progress", child_job_ == ChildJob::SAVE ? 1 : 0);
+    lines.push_back(std::string("rdb_last_save_status:") + (last_save_ok_ ? "ok" : "err"));
+    add("rdb_last_save_time", last_save_time_);
+    add("rdb_last_save_bytes", last_save_bytes_);
+    add("rdb_last_save_usec", last_save_usec_);
+    char rate[32];
+    snprintf(rate, sizeof(rate), "%.1f", last_save_usec_ ? double(last_save_bytes_) / last_save_usec_ : 0.0);
+    lines.push_back(std::string("rdb_last_save_mb_per_sec:") + rate);
+    add("rdb_last_fork_usec", last_fork_usec_);
+    add("aof_enabled", aof_ ? 1 : 0);
+    if (aof_) {
+        Aof::Stats aof = aof_->stats();
+        add("aof_rewrite_in_progress", aof_->rewriting() ? 1 : 0);
+        lines.push_back(std::string("aof_last_rewrite_status:") + (aof.last_rewrite_ok ? "ok" : "err"));
+        lines.push_back(std::string("aof_last_write_status:") + (aof.last_write_ok ? "ok" : "err"));
+        add("aof_current_size", aof.size);
+        add("aof_writes", aof.writes);
+        add("aof_fsyncs", aof.fsyncs);
+    }
+    if (!group_) {
+        lines.push_back(std::string("role:") + (primary_ ? "replica" : "primary"));
+        int64_t now = now_ms();
+        if (primary_) {
+            const PrimaryLink& link = *primary_;
+            lines.push_back("primary_host:" + link.host);
+            add("primary_port", link.port);
+            const char* status = link.phase == PrimaryLink::STREAM     ? "up"
+                                 : link.phase == PrimaryLink::SNAPSHOT ? "sync"
+                                                                       : "down";
+            lines.push_back(std::string("primary_link_status:") + status);
+            add("primary_last_io_ms", link.last_io_ms ? now - link.last_io_ms : -1);
+            add("primary_repl_offset", link.offset);
+            add("primary_full_syncs", link.full_syncs);
+            add("primary_partial_syncs", link.partial_syncs);
+        }
+        uint64_t offset = backlog_ ? backlog_->end_offset() : 0;
+        lines.push_back("repl_id:" + repl_id_);
+        add("repl_offset", offset);
+        add("repl_backlog_size", backlog_ ? backlog_->capacity() : 0);
+        add("repl_backlog_first_offset", backlog_ ? backlog_->start_offset() : 0);
+        add("repl_full_syncs_served", repl_full_syncs_);
+        add("repl_partial_syncs_served", repl_partial_syncs_);
+        add("connected_replicas", replicas_.size());
+        static const char* const k_phases[] = {"wait_fork", "wait_snapshot", "send_snapshot", "online"};
+        for (size_t i = 0; i < replicas_.size(); ++i) {
+            const ReplicaLink& link = *replicas_[i]->replica;
+            lines.push_back("replica" + std::to_string(i) + ":state=" + k_phases[link.phase] +
+                            ",offset=" + std::to_string(link.ack_offset) +
+                            ",lag=" + std::to_string(offset - std::min(offset, link.ack_offset)) +
+                            ",ack_age_ms=" + std::to_string(now - link.ack_ms));
+        }
+    }
+    out_array(out, lines);
+}
+
+// ===== scan =====
+
+// Parses an unsigned decimal spanning all of `s`.
+static bool parse_uint(std::string_view s, uint64_t& out) {
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return ec == std::errc() && ptr == s.data() + s.size();
+}
+
+// Glob-style match: `*` any run, `?` any byte, `[abc]`, `[^a-z]` classes and
+// `\` escapes. A `*` backtracks only to its latest occurrence, which keeps
+// the match linear in practice.
+static bool glob_match(std::string_view pattern, std::string_view str) {
+    size_t p = 0, s = 0;
+    size_t star_p = std::string_view::npos, star_s = 0;
+    while (s < str.size()) {
+        if (p < pattern.size()) {
+            char c = pattern[p];
+            if (c == '*') {
+                star_p = ++p;
+                star_s = s;
+                continue;
+            }
+            if (c == '?') {
+                ++p, ++s;
+                continue;
+            }
+            if (c == '[') {
+                size_t q = p + 1;
+                bool negate = q < pattern.size() && pattern[q] == '^';
+                if (negate) ++q;
+                bool hit = false;
+                while (q < pattern.size() && pattern[q] != ']') {
+                    if (pattern[q] == '\\' && q + 1 < pattern.size()) ++q;
+                    if (q + 2 < pattern.size() && pattern[q + 1] == '-' && pattern[q + 2] != ']') {
+                        char lo = std::min(pattern[q], pattern[q + 2]);
+                        char hi = std::max(pattern[q], pattern[q + 2]);
+                        hit |= str[s] >= lo && str[s] <= hi;
+                        q += 3;
+                    } else {
+                        hit |= pattern[q] == str[s];
+                        ++q;
+                    }
+                }
+                if (hit != negate) {
+                    p = q < pattern.size() ? q + 1 : q;
+                    ++s;
+                    continue;
+                }
+            } else {
+                if (c == '\\' && p + 1 < pattern.size()) c = pattern[++p];
+                if (c == str[s]) {
+                    ++p, ++s;
+                    continue;
+                }
+            }
+        }
+        if (star_p == std::string_view::npos) return false;
+        p = star_p;
+        s = ++star_s;
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+// SCAN cursor [match pattern] [count n]. The low bits of the cursor walk this
+// shard's table; with --threads the top bits name the shard, so one cursor
+// walks the shards in turn.
+static const int k_scan_shard_shift = 48;
+
+void Server::scan_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    if (cmd.size() % 2 != 0) { out_error(out, "Invalid number of arguments for 'scan'"); return; }
+    uint64_t cursor = 0;
+    if (!parse_uint(cmd[1], cursor) || (cursor >> k_scan_shard_shift) != shard_id_) {
+        out_error(out, "invalid cursor");
+        return;
+    }
+    std::string_view pattern;
+    bool match = false;
+    uint64_t count = 10;
+    for (size_t i = 2; i < cmd.size(); i += 2) {
+        if (cmd[i] == "match") {
+            pattern = cmd[i + 1];
+            match = pattern != "*";
+        } else if (cmd[i] == "count" && parse_uint(cmd[i + 1], count) && count > 0) {
+            count = std::min<uint64_t>(count, UINT32_MAX);
+        } else {
+            out_error(out, "syntax error");
+            return;
+        }
+    }
+
+    // Stop after `count` entries, or after count * 10 buckets so a sparse
+    // table cannot turn one call into a long walk. MATCH filters after the
+    // fact, so it may return fewer (even no) keys before the end.
+    size_t bucket_cursor = cursor & ((uint64_t(1) << k_scan_shard_shift) - 1);
+    uint64_t visited = 0;
+    uint64_t budget = count * 10;
+    int64_t now = now_ms();
+    std::vector<std::string> keys;
+    do {
+        bucket_cursor = db_.scan(bucket_cursor, [&](std::string_view key, Entry* entry) {
+            visited++;
+            if (entry->expire_at != Entry::k_no_expiry && entry->expire_at <= now) return;
+            if (match && !glob_match(pattern, key)) return;
+            keys.emplace_back(key);
+        });
+    } while (bucket_cursor && visited < count && --budget);
+
+    unsigned int shards = group_ ? group_->size() : 1;
+    uint64_t next = 0;
+    if (bucket_cursor) next = (uint64_t(shard_id_) << k_scan_shard_shift) | bucket_cursor;
+    else if (shard_id_ + 1 < shards) next = uint64_t(shard_id_ + 1) << k_scan_shard_shift;
+
+    out.push_back(SER_ARR);
+    uint32_t n = 2;
+    out.append((const char*)&n, 4);
+    out_string(out, std::to_string(next));
+    out_array(out, keys);
+}
+
+// ===== snapshots =====
+
+std::string Server::snapshot_file_path() const {
+    return snapshot_shard_path(config_.snapshot_path, group_ ? static_cast<int>(shard_id_) : -1);
+}
+
+uint64_t Server::write_snapshot(const std::string& path, std::string& err) const {
+    SnapshotHeader header;
+    header.shard = group_ ? shard_id_ : 0;
+    header.shards = group_ ? group_->size() : 1;
+    header.saved_at = unix_ms();
+    header.keys = db_.size();
+    // Deadlines are kept on the monotonic clock; the file needs wall-clock
+    // time. Keys already expired are written too and dropped on load.
+    int64_t to_unix = header.saved_at - now_ms();
+
+    auto write_keys = [&](SnapshotWriter& writer) {
+        bool ok = true;
+        db_.for_each([&](std::string_view key, Entry* entry) {
+            if (!ok) return;
+            int64_t expire_at = entry->expire_at == Entry::k_no_expiry ? k_snapshot_no_expiry
+                                                                       : entry->expire_at + to_unix;
+            if (ZSet* zset = entry->zset_value()) {
+                ok = writer.begin_zset(key, zset->zcard(), expire_at);
+                zset->for_each([&](std::string_view member, double score) {
+                    ok = ok && writer.add_member(member, score);
+                });
+            } else if (entry->is_int()) {
+                ok = writer.write_int(key, entry->int_value(), expire_at);
+            } else {
+                char scratch[Entry::k_max_int_chars];
+                ok = writer.write_string(key, entry->str_value(scratch), expire_at);
+            }
+        });
+        return ok;
+    };
+    return snapshot_save(path, header, write_keys, err);
+}
+
+void Server::finish_save(bool ok, uint64_t bytes, int64_t usec) {
+    last_save_ok_ = ok;
+    if (!ok) return;
+    last_save_time_ = unix_ms() / 1000;
+    last_save_bytes_ = bytes;
+    last_save_usec_ = usec;
+}
+
+void Server::save_command(const std::vector<std::string_view>&, ReplyOut out) {
+    if (child_pid_ > 0) { out_error(out, child_busy_error()); return; }
+    auto start = std::chrono::steady_clock::now();
+    std::string err;
+    uint64_t bytes = write_snapshot(snapshot_file_path(), err);
+    finish_save(bytes > 0, bytes, usec_since(start));
+    if (!bytes) { out_error(out, err); return; }
+    out_ok(out);
+}
+
+void Server::bgsave_command(const std::vector<std::string_view>&, ReplyOut out) {
+    if (child_pid_ > 0) { out_error(out, child_busy_error()); return; }
+    std::string err;
+    auto work = [this](uint64_t& bytes, std::string& e) { return (bytes = write_snapshot(snapshot_file_path(), e)) > 0; };
+    if (!fork_child(ChildJob::SAVE, work, err)) {
+        last_save_ok_ = false;
+        out_error(out, "Background save failed: " + err);
+        return;
+    }
+    out_string(out, "Background saving started");
+}
+
+const char* Server::child_busy_error() const {
+    return child_job_ == ChildJob::REWRITE ? "Background append-only log rewrite already in progress"
+                                           : "Background save already in progress";
+}
+
+bool Server::fork_child(ChildJob job, const std::function<bool(uint64_t& bytes, std::string& err)>& work,
+                        std::string& err) {
+    if (!child_report_) {
+        void* page = ::mmap(nullptr, sizeof(ChildReport), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (page == MAP_FAILED) {
+            err = strerror(errno);
+            return false;
+        }
+        child_report_ = static_cast<ChildReport*>(page);
+    }
+    *child_report_ = {0, 0};
+
+    // fork() copies the page tables, not the pages: its cost grows with the
+    // dataset and is paid here, on the event loop. Pages the parent writes
+    // afterwards are copied one by one, so the child sees the keyspace as it
+    // was at this instant.
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        uint64_t bytes = 0;
+        std::string child_err;
+        bool ok = work(bytes, child_err);
+        if (!ok) {
+            const char* name = job == ChildJob::SAVE ? "BGSAVE" : job == ChildJob::SYNC ? "SYNC" : "BGREWRITEAOF";
+            fprintf(stderr, "%s: %s\n", name, child_err.c_str());
+        }
+        child_report_->bytes = bytes;
+        child_report_->usec = usec_since(start);
+        ::_exit(ok ? 0 : 1);  // skip destructors: they would free the parent's copy-on-write pages
+    }
+    last_fork_usec_ = usec_since(start);
+    if (pid < 0) {
+        err = std::string("fork: ") + strerror(errno);
+        return false;
+    }
+    child_pid_ = pid;
+    child_job_ = job;
+    return true;
+}
+
+void Server::reap_child() {
+    int status = 0;
+    pid_t pid = ::waitpid(child_pid_, &status, WNOHANG);
+    if (pid == 0) return;  // still writing
+    ChildJob job = child_job_;
+    child_pid_ = -1;
+    child_job_ = ChildJob::NONE;
+    bool ok = pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (job == ChildJob::SAVE) finish_save(ok, child_report_->bytes, child_report_->usec);
+    else if (job == ChildJob::SYNC) finish_sync(ok);
+    else finish_rewrite(ok);
+}
+
+// What a load thread made of one snapshot chunk: the entries still live, by
+// the server they go to, what they will be charged, and how many records
+// had expired instead.
+struct LoadedChunk {
+    std::vector<std::vector<Entry*>> entries;
+    std::vector<MemoryStats> mem;
+    uint64_t expired = 0;
+    std::string err;
+};
+
+// Runs work(0) ... work(n - 1) on up to `threads` threads, this one included.
+static void run_parallel(size_t n, unsigned int threads, const std::function<void(size_t)>& work) {
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;) work(i);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads && t < n; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+}
+
+bool Server::load_snapshot(const std::string& path, SnapshotLoadStats& stats, std::string& err) {
+    return load_snapshot(path, {this}, nullptr, stats, err);
+}
+
+bool Server::load_snapshot(const std::string& path, const std::vector<Server*>& servers,
+                           const std::function<unsigned int(std::string_view)>& route,
+                           SnapshotLoadStats& stats, std::string& err) {
+    std::vector<std::unique_ptr<SnapshotReader>> files;
+    if (!snapshot_open(path, files, err)) return false;
+    std::vector<std::pair<size_t, size_t>> tasks;  // (file, chunk)
+    for (size_t f = 0; f < files.size(); ++f) {
+        for (size_t c = 0; c < files[f]->chunk_count(); ++c) tasks.emplace_back(f, c);
+    }
+
+    const Server& first = *servers[0];
+    unsigned int threads = first.config_.load_threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // One clock reading for the whole load: deadlines move to the monotonic
+    // clock by the same offset, and every key starts out equally recent.
+    int64_t now = now_ms();
+    int64_t to_local = now - unix_ms();
+    uint32_t access = first.initial_access();
+
+    // Phase 1, on every core: verify each chunk and turn its records into
+    // entries. Slab allocations come from each thread's own free lists.
+    std::vector<LoadedChunk> loaded(tasks.size());
+    run_parallel(tasks.size(), threads, [&](size_t t) {
+        const SnapshotReader& reader = *files[tasks[t].first];
+        LoadedChunk& out = loaded[t];
+        out.entries.resize(servers.size());
+        out.mem.resize(servers.size());
+        for (auto& entries : out.entries) entries.reserve(reader.chunk_records(tasks[t].second) / servers.size());
+        bool ok = reader.read_chunk(tasks[t].second, [&](const SnapshotRecord& rec) {
+            int64_t expire_at = Entry::k_no_expiry;
+            if (rec.expire_at != k_snapshot_no_expiry) {
+                expire_at = rec.expire_at + to_local;
+                if (expire_at <= now) {
+                    out.expired++;
+                    return;
+                }
+            }
+            Entry* entry;
+            if (rec.type == SNAP_ZSET) {
+                entry = Entry::make_zset(rec.key);
+                entry->zset_value()->load_sorted(rec.members);
+            } else if (rec.type == SNAP_INT) {
+                entry = Entry::make_int(rec.key, rec.int_value);
+            } else {
+                entry = Entry::make_string(rec.key, rec.str);
+            }
+            entry->access = access;
+            entry->expire_at = expire_at;
+            unsigned int index = route ? route(rec.key) : 0;
+            out.entries[index].push_back(entry);
+            out.mem[index].add(first.entry_breakdown(entry), false);
+        }, out.err);
+        if (!ok) out.err = reader.path() + ": " + out.err;
+    });
+
+    for (const LoadedChunk& chunk : loaded) {
+        if (chunk.err.empty()) continue;
+        err = chunk.err;
+        for (const LoadedChunk& c : loaded) {
+            for (const auto& entries : c.entries) {
+                for (Entry* entry : entries) delete entry;
+            }
+        }
+        return false;
+    }
+
+    for (const LoadedChunk& chunk : loaded) {
+        for (const auto& entries : chunk.entries) stats.keys += entries.size();
+        stats.expired += chunk.expired;
+    }
+
+    // Phase 2: every server links its own share, in parallel with the others.
+    std::vector<std::string> errs(servers.size());
+    run_parallel(servers.size(), threads, [&](size_t i) {
+        servers[i]->adopt_loaded(loaded, static_cast<unsigned int>(i), errs[i]);
+    });
+    for (const auto& file : files) stats.bytes += file->file_size();
+    stats.files += static_cast<unsigned int>(files.size());
+    for (const std::string& e : errs) {
+        if (!e.empty()) {
+            err = e;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Server::adopt_loaded(std::vector<LoadedChunk>& chunks, unsigned int index, std::string& err) {
+    size_t n = 0;
+    for (const LoadedChunk& chunk : chunks) n += chunk.entries[index].size();
+    db_.reserve(db_.size() + n);
+
+    const size_t k_batch = 64;
+    std::string_view keys[k_batch];
+    bool inserted[k_batch];
+    for (LoadedChunk& chunk : chunks) {
+        std::vector<Entry*>& entries = chunk.entries[index];
+        mem_.add(chunk.mem[index], false);
+        for (size_t base = 0; base < entries.size(); base += k_batch) {
+            size_t m = std::min(k_batch, entries.size() - base);
+            for (size_t i = 0; i < m; ++i) __builtin_prefetch(entries[base + i]);
+            for (size_t i = 0; i < m; ++i) keys[i] = entries[base + i]->key();
+            db_.insert_many(keys, &entries[base], m, inserted);
+            for (size_t i = 0; i < m; ++i) {
+                Entry* entry = entries[base + i];
+                if (!inserted[i]) {
+                    if (err.empty()) err = "duplicate key '" + std::string(entry->key()) + "'";
+                    uncharge_entry(entry);
+                    delete entry;
+                } else if (entry->expire_at != Entry::k_no_expiry) {
+                    ttl_.update(entry);
+                }
+            }
+        }
+        std::vector<Entry*>().swap(entries);
+    }
+}
+
+// ===== append-only log =====
+
+std::string Server::aof_file_path() const {
+    return snapshot_shard_path(config_.aof_path, group_ ? static_cast<int>(shard_id_) : -1);
+}
+
+bool Server::load_aof(const std::vector<std::string>& files, AofLoadStats& stats, std::string& err) {
+    for (const std::string& file : files) {
+        if (!aof_replay(file, [this](const std::vector<std::string_view>& cmd) { replay(cmd); }, stats, err)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Server::replay(const std::vector<std::string_view>& cmd) {
+    std::string discard;
+    loading_ = true;
+    handle_command(cmd, discard);
+    loading_ = false;
+}
+
+bool Server::start_aof(bool rewrite, std::string& err) {
+    std::string path = aof_file_path();
+    if (rewrite) {
+        std::string tmp = path + ".rewrite";
+        uint64_t bytes = 0;
+        if (!write_aof_rewrite(tmp, bytes, err)) return false;
+        if (::rename(tmp.c_str(), path.c_str()) < 0) {
+            err = "cannot rename " + tmp + ": " + strerror(errno);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+    }
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) < 0) {
+        err = "cannot open " + path + ": " + strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    aof_ = std::make_unique<Aof>(fd, static_cast<uint64_t>(st.st_size), config_.appendfsync, [this] { wake(); });
+    return true;
+}
+
+// Logs, and replicates, a command that just ran. PEXPIRE and PEXPIREAT
+// become the deadline they set, or a DEL if they deleted the key, and
+// nothing otherwise. A failed MSET is left out: a group replaying it with
+// another shard count splits it into SETs, which would not fail together.
+void Server::log_command(const std::vector<std::string_view>& cmd) {
+    if (cmd[0] == "mset") {
+        for (size_t i = 1; i < cmd.size(); i += 2) {
+            Entry* entry = db_.get(cmd[i]);
+            if (!entry || entry->type() != Entry::STRING) return;
+        }
+    }
+    if (cmd[0] == "pexpire" || cmd[0] == "pexpireat") {
+        if (expire_outcome_ == ExpireOutcome::DELETED) {
+            propagate({"del", cmd[1]});
+        } else if (expire_outcome_ == ExpireOutcome::SET) {
+            Entry* entry = db_.get(cmd[1]);
+            std::string at = std::to_string(entry->expire_at - now_ms() + unix_ms());
+            propagate({"pexpireat", cmd[1], at});
+        }
+        return;
+    }
+    propagate(cmd);
+}
+
+// Deletes a key no command asked to delete: it expired, or was evicted.
+void Server::evict_entry(Entry* entry) {
+    if (aof_ || backlog_) propagate({"del", entry->key()});
+    delete_entry(entry);
+}
+
+// The log and the replication stream carry the same commands.
+void Server::propagate(const std::vector<std::string_view>& cmd) {
+    if (aof_) aof_->append(cmd);
+    if (backlog_) feed_replicas(cmd);
+}
+
+// Under appendfsync always, a reply to anything logged this turn waits for
+// the turn to be synced; handle_read() keeps the connection from writing
+// until release_aof_waiters() finds it durable.
+void Server::hold_for_aof(Connection* conn) {
+    if (!aof_ || config_.appendfsync != AofFsync::ALWAYS || !aof_->turn_dirty()) return;
+    if (conn->aof_turn != aof_->turn()) {
+        conn->aof_turn = aof_->turn();
+        aof_waiters_.push_back({conn->fd, conn->id});
+    }
+}
+
+void Server::release_aof_waiters() {
+    uint64_t durable = aof_->durable_turn();
+    while (!aof_held_.empty() && aof_held_.front().turn <= durable) {
+        send_to_shard(aof_held_.front().shard, std::move(aof_held_.front().msg));
+        aof_held_.pop_front();
+    }
+    if (aof_waiters_.empty()) return;
+    // Servicing a connection may hold it again, for this turn.
+    std::vector<AofWaiter> waiters;
+    waiters.swap(aof_waiters_);
+    for (const AofWaiter& w : waiters) {
+        Connection* conn = (size_t)w.fd < fd2conn_.size() ? fd2conn_[w.fd] : nullptr;
+        if (!conn || conn->id != w.conn_id) continue;
+        if (conn->aof_turn > durable) {
+            aof_waiters_.push_back(w);
+        } else if (conn->state == STATE_REQ) {
+            service_connection(conn);
+        }
+    }
+}
+
+// The shortest log that rebuilds the keyspace: a SET or a ZADD per member,
+// and a PEXPIREAT for each TTL.
+bool Server::write_aof_rewrite(const std::string& path, uint64_t& bytes, std::string& err) const {
+    int64_t to_unix = unix_ms() - now_ms();
+    auto write_cmds = [&](AofFileWriter& writer) {
+        bool ok = true;
+        db_.for_each([&](std::string_view key, Entry* entry) {
+            if (!ok) return;
+            if (ZSet* zset = entry->zset_value()) {
+                zset->for_each([&](std::string_view member, double score) {
+                    // Shortest digits that parse back to the same double.
+                    char text[32];
+                    char* end = std::to_chars(text, text + sizeof(text), score).ptr;
+                    ok = ok && writer.add({"zadd", key, std::string_view(text, end - text), member});
+                });
+            } else {
+                char scratch[Entry::k_max_int_chars];
+                ok = writer.add({"set", key, entry->str_value(scratch)});
+            }
+            if (ok && entry->expire_at != Entry::k_no_expiry) {
+                ok = writer.add({"pexpireat", key, std::to_string(entry->expire_at + to_unix)});
+            }
+        });
+        return ok;
+    };
+    return aof_write_file(path, write_cmds, bytes, err);
+}
+
+void Server::bgrewriteaof_command(const std::vector<std::string_view>&, ReplyOut out) {
+    if (!aof_) { out_error(out, "Append-only log is not enabled"); return; }
+    if (child_pid_ > 0 || aof_->rewriting()) { out_error(out, child_busy_error()); return; }
+    std::string tmp = aof_file_path() + ".rewrite";
+    std::string err;
+    auto work = [this, &tmp](uint64_t& bytes, std::string& e) { return write_aof_rewrite(tmp, bytes, e); };
+    if (!fork_child(ChildJob::REWRITE, work, err)) {
+        out_error(out, "Background append-only log rewrite failed: " + err);
+        return;
+    }
+    // Everything logged from here on is also kept for the new log.
+    aof_->begin_rewrite();
+    out_string(out, "Background append-only log rewrite started");
+}
+
+void Server::finish_rewrite(bool ok) {
+    std::string path = aof_file_path();
+    std::string tmp = path + ".rewrite";
+    int fd = ok ? ::open(tmp.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC) : -1;
+    if (fd < 0) {
+        aof_->abort_rewrite();
+        ::unlink(tmp.c_str());
+        return;
+    }
+    aof_->finish_rewrite(fd, tmp, path);
+}
+
+// ===== replication =====
+
+std::string Server::sync_snapshot_path() const {
+    return config_.snapshot_path + ".sync." + std::to_string(::getpid());
+}
+
+// PSYNC <repl-id> <offset>: the connection becomes a replica. It resumes
+// from the backlog when it can; otherwise it waits for a snapshot, forked at
+// the end of this turn so the offset covers everything run before it.
+void Server::psync_command(Connection* conn, const std::vector<std::string_view>& cmd) {
+    std::string reply;
+    if (group_) {
+        out_error(reply, "Replication is not supported with more than one thread");
+        queue_reply(conn, reply);
+        return;
+    }
+    if (!backlog_) backlog_ = std::make_unique<ReplBacklog>(std::max<size_t>(config_.repl_backlog_size, 1));
+    conn->replica = std::make_unique<ReplicaLink>();
+    replicas_.push_back(conn);
+    ReplicaLink& link = *conn->replica;
+    link.ack_ms = now_ms();
+
+    uint64_t offset = 0;
+    if (cmd[1] == repl_id_ && parse_uint(cmd[2], offset) && backlog_->covers(offset)) {
+        out_string(reply, "CONTINUE");
+        append_frame(conn, reply);
+        std::string tail;
+        backlog_->copy_from(offset, tail);
+        append_output(conn, tail);
+        link.phase = ReplicaLink::ONLINE;
+        link.ack_offset = offset;
+        repl_partial_syncs_++;
+    }
+}
+
+// REPLCONF ACK <offset>, the only thing a replica sends. It is not
+// answered: a reply would land in the middle of the replica's stream.
+void Server::replconf_command(Connection* conn, const std::vector<std::string_view>& cmd) {
+    if (!conn->replica) {
+        std::string reply;
+        out_error(reply, "REPLCONF is only accepted from a replica");
+        queue_reply(conn, reply);
+        return;
+    }
+    uint64_t offset = 0;
+    if (cmd.size() == 3 && cmd[1] == "ack" && parse_uint(cmd[2], offset)) {
+        conn->replica->ack_offset = offset;
+        conn->replica->ack_ms = now_ms();
+    }
+}
+
+void Server::feed_replicas(const std::vector<std::string_view>& cmd) {
+    repl_frame_.clear();
+    append_request_frame(repl_frame_, cmd);
+    backlog_->append(repl_frame_);
+    for (Connection* conn : replicas_) {
+        ReplicaLink& link = *conn->replica;
+        if (link.phase == ReplicaLink::ONLINE) append_output(conn, repl_frame_);
+        else if (link.phase != ReplicaLink::WAIT_FORK) link.held += repl_frame_;
+    }
+}
+
+// One child writes the snapshot for every replica waiting for one.
+void Server::fork_sync() {
+    std::string path = sync_snapshot_path();
+    std::string err;
+    auto work = [this, &path](uint64_t& bytes, std::string& e) { return (bytes = write_snapshot(path, e)) > 0; };
+    if (!fork_child(ChildJob::SYNC, work, err)) {
+        std::cerr << "replication: cannot start a full sync: " << err << "\n";
+        sync_retry_ms_ = now_ms() + k_repl_retry_ms;
+        return;
+    }
+    uint64_t offset = backlog_->end_offset();
+    std::string reply;
+    out_string(reply, "FULLRESYNC " + repl_id_ + " " + std::to_string(offset));
+    for (Connection* conn : replicas_) {
+        ReplicaLink& link = *conn->replica;
+        if (link.phase != ReplicaLink::WAIT_FORK) continue;
+        link.phase = ReplicaLink::WAIT_SNAPSHOT;
+        link.sync_offset = offset;
+        link.ack_offset = offset;
+        append_frame(conn, reply);
+        repl_full_syncs_++;
+    }
+}
+
+// Each waiting replica gets its own descriptor on the child's file, which is
+// unlinked right away; the kernel drops it once the last one is sent.
+void Server::finish_sync(bool ok) {
+    std::string path = sync_snapshot_path();
+    if (!ok) std::cerr << "replication: the snapshot for a full sync failed\n";
+    std::vector<Connection*> failed;
+    for (Connection* conn : replicas_) {
+        ReplicaLink& link = *conn->replica;
+        if (link.phase != ReplicaLink::WAIT_SNAPSHOT) continue;
+        int fd = ok ? ::open(path.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) < 0) {
+            if (fd >= 0) ::close(fd);
+            failed.push_back(conn);
+            continue;
+        }
+        link.snapshot_fd = fd;
+        link.snapshot_pos = 0;
+        link.snapshot_left = static_cast<uint64_t>(st.st_size);
+        link.phase = ReplicaLink::SEND_SNAPSHOT;
+        uint64_t size = link.snapshot_left;
+        append_output(conn, std::string_view(reinterpret_cast<const char*>(&size), 8));
+    }
+    ::unlink(path.c_str());
+    // They reconnect and ask again.
+    for (Connection* conn : failed) close_connection(conn);
+}
+
+// Sends what the socket takes of a replica's snapshot straight from the page
+// cache. Returns true once all of it is out and the held stream is queued.
+bool Server::send_snapshot(Connection* conn) {
+    ReplicaLink& link = *conn->replica;
+    if (link.phase != ReplicaLink::SEND_SNAPSHOT) return false;
+    while (link.snapshot_left > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(link.snapshot_left, size_t(1) << 30));
+        ssize_t n = ::sendfile(conn->fd, link.snapshot_fd, &link.snapshot_pos, chunk);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return false;
+        if (n <= 0) {
+            std::cerr << "replication: cannot send a snapshot: " << (n < 0 ? strerror(errno) : "file cut short") << "\n";
+            conn->state = STATE_END;
+            return false;
+        }
+        link.snapshot_left -= static_cast<uint64_t>(n);
+    }
+    ::close(link.snapshot_fd);
+    link.snapshot_fd = -1;
+    link.phase = ReplicaLink::ONLINE;
+    append_output(conn, link.held);
+    std::string().swap(link.held);
+    return true;
+}
+
+// End of a turn: writes out what the turn fed the replicas, one write each.
+// A replica that fell too far behind is dropped before it holds any more.
+void Server::flush_replicas() {
+    std::vector<Connection*> replicas = replicas_;
+    for (Connection* conn : replicas) {
+        ReplicaLink& link = *conn->replica;
+        if (conn->wbuf.size() + link.held.size() > k_max_replica_output) {
+            std::cerr << "replication: dropping a replica " << conn->wbuf.size() + link.held.size()
+                      << " bytes behind\n";
+            close_connection(conn);
+            continue;
+        }
+        if (conn->state != STATE_REQ || (conn->wbuf.empty() && link.phase != ReplicaLink::SEND_SNAPSHOT)) continue;
+        conn->state = STATE_RES;
+        handle_write(conn);
+        if (conn->state == STATE_END) close_connection(conn);
+        else if (conn->state == STATE_RES) loop_->modify(conn->fd, Interest::WRITE);
+    }
+}
+
+// The stream this server serves starts over; its replicas must resync.
+void Server::drop_replicas() {
+    std::vector<Connection*> replicas = replicas_;
+    for (Connection* conn : replicas) close_connection(conn);
+    backlog_.reset();
+    repl_id_ = new_repl_id();
+}
+
+// REPLICAOF host port | REPLICAOF no one
+void Server::replicaof_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    if (group_) { out_error(out, "Replication is not supported with more than one thread"); return; }
+    if (cmd[1] == "no" && cmd[2] == "one") {
+        // Keeps the data and goes on serving its own stream to any replicas.
+        if (primary_ && primary_->fd >= 0) loop_->remove(primary_->fd);
+        primary_.reset();
+        out_ok(out);
+        return;
+    }
+    uint64_t port = 0;
+    if (!parse_uint(cmd[2], port) || port == 0 || port > 65535) { out_error(out, "Invalid port"); return; }
+    if (primary_ && primary_->host == cmd[1] && primary_->port == port) { out_ok(out); return; }
+    if (primary_ && primary_->fd >= 0) loop_->remove(primary_->fd);
+    primary_ = std::make_unique<PrimaryLink>(std::string(cmd[1]), static_cast<uint16_t>(port));
+    out_ok(out);
+}
+
+// Runs at the end of every loop turn while replication is in use.
+void Server::replication_cron() {
+    int64_t now = now_ms();
+    if (primary_) {
+        PrimaryLink& link = *primary_;
+        if (link.phase == PrimaryLink::DOWN && now >= link.retry_ms) connect_to_primary();
+        if (link.phase == PrimaryLink::STREAM && now - link.ack_ms >= k_repl_ack_ms &&
+            (link.offset != link.acked || now - link.ack_ms >= 1000)) {
+            link.ack_ms = now;
+            link.acked = link.offset;
+            send_to_primary({"replconf", "ack", std::to_string(link.offset)});
+        } else if (link.fd >= 0 && !link.wbuf.empty()) {
+            send_to_primary({});
+        }
+    }
+    if (replicas_.empty()) return;
+    if (child_pid_ <= 0 && now >= sync_retry_ms_) {
+        for (Connection* conn : replicas_) {
+            if (conn->replica->phase == ReplicaLink::WAIT_FORK) {
+                fork_sync();
+                break;
+            }
+        }
+    }
+    flush_replicas();
+}
+
+void Server::connect_to_primary() {
+    PrimaryLink& link = *primary_;
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    std::string port = std::to_string(link.port);
+    int rv = ::getaddrinfo(link.host.c_str(), port.c_str(), &hints, &res);
+    if (rv != 0) {
+        primary_link_down("cannot resolve " + link.host + ": " + gai_strerror(rv));
+        return;
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::string reason = std::string("socket: ") + strerror(errno);
+        ::freeaddrinfo(res);
+        primary_link_down(reason);
+        return;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    rv = ::connect(fd, res->ai_addr, res->ai_addrlen);
+    ::freeaddrinfo(res);
+    if (rv < 0 && errno != EINPROGRESS) {
+        std::string reason = std::string("connect: ") + strerror(errno);
+        ::close(fd);
+        primary_link_down(reason);
+        return;
+    }
+    link.fd = fd;
+    link.phase = PrimaryLink::CONNECTING;
+    link.last_io_ms = now_ms();
+    loop_->add(fd, Interest::WRITE);
+}
+
+void Server::primary_link_down(const std::string& reason) {
+    PrimaryLink& link = *primary_;
+    std::cerr << "replication: link to " << link.host << ":" << link.port << " down: " << reason << "\n";
+    if (link.fd >= 0) {
+        loop_->remove(link.fd);
+        ::close(link.fd);
+        link.fd = -1;
+    }
+    if (link.snapshot_fd >= 0) {
+        ::close(link.snapshot_fd);
+        ::unlink(link.snapshot_tmp.c_str());
+        link.snapshot_fd = -1;
+    }
+    link.rbuf.clear();
+    link.wbuf.clear();
+    link.phase = PrimaryLink::DOWN;
+    link.retry_ms = now_ms() + k_repl_retry_ms;
+}
+
+// Queues `cmd`, if any, and writes what the socket takes. An ACK is dropped
+// rather than queued behind a backlog of them; the next one supersedes it.
+void Server::send_to_primary(const std::vector<std::string_view>& cmd) {
+    PrimaryLink& link = *primary_;
+    if (!cmd.empty() && link.wbuf.size() < 4096) append_request_frame(link.wbuf, cmd);
+    ssize_t n = ::write(link.fd, link.wbuf.data(), link.wbuf.size());
+    if (n > 0) link.wbuf.erase(0, static_cast<size_t>(n));
+    else if (n < 0 && errno != EAGAIN && errno != EINTR) primary_link_down(std::string("write: ") + strerror(errno));
+}
+
+// Readable (or, while connecting, writable) link to the primary.
+void Server::service_primary() {
+    PrimaryLink& link = *primary_;
+    if (link.phase == PrimaryLink::CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        ::getsockopt(link.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err) {
+            primary_link_down(std::string("connect: ") + strerror(err));
+            return;
+        }
+        loop_->modify(link.fd, Interest::READ);
+        link.phase = PrimaryLink::HANDSHAKE;
+        std::string offset = link.repl_id.empty() ? "-1" : std::to_string(link.offset);
+        send_to_primary({"psync", link.repl_id.empty() ? "?" : link.repl_id, offset});
+        return;
+    }
+    const size_t k_read_chunk = 64 * 1024;
+    while (link.fd >= 0) {
+        size_t have = link.rbuf.size();
+        link.rbuf.resize(have + k_read_chunk);
+        ssize_t n = ::read(link.fd, &link.rbuf[have], k_read_chunk);
+        link.rbuf.resize(have + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) primary_link_down(std::string("read: ") + strerror(errno));
+            return;
+        }
+        if (n == 0) {
+            primary_link_down("connection closed");
+            return;
+        }
+        link.last_io_ms = now_ms();
+        if (!consume_primary_input()) return;
+    }
+}
+
+// Takes what it can from the link's buffer: the PSYNC reply, the snapshot
+// into a file, then whole commands. Returns false if the link went down.
+bool Server::consume_primary_input() {
+    PrimaryLink& link = *primary_;
+    std::vector<std::string_view> cmd;
+    size_t pos = 0;
+    for (;;) {
+        const char* data = link.rbuf.data() + pos;
+        size_t avail = link.rbuf.size() - pos;
+        if (link.phase == PrimaryLink::SNAPSHOT) {
+            if (!link.snapshot_sized) {
+                if (avail < 8) break;
+                std::memcpy(&link.snapshot_left, data, 8);
+                link.snapshot_sized = true;
+                pos += 8;
+                continue;
+            }
+            size_t n = static_cast<size_t>(std::min<uint64_t>(avail, link.snapshot_left));
+            for (size_t done = 0; done < n;) {
+                ssize_t w = ::write(link.snapshot_fd, data + done, n - done);
+                if (w < 0 && errno == EINTR) continue;
+                if (w < 0) {
+                    primary_link_down("cannot write " + link.snapshot_tmp + ": " + strerror(errno));
+                    return false;
+                }
+                done += static_cast<size_t>(w);
+            }
+            pos += n;
+            link.snapshot_left -= n;
+            if (link.snapshot_left > 0) break;
+            if (!finish_full_sync()) return false;
+            continue;
+        }
+
+        if (avail < 4) break;
+        uint32_t len = 0;
+        std::memcpy(&len, data, 4);
+        if (len > config_.max_frame) {
+            primary_link_down("frame too long");
+            return false;
+        }
+        if (avail - 4 < len) break;
+        if (link.phase == PrimaryLink::HANDSHAKE) {
+            // [SER_STR or SER_ERR][len u32][text]
+            std::string_view reply(data + 4, len);
+            std::string_view text = reply.size() >= 5 ? reply.substr(5) : std::string_view();
+            if (reply.empty() || reply[0] != SER_STR) {
+                primary_link_down("PSYNC refused: " + std::string(text));
+                return false;
+            }
+            if (text == "CONTINUE") {
+                link.phase = PrimaryLink::STREAM;
+                link.partial_syncs++;
+            } else {
+                size_t space = text.find(' ', 11);
+                if (text.substr(0, 11) != "FULLRESYNC " || space == std::string_view::npos ||
+                    !parse_uint(text.substr(space + 1), link.sync_offset)) {
+                    primary_link_down("bad PSYNC reply");
+                    return false;
+                }
+                link.sync_id = std::string(text.substr(11, space - 11));
+                link.snapshot_tmp = config_.snapshot_path + ".replica." + std::to_string(::getpid());
+                link.snapshot_fd = ::open(link.snapshot_tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (link.snapshot_fd < 0) {
+                    primary_link_down("cannot create " + link.snapshot_tmp + ": " + strerror(errno));
+                    return false;
+                }
+                link.snapshot_sized = false;
+                link.phase = PrimaryLink::SNAPSHOT;
+            }
+        } else {
+            cmd.clear();
+            if (parse_request(reinterpret_cast<const uint8_t*>(data + 4), len, cmd) != 0 || cmd.empty()) {
+                primary_link_down("malformed command in the stream");
+                return false;
+            }
+            replay(cmd);
+            link.offset += 4 + len;
+        }
+        pos += 4 + len;
+    }
+    link.rbuf.erase(0, pos);
+    return true;
+}
+
+// The snapshot has arrived: it replaces the keyspace, and the stream goes on
+// from its offset.
+bool Server::finish_full_sync() {
+    PrimaryLink& link = *primary_;
+    ::close(link.snapshot_fd);
+    link.snapshot_fd = -1;
+    auto start = std::chrono::steady_clock::now();
+    clear_keyspace();
+    SnapshotLoadStats stats;
+    std::string err;
+    bool ok = load_snapshot(link.snapshot_tmp, stats, err);
+    ::unlink(link.snapshot_tmp.c_str());
+    if (!ok) {
+        clear_keyspace();
+        link.repl_id.clear();
+        primary_link_down("cannot load the primary's snapshot: " + err);
+        return false;
+    }
+    std::cerr << "replication: loaded " << stats.keys << " keys (" << stats.expired << " expired, skipped) from "
+              << link.host << ":" << link.port << " in " << usec_since(start) / 1000 << " ms\n";
+    link.repl_id = link.sync_id;
+    link.offset = link.sync_offset;
+    link.acked = link.offset;
+    link.full_syncs++;
+    link.phase = PrimaryLink::STREAM;
+
+    // What was built on the old keyspace starts over: a rewrite in progress
+    // is abandoned, the log is rewritten, and replicas of this one resync.
+    if (child_job_ == ChildJob::REWRITE) {
+        ::kill(child_pid_, SIGKILL);
+        ::waitpid(child_pid_, nullptr, 0);
+        child_pid_ = -1;
+        child_job_ = ChildJob::NONE;
+        aof_->abort_rewrite();
+        ::unlink((aof_file_path() + ".rewrite").c_str());
+    }
+    if (aof_) {
+        aof_.reset();
+        if (!start_aof(true, err)) std::cerr << "cannot rewrite the append-only log: " << err << "\n";
+    }
+    drop_replicas();
+    return true;
+}
+
+// Drops every key, for a replica about to load its primary's snapshot.
+void Server::clear_keyspace() {
+    std::vector<Entry*> entries;
+    entries.reserve(db_.size());
+    db_.for_each([&](std::string_view, Entry* entry) { entries.push_back(entry); });
+    for (Entry* entry : entries) delete_entry(entry);
+    eviction_pool_.clear();
+}
+
+// ===== maxmemory =====
+
+bool parse_eviction_policy(std::string_view name, EvictionPolicy& out) {
+    if (name == "noeviction") out = EvictionPolicy::NOEVICTION;
+    else if (name == "allkeys-lru") out = EvictionPolicy::ALLKEYS_LRU;
+    else if (name == "allkeys-lfu") out = EvictionPolicy::ALLKEYS_LFU;
+    else if (name == "volatile-ttl") out = EvictionPolicy::VOLATILE_TTL;
+    else return false;
+    return true;
+}
+
+// Keys sampled from the keyspace per eviction, and how many of the best
+// candidates seen are remembered across evictions.
+static const unsigned int k_eviction_samples = 5;
+static const size_t k_eviction_pool_size = 16;
+
+// LFU counter: new keys start at k_lfu_init so they are not evicted before
+// they have had a chance to be read. Each access increments the counter with
+// probability 1 / ((counter - init) * log_factor + 1), so reaching 255 takes
+// about a million hits; each idle decay period subtracts one.
+static const uint32_t k_lfu_init = 5;
+static const uint32_t k_lfu_log_factor = 10;
+static const uint32_t k_lfu_decay_minutes = 1;
+
+static uint32_t lfu_minutes(int64_t now) {
+    return static_cast<uint32_t>(now / 60000) & 0xFFFFFF;
+}
+
+static uint32_t lfu_decayed_counter(uint32_t access, int64_t now) {
+    uint32_t counter = access & 0xFF;
+    uint32_t elapsed = (lfu_minutes(now) - (access >> 8)) & 0xFFFFFF;
+    uint32_t periods = elapsed / k_lfu_decay_minutes;
+    return periods >= counter ? 0 : counter - periods;
+}
+
+uint64_t Server::next_random() {
+    // xorshift64*
+    rng_ ^= rng_ >> 12;
+    rng_ ^= rng_ << 25;
+    rng_ ^= rng_ >> 27;
+    return rng_ * 0x2545F4914F6CDD1DULL;
+}
+
+uint32_t Server::initial_access() const {
+    int64_t now = now_ms();
+    if (config_.maxmemory_policy == EvictionPolicy::ALLKEYS_LFU) {
+        return (lfu_minutes(now) << 8) | k_lfu_init;
+    }
+    return static_cast<uint32_t>(now);
+}
+
+// Records an access for the eviction policy in use.
+void Server::touch(Entry* entry) {
+    if (config_.maxmemory == 0) return;
+    int64_t now = now_ms();
+    if (config_.maxmemory_policy != EvictionPolicy::ALLKEYS_LFU) {
+        entry->access = static_cast<uint32_t>(now);
+        return;
+    }
+    uint32_t counter = lfu_decayed_counter(entry->access, now);
+    if (counter < 255) {
+        uint32_t base = counter > k_lfu_init ? counter - k_lfu_init : 0;
+        double r = (next_random() >> 11) * (1.0 / 9007199254740992.0);
+        if (r < 1.0 / (base * k_lfu_log_factor + 1)) counter++;
+    }
+    entry->access = (lfu_minutes(now) << 8) | counter;
+}
+
+// Higher scores are evicted first.
+uint64_t Server::eviction_score(const Entry* entry, int64_t now) const {
+    if (config_.maxmemory_policy == EvictionPolicy::ALLKEYS_LFU) {
+        return 255 - lfu_decayed_counter(entry->access, now);
+    }
+    return static_cast<uint32_t>(static_cast<uint32_t>(now) - entry->access);  // idle ms
+}
 
-    while (true) {
-        std::vector<pollfd> pollfds;
-        pollfds.push_back({listen_fd, POLLIN, 0});
-        for (Connection* conn : fd2conn_) {
-            if (conn) {
-                pollfd pfd = {conn->fd, 0, 0};
-                if (conn->state == STATE_REQ) {
-                    pfd.events = POLLIN;
-                } else if (conn->state == STATE_RES) {
-                    pfd.events = POLLOUT;
-                }
-                pfd.events |= POLLERR;
-                pollfds.push_back(pfd);
-            }
+// Makes room for a write. Returns false when the write must be refused.
+bool Server::evict_for_write() {
+    while (used_memory() > config_.maxmemory) {
+        if (config_.maxmemory_policy == EvictionPolicy::NOEVICTION || !evict_one()) {
+            return false;
         }
+    }
+    return true;
+}
 
-        int rv = ::poll(pollfds.data(), pollfds.size(), 1000);
-        if (rv < 0) {
-            perror("poll");
-            exit(1);
-        }
+bool Server::evict_one() {
+    if (config_.maxmemory_policy == EvictionPolicy::VOLATILE_TTL) {
+        // The TTL heap already orders volatile keys exactly; no need to sample.
+        Entry* soonest = ttl_.top();
+        if (!soonest) return false;
+        evict_entry(soonest);
+        return true;
+    }
 
-        size_t idx = 0;
-        if (pollfds[idx++].revents & POLLIN) {
-            accept_new_connection(listen_fd);
-        }
+    int64_t now = now_ms();
+    for (int attempt = 0; attempt < 16 && db_.size() > 0; ++attempt) {
+        db_.sample(next_random(), k_eviction_samples, [&](std::string_view key, Entry* entry) {
+            uint64_t score = eviction_score(entry, now);
+            auto& pool = eviction_pool_;
+            if (pool.size() == k_eviction_pool_size && score <= pool.front().score) return;
+            for (const EvictionCandidate& c : pool) {
+                if (c.key == key) return;
+            }
+            auto pos = std::upper_bound(pool.begin(), pool.end(), score,
+                                        [](uint64_t s, const EvictionCandidate& c) { return s < c.score; });
+            pool.insert(pos, EvictionCandidate{score, std::string(key)});
+            if (pool.size() > k_eviction_pool_size) pool.erase(pool.begin());
+        });
 
-        for (; idx < pollfds.size(); ++idx) {
-            pollfd& pfd = pollfds[idx];
-            Connection* conn = fd2conn_[pfd.fd];
-            if (!conn) continue;
-            if (pfd.revents & (POLLIN | POLLOUT | POLLERR)) {
-                handle_connection_io(conn);
-                if (conn->state == STATE_END) {
-                    close_connection(conn);
-                    fd2conn_[pfd.fd] = nullptr;
-                    delete conn;
-                }
+        // Candidates may have been deleted since they were pooled.
+        while (!eviction_pool_.empty()) {
+            std::string key = std::move(eviction_pool_.back().key);
+            eviction_pool_.pop_back();
+            if (Entry* entry = db_.get(key)) {
+                evict_entry(entry);
+                return true;
             }
         }
     }
+    return false;
+}
+
+void Server::stop() {
+    stopping_.store(true, std::memory_order_relaxed);
+    wake();
 }
 
-void Server::accept_new_connection(int listen_fd) {
-    sockaddr_in client_addr{};
-    socklen_t socklen = sizeof(client_addr);
-    int conn_fd = ::accept(listen_fd, (sockaddr*)&client_addr, &socklen);
-    if (conn_fd >= 0) {
+void Server::wake() {
+    uint64_t one = 1;
+    ssize_t rv = ::write(wake_fd_, &one, sizeof(one));
+    (void)rv;
+}
+
+void Server::accept_new_connections(int listen_fd) {
+    // The listener is edge-triggered under epoll, so drain the accept queue.
+    while (true) {
+        sockaddr_in client_addr{};
+        socklen_t socklen = sizeof(client_addr);
+        int conn_fd = ::accept(listen_fd, (sockaddr*)&client_addr, &socklen);
+        if (conn_fd < 0) break;
+
         fcntl(conn_fd, F_SETFL, O_NONBLOCK);
-        Connection* conn = new Connection(conn_fd);
+        // Replies can now leave in several writes per batch (e.g. around a
+        // request forwarded to another shard); don't let Nagle hold them back
+        // waiting for the client's delayed ACK.
+        int one = 1;
+        ::setsockopt(conn_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Connection* conn = new Connection(conn_fd, next_conn_id_++);
+        mem_.connections += connection_memory(conn);
         if (fd2conn_.size() <= (size_t)conn_fd) {
             fd2conn_.resize(conn_fd + 1, nullptr);
         }
         fd2conn_[conn_fd] = conn;
+        loop_->add(conn_fd, Interest::READ);
     }
 }
 
 void Server::close_connection(Connection* conn) {
+    if (conn->replica) replicas_.erase(std::find(replicas_.begin(), replicas_.end(), conn));
+    loop_->remove(conn->fd);
     ::close(conn->fd);
+    fd2conn_[conn->fd] = nullptr;
+    mem_.connections -= connection_memory(conn);
+    delete conn;
 }
 
-void Server::handle_connection_io(Connection* conn) {
-    if (conn->state == STATE_REQ) {
-        handle_read(conn);
-    } else if (conn->state == STATE_RES) {
-        handle_write(conn);
+void Server::service_connection(Connection* conn) {
+    // Interest was registered for `before`; only touch the backend when the
+    // state actually flips.
+    ConnectionState before = conn->state;
+    handle_connection_io(conn);
+    if (conn->state == STATE_END) {
+        close_connection(conn);
+    } else if (conn->state != before) {
+        loop_->modify(conn->fd, interest_for(conn->state));
     }
 }
 
+void Server::handle_connection_io(Connection* conn) {
+    // Keep going while the state flips: a finished write may leave complete
+    // requests in rbuf or unread bytes in the socket, and with edge-triggered
+    // epoll nobody will tell us about them again.
+    ConnectionState before;
+    do {
+        before = conn->state;
+        if (conn->state == STATE_REQ) {
+            handle_read(conn);
+        } else if (conn->state == STATE_RES) {
+            handle_write(conn);
+        }
+    } while (conn->state != before && conn->state != STATE_END);
+}
+
 void Server::handle_read(Connection* conn) {
-    while (true) {
-        uint8_t buf[4096];
-        ssize_t n = ::read(conn->fd, buf, sizeof(buf));
+    while (conn->state == STATE_REQ) {
+        process_requests(conn);
+        if (conn->state != STATE_REQ || conn->wbuf.size() >= Connection::k_max_wbuf) break;
+
+        // The rest of a large argument skips rbuf and lands in its buffer.
+        ssize_t n = 0;
+        Connection::BulkRequest* bulk = conn->bulk.get();
+        if (bulk && bulk->phase == Connection::BulkRequest::DATA && conn->rbuf.empty() &&
+            bulk->lens.back() - bulk->filled >= conn->rbuf.capacity()) {
+            n = ::read(conn->fd, bulk->args.back()->data() + bulk->filled, bulk->lens.back() - bulk->filled);
+            if (n > 0) {
+                bulk->filled += static_cast<uint32_t>(n);
+                bulk->remaining -= static_cast<uint32_t>(n);
+            }
+        } else {
+            // A zero-length readv would look like EOF.
+            if (conn->rbuf.free_space() == 0) break;
+            n = conn->rbuf.read_from(conn->fd);
+        }
         if (n < 0) {
             if (errno == EAGAIN) {
                 break;
+            } else if (errno == EINTR) {
+                continue;
             } else {
                 perror("read");
                 conn->state = STATE_END;
@@ -101,162 +1613,916 @@ void Server::handle_read(Connection* conn) {
         } else if (n == 0) {
             conn->state = STATE_END;
             break;
+        }
+    }
+    // Everything answered this turn goes out in a single flush, once the
+    // writes among it are on disk if appendfsync is always.
+    if (conn->state == STATE_REQ && !conn->wbuf.empty() &&
+        !(aof_ && conn->aof_turn > aof_->durable_turn())) {
+        conn->state = STATE_RES;
+    }
+}
+
+// Executes every complete frame in rbuf and appends the framed responses to
+// wbuf, stopping early once k_max_wbuf bytes are queued so one pipelining
+// client cannot grow its output without bound.
+void Server::process_requests(Connection* conn) {
+    std::vector<std::string_view> cmd;
+    std::string response;
+    while (conn->pending.size() < Connection::k_max_pending &&
+           conn->wbuf.size() < Connection::k_max_wbuf) {
+        if (conn->bulk) {
+            int rv = receive_bulk(conn);
+            if (rv < 0) {
+                std::cerr << "Bad request\n";
+                conn->state = STATE_END;
+                break;
+            }
+            if (rv == 0) break;
+
+            Connection::BulkRequest& bulk = *conn->bulk;
+            cmd.clear();
+            for (uint32_t i = 0; i < bulk.argc; ++i) cmd.emplace_back(bulk.args[i]->data(), bulk.lens[i]);
+            // Buffers a SET keeps move from the connection's account to the
+            // keyspace's.
+            mem_.connections -= connection_memory(conn);
+            bulk_args_ = &bulk.args;
+            execute_request(conn, cmd, nullptr, 0, response);
+            bulk_args_ = nullptr;
+            conn->bulk.reset();
+            mem_.connections += connection_memory(conn);
+            continue;
+        }
+
+        if (conn->rbuf.size() < 4) break;
+        uint32_t len = 0;
+        conn->rbuf.peek(0, &len, 4);
+        if (len > config_.max_frame) {
+            std::cerr << "Message too long\n";
+            conn->state = STATE_END;
+            break;
+        }
+        if (len > Connection::k_max_rbuf_frame) {
+            conn->rbuf.consume(4);
+            mem_.connections -= connection_memory(conn);
+            conn->bulk = std::make_unique<Connection::BulkRequest>(len);
+            mem_.connections += connection_memory(conn);
+            continue;
+        }
+        if (conn->rbuf.size() < 4 + len) break;
+
+        // Parse in place unless the frame wraps around the end of the ring.
+        const uint8_t* frame = conn->rbuf.contiguous(4, len);
+        if (!frame) {
+            mem_.connections -= connection_memory(conn);
+            conn->frame_scratch.resize(len);
+            mem_.connections += connection_memory(conn);
+            conn->rbuf.peek(4, conn->frame_scratch.data(), len);
+            frame = conn->frame_scratch.data();
+        }
+
+        cmd.clear();
+        if (parse_request(frame, len, cmd) != 0) {
+            std::cerr << "Bad request\n";
+            conn->state = STATE_END;
+            break;
+        }
+        execute_request(conn, cmd, frame, len, response);
+        conn->rbuf.consume(4 + len);
+    }
+}
+
+// Runs one parsed request here, or forwards it to the shard that owns it.
+// `frame` is the request as received, or nullptr for a bulk request.
+void Server::execute_request(Connection* conn, const std::vector<std::string_view>& cmd,
+                             const uint8_t* frame, uint32_t len, std::string& response) {
+    response.clear();
+    const CommandSpec* spec = cmd.empty() ? nullptr : find_command(cmd[0]);
+    if (conn->replica) {
+        // Anything else a replica sends is ignored.
+        if (spec && spec->link_handler == &Server::replconf_command) replconf_command(conn, cmd);
+        return;
+    }
+    if (spec && spec->link_handler && spec->arity_ok(cmd.size())) {
+        (this->*spec->link_handler)(conn, cmd);
+        return;
+    }
+    if (group_ && dispatch_remote(conn, spec, cmd, frame, len, response)) return;
+    if (!conn->pending.empty()) {
+        run_command(spec, cmd, response);
+        queue_reply(conn, response);
+        hold_for_aof(conn);
+        return;
+    }
+    // Nothing is owed ahead of this reply: serialize it in place.
+    size_t capacity = conn->wbuf.capacity();
+    OutputQueue::FrameMark mark = conn->wbuf.begin_frame();
+    run_command(spec, cmd, ReplyOut(conn->wbuf));
+    conn->wbuf.end_frame(mark);
+    if (conn->wbuf.capacity() != capacity) {
+        mem_.connections += alloc_size(conn->wbuf.capacity()) - alloc_size(capacity);
+    }
+    hold_for_aof(conn);
+}
+
+// Moves bytes of a bulk request from rbuf into its argument buffers, checking
+// the layout parse_request() would. Returns 1 once the whole frame has
+// arrived, 0 while more is needed and -1 on a malformed frame.
+int Server::receive_bulk(Connection* conn) {
+    using Bulk = Connection::BulkRequest;
+    Bulk& bulk = *conn->bulk;
+    while (bulk.phase != Bulk::DONE) {
+        if (bulk.phase == Bulk::DATA) {
+            uint32_t len = bulk.lens.back();
+            uint32_t n = static_cast<uint32_t>(std::min<size_t>(len - bulk.filled, conn->rbuf.size()));
+            conn->rbuf.peek(0, bulk.args.back()->data() + bulk.filled, n);
+            conn->rbuf.consume(n);
+            bulk.filled += n;
+            bulk.remaining -= n;
+            if (bulk.filled < len) return 0;
+            bulk.filled = 0;
+            bulk.phase = bulk.args.size() == bulk.argc ? Bulk::DONE : Bulk::LEN;
+            continue;
+        }
+
+        // A 4-byte argument count or length prefix, possibly split.
+        if (bulk.remaining < 4 - bulk.filled) return -1;
+        uint32_t n = static_cast<uint32_t>(std::min<size_t>(4 - bulk.filled, conn->rbuf.size()));
+        conn->rbuf.peek(0, bulk.prefix + bulk.filled, n);
+        conn->rbuf.consume(n);
+        bulk.filled += n;
+        bulk.remaining -= n;
+        if (bulk.filled < 4) return 0;
+        bulk.filled = 0;
+        uint32_t value = 0;
+        std::memcpy(&value, bulk.prefix, 4);
+        if (bulk.phase == Bulk::ARGC) {
+            if (value == 0 || value > 1024) return -1;
+            bulk.argc = value;
+            bulk.args.reserve(value);
+            bulk.lens.reserve(value);
+            bulk.phase = Bulk::LEN;
         } else {
-            conn->rbuf.insert(conn->rbuf.end(), buf, buf + n);
-            while (true) {
-                if (conn->rbuf.size() < 4) break;
-                uint32_t len = 0;
-                std::memcpy(&len, &conn->rbuf[0], 4);
-                if (len > Connection::k_max_msg) {
-                    std::cerr << "Message too long\n";
-                    conn->state = STATE_END;
-                    break;
-                }
-                if (conn->rbuf.size() < 4 + len) break;
+            if (value > bulk.remaining) return -1;
+            // The pages of a large buffer are only touched as the argument
+            // arrives.
+            bulk.args.emplace_back(ValueBuffer::create(value));
+            bulk.lens.push_back(value);
+            bulk.bytes += value;
+            mem_.connections += value;
+            bulk.phase = Bulk::DATA;
+        }
+    }
+    return bulk.remaining == 0 ? 1 : -1;
+}
 
-                std::vector<std::string> cmd;
-                if (parse_request(&conn->rbuf[4], len, cmd) != 0) {
-                    std::cerr << "Bad request\n";
-                    conn->state = STATE_END;
-                    break;
-                }
-                std::string response;
-                handle_command(cmd, response);
+// Frames `response` into wbuf, or parks it behind replies still owed by other
+// shards so the client sees responses in request order.
+void Server::queue_reply(Connection* conn, const std::string& response) {
+    if (!conn->pending.empty()) {
+        conn->pending.push_back({conn->next_seq++, 0, {response}, {}});
+        return;
+    }
+    append_frame(conn, response);
+}
 
-                uint32_t wlen = static_cast<uint32_t>(response.size());
-                conn->wbuf.resize(4 + wlen);
-                std::memcpy(&conn->wbuf[0], &wlen, 4);
-                std::memcpy(&conn->wbuf[4], response.data(), wlen);
-                conn->wbuf_sent = 0;
-                conn->state = STATE_RES;
+// Appends one length-prefixed reply to wbuf.
+void Server::append_frame(Connection* conn, std::string_view reply) {
+    uint32_t wlen = static_cast<uint32_t>(reply.size());
+    append_output(conn, std::string_view(reinterpret_cast<const char*>(&wlen), 4));
+    append_output(conn, reply);
+}
 
-                conn->rbuf.erase(conn->rbuf.begin(), conn->rbuf.begin() + 4 + len);
-                break;
-            }
+// Appends raw bytes to wbuf, accounting for any growth.
+void Server::append_output(Connection* conn, std::string_view data) {
+    size_t capacity = conn->wbuf.capacity();
+    conn->wbuf.append(data.data(), data.size());
+    if (conn->wbuf.capacity() != capacity) {
+        mem_.connections += alloc_size(conn->wbuf.capacity()) - alloc_size(capacity);
+    }
+}
+
+// ===== Multi-core mode: cross-shard forwarding =====
+
+// Which shard(s) a command must run on: the argument index of its first key,
+// k_route_all for commands that span the whole keyspace, or k_route_local for
+// commands that are answered wherever they arrive (including malformed ones,
+// whose error is the same on every shard).
+static const int k_route_local = 0;
+static const int k_route_all = -1;
+static const int k_route_cursor = -2;  // the shard is encoded in cmd[1]
+
+static int route_of(const CommandSpec* spec, const std::vector<std::string_view>& cmd) {
+    if (!spec || !spec->arity_ok(cmd.size())) return k_route_local;
+    if (spec->flags & CMD_ALL_SHARDS) return k_route_all;
+    if (spec->flags & CMD_CURSOR) return k_route_cursor;
+    return spec->first_key;
+}
+
+// Concatenates SER_ARR replies from several shards into one array. If any
+// shard failed, its error is the reply; other non-array parts (the same
+// status from every shard, as for SAVE) are returned as is.
+static std::string merge_array_replies(const std::vector<std::string>& parts) {
+    for (const std::string& part : parts) {
+        if (!part.empty() && part[0] == SER_ERR) return part;
+    }
+    uint32_t total = 0;
+    for (const std::string& part : parts) {
+        if (part.size() < 5 || part[0] != SER_ARR) return part;
+        uint32_t n = 0;
+        std::memcpy(&n, &part[1], 4);
+        total += n;
+    }
+    std::string out;
+    out.push_back(SER_ARR);
+    out.append((const char*)&total, 4);
+    for (const std::string& part : parts) {
+        out.append(part, 5, std::string::npos);
+    }
+    return out;
+}
+
+// The size of the serialized value at `pos` of a reply.
+static size_t reply_value_size(const std::string& reply, size_t pos) {
+    uint32_t n = 0;
+    switch (reply[pos]) {
+    case SER_NIL:
+        return 1;
+    case SER_INT:
+    case SER_DBL:
+        return 9;
+    case SER_ARR: {
+        std::memcpy(&n, &reply[pos + 1], 4);
+        size_t end = pos + 5;
+        for (uint32_t i = 0; i < n; ++i) end += reply_value_size(reply, end);
+        return end - pos;
+    }
+    default:  // SER_STR, SER_ERR
+        std::memcpy(&n, &reply[pos + 1], 4);
+        return 5 + n;
+    }
+}
+
+// Reassembles the replies to a command split across shards, `parts` indexed
+// by shard. If any shard failed, its error is the reply. Arrays, one element
+// per key as from MGET, are interleaved back into request order; any other
+// reply, the same status from every shard as for MSET, is returned once.
+static std::string merge_split_replies(const std::vector<std::string>& parts,
+                                       const std::vector<unsigned int>& key_shards) {
+    for (const std::string& part : parts) {
+        if (!part.empty() && part[0] == SER_ERR) return part;
+    }
+    const std::string& first = parts[key_shards[0]];
+    if (first.size() < 5 || first[0] != SER_ARR) return first;
+    std::vector<size_t> next(parts.size(), 5);
+    std::string out;
+    out.push_back(SER_ARR);
+    uint32_t total = static_cast<uint32_t>(key_shards.size());
+    out.append((const char*)&total, 4);
+    for (unsigned int shard : key_shards) {
+        size_t size = reply_value_size(parts[shard], next[shard]);
+        out.append(parts[shard], next[shard], size);
+        next[shard] += size;
+    }
+    return out;
+}
+
+// The request to forward to another shard: the frame as received, or for a
+// bulk request (no frame) the arguments encoded again.
+static std::string request_payload(const std::vector<std::string_view>& cmd, const uint8_t* frame, uint32_t len) {
+    if (frame) return std::string((const char*)frame, len);
+    std::string out;
+    uint32_t argc = static_cast<uint32_t>(cmd.size());
+    out.append((const char*)&argc, 4);
+    for (std::string_view arg : cmd) {
+        uint32_t n = static_cast<uint32_t>(arg.size());
+        out.append((const char*)&n, 4);
+        out.append(arg);
+    }
+    return out;
+}
+
+// Sends `cmd` to the shard(s) that must execute it and reserves its slot in
+// the connection's pending replies. Returns false when it should simply run
+// here.
+bool Server::dispatch_remote(Connection* conn, const CommandSpec* spec, const std::vector<std::string_view>& cmd,
+                             const uint8_t* frame, uint32_t len, std::string& response) {
+    int route = route_of(spec, cmd);
+    if (route == k_route_local) return false;
+
+    uint64_t seq = conn->next_seq;
+    if (route > 0) {
+        unsigned int owner = group_->shard_of(cmd[route]);
+        // A multi-key command whose keys live on several shards runs on each
+        // with its own keys. One whose keys do not come in whole steps is
+        // left to its handler to refuse.
+        size_t last = spec->last_key_index(cmd.size());
+        for (size_t i = route + spec->key_step; i <= last; i += spec->key_step) {
+            if (group_->shard_of(cmd[i]) == owner) continue;
+            if ((cmd.size() - spec->first_key) % spec->key_step != 0) return false;
+            dispatch_split(conn, spec, cmd);
+            return true;
+        }
+        if (owner == shard_id_) return false;
+        conn->pending.push_back({seq, 1, {}, {}});
+        send_to_shard(owner, ShardMessage{ShardMessage::REQUEST, shard_id_, conn->fd, conn->id, seq,
+                                          request_payload(cmd, frame, len)});
+    } else if (route == k_route_cursor) {
+        // A malformed cursor, or one naming no shard, is rejected locally.
+        uint64_t cursor = 0;
+        if (!parse_uint(cmd[1], cursor)) return false;
+        uint64_t owner = cursor >> k_scan_shard_shift;
+        if (owner == shard_id_ || owner >= group_->size()) return false;
+        conn->pending.push_back({seq, 1, {}, {}});
+        send_to_shard(static_cast<unsigned int>(owner),
+                      ShardMessage{ShardMessage::REQUEST, shard_id_, conn->fd, conn->id, seq,
+                                   request_payload(cmd, frame, len)});
+    } else {
+        if (group_->size() == 1) return false;
+        // Fan out: run the local part now and gather the rest.
+        run_command(spec, cmd, response);
+        conn->pending.push_back({seq, group_->size() - 1, {response}, {}});
+        for (unsigned int i = 0; i < group_->size(); ++i) {
+            if (i == shard_id_) continue;
+            send_to_shard(i, ShardMessage{ShardMessage::REQUEST, shard_id_, conn->fd, conn->id, seq,
+                                          request_payload(cmd, frame, len)});
         }
     }
+    conn->next_seq++;
+    return true;
 }
 
-void Server::handle_write(Connection* conn) {
-    while (conn->wbuf_sent < conn->wbuf.size()) {
-        ssize_t n = ::write(conn->fd, &conn->wbuf[conn->wbuf_sent], conn->wbuf.size() - conn->wbuf_sent);
-        if (n < 0) {
-            if (errno == EAGAIN) {
-                break;
+// Splits a multi-key command into one command per shard holding that
+// shard's keys, each with the arguments that follow it, in request order.
+// The local part runs now; one pending reply gathers the rest.
+void Server::dispatch_split(Connection* conn, const CommandSpec* spec, const std::vector<std::string_view>& cmd) {
+    Connection::PendingReply slot{conn->next_seq++, 0, std::vector<std::string>(group_->size()), {}};
+    std::vector<std::vector<std::string_view>> split(group_->size());
+    size_t last = spec->last_key_index(cmd.size());
+    for (size_t i = spec->first_key; i <= last; i += spec->key_step) {
+        unsigned int shard = group_->shard_of(cmd[i]);
+        if (split[shard].empty()) split[shard].assign(cmd.begin(), cmd.begin() + spec->first_key);
+        split[shard].insert(split[shard].end(), cmd.begin() + i, cmd.begin() + i + spec->key_step);
+        slot.key_shards.push_back(shard);
+    }
+    for (unsigned int i = 0; i < group_->size(); ++i) {
+        if (split[i].empty()) continue;
+        if (i == shard_id_) {
+            run_command(spec, split[i], slot.parts[i]);
+            hold_for_aof(conn);
+            continue;
+        }
+        slot.awaiting++;
+        send_to_shard(i, ShardMessage{ShardMessage::REQUEST, shard_id_, conn->fd, conn->id, slot.seq,
+                                      request_payload(split[i], nullptr, 0)});
+    }
+    conn->pending.push_back(std::move(slot));
+}
+
+void Server::send_to_shard(unsigned int shard, ShardMessage&& msg) {
+    // Preserve per-destination order: once something has spilled, everything
+    // after it spills too until the outbox drains.
+    if (!outbox_[shard].empty() || !group_->queue(shard_id_, shard).push(std::move(msg))) {
+        outbox_[shard].push_back(std::move(msg));
+    }
+    notify_[shard] = true;
+}
+
+// Moves spilled messages into their queues and wakes every shard that was sent
+// something this turn. Returns true if anything is still waiting for room.
+bool Server::flush_outbox() {
+    bool pending = false;
+    for (unsigned int i = 0; i < outbox_.size(); ++i) {
+        std::deque<ShardMessage>& box = outbox_[i];
+        while (!box.empty() && group_->queue(shard_id_, i).push(std::move(box.front()))) {
+            box.pop_front();
+        }
+        pending |= !box.empty();
+        if (notify_[i]) {
+            notify_[i] = false;
+            group_->notify(i);
+        }
+    }
+    return pending;
+}
+
+void Server::drain_shard_queues() {
+    std::vector<std::string_view> cmd;
+    ShardMessage msg;
+    for (unsigned int from = 0; from < group_->size(); ++from) {
+        if (from == shard_id_) continue;
+        SpscQueue<ShardMessage>& q = group_->queue(from, shard_id_);
+        while (q.pop(msg)) {
+            if (msg.kind == ShardMessage::REPLY) {
+                deliver_reply(msg);
+                continue;
+            }
+            cmd.clear();
+            std::string response;
+            if (parse_request((const uint8_t*)msg.payload.data(), msg.payload.size(), cmd) == 0) {
+                handle_command(cmd, response);
             } else {
-                perror("write");
-                conn->state = STATE_END;
-                break;
+                out_error(response, "Bad request");
             }
-        } else {
-            conn->wbuf_sent += static_cast<size_t>(n);
+            if (aof_ && config_.appendfsync == AofFsync::ALWAYS && aof_->turn_dirty()) {
+                aof_held_.push_back({aof_->turn(), from, ShardMessage{ShardMessage::REPLY, shard_id_, msg.fd,
+                                                                      msg.conn_id, msg.seq, std::move(response)}});
+                continue;
+            }
+            send_to_shard(from, ShardMessage{ShardMessage::REPLY, shard_id_, msg.fd, msg.conn_id,
+                                             msg.seq, std::move(response)});
         }
     }
-    if (conn->wbuf_sent == conn->wbuf.size()) {
-        conn->wbuf.clear();
-        conn->wbuf_sent = 0;
+    flush_outbox();
+}
+
+void Server::deliver_reply(ShardMessage& msg) {
+    Connection* conn = (size_t)msg.fd < fd2conn_.size() ? fd2conn_[msg.fd] : nullptr;
+    if (!conn || conn->id != msg.conn_id || conn->pending.empty() ||
+        msg.seq < conn->pending.front().seq) {
+        return;  // the connection went away while the request was in flight
+    }
+
+    Connection::PendingReply& slot = conn->pending[msg.seq - conn->pending.front().seq];
+    if (slot.key_shards.empty()) slot.parts.push_back(std::move(msg.payload));
+    else slot.parts[msg.from_shard] = std::move(msg.payload);
+    slot.awaiting--;
+    flush_pending(conn);
+
+    // Resume the pipeline: run any frames that were held back, then flush.
+    if (conn->state == STATE_REQ) {
+        service_connection(conn);
+    }
+}
+
+// Moves every completed reply at the front of the pending queue into wbuf.
+void Server::flush_pending(Connection* conn) {
+    while (!conn->pending.empty() && conn->pending.front().awaiting == 0) {
+        Connection::PendingReply& slot = conn->pending.front();
+        std::string reply = !slot.key_shards.empty() ? merge_split_replies(slot.parts, slot.key_shards)
+                            : slot.parts.size() == 1 ? std::move(slot.parts[0])
+                                                     : merge_array_replies(slot.parts);
+        conn->pending.pop_front();
+        append_frame(conn, reply);
+    }
+}
+
+void Server::handle_write(Connection* conn) {
+    // A replica's snapshot follows what is queued ahead of it, and queues
+    // the stream behind it once it is out.
+    do {
+        while (!conn->wbuf.empty()) {
+            ssize_t n = conn->wbuf.write_to(conn->fd);
+            if (n < 0) {
+                if (errno == EAGAIN) {
+                    break;
+                } else if (errno == EINTR) {
+                    continue;
+                } else {
+                    perror("write");
+                    conn->state = STATE_END;
+                    break;
+                }
+            }
+        }
+    } while (conn->replica && conn->state == STATE_RES && conn->wbuf.empty() && send_snapshot(conn));
+    if (conn->state == STATE_RES && conn->wbuf.empty() &&
+        !(conn->replica && conn->replica->phase == ReplicaLink::SEND_SNAPSHOT)) {
         conn->state = STATE_REQ;
     }
 }
 
-// ===== Commands (same logic as your original handle_command) =====
+// [member, score, member, score, ...]
+static void out_member_scores(ReplyOut out, const std::vector<std::pair<std::string, double>>& result) {
+    out.push_back(SER_ARR);
+    uint32_t len = static_cast<uint32_t>(result.size() * 2);
+    out.append((char*)&len, 4);
+    for (const auto& pair : result) {
+        out_string(out, pair.first);
+        out_double(out, pair.second);
+    }
+}
+
+// A string entry's value. A HEAP value goes to a connection's output queue
+// by reference instead of being copied.
+static void out_string_value(ReplyOut out, const Entry* entry) {
+    char scratch[Entry::k_max_int_chars];
+    std::string_view value = entry->str_value(scratch);
+    if (ValueBuffer* buf = entry->heap_buffer()) out_shared_string(out, buf, value.size());
+    else out_string(out, value);
+}
 
-#include <cstdlib>
+// Parses a finite double spanning all of `s`.
+static bool parse_double(std::string_view s, double& out) {
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return ec == std::errc() && ptr == s.data() + s.size() && std::isfinite(out);
+}
+
+// Parses a score spanning all of `s`: any double but NaN, so that "-inf" and
+// "inf" can bound a range.
+static bool parse_score(std::string_view s, double& out) {
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return ec == std::errc() && ptr == s.data() + s.size() && !std::isnan(out);
+}
+
+static bool parse_int32(std::string_view s, int& out) {
+    int64_t value = 0;
+    if (!Entry::parse_int(s, value) || value < INT32_MIN || value > INT32_MAX) return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+// Every command. CMD_WRITE commands that reach their handler are logged and
+// replicated even when they fail: they fail the same way on replay.
+constexpr CommandSpec Server::k_commands[] = {
+    // name          arity  flags                        keys      handler
+    {"get",             -2, 0,                           1, 1, 1,  &Server::get_command, nullptr},
+    {"set",              3, CMD_WRITE | CMD_DENYOOM,     1, 1, 1,  &Server::set_command, nullptr},
+    {"mget",            -2, 0,                           1, -1, 1, &Server::mget_command, nullptr},
+    {"mset",            -3, CMD_WRITE | CMD_DENYOOM,     1, -1, 2, &Server::mset_command, nullptr},
+    {"incr",             2, CMD_WRITE | CMD_DENYOOM,     1, 1, 1,  &Server::incr_command, nullptr},
+    {"decr",             2, CMD_WRITE | CMD_DENYOOM,     1, 1, 1,  &Server::decr_command, nullptr},
+    {"incrby",           3, CMD_WRITE | CMD_DENYOOM,     1, 1, 1,  &Server::incrby_command, nullptr},
+    {"incrbyfloat",      3, CMD_WRITE | CMD_DENYOOM,     1, 1, 1,  &Server::incrbyfloat_command, nullptr},
+    {"del",              2, CMD_WRITE,                   1, 1, 1,  &Server::del_command, nullptr},
+    {"keys",             1, CMD_ALL_SHARDS,              0, 0, 0,  &Server::keys_command, nullptr},
+    {"scan",            -2, CMD_CURSOR,                  0, 0, 0,  &Server::scan_command, nullptr},
+    {"info",             1, CMD_ALL_SHARDS,              0, 0, 0,  &Server::info_command, nullptr},
+    {"save",             1, CMD_ALL_SHARDS,              0, 0, 0,  &Server::save_command, nullptr},
+    {"bgsave",           1, CMD_ALL_SHARDS,              0, 0, 0,  &Server::bgsave_command, nullptr},
+    {"bgrewriteaof",     1, CMD_ALL_SHARDS,              0, 0, 0,  &Server::bgrewriteaof_command, nullptr},
+    {"memory",           3, 0,                           2, 2, 1,  &Server::memory_command, nullptr},
+    {"zadd",             4, CMD_WRITE | CMD_DENYOOM,     1, 1, 1,  &Server::zadd_command, nullptr},
+    {"zrem",             3, CMD_WRITE,                   1, 1, 1,  &Server::zrem_command, nullptr},
+    {"zscore",           3, 0,                           1, 1, 1,  &Server::zscore_command, nullptr},
+    {"zquery",           6, 0,                           1, 1, 1,  &Server::zquery_command, nullptr},
+    {"zrank",            3, 0,                           1, 1, 1,  &Server::zrank_command, nullptr},
+    {"zrevrank",         3, 0,                           1, 1, 1,  &Server::zrevrank_command, nullptr},
+    {"zrange",           4, 0,                           1, 1, 1,  &Server::zrange_command, nullptr},
+    {"zcard",            2, 0,                           1, 1, 1,  &Server::zcard_command, nullptr},
+    {"pexpire",          3, CMD_WRITE,                   1, 1, 1,  &Server::pexpire_command, nullptr},
+    {"pexpireat",        3, CMD_WRITE,                   1, 1, 1,  &Server::pexpireat_command, nullptr},
+    {"pttl",             2, 0,                           1, 1, 1,  &Server::pttl_command, nullptr},
+    {"replicaof",        3, 0,                           0, 0, 0,  &Server::replicaof_command, nullptr},
+    {"psync",            3, 0,                           0, 0, 0,  nullptr, &Server::psync_command},
+    {"replconf",        -2, 0,                           0, 0, 0,  nullptr, &Server::replconf_command},
+};
+
+const CommandSpec* Server::find_command(std::string_view name) {
+    static constexpr PerfectHash<std::size(k_commands)> index([] {
+        std::array<std::string_view, std::size(k_commands)> names{};
+        for (size_t i = 0; i < names.size(); ++i) names[i] = k_commands[i].name;
+        return names;
+    }());
+    int i = index.find(name);
+    return i < 0 ? nullptr : &k_commands[i];
+}
 
-void Server::handle_command(const std::vector<std::string>& cmd, std::string& out) {
-    if (cmd.empty()) {
-        out_error(out, "Empty command");
+void Server::handle_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    run_command(cmd.empty() ? nullptr : find_command(cmd[0]), cmd, out);
+}
+
+void Server::run_command(const CommandSpec* spec, const std::vector<std::string_view>& cmd, ReplyOut out) {
+    if (cmd.empty()) { out_error(out, "Empty command"); return; }
+    if (!spec) { out_error(out, "Unknown command"); return; }
+    if (!spec->arity_ok(cmd.size())) {
+        out_error(out, "Invalid number of arguments for '" + std::string(spec->name) + "'");
+        return;
+    }
+    if (!spec->handler) {
+        out_error(out, "'" + std::string(spec->name) + "' is only accepted from a client connection");
+        return;
+    }
+    // A key that does not fit an Entry record can never be stored.
+    if (spec->flags & CMD_DENYOOM) {
+        size_t last = spec->last_key_index(cmd.size());
+        for (size_t i = spec->first_key; i <= last; i += spec->key_step) {
+            if (cmd[i].size() > Entry::k_max_key_len) { out_error(out, "key is too long"); return; }
+        }
+    }
+    // A replica changes only with its primary's stream, which is applied
+    // like a log replay.
+    if (primary_ && !loading_ && (spec->flags & CMD_WRITE)) {
+        out_error(out, "READONLY You can't write against a read only replica");
+        return;
+    }
+    if (config_.maxmemory && (spec->flags & CMD_DENYOOM) && !loading_ && !evict_for_write()) {
+        out_error(out, "OOM command not allowed when used memory > 'maxmemory'");
         return;
     }
-    const std::string& command = cmd[0];
 
-    if (command == "get") {
-        if (cmd.size() != 2) { out_error(out, "Invalid number of arguments for 'get'"); return; }
-        Entry* entry = db_.get(cmd[1]);
-        if (entry && entry->type == Entry::STRING) out_string(out, entry->str_value);
-        else out_nil(out);
+    (this->*spec->handler)(cmd, out);
+    // After it ran, so keys it found expired are logged as deleted first.
+    if ((aof_ || backlog_) && (spec->flags & CMD_WRITE)) log_command(cmd);
+}
 
-    } else if (command == "set") {
-        if (cmd.size() != 3) { out_error(out, "Invalid number of arguments for 'set'"); return; }
-        Entry* entry = db_.get(cmd[1]);
-        if (entry) {
-            if (entry->type != Entry::STRING) { out_error(out, "Wrong type"); return; }
-            entry->str_value = cmd[2];
-        } else {
-            entry = new Entry(cmd[1], cmd[2]);
-            db_.put(cmd[1], entry);
+// GET key [int]: with "int", integer values come back as integers.
+void Server::get_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    if (cmd.size() > 3 || (cmd.size() == 3 && cmd[2] != "int")) {
+        out_error(out, "Invalid number of arguments for 'get'");
+        return;
+    }
+    Entry* entry = lookup(cmd[1]);
+    if (!entry || entry->type() != Entry::STRING) {
+        out_nil(out);
+    } else if (entry->is_int() && cmd.size() == 3) {
+        out_int(out, entry->int_value());
+    } else {
+        out_string_value(out, entry);
+    }
+}
+
+void Server::set_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    if (!set_string(cmd[1], cmd[2])) { out_error(out, "Wrong type"); return; }
+    out_ok(out);
+}
+
+void Server::mget_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    size_t n = cmd.size() - 1;
+    batch_entries_.resize(n);
+    db_.get_many(cmd.data() + 1, n, batch_entries_.data());
+    int64_t now = now_ms();
+    out.push_back(SER_ARR);
+    uint32_t count = static_cast<uint32_t>(n);
+    out.append((const char*)&count, 4);
+    for (Entry* entry : batch_entries_) {
+        // Expired keys are hidden, not deleted here: a key repeated later
+        // in the request still points at the entry.
+        if (!entry || entry->type() != Entry::STRING ||
+            (entry->expire_at != Entry::k_no_expiry && entry->expire_at <= now)) {
+            out_nil(out);
+            continue;
         }
-        out_ok(out);
+        touch(entry);
+        out_string_value(out, entry);
+    }
+}
 
-    } else if (command == "del") {
-        if (cmd.size() != 2) { out_error(out, "Invalid number of arguments for 'del'"); return; }
-        db_.remove(cmd[1]);
-        out_int(out, 1);
-
-    } else if (command == "keys") {
-        if (cmd.size() != 1) { out_error(out, "Invalid number of arguments for 'keys'"); return; }
-        std::vector<std::string> keys = db_.keys();
-        out_array(out, keys);
-
-    } else if (command == "zadd") {
-        if (cmd.size() != 4) { out_error(out, "Invalid number of arguments for 'zadd'"); return; }
-        const std::string& key = cmd[1];
-        double score = std::stod(cmd[2]);
-        const std::string& member = cmd[3];
-
-        Entry* entry = db_.get(key);
-        if (!entry) {
-            entry = new Entry(key, "");
-            entry->type = Entry::ZSET;
-            entry->zset_value = new ZSet();
-            db_.put(key, entry);
-        }
-        if (entry->type != Entry::ZSET) { out_error(out, "Wrong type"); return; }
-        bool added = entry->zset_value->zadd(member, score);
-        out_int(out, added ? 1 : 0);
-
-    } else if (command == "zrem") {
-        if (cmd.size() != 3) { out_error(out, "Invalid number of arguments for 'zrem'"); return; }
-        const std::string& key = cmd[1];
-        const std::string& member = cmd[2];
-
-        Entry* entry = db_.get(key);
-        if (!entry || entry->type != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
-        bool removed = entry->zset_value->zrem(member);
-        out_int(out, removed ? 1 : 0);
-
-    } else if (command == "zscore") {
-        if (cmd.size() != 3) { out_error(out, "Invalid number of arguments for 'zscore'"); return; }
-        const std::string& key = cmd[1];
-        const std::string& member = cmd[2];
-
-        Entry* entry = db_.get(key);
-        if (!entry || entry->type != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
-        double score;
-        if (entry->zset_value->zscore(member, score)) out_double(out, score);
-        else out_nil(out);
-
-    } else if (command == "zquery") {
-        if (cmd.size() != 6) { out_error(out, "Invalid number of arguments for 'zquery'"); return; }
-        const std::string& key = cmd[1];
-        double min_score = std::stod(cmd[2]);
-        const std::string& min_member = cmd[3];
-        int offset = std::stoi(cmd[4]);
-        int limit = std::stoi(cmd[5]);
-
-        Entry* entry = db_.get(key);
-        if (!entry || entry->type != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
-        std::vector<std::pair<std::string, double>> result = entry->zset_value->zquery(min_score, min_member, offset, limit);
-
-        out.push_back(SER_ARR);
-        uint32_t len = static_cast<uint32_t>(result.size() * 2);
-        out.append((char*)&len, 4);
-        for (const auto& pair : result) {
-            out_string(out, pair.first);
-            out_double(out, pair.second);
+void Server::mset_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    if (cmd.size() % 2 == 0) { out_error(out, "Invalid number of arguments for 'mset'"); return; }
+    size_t n = (cmd.size() - 1) / 2;
+    batch_keys_.clear();
+    for (size_t i = 1; i < cmd.size(); i += 2) batch_keys_.push_back(cmd[i]);
+    batch_entries_.resize(n);
+    db_.get_many(batch_keys_.data(), n, batch_entries_.data());
+    // All or nothing: check types before writing anything. The writes
+    // then find their buckets already in cache.
+    int64_t now = now_ms();
+    for (Entry* entry : batch_entries_) {
+        if (entry && entry->type() != Entry::STRING &&
+            (entry->expire_at == Entry::k_no_expiry || entry->expire_at > now)) {
+            out_error(out, "Wrong type");
+            return;
         }
+    }
+    for (size_t i = 1; i < cmd.size(); i += 2) set_string(cmd[i], cmd[i + 1]);
+    out_ok(out);
+}
+
+void Server::incr_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    incr_by(cmd[1], 1, out);
+}
+
+void Server::decr_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    incr_by(cmd[1], -1, out);
+}
+
+void Server::incrby_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    int64_t delta = 0;
+    if (!Entry::parse_int(cmd[2], delta)) { out_error(out, "value is not an integer or out of range"); return; }
+    incr_by(cmd[1], delta, out);
+}
+
+void Server::incr_by(std::string_view key, int64_t delta, ReplyOut out) {
+    Entry* entry = lookup(key);
+    if (entry && entry->type() != Entry::STRING) { out_error(out, "Wrong type"); return; }
+    // Every value that parses as an integer is INT-encoded.
+    if (entry && !entry->is_int()) { out_error(out, "value is not an integer or out of range"); return; }
+    int64_t value = 0;
+    if (__builtin_add_overflow(entry ? entry->int_value() : 0, delta, &value)) {
+        out_error(out, "increment or decrement would overflow");
+        return;
+    }
+    if (entry) {
+        entry->set_int(value);  // same size, and the TTL stays
+    } else {
+        entry = Entry::make_int(key, value);
+        entry->access = initial_access();
+        db_.put(entry->key(), entry);
+        charge_entry(entry);
+    }
+    out_int(out, value);
+}
+
+void Server::incrbyfloat_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    double delta = 0;
+    if (!parse_double(cmd[2], delta)) { out_error(out, "value is not a valid float"); return; }
+
+    Entry* entry = lookup(cmd[1]);
+    if (entry && entry->type() != Entry::STRING) { out_error(out, "Wrong type"); return; }
+    double value = 0;
+    char scratch[Entry::k_max_int_chars];
+    if (entry && !parse_double(entry->str_value(scratch), value)) {
+        out_error(out, "value is not a valid float");
+        return;
+    }
+    value += delta;
+    if (!std::isfinite(value)) { out_error(out, "increment would produce NaN or Infinity"); return; }
+    // Shortest round-trip digits, without an exponent (up to ~310 chars).
+    char text[400];
+    char* end = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed).ptr;
+    std::string_view formatted(text, end - text);
+    if (entry) {
+        assign_string(entry, formatted);
+    } else {
+        entry = Entry::make_string(cmd[1], formatted);
+        entry->access = initial_access();
+        db_.put(entry->key(), entry);
+        charge_entry(entry);
+    }
+    out_string(out, formatted);
+}
+
+void Server::del_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    Entry* entry = db_.get(cmd[1]);
+    if (entry) delete_entry(entry);
+    out_int(out, 1);
+}
+
+void Server::keys_command(const std::vector<std::string_view>&, ReplyOut out) {
+    // Expired keys the active cycle has not reached yet are hidden, not
+    // deleted, so KEYS stays a read.
+    int64_t now = now_ms();
+    std::vector<std::string> keys;
+    for (std::string_view k : db_.keys()) {
+        Entry* entry = db_.get(k);
+        if (entry->expire_at == Entry::k_no_expiry || entry->expire_at > now) keys.emplace_back(k);
+    }
+    out_array(out, keys);
+}
+
+void Server::memory_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    if (cmd[1] != "usage") { out_error(out, "Usage: memory usage <key>"); return; }
+    Entry* entry = lookup(cmd[2]);
+    if (!entry) { out_nil(out); return; }
+    out_int(out, static_cast<int64_t>(entry_memory(entry)));
+}
+
+void Server::zadd_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    std::string_view key = cmd[1];
+    double score = 0;
+    if (!parse_score(cmd[2], score)) { out_error(out, "value is not a valid float"); return; }
+    std::string_view member = cmd[3];
+
+    Entry* entry = lookup(key);
+    if (!entry) {
+        entry = Entry::make_zset(key);
+        entry->access = initial_access();
+        db_.put(entry->key(), entry);
+    } else if (entry->type() != Entry::ZSET) {
+        out_error(out, "Wrong type");
+        return;
+    } else {
+        uncharge_entry(entry);
+    }
+    bool added = entry->zset_value()->zadd(member, score);
+    charge_entry(entry);
+    out_int(out, added ? 1 : 0);
+}
+
+void Server::zrem_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    std::string_view key = cmd[1];
+    std::string_view member = cmd[2];
+
+    Entry* entry = lookup(key);
+    if (!entry || entry->type() != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
+    uncharge_entry(entry);
+    bool removed = entry->zset_value()->zrem(member);
+    charge_entry(entry);
+    out_int(out, removed ? 1 : 0);
+}
 
+void Server::zscore_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    std::string_view key = cmd[1];
+    std::string_view member = cmd[2];
+
+    Entry* entry = lookup(key);
+    if (!entry || entry->type() != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
+    double score;
+    if (entry->zset_value()->zscore(member, score)) out_double(out, score);
+    else out_nil(out);
+}
+
+void Server::zquery_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    std::string_view key = cmd[1];
+    double min_score = 0;
+    if (!parse_score(cmd[2], min_score)) { out_error(out, "value is not a valid float"); return; }
+    std::string_view min_member = cmd[3];
+    int offset = 0, limit = 0;
+    if (!parse_int32(cmd[4], offset) || !parse_int32(cmd[5], limit)) {
+        out_error(out, "value is not an integer or out of range");
+        return;
+    }
+
+    Entry* entry = lookup(key);
+    if (!entry || entry->type() != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
+    out_member_scores(out, entry->zset_value()->zquery(min_score, min_member, offset, limit));
+}
+
+void Server::zrank_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    zrank_of(cmd, false, out);
+}
+
+void Server::zrevrank_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    zrank_of(cmd, true, out);
+}
+
+void Server::zrank_of(const std::vector<std::string_view>& cmd, bool reverse, ReplyOut out) {
+    std::string_view key = cmd[1];
+    std::string_view member = cmd[2];
+
+    Entry* entry = lookup(key);
+    if (!entry || entry->type() != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
+    size_t rank;
+    if (!entry->zset_value()->zrank(member, rank)) { out_nil(out); return; }
+    if (reverse) rank = entry->zset_value()->zcard() - 1 - rank;
+    out_int(out, static_cast<int64_t>(rank));
+}
+
+void Server::zrange_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    std::string_view key = cmd[1];
+    int64_t start = 0, stop = 0;
+    if (!Entry::parse_int(cmd[2], start) || !Entry::parse_int(cmd[3], stop)) {
+        out_error(out, "value is not an integer or out of range");
+        return;
+    }
+
+    Entry* entry = lookup(key);
+    if (!entry || entry->type() != Entry::ZSET) { out_error(out, "Wrong type or key does not exist"); return; }
+    out_member_scores(out, entry->zset_value()->zrange(start, stop));
+}
+
+void Server::zcard_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    Entry* entry = lookup(cmd[1]);
+    if (!entry) { out_int(out, 0); return; }
+    if (entry->type() != Entry::ZSET) { out_error(out, "Wrong type"); return; }
+    out_int(out, static_cast<int64_t>(entry->zset_value()->zcard()));
+}
+
+void Server::pexpire_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    expire_outcome_ = ExpireOutcome::NONE;
+    int64_t ttl_ms = 0;
+    if (!Entry::parse_int(cmd[2], ttl_ms)) { out_error(out, "value is not an integer or out of range"); return; }
+    // The deadline must fit both clocks: the log records it in Unix time.
+    int64_t expire_at = 0, unix_at = 0;
+    if (ttl_ms > 0 && (__builtin_add_overflow(now_ms(), ttl_ms, &expire_at) ||
+                       __builtin_add_overflow(unix_ms(), ttl_ms, &unix_at))) {
+        out_error(out, "invalid expire time");
+        return;
+    }
+    Entry* entry = lookup(cmd[1]);
+    if (!entry) { out_int(out, 0); return; }
+    if (ttl_ms <= 0) {
+        delete_entry(entry);
+        expire_outcome_ = ExpireOutcome::DELETED;
     } else {
-        out_error(out, "Unknown command");
+        entry->expire_at = expire_at;
+        ttl_.update(entry);
+        expire_outcome_ = ExpireOutcome::SET;
     }
+    out_int(out, 1);
+}
+
+// PEXPIREAT key unix-ms: the form the log records PEXPIRE in. While a log is
+// replayed a passed deadline is only set, like any other; one from before
+// the monotonic clock started is set as its start.
+void Server::pexpireat_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    expire_outcome_ = ExpireOutcome::NONE;
+    int64_t at = 0;
+    if (!Entry::parse_int(cmd[2], at)) { out_error(out, "value is not an integer or out of range"); return; }
+    int64_t now = now_ms();
+    int64_t expire_at = 0;
+    if (__builtin_sub_overflow(at, unix_ms(), &expire_at) || __builtin_add_overflow(expire_at, now, &expire_at)) {
+        out_error(out, "invalid expire time");
+        return;
+    }
+    Entry* entry = lookup(cmd[1]);
+    if (!entry) { out_int(out, 0); return; }
+    if (expire_at <= now && !loading_) {
+        delete_entry(entry);
+        expire_outcome_ = ExpireOutcome::DELETED;
+    } else {
+        // Never k_no_expiry.
+        entry->expire_at = std::max<int64_t>(expire_at, 0);
+        ttl_.update(entry);
+        expire_outcome_ = ExpireOutcome::SET;
+    }
+    out_int(out, 1);
+}
+
+void Server::pttl_command(const std::vector<std::string_view>& cmd, ReplyOut out) {
+    Entry* entry = lookup(cmd[1]);
+    if (!entry) { out_int(out, -2); return; }
+    if (entry->expire_at == Entry::k_no_expiry) { out_int(out, -1); return; }
+    out_int(out, std::max<int64_t>(entry->expire_at - now_ms(), 0));
 }
@@ -0,0 +1,78 @@
+#include "server/shard.h"
+#include "server/server.h"
+
+// Messages in flight per direction before the sender spills to its outbox.
+static const size_t k_shard_queue_capacity = 4096;
+
+ShardGroup::ShardGroup(const ServerConfig& config, unsigned int num_shards)
+    : num_shards_(num_shards ? num_shards : 1) {
+    queues_.resize(num_shards_ * num_shards_);
+    for (auto& q : queues_) {
+        q = std::make_unique<SpscQueue<ShardMessage>>(k_shard_queue_capacity);
+    }
+    // Keys are spread evenly over the shards, so each gets an equal share of
+    // the memory ceiling.
+    ServerConfig shard_config = config;
+    shard_config.maxmemory = config.maxmemory / num_shards_;
+    for (unsigned int i = 0; i < num_shards_; ++i) {
+        servers_.push_back(std::make_unique<Server>(shard_config, this, i));
+    }
+}
+
+ShardGroup::~ShardGroup() = default;
+
+unsigned int ShardGroup::shard_of(std::string_view key) const {
+    // Take the shard from the high bits: each shard's HashTable indexes its
+    // buckets with the low bits of the same hash, and a modulo of those would
+    // leave every shard using only 1/N of its buckets.
+    uint64_t h = StringHash()(key);
+    return static_cast<unsigned int>(((h >> 32) * num_shards_) >> 32);
+}
+
+bool ShardGroup::load_snapshot(const std::string& path, SnapshotLoadStats& stats, std::string& err) {
+    std::vector<Server*> servers;
+    for (auto& server : servers_) servers.push_back(server.get());
+    return Server::load_snapshot(path, servers, [this](std::string_view key) { return shard_of(key); }, stats, err);
+}
+
+bool ShardGroup::load_aof(const std::vector<std::string>& files, AofLoadStats& stats, std::string& err) {
+    std::vector<std::string_view> single;
+    auto apply = [&](const std::vector<std::string_view>& cmd) {
+        if (cmd[0] == "mset" && cmd.size() % 2 == 1) {
+            for (size_t i = 1; i < cmd.size(); i += 2) {
+                single = {"set", cmd[i], cmd[i + 1]};
+                servers_[shard_of(cmd[i])]->replay(single);
+            }
+            return;
+        }
+        servers_[cmd.size() >= 2 ? shard_of(cmd[1]) : 0]->replay(cmd);
+    };
+    for (const std::string& file : files) {
+        if (!aof_replay(file, apply, stats, err)) return false;
+    }
+    return true;
+}
+
+bool ShardGroup::start_aof(bool rewrite, std::string& err) {
+    for (auto& server : servers_) {
+        if (!server->start_aof(rewrite, err)) return false;
+    }
+    return true;
+}
+
+void ShardGroup::notify(unsigned int shard) {
+    servers_[shard]->wake();
+}
+
+void ShardGroup::run(const std::vector<int>& listen_fds) {
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < num_shards_; ++i) {
+        threads.emplace_back([this, i, fd = listen_fds[i]] { servers_[i]->run(fd); });
+    }
+    servers_[0]->run(listen_fds[0]);
+    for (std::thread& t : threads) t.join();
+}
+
+void ShardGroup::stop() {
+    for (auto& server : servers_) server->stop();
+}
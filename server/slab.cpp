@@ -0,0 +1,17 @@
+#include "server/slab.h"
+
+void* slab_refill(size_t cls) {
+    size_t object = cls * k_slab_class_bytes;
+    size_t count = k_slab_bytes / object;
+    char* slab = static_cast<char*>(::operator new(k_slab_bytes));
+    // Keep the first object for the caller and list the rest in address
+    // order, so consecutive allocations stay adjacent.
+    SlabFreeObject* head = nullptr;
+    for (size_t i = count - 1; i >= 1; --i) {
+        SlabFreeObject* obj = reinterpret_cast<SlabFreeObject*>(slab + i * object);
+        obj->next = head;
+        head = obj;
+    }
+    slab_free_lists[cls] = head;
+    return slab;
+}
@@ -0,0 +1,474 @@
+#include "server/snapshot.h"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char k_magic[8] = {'C', 'D', 'B', 'S', 'N', 'A', 'P', '\0'};
+// magic, version, shard, shards, saved_at, keys
+static const size_t k_header_size = 8 + 4 + 4 + 4 + 8 + 8;
+// records, crc32c, bytes
+static const size_t k_chunk_header_size = 4 + 4 + 8;
+
+// ===== CRC-32C =====
+
+// Slicing-by-8 tables: table[k][b] is the CRC of byte b followed by k zero
+// bytes, so eight input bytes are folded in with eight lookups.
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+static constexpr CrcTables make_crc_tables() {
+    CrcTables t{};
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t crc = b;
+        for (int i = 0; i < 8; ++i) crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+        t[0][b] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+        for (uint32_t b = 0; b < 256; ++b) t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+    }
+    return t;
+}
+
+static constexpr CrcTables k_crc_tables = make_crc_tables();
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t n) {
+    const auto& t = k_crc_tables;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        word ^= crc;
+        crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^
+              t[4][(word >> 24) & 0xFF] ^ t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^
+              t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+    }
+    for (; n > 0; ++p, --n) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+    return ~crc;
+}
+
+// ===== Writer =====
+
+static bool write_fully(int fd, const char* data, size_t n) {
+    while (n > 0) {
+        ssize_t rv = ::write(fd, data, n);
+        if (rv < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += rv;
+        n -= static_cast<size_t>(rv);
+    }
+    return true;
+}
+
+SnapshotWriter::SnapshotWriter(int fd) : fd_(fd) {
+    buf_.reserve(k_flush_at + 4096);
+}
+
+// Folds the buffered bytes of the open chunk into its checksum.
+void SnapshotWriter::checksum_buffer() {
+    crc_ = crc32c(crc_, buf_.data() + crc_pos_, buf_.size() - crc_pos_);
+    crc_pos_ = buf_.size();
+}
+
+bool SnapshotWriter::flush() {
+    checksum_buffer();
+    if (!failed_ && !write_fully(fd_, buf_.data(), buf_.size())) failed_ = true;
+    written_ += buf_.size();
+    buf_.clear();
+    crc_pos_ = 0;
+    return !failed_;
+}
+
+void SnapshotWriter::put_varint(uint64_t v) {
+    while (v >= 0x80) {
+        put_u8(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    put_u8(static_cast<uint8_t>(v));
+}
+
+void SnapshotWriter::put_str(std::string_view s) {
+    put_varint(s.size());
+    if (s.size() < k_flush_at) {
+        put_fixed(s.data(), s.size());
+        return;
+    }
+    // A large value goes straight from the keyspace to the file.
+    flush();
+    crc_ = crc32c(crc_, s.data(), s.size());
+    if (!failed_ && !write_fully(fd_, s.data(), s.size())) failed_ = true;
+    written_ += s.size();
+}
+
+// Reserves the header of a new chunk, to be filled in by close_chunk().
+void SnapshotWriter::open_chunk() {
+    chunk_open_ = true;
+    chunk_start_ = bytes_written();
+    chunk_records_ = 0;
+    buf_.append(k_chunk_header_size, '\0');
+    crc_ = 0;
+    crc_pos_ = buf_.size();
+}
+
+void SnapshotWriter::close_chunk() {
+    chunk_open_ = false;
+    checksum_buffer();
+    uint64_t bytes = bytes_written() - chunk_start_ - k_chunk_header_size;
+    char header[k_chunk_header_size];
+    std::memcpy(header, &chunk_records_, 4);
+    std::memcpy(header + 4, &crc_, 4);
+    std::memcpy(header + 8, &bytes, 8);
+    if (chunk_start_ >= written_) {
+        std::memcpy(&buf_[chunk_start_ - written_], header, sizeof(header));
+    } else if (!failed_ && ::pwrite(fd_, header, sizeof(header), static_cast<off_t>(chunk_start_)) !=
+                               static_cast<ssize_t>(sizeof(header))) {
+        failed_ = true;
+    }
+}
+
+bool SnapshotWriter::begin(const SnapshotHeader& header) {
+    put_fixed(k_magic, sizeof(k_magic));
+    put_fixed(&header.version, 4);
+    put_fixed(&header.shard, 4);
+    put_fixed(&header.shards, 4);
+    put_fixed(&header.saved_at, 8);
+    put_fixed(&header.keys, 8);
+    header_crc_ = crc32c(0, buf_.data(), k_header_size);
+    return !failed_;
+}
+
+bool SnapshotWriter::begin_record(SnapshotRecordType type, std::string_view key, int64_t expire_at) {
+    if (!chunk_open_) open_chunk();
+    if (expire_at == k_snapshot_no_expiry) {
+        put_u8(type);
+    } else {
+        put_u8(type | k_snapshot_has_expiry);
+        put_fixed(&expire_at, 8);
+    }
+    put_str(key);
+    return !failed_;
+}
+
+// Counts a finished record, and closes the chunk once it is big enough.
+bool SnapshotWriter::end_record() {
+    chunk_records_++;
+    if (bytes_written() - chunk_start_ >= k_chunk_bytes) close_chunk();
+    return flush_if_full();
+}
+
+bool SnapshotWriter::write_string(std::string_view key, std::string_view value, int64_t expire_at) {
+    begin_record(SNAP_STRING, key, expire_at);
+    put_str(value);
+    return end_record();
+}
+
+bool SnapshotWriter::write_int(std::string_view key, int64_t value, int64_t expire_at) {
+    begin_record(SNAP_INT, key, expire_at);
+    // Zigzag, so small negative numbers stay short too.
+    put_varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    return end_record();
+}
+
+bool SnapshotWriter::begin_zset(std::string_view key, size_t count, int64_t expire_at) {
+    begin_record(SNAP_ZSET, key, expire_at);
+    put_varint(count);
+    members_left_ = count;
+    return count ? flush_if_full() : end_record();
+}
+
+bool SnapshotWriter::add_member(std::string_view member, double score) {
+    put_str(member);
+    put_fixed(&score, 8);
+    return --members_left_ ? flush_if_full() : end_record();
+}
+
+bool SnapshotWriter::finish() {
+    if (chunk_open_) close_chunk();
+    char end[k_chunk_header_size] = {};
+    std::memcpy(end + 4, &header_crc_, 4);
+    put_fixed(end, sizeof(end));
+    return flush();
+}
+
+// ===== Reader =====
+
+static bool parse_header(const char* p, size_t len, SnapshotHeader& h, std::string& err) {
+    if (len < k_header_size || std::memcmp(p, k_magic, sizeof(k_magic)) != 0) {
+        err = "not a snapshot file";
+        return false;
+    }
+    p += sizeof(k_magic);
+    std::memcpy(&h.version, p, 4);
+    std::memcpy(&h.shard, p + 4, 4);
+    std::memcpy(&h.shards, p + 8, 4);
+    std::memcpy(&h.saved_at, p + 12, 8);
+    std::memcpy(&h.keys, p + 20, 8);
+    if (h.version != k_snapshot_version) {
+        err = "unsupported snapshot version " + std::to_string(h.version);
+        return false;
+    }
+    if (h.shards == 0 || h.shard >= h.shards) {
+        err = "bad shard numbers in header";
+        return false;
+    }
+    return true;
+}
+
+SnapshotReader::~SnapshotReader() {
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+}
+
+bool SnapshotReader::open(const std::string& path, std::string& err) {
+    path_ = path;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        err = std::string("cannot open: ") + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        err = std::string("cannot stat: ") + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* map = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            err = std::string("cannot map: ") + strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        // Every loader thread reads its chunks front to back.
+        ::madvise(map, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(map);
+    }
+    ::close(fd);
+    if (!parse_header(data_, size_, header_, err)) return false;
+
+    // Walk the chunk headers; the end marker must close the file exactly.
+    size_t pos = k_header_size;
+    uint64_t records = 0;
+    for (;;) {
+        if (size_ - pos < k_chunk_header_size) {
+            err = "truncated snapshot";
+            return false;
+        }
+        Chunk chunk;
+        std::memcpy(&chunk.records, data_ + pos, 4);
+        std::memcpy(&chunk.crc, data_ + pos + 4, 4);
+        std::memcpy(&chunk.bytes, data_ + pos + 8, 8);
+        pos += k_chunk_header_size;
+        if (chunk.records == 0) {
+            if (chunk.bytes != 0 || chunk.crc != crc32c(0, data_, k_header_size)) {
+                err = "checksum mismatch in header";
+                return false;
+            }
+            break;
+        }
+        if (chunk.bytes > size_ - pos) {
+            err = "truncated snapshot";
+            return false;
+        }
+        chunk.offset = pos;
+        chunks_.push_back(chunk);
+        records += chunk.records;
+        pos += chunk.bytes;
+    }
+    if (pos != size_) {
+        err = "data after the end marker";
+        return false;
+    }
+    if (records != header_.keys) {
+        err = "chunks hold " + std::to_string(records) + " records, the header counts " +
+              std::to_string(header_.keys);
+        return false;
+    }
+    return true;
+}
+
+// Decodes the records of one chunk.
+class RecordCursor {
+public:
+    RecordCursor(const char* p, size_t n) : p_(p), end_(p + n) {}
+
+    bool done() const { return p_ == end_; }
+    bool next(SnapshotRecord& rec, std::string& err);
+
+private:
+    bool get_varint(uint64_t& v);
+    bool get_str(std::string_view& s);
+    template <typename T> bool get_fixed(T& v);
+
+    const char* p_;
+    const char* end_;
+};
+
+bool RecordCursor::get_varint(uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p_ < end_; shift += 7) {
+        uint8_t b = static_cast<uint8_t>(*p_++);
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool RecordCursor::get_str(std::string_view& s) {
+    uint64_t len;
+    if (!get_varint(len) || len > static_cast<size_t>(end_ - p_)) return false;
+    s = std::string_view(p_, len);
+    p_ += len;
+    return true;
+}
+
+template <typename T>
+bool RecordCursor::get_fixed(T& v) {
+    if (static_cast<size_t>(end_ - p_) < sizeof(T)) return false;
+    std::memcpy(&v, p_, sizeof(T));
+    p_ += sizeof(T);
+    return true;
+}
+
+bool RecordCursor::next(SnapshotRecord& rec, std::string& err) {
+    uint8_t tag;
+    if (!get_fixed(tag)) {
+        err = "fewer records than the chunk counts";
+        return false;
+    }
+    rec.type = static_cast<SnapshotRecordType>(tag & ~k_snapshot_has_expiry);
+    rec.expire_at = k_snapshot_no_expiry;
+    bool ok = (!(tag & k_snapshot_has_expiry) || get_fixed(rec.expire_at)) && get_str(rec.key);
+    uint64_t n = 0;
+    switch (rec.type) {
+    case SNAP_STRING:
+        ok = ok && get_str(rec.str);
+        break;
+    case SNAP_INT:
+        ok = ok && get_varint(n);
+        rec.int_value = static_cast<int64_t>(n >> 1) ^ -static_cast<int64_t>(n & 1);
+        break;
+    case SNAP_ZSET:
+        // Each member takes at least 9 bytes, which bounds a corrupt count.
+        ok = ok && get_varint(n) && n <= static_cast<size_t>(end_ - p_) / 9;
+        rec.members.clear();
+        if (ok) rec.members.reserve(n);
+        for (uint64_t i = 0; ok && i < n; ++i) {
+            std::string_view member;
+            double score;
+            ok = get_str(member) && get_fixed(score);
+            rec.members.emplace_back(member, score);
+        }
+        break;
+    default:
+        err = "unknown record type " + std::to_string(rec.type);
+        return false;
+    }
+    if (!ok) {
+        err = "truncated record";
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::read_chunk(size_t i, const std::function<void(const SnapshotRecord&)>& visit,
+                                std::string& err) const {
+    const Chunk& chunk = chunks_[i];
+    const char* p = data_ + chunk.offset;
+    if (crc32c(0, p, chunk.bytes) != chunk.crc) {
+        err = "checksum mismatch in chunk " + std::to_string(i);
+        return false;
+    }
+    RecordCursor cursor(p, chunk.bytes);
+    SnapshotRecord rec;
+    for (uint32_t n = 0; n < chunk.records; ++n) {
+        if (!cursor.next(rec, err)) return false;
+        visit(rec);
+    }
+    if (!cursor.done()) {
+        err = "more records than chunk " + std::to_string(i) + " counts";
+        return false;
+    }
+    return true;
+}
+
+// ===== Files =====
+
+std::string snapshot_shard_path(const std::string& path, int shard) {
+    return shard < 0 ? path : path + "." + std::to_string(shard);
+}
+
+uint64_t snapshot_save(const std::string& path, const SnapshotHeader& header,
+                       const std::function<bool(SnapshotWriter&)>& write_keys, std::string& err) {
+    std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        err = "cannot create " + tmp + ": " + strerror(errno);
+        return 0;
+    }
+    SnapshotWriter writer(fd);
+    bool ok = writer.begin(header) && write_keys(writer) && writer.finish() && ::fsync(fd) == 0;
+    int saved_errno = errno;
+    ::close(fd);
+    if (ok && ::rename(tmp.c_str(), path.c_str()) < 0) {
+        saved_errno = errno;
+        ok = false;
+    }
+    if (!ok) {
+        err = "cannot write " + path + ": " + strerror(saved_errno);
+        ::unlink(tmp.c_str());
+        return 0;
+    }
+    return writer.bytes_written();
+}
+
+// Reads just the header of `path`: 1 if it is a snapshot, 0 if it exists but
+// is not one, -1 if there is no such file.
+static int peek_header(const std::string& path, SnapshotHeader& h) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT ? -1 : 0;
+    char buf[k_header_size];
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    ::close(fd);
+    std::string err;
+    return n > 0 && parse_header(buf, static_cast<size_t>(n), h, err) ? 1 : 0;
+}
+
+bool snapshot_open(const std::string& path, std::vector<std::unique_ptr<SnapshotReader>>& files,
+                   std::string& err) {
+    // Pick whichever of a single server's and a group's snapshot is newer, so
+    // switching between the two modes keeps the data.
+    SnapshotHeader single, group;
+    int has_single = peek_header(path, single);
+    int has_group = peek_header(snapshot_shard_path(path, 0), group);
+    if (has_single < 0 && has_group < 0) return true;
+
+    std::vector<std::string> paths;
+    if (has_single == 0 || (has_single > 0 && (has_group <= 0 || single.saved_at >= group.saved_at))) {
+        paths.push_back(path);
+    } else {
+        for (uint32_t i = 0; i < (has_group > 0 ? group.shards : 1); ++i) {
+            paths.push_back(snapshot_shard_path(path, static_cast<int>(i)));
+        }
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto reader = std::make_unique<SnapshotReader>();
+        if (!reader->open(paths[i], err)) {
+            err = paths[i] + ": " + err;
+            return false;
+        }
+        if (reader->header().shard != i || reader->header().shards != paths.size()) {
+            err = paths[i] + ": not part of the same snapshot as " + paths[0];
+            return false;
+        }
+        files.push_back(std::move(reader));
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#include "server/ttl_heap.h"
+#include "server/memory.h"
+
+void TtlHeap::set(size_t idx, Entry* entry) {
+    heap_[idx] = entry;
+    entry->heap_idx = static_cast<uint32_t>(idx);
+}
+
+void TtlHeap::sift_up(size_t idx) {
+    Entry* entry = heap_[idx];
+    while (idx > 0) {
+        size_t parent = (idx - 1) / 2;
+        if (heap_[parent]->expire_at <= entry->expire_at) break;
+        set(idx, heap_[parent]);
+        idx = parent;
+    }
+    set(idx, entry);
+}
+
+void TtlHeap::sift_down(size_t idx) {
+    Entry* entry = heap_[idx];
+    size_t n = heap_.size();
+    while (true) {
+        size_t child = 2 * idx + 1;
+        if (child >= n) break;
+        if (child + 1 < n && heap_[child + 1]->expire_at < heap_[child]->expire_at) child++;
+        if (entry->expire_at <= heap_[child]->expire_at) break;
+        set(idx, heap_[child]);
+        idx = child;
+    }
+    set(idx, entry);
+}
+
+void TtlHeap::update(Entry* entry) {
+    if (entry->heap_idx == Entry::k_no_heap_idx) {
+        heap_.push_back(entry);
+        entry->heap_idx = static_cast<uint32_t>(heap_.size() - 1);
+        sift_up(entry->heap_idx);
+        return;
+    }
+    sift_up(entry->heap_idx);
+    sift_down(entry->heap_idx);
+}
+
+void TtlHeap::remove(Entry* entry) {
+    size_t idx = entry->heap_idx;
+    if (idx == Entry::k_no_heap_idx) return;
+    entry->heap_idx = Entry::k_no_heap_idx;
+
+    Entry* last = heap_.back();
+    heap_.pop_back();
+    if (last == entry) return;
+    set(idx, last);
+    sift_up(idx);
+    sift_down(last->heap_idx);
+}
+
+size_t TtlHeap::memory_usage() const {
+    return heap_.capacity() ? alloc_size(heap_.capacity() * sizeof(Entry*)) : 0;
+}
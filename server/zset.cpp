@@ -1,129 +1,18 @@
 #include "server/zset.h"
 
-ZSet::ZSet() : tree_by_score(nullptr), tree_by_member(nullptr) {}
+#include <cstring>
+#include "server/memory.h"
+
+ZSet::ZSet(size_t max_flat_members, size_t max_flat_member_len)
+    : tree_by_member(nullptr), encoding(FLAT), flat_count(0),
+      max_flat_members(max_flat_members),
+      // The length has to fit the entry's one-byte length field.
+      max_flat_member_len(std::min<size_t>(max_flat_member_len, 255)), member_heap(0) {}
 
 ZSet::~ZSet() {
-    destroy(tree_by_score);
     destroy(tree_by_member);
 }
 
-int ZSet::height(ScoreNode* node) {
-    return node ? node->height : 0;
-}
-
-void ZSet::updateHeight(ScoreNode* node) {
-    node->height = 1 + std::max(height(node->left), height(node->right));
-}
-
-int ZSet::balanceFactor(ScoreNode* node) {
-    return height(node->left) - height(node->right);
-}
-
-ZSet::ScoreNode* ZSet::rotateLeft(ScoreNode* x) {
-    ScoreNode* y = x->right;
-    x->right = y->left;
-    y->left = x;
-    updateHeight(x);
-    updateHeight(y);
-    return y;
-}
-
-ZSet::ScoreNode* ZSet::rotateRight(ScoreNode* y) {
-    ScoreNode* x = y->left;
-    y->left = x->right;
-    x->right = y;
-    updateHeight(y);
-    updateHeight(x);
-    return x;
-}
-
-ZSet::ScoreNode* ZSet::balance(ScoreNode* node) {
-    updateHeight(node);
-    int bf = balanceFactor(node);
-
-    if (bf > 1) {
-        if (balanceFactor(node->left) < 0) {
-            node->left = rotateLeft(node->left);
-        }
-        return rotateRight(node);
-    }
-    if (bf < -1) {
-        if (balanceFactor(node->right) > 0) {
-            node->right = rotateRight(node->right);
-        }
-        return rotateLeft(node);
-    }
-    return node;
-}
-
-ZSet::ScoreNode* ZSet::insert(ScoreNode* node, double score, const std::string& member) {
-    if (!node) {
-        return new ScoreNode(score, member);
-    }
-    if (score < node->score || (score == node->score && member < node->member)) {
-        node->left = insert(node->left, score, member);
-    } else if (score > node->score || (score == node->score && member > node->member)) {
-        node->right = insert(node->right, score, member);
-    } else {
-        // Duplicate node, do nothing
-        return node;
-    }
-    return balance(node);
-}
-
-ZSet::ScoreNode* ZSet::remove(ScoreNode* node, double score, const std::string& member) {
-    if (!node) {
-        return nullptr;
-    }
-    if (score < node->score || (score == node->score && member < node->member)) {
-        node->left = remove(node->left, score, member);
-    } else if (score > node->score || (score == node->score && member > node->member)) {
-        node->right = remove(node->right, score, member);
-    } else {
-        // Node found
-        if (!node->left) {
-            ScoreNode* right = node->right;
-            delete node;
-            return right;
-        } else if (!node->right) {
-            ScoreNode* left = node->left;
-            delete node;
-            return left;
-        } else {
-            // Two children
-            ScoreNode* min = node->right;
-            while (min->left) min = min->left;
-            node->score = min->score;
-            node->member = min->member;
-            node->right = remove(node->right, min->score, min->member);
-        }
-    }
-    return balance(node);
-}
-
-void ZSet::inorder(ScoreNode* node, double min_score, const std::string& min_member, int& offset, int limit, std::vector<std::pair<std::string, double>>& result) {
-    if (!node || (int)result.size() >= limit) return;
-
-    if (node->score > min_score || (node->score == min_score && node->member >= min_member)) {
-        inorder(node->left, min_score, min_member, offset, limit, result);
-        if (offset > 0) {
-            offset--;
-        } else if ((int)result.size() < limit) {
-            result.emplace_back(node->member, node->score);
-        }
-        inorder(node->right, min_score, min_member, offset, limit, result);
-    } else {
-        inorder(node->right, min_score, min_member, offset, limit, result);
-    }
-}
-
-void ZSet::destroy(ScoreNode* node) {
-    if (!node) return;
-    destroy(node->left);
-    destroy(node->right);
-    delete node;
-}
-
 int ZSet::height(MemberNode* node) {
     return node ? node->height : 0;
 }
@@ -173,7 +62,7 @@ ZSet::MemberNode* ZSet::balance(MemberNode* node) {
     return node;
 }
 
-ZSet::MemberNode* ZSet::insert(MemberNode* node, const std::string& member, double score) {
+ZSet::MemberNode* ZSet::insert(MemberNode* node, std::string_view member, double score) {
     if (!node) {
         return new MemberNode(member, score);
     }
@@ -188,7 +77,7 @@ ZSet::MemberNode* ZSet::insert(MemberNode* node, const std::string& member, doub
     return balance(node);
 }
 
-ZSet::MemberNode* ZSet::remove(MemberNode* node, const std::string& member) {
+ZSet::MemberNode* ZSet::remove(MemberNode* node, std::string_view member) {
     if (!node) {
         return nullptr;
     }
@@ -218,7 +107,7 @@ ZSet::MemberNode* ZSet::remove(MemberNode* node, const std::string& member) {
     return balance(node);
 }
 
-ZSet::MemberNode* ZSet::find(MemberNode* node, const std::string& member) {
+ZSet::MemberNode* ZSet::find(MemberNode* node, std::string_view member) {
     if (!node) return nullptr;
     if (member < node->member) {
         return find(node->left, member);
@@ -229,6 +118,21 @@ ZSet::MemberNode* ZSet::find(MemberNode* node, const std::string& member) {
     }
 }
 
+// A perfectly balanced tree over members[by_member[0..n)], which are in
+// member order: the middle one at the root, each half below it.
+ZSet::MemberNode* ZSet::buildBalanced(const std::vector<std::pair<std::string_view, double>>& members,
+                                      const uint32_t* by_member, size_t n) {
+    if (n == 0) return nullptr;
+    size_t mid = n / 2;
+    const auto& [member, score] = members[by_member[mid]];
+    MemberNode* node = new MemberNode(member, score);
+    member_heap += string_heap_size(member.size());
+    node->left = buildBalanced(members, by_member, mid);
+    node->right = buildBalanced(members, by_member + mid + 1, n - mid - 1);
+    updateHeight(node);
+    return node;
+}
+
 void ZSet::destroy(MemberNode* node) {
     if (!node) return;
     destroy(node->left);
@@ -236,35 +140,188 @@ void ZSet::destroy(MemberNode* node) {
     delete node;
 }
 
-bool ZSet::zadd(const std::string& member, double score) {
+// ===== FLAT encoding =====
+
+double ZSet::flatScore(size_t pos) const {
+    double score;
+    std::memcpy(&score, flat.data() + pos, sizeof(double));
+    return score;
+}
+
+std::string_view ZSet::flatMember(size_t pos) const {
+    return std::string_view(flat.data() + pos + k_flat_header, (uint8_t)flat[pos + sizeof(double)]);
+}
+
+// Byte offset of `member`'s entry, or flat.size() if absent.
+size_t ZSet::flatFind(std::string_view member) const {
+    for (size_t pos = 0; pos < flat.size(); pos = flatNext(pos)) {
+        if (flatMember(pos) == member) return pos;
+    }
+    return flat.size();
+}
+
+// Byte offset of the first entry at or after (score, member); `rank` receives
+// the number of entries before it.
+size_t ZSet::flatLowerBound(double score, std::string_view member, size_t& rank) const {
+    rank = 0;
+    size_t pos = 0;
+    while (pos < flat.size()) {
+        double s = flatScore(pos);
+        if (s > score || (s == score && flatMember(pos) >= member)) break;
+        pos = flatNext(pos);
+        rank++;
+    }
+    return pos;
+}
+
+void ZSet::flatInsert(double score, std::string_view member) {
+    size_t rank;
+    size_t pos = flatLowerBound(score, member, rank);
+    char header[k_flat_header];
+    std::memcpy(header, &score, sizeof(double));
+    header[sizeof(double)] = (char)(uint8_t)member.size();
+    flat.insert(pos, member);
+    flat.insert(pos, header, k_flat_header);
+    flat_count++;
+}
+
+void ZSet::flatErase(size_t pos) {
+    flat.erase(pos, flatNext(pos) - pos);
+    flat_count--;
+}
+
+void ZSet::flatCollect(size_t pos, size_t limit, std::vector<std::pair<std::string, double>>& result) const {
+    for (; pos < flat.size() && result.size() < limit; pos = flatNext(pos)) {
+        result.emplace_back(flatMember(pos), flatScore(pos));
+    }
+}
+
+// One-way: a set that outgrew FLAT stays a TREE even if it shrinks again.
+void ZSet::convertToTree() {
+    for (size_t pos = 0; pos < flat.size(); pos = flatNext(pos)) {
+        tree_by_member = insert(tree_by_member, flatMember(pos), flatScore(pos));
+        member_heap += string_heap_size(flatMember(pos).size());
+        tree_by_score.insert(flatScore(pos), flatMember(pos));
+    }
+    std::string().swap(flat);
+    flat_count = 0;
+    encoding = TREE;
+}
+
+size_t ZSet::memory_usage() const {
+    size_t bytes = slab_object_size(sizeof(ZSet));
+    if (encoding == FLAT) {
+        return bytes + string_heap_size(flat);
+    }
+    return bytes + tree_by_score.memory_usage() + zcard() * slab_object_size(sizeof(MemberNode)) + member_heap;
+}
+
+// ===== Commands =====
+
+void ZSet::load_sorted(const std::vector<std::pair<std::string_view, double>>& members) {
+    size_t n = members.size();
+    bool ordered = true;
+    bool fits_flat = n <= max_flat_members;
+    for (size_t i = 0; i < n; ++i) {
+        const auto& [member, score] = members[i];
+        if (member.size() > max_flat_member_len) fits_flat = false;
+        if (i > 0) {
+            const auto& [prev_member, prev_score] = members[i - 1];
+            if (!(prev_score < score || (prev_score == score && prev_member < member))) ordered = false;
+        }
+    }
+    // The member order, for the member index, also shows a repeated member.
+    std::vector<uint32_t> by_member(n);
+    for (size_t i = 0; i < n; ++i) by_member[i] = static_cast<uint32_t>(i);
+    if (ordered) {
+        std::sort(by_member.begin(), by_member.end(),
+                  [&](uint32_t a, uint32_t b) { return members[a].first < members[b].first; });
+        for (size_t i = 1; i < n && ordered; ++i) {
+            ordered = members[by_member[i - 1]].first != members[by_member[i]].first;
+        }
+    }
+    if (!ordered) {
+        for (const auto& [member, score] : members) zadd(member, score);
+        return;
+    }
+
+    if (fits_flat) {
+        size_t bytes = 0;
+        for (const auto& [member, score] : members) bytes += k_flat_header + member.size();
+        flat.reserve(bytes);
+        for (const auto& [member, score] : members) {
+            flat.append(reinterpret_cast<const char*>(&score), sizeof(double));
+            flat.push_back((char)(uint8_t)member.size());
+            flat.append(member);
+        }
+        flat_count = n;
+        return;
+    }
+    encoding = TREE;
+    tree_by_score.load_sorted(members.data(), n);
+    tree_by_member = buildBalanced(members, by_member.data(), n);
+}
+
+bool ZSet::zadd(std::string_view member, double score) {
+    if (encoding == FLAT) {
+        size_t pos = flatFind(member);
+        if (pos < flat.size()) {
+            if (flatScore(pos) == score) return true;
+            flatErase(pos);
+            flatInsert(score, member);
+            return true;
+        }
+        if (flat_count < max_flat_members && member.size() <= max_flat_member_len) {
+            flatInsert(score, member);
+            return true;
+        }
+        convertToTree();
+    }
+
     MemberNode* mnode = find(tree_by_member, member);
     if (mnode) {
         // Member exists, remove from tree_by_score
-        tree_by_score = remove(tree_by_score, mnode->score, member);
+        tree_by_score.remove(mnode->score, member);
         // Update member's score
         mnode->score = score;
     } else {
         // Insert into tree_by_member
         tree_by_member = insert(tree_by_member, member, score);
+        member_heap += string_heap_size(member.size());
     }
     // Insert into tree_by_score
-    tree_by_score = insert(tree_by_score, score, member);
+    tree_by_score.insert(score, member);
     return true;
 }
 
-bool ZSet::zrem(const std::string& member) {
+bool ZSet::zrem(std::string_view member) {
+    if (encoding == FLAT) {
+        size_t pos = flatFind(member);
+        if (pos == flat.size()) return false;
+        flatErase(pos);
+        return true;
+    }
+
     MemberNode* mnode = find(tree_by_member, member);
     if (!mnode) {
         return false;
     }
-    // Remove from tree_by_member
+    // Removing from tree_by_member may free or overwrite mnode
+    double score = mnode->score;
     tree_by_member = remove(tree_by_member, member);
-    // Remove from tree_by_score
-    tree_by_score = remove(tree_by_score, mnode->score, member);
+    member_heap -= string_heap_size(member.size());
+    tree_by_score.remove(score, member);
     return true;
 }
 
-bool ZSet::zscore(const std::string& member, double& out_score) {
+bool ZSet::zscore(std::string_view member, double& out_score) {
+    if (encoding == FLAT) {
+        size_t pos = flatFind(member);
+        if (pos == flat.size()) return false;
+        out_score = flatScore(pos);
+        return true;
+    }
+
     MemberNode* mnode = find(tree_by_member, member);
     if (mnode) {
         out_score = mnode->score;
@@ -273,8 +330,52 @@ bool ZSet::zscore(const std::string& member, double& out_score) {
     return false;
 }
 
-std::vector<std::pair<std::string, double>> ZSet::zquery(double min_score, const std::string& min_member, int offset, int limit) {
+std::vector<std::pair<std::string, double>> ZSet::zquery(double min_score, std::string_view min_member, int offset, int limit) {
+    std::vector<std::pair<std::string, double>> result;
+    if (limit <= 0) return result;
+    if (encoding == FLAT) {
+        size_t rank;
+        size_t pos = flatLowerBound(min_score, min_member, rank);
+        for (int skip = offset; skip > 0 && pos < flat.size(); --skip) pos = flatNext(pos);
+        flatCollect(pos, limit, result);
+        return result;
+    }
+    size_t start = tree_by_score.count_less(min_score, min_member) + (offset > 0 ? offset : 0);
+    tree_by_score.range(start, limit, result);
+    return result;
+}
+
+bool ZSet::zrank(std::string_view member, size_t& out_rank) {
+    if (encoding == FLAT) {
+        size_t pos = flatFind(member);
+        if (pos == flat.size()) return false;
+        flatLowerBound(flatScore(pos), member, out_rank);
+        return true;
+    }
+
+    MemberNode* mnode = find(tree_by_member, member);
+    if (!mnode) {
+        return false;
+    }
+    out_rank = tree_by_score.count_less(mnode->score, member);
+    return true;
+}
+
+std::vector<std::pair<std::string, double>> ZSet::zrange(int64_t start, int64_t stop) {
     std::vector<std::pair<std::string, double>> result;
-    inorder(tree_by_score, min_score, min_member, offset, limit, result);
+    int64_t n = static_cast<int64_t>(zcard());
+    if (start < 0) start = std::max<int64_t>(n + start, 0);
+    if (stop < 0) stop = n + stop;
+    if (stop >= n) stop = n - 1;
+    if (start > stop) return result;
+
+    result.reserve(stop - start + 1);
+    if (encoding == FLAT) {
+        size_t pos = 0;
+        for (int64_t skip = start; skip > 0; --skip) pos = flatNext(pos);
+        flatCollect(pos, stop - start + 1, result);
+        return result;
+    }
+    tree_by_score.range(start, stop - start + 1, result);
     return result;
 }
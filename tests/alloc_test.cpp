@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "server/server.h"
+#include "server/protocol.h"
+#include "client/protocol.h"
+
+// Counting replacements for the global allocation functions. Counting is only
+// armed inside AllocCounter scopes so gtest's own bookkeeping is not measured.
+static thread_local bool g_counting = false;
+static thread_local size_t g_allocs = 0;
+
+static void* counted_alloc(size_t n) {
+    if (g_counting) g_allocs++;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t n) { return counted_alloc(n); }
+void* operator new[](size_t n) { return counted_alloc(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+struct AllocCounter {
+    AllocCounter() { g_allocs = 0; g_counting = true; }
+    ~AllocCounter() { g_counting = false; }
+    size_t count() const { return g_allocs; }
+};
+
+// Runs one framed request through the same parse + dispatch path the event
+// loop uses, with the argument vector and reply buffer already warmed up.
+static size_t allocs_for(Server& s, const std::vector<std::string>& cmd) {
+    std::vector<uint8_t> frame;
+    serialize_request(cmd, frame);
+    std::vector<std::string_view> args;
+    args.reserve(16);
+    std::string out;
+    out.reserve(4096);
+
+    AllocCounter counter;
+    if (parse_request(frame.data() + 4, frame.size() - 4, args) != 0) return SIZE_MAX;
+    s.handle_command(args, out);
+    return counter.count();
+}
+
+TEST(Allocations, GetPerformsNoHeapAllocations) {
+    Server s;
+    std::string out;
+    s.handle_command({"set", "a-key-long-enough-to-defeat-sso", "a-value-long-enough-to-defeat-sso"}, out);
+
+    EXPECT_EQ(allocs_for(s, {"get", "a-key-long-enough-to-defeat-sso"}), 0u);
+    EXPECT_EQ(allocs_for(s, {"get", "missing-key-long-enough-to-defeat-sso"}), 0u);
+}
+
+TEST(Allocations, ZScorePerformsNoHeapAllocations) {
+    Server s;
+    std::string out;
+    s.handle_command({"zadd", "a-zset-key-long-enough-to-defeat-sso", "1.5", "a-member-long-enough-to-defeat-sso"}, out);
+
+    EXPECT_EQ(allocs_for(s, {"zscore", "a-zset-key-long-enough-to-defeat-sso", "a-member-long-enough-to-defeat-sso"}), 0u);
+}
+
+TEST(Allocations, MGetPerformsNoHeapAllocations) {
+    Server s;
+    std::string out;
+    s.handle_command({"set", "a-key-long-enough-to-defeat-sso", "a-value-long-enough-to-defeat-sso"}, out);
+    s.handle_command({"set", "counter", "12345"}, out);
+    std::vector<std::string> mget = {"mget", "a-key-long-enough-to-defeat-sso", "counter", "missing-key"};
+    allocs_for(s, mget);  // sizes the batch scratch
+
+    EXPECT_EQ(allocs_for(s, mget), 0u);
+}
+
+TEST(Allocations, SetMaterializesOwnedCopies) {
+    Server s;
+    EXPECT_GT(allocs_for(s, {"set", "a-key-long-enough-to-defeat-sso", "v"}), 0u);
+}
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "server/aof.h"
+#include "server_harness.h"
+
+static off_t file_size(const std::string& path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+TEST(Aof, ReplayRebuildsTheKeyspace) {
+    TempPath path("replay.aof", {".rewrite"});
+    ServerConfig config;
+    config.aof_path = path.str();
+    {
+        ServerHarness harness(config);
+        int fd = harness.connect();
+        ASSERT_GE(fd, 0);
+        request(fd, {"set", "s", "hello"});
+        request(fd, {"mset", "a", "1", "b", "2"});
+        request(fd, {"incr", "a"});
+        request(fd, {"incrbyfloat", "f", "1.5"});
+        request(fd, {"zadd", "z", "1", "one"});
+        request(fd, {"zadd", "z", "2", "two"});
+        request(fd, {"zadd", "z", "0.1", "tenth"});
+        request(fd, {"zrem", "z", "two"});
+        request(fd, {"set", "gone", "x"});
+        request(fd, {"del", "gone"});
+        request(fd, {"set", "ttl", "v"});
+        request(fd, {"pexpire", "ttl", "100000"});
+        request(fd, {"set", "zero", "v"});
+        request(fd, {"pexpire", "zero", "0"});
+        // Expires, and is found expired by the ZADD: the log must show the
+        // deletion before the ZADD or the replay would hit a string.
+        request(fd, {"set", "reused", "v"});
+        request(fd, {"pexpire", "reused", "10"});
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        EXPECT_EQ(request(fd, {"zadd", "reused", "5", "m"}), int_reply(1));
+        // A failed MSET leaves no trace, even split across shards on replay.
+        EXPECT_EQ(request(fd, {"mset", "c", "3", "z", "4"})[0], SER_ERR);
+        ::close(fd);
+    }
+
+    Server b(config);
+    AofLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(b.load_aof(aof_files(path.str()), stats, err)) << err;
+    EXPECT_EQ(stats.files, 1u);
+    EXPECT_EQ(stats.truncated, 0u);
+    EXPECT_EQ(run(b, {"get", "s"}), str_reply("hello"));
+    EXPECT_EQ(run(b, {"get", "a", "int"}), int_reply(2));
+    EXPECT_EQ(run(b, {"get", "b"}), str_reply("2"));
+    EXPECT_EQ(run(b, {"get", "f"}), str_reply("1.5"));
+    EXPECT_EQ(run(b, {"zcard", "z"}), int_reply(2));
+    EXPECT_EQ(run(b, {"zrank", "z", "tenth"}), int_reply(0));
+    EXPECT_EQ(run(b, {"get", "gone"}), run(b, {"get", "nothing"}));
+    EXPECT_EQ(run(b, {"get", "zero"}), run(b, {"get", "nothing"}));
+    EXPECT_EQ(run(b, {"get", "c"}), run(b, {"get", "nothing"}));
+    EXPECT_EQ(run(b, {"zcard", "reused"}), int_reply(1));
+
+    std::string pttl = run(b, {"pttl", "ttl"});
+    int64_t left = 0;
+    ASSERT_EQ(pttl.size(), 9u);
+    std::memcpy(&left, &pttl[1], 8);
+    EXPECT_GT(left, 90000);
+    EXPECT_LE(left, 100000);
+}
+
+TEST(Aof, TornTailIsDroppedAndCorruptionIsNot) {
+    TempPath path("torn.aof", {".rewrite"});
+    ServerConfig config;
+    config.aof_path = path.str();
+    {
+        ServerHarness harness(config);
+        int fd = harness.connect();
+        ASSERT_GE(fd, 0);
+        for (int i = 0; i < 10; ++i) request(fd, {"set", "k" + std::to_string(i), "v"});
+        ::close(fd);
+    }
+    off_t whole = file_size(path.str());
+    ASSERT_GT(whole, 0);
+
+    // Half a SET, as a crash in the middle of a write leaves it.
+    std::string frame;
+    append_request_frame(frame, {"set", "torn", "value"});
+    int fd = ::open(path.str().c_str(), O_WRONLY | O_APPEND);
+    ASSERT_EQ(::write(fd, frame.data(), frame.size() / 2), static_cast<ssize_t>(frame.size() / 2));
+    ::close(fd);
+
+    Server b(config);
+    AofLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(b.load_aof({path.str()}, stats, err)) << err;
+    EXPECT_EQ(stats.commands, 10u);
+    EXPECT_EQ(stats.truncated, frame.size() / 2);
+    EXPECT_EQ(file_size(path.str()), whole);
+    EXPECT_EQ(run(b, {"get", "k9"}), str_reply("v"));
+
+    // A whole frame that does not parse is not a crash artifact.
+    uint32_t bad[2] = {4, 5000};  // argc over the limit
+    fd = ::open(path.str().c_str(), O_WRONLY | O_APPEND);
+    ASSERT_EQ(::write(fd, bad, sizeof(bad)), static_cast<ssize_t>(sizeof(bad)));
+    ::close(fd);
+    Server c(config);
+    EXPECT_FALSE(c.load_aof({path.str()}, stats, err));
+    EXPECT_NE(err.find("malformed"), std::string::npos) << err;
+}
+
+TEST(Aof, TurnsLoggedBeforeTheWriterSwitchesReachTheNewLog) {
+    TempPath path("switch.aof", {".rewrite"});
+    std::string tmp = path.str() + ".rewrite";
+    // The writer picks the switch up at its own pace, so repeat to catch it
+    // both before and after the next turn is queued.
+    for (int round = 0; round < 50; ++round) {
+        // What the child would have written: the keyspace at the fork.
+        uint64_t bytes = 0;
+        std::string err;
+        ASSERT_TRUE(aof_write_file(tmp, [](AofFileWriter& w) { return w.add({"set", "a", "0"}); }, bytes, err))
+            << err;
+        int fd = ::open(path.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        int tmp_fd = ::open(tmp.c_str(), O_WRONLY | O_APPEND);
+        ASSERT_GE(fd, 0);
+        ASSERT_GE(tmp_fd, 0);
+        {
+            Aof aof(fd, 0, AofFsync::NO, nullptr);
+            aof.begin_rewrite();
+            aof.append({"set", "a", "1"});
+            aof.finish_rewrite(tmp_fd, tmp, path.str());
+            aof.append({"set", "b", "2"});
+            aof.end_turn();
+        }
+
+        Server b;
+        AofLoadStats stats;
+        ASSERT_TRUE(b.load_aof({path.str()}, stats, err)) << err;
+        EXPECT_EQ(run(b, {"get", "a"}), str_reply("1")) << "round " << round;
+        ASSERT_EQ(run(b, {"get", "b"}), str_reply("2")) << "round " << round;
+    }
+}
+
+TEST(Aof, AlwaysRepliesOnlyOnceTheWriteIsOnDisk) {
+    TempPath path("always.aof", {".rewrite"});
+    ServerConfig config;
+    config.aof_path = path.str();
+    config.appendfsync = AofFsync::ALWAYS;
+    ServerHarness harness(config);
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    std::string expected;
+    for (int i = 0; i < 20; ++i) {
+        std::string key = "k" + std::to_string(i);
+        ASSERT_EQ(request(fd, {"set", key, "v"}), str_reply("OK"));
+        append_request_frame(expected, {"set", key, "v"});
+        EXPECT_EQ(file_size(path.str()), static_cast<off_t>(expected.size()));
+    }
+    // Reads wait only behind writes of the same turn.
+    EXPECT_EQ(request(fd, {"get", "k0"}), str_reply("v"));
+    // An expire that finds no key, or is refused, changes nothing to log.
+    EXPECT_EQ(request(fd, {"pexpire", "missing", "0"}), int_reply(0));
+    EXPECT_EQ(request(fd, {"pexpireat", "missing", "1"}), int_reply(0));
+    EXPECT_EQ(request(fd, {"pexpireat", "k0", "-9223372036854775808"})[0], SER_ERR);
+    EXPECT_EQ(file_size(path.str()), static_cast<off_t>(expected.size()));
+
+    std::string info = request(fd, {"info"});
+    EXPECT_EQ(info_field(info, "aof_enabled"), "1");
+    EXPECT_EQ(info_field(info, "aof_last_write_status"), "ok");
+    EXPECT_EQ(info_field(info, "aof_current_size"), std::to_string(expected.size()));
+    EXPECT_GE(std::stoll(info_field(info, "aof_fsyncs")), 20);
+    ::close(fd);
+}
+
+TEST(Aof, RewriteCompactsTheLogWhileServing) {
+    TempPath path("rewrite.aof", {".rewrite"});
+    ServerConfig config;
+    config.aof_path = path.str();
+    {
+        ServerHarness harness(config);
+        int fd = harness.connect();
+        ASSERT_GE(fd, 0);
+        for (int round = 0; round < 20; ++round) {
+            for (int i = 0; i < 100; ++i) {
+                request(fd, {"set", "k" + std::to_string(i), "v" + std::to_string(round)});
+            }
+        }
+        request(fd, {"zadd", "z", "0.30000000000000004", "m"});
+        request(fd, {"pexpire", "k0", "100000"});
+        std::string info = request(fd, {"info"});
+        long long before = std::stoll(info_field(info, "aof_current_size"));
+
+        EXPECT_EQ(request(fd, {"bgrewriteaof"}), str_reply("Background append-only log rewrite started"));
+        EXPECT_EQ(request(fd, {"bgsave"})[0], SER_ERR);
+        // Writes while the child runs reach the new log too.
+        for (int i = 0; i < 100; ++i) request(fd, {"set", "late" + std::to_string(i), "x"});
+        for (int attempt = 0; attempt < 200; ++attempt) {
+            info = request(fd, {"info"});
+            if (info_field(info, "aof_rewrite_in_progress") == "0") break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_EQ(info_field(info, "aof_rewrite_in_progress"), "0");
+        EXPECT_EQ(info_field(info, "aof_last_rewrite_status"), "ok");
+        EXPECT_LT(std::stoll(info_field(info, "aof_current_size")), before / 5);
+        request(fd, {"set", "after", "y"});
+        ::close(fd);
+    }
+    EXPECT_EQ(file_size(path.str() + ".rewrite"), -1);
+
+    Server b(config);
+    AofLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(b.load_aof(aof_files(path.str()), stats, err)) << err;
+    EXPECT_EQ(run(b, {"get", "k99"}), str_reply("v19"));
+    EXPECT_EQ(run(b, {"get", "late99"}), str_reply("x"));
+    EXPECT_EQ(run(b, {"get", "after"}), str_reply("y"));
+    EXPECT_EQ(run(b, {"zscore", "z", "m"}), [] {
+        std::string out;
+        out_double(out, 0.30000000000000004);
+        return out;
+    }());
+    EXPECT_NE(run(b, {"pttl", "k0"}), int_reply(-1));
+}
+
+TEST(Aof, GroupLogsReplayIntoAnotherShardCount) {
+    TempPath path("group.aof", {".rewrite"});
+    ServerConfig config;
+    config.aof_path = path.str();
+    {
+        ShardedHarness harness(2, config);
+        int fd = harness.connect();
+        ASSERT_GE(fd, 0);
+        for (int i = 0; i < 200; ++i) request(fd, {"set", "k" + std::to_string(i), "v" + std::to_string(i)});
+        request(fd, {"del", "k7"});
+        ::close(fd);
+    }
+    std::vector<std::string> files = aof_files(path.str());
+    ASSERT_EQ(files.size(), 2u);
+
+    ShardGroup group(config, 3);
+    AofLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(group.load_aof(files, stats, err)) << err;
+    EXPECT_EQ(stats.files, 2u);
+    ASSERT_TRUE(group.start_aof(true, err)) << err;
+    EXPECT_EQ(aof_files(path.str()).size(), 3u);
+    for (int i = 0; i < 200; ++i) {
+        std::string key = "k" + std::to_string(i);
+        std::string got = run(group.shard(group.shard_of(key)), {"get", key});
+        if (i == 7) EXPECT_EQ(got[0], SER_NIL);
+        else EXPECT_EQ(got, str_reply("v" + std::to_string(i))) << key;
+    }
+}
@@ -297,6 +297,30 @@ TEST(ClientReplDeath, ResponseTooLarge) {
     );
 }
 
+TEST(ClientRepl, ResponseLimitIsConfigurable) {
+    using namespace testutil;
+
+    std::string big(11 * 1024 * 1024, 'x');
+    FakeTransport t;
+    t.scripted_recv = frame(ser_str(big));
+
+    std::istringstream in("GET big\n");
+    std::ostringstream out, err;
+    EXPECT_EQ(run_client_repl(t, in, out, err, 16 * 1024 * 1024), 0);
+    EXPECT_EQ(out.str(), "> " + big + "\n> ");
+}
+
+TEST(ClientReplDeath, ResponseOverConfiguredLimit) {
+    using namespace testutil;
+
+    FakeTransport t;
+    t.scripted_recv = frame(ser_str("seventeen bytes."));
+
+    std::istringstream in("ANY\n");
+    std::ostringstream out, err;
+    EXPECT_DEATH({ run_client_repl(t, in, out, err, 16); }, "Response too large");
+}
+
 // ======================= Integration-ish serialization check =================
 
 TEST(ProtocolSerialize, ArgumentsMarshaledCorrectly) {
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "server_harness.h"
+
+// Frames several requests back to back so they arrive in one segment.
+static std::vector<uint8_t> pipeline(const std::vector<std::vector<std::string>>& cmds) {
+    std::vector<uint8_t> out;
+    for (const auto& cmd : cmds) {
+        std::vector<uint8_t> req;
+        serialize_request(cmd, req);
+        out.insert(out.end(), req.begin(), req.end());
+    }
+    return out;
+}
+
+static std::string str_body(const std::string& s) {
+    std::string body(1, (char)SER_STR);
+    uint32_t len = static_cast<uint32_t>(s.size());
+    body.append((const char*)&len, 4);
+    body.append(s);
+    return body;
+}
+
+TEST(Pipelining, AnswersEveryFrameInOrder) {
+    ServerHarness harness;
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    std::vector<std::vector<std::string>> cmds;
+    for (int i = 0; i < 100; ++i) {
+        cmds.push_back({"set", "k" + std::to_string(i), "v" + std::to_string(i)});
+        cmds.push_back({"get", "k" + std::to_string(i)});
+    }
+    std::vector<uint8_t> buf = pipeline(cmds);
+    ASSERT_TRUE(send_all(fd, buf.data(), buf.size()));
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(recv_response(fd), str_body("OK"));
+        EXPECT_EQ(recv_response(fd), str_body("v" + std::to_string(i)));
+    }
+    ::close(fd);
+}
+
+TEST(Pipelining, OutputCapAppliesBackpressureWithoutLosingReplies) {
+    ServerHarness harness;
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    std::string value(1000, 'x');
+    ASSERT_TRUE(send_request(fd, {"set", "big", value}));
+    ASSERT_EQ(recv_response(fd), str_body("OK"));
+
+    // ~1000 bytes per reply, so this queues far more than k_max_wbuf.
+    const int n = 2000;
+    std::vector<std::vector<std::string>> cmds(n, std::vector<std::string>{"get", "big"});
+    std::vector<uint8_t> buf = pipeline(cmds);
+
+    std::thread writer([&] { send_all(fd, buf.data(), buf.size()); });
+    int got = 0;
+    for (int i = 0; i < n; ++i) {
+        if (recv_response(fd) == str_body(value)) got++;
+    }
+    writer.join();
+    EXPECT_EQ(got, n);
+    ::close(fd);
+}
+
+TEST(Pipelining, PartialFrameWaitsForTheRest) {
+    ServerHarness harness;
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    std::vector<uint8_t> buf = pipeline({{"set", "a", "1"}, {"get", "a"}});
+    size_t split = buf.size() - 3;
+    ASSERT_TRUE(send_all(fd, buf.data(), split));
+    EXPECT_EQ(recv_response(fd), str_body("OK"));
+    ASSERT_TRUE(send_all(fd, buf.data() + split, buf.size() - split));
+    EXPECT_EQ(recv_response(fd), str_body("1"));
+    ::close(fd);
+}
+
+TEST(Pipelining, FramesThatWrapTheReadBufferParseCorrectly) {
+    ServerHarness harness;
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    // Odd, growing frame sizes push frame boundaries across the end of the
+    // connection's ring buffer at many different offsets.
+    std::vector<std::vector<std::string>> cmds;
+    for (int i = 0; i < 300; ++i) {
+        cmds.push_back({"set", "k" + std::to_string(i), std::string(1 + (i * 37) % 3000, 'a' + i % 26)});
+        cmds.push_back({"get", "k" + std::to_string(i)});
+    }
+    std::vector<uint8_t> buf = pipeline(cmds);
+
+    std::thread writer([&] { send_all(fd, buf.data(), buf.size()); });
+    for (int i = 0; i < 300; ++i) {
+        ASSERT_EQ(recv_response(fd), str_body("OK"));
+        ASSERT_EQ(recv_response(fd), str_body(cmds[2 * i][2]));
+    }
+    writer.join();
+    ::close(fd);
+}
+
+TEST(LargeFrames, ValuesLargerThanTheReadBufferRoundTrip) {
+    ServerHarness harness;
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    for (size_t size : {size_t(5000), size_t(1) << 20, size_t(4) << 20}) {
+        std::string value(size, '\0');
+        for (size_t i = 0; i < size; ++i) value[i] = static_cast<char>('a' + (i * 7) % 26);
+        std::vector<uint8_t> buf = pipeline({{"set", "blob", value}, {"get", "blob"}, {"set", "small", "1"}});
+
+        // Dribble the frame in at odd sizes so prefixes and arguments split
+        // across reads.
+        std::thread writer([&] {
+            size_t pos = 0;
+            for (size_t step = 1; pos < buf.size(); step = step * 3 + 1) {
+                size_t n = std::min(step % 100000 + 1, buf.size() - pos);
+                send_all(fd, buf.data() + pos, n);
+                pos += n;
+            }
+        });
+        EXPECT_EQ(recv_response(fd), str_body("OK"));
+        EXPECT_EQ(recv_response(fd), str_body(value));
+        EXPECT_EQ(recv_response(fd), str_body("OK"));
+        writer.join();
+    }
+
+    // Several large arguments in one frame.
+    std::string a(300000, 'a'), b(200000, 'b');
+    ASSERT_TRUE(send_request(fd, {"mset", "a", a, "b", b}));
+    EXPECT_EQ(recv_response(fd), str_body("OK"));
+    ASSERT_TRUE(send_request(fd, {"get", "b"}));
+    EXPECT_EQ(recv_response(fd), str_body(b));
+    ::close(fd);
+
+    // The grown buffers were charged to the connection and released with it.
+    fd = harness.connect();
+    ASSERT_GE(fd, 0);
+    unsigned long long connections = 0;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        ASSERT_TRUE(send_request(fd, {"info"}));
+        std::string info = recv_response(fd);
+        size_t pos = info.find("mem_connections:");
+        ASSERT_NE(pos, std::string::npos);
+        connections = std::stoull(info.substr(pos + 16));
+        if (connections < (1u << 20)) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));  // the close may not be seen yet
+    }
+    EXPECT_LT(connections, 1u << 20);
+    ::close(fd);
+}
+
+TEST(LargeFrames, QueuedRepliesKeepTheValueTheyRead) {
+    ServerHarness harness;
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    // Replies to the GETs are still queued by reference when the key is
+    // overwritten and deleted behind them.
+    std::string a(100000, 'a'), b(100000, 'b');
+    std::vector<uint8_t> buf = pipeline({{"set", "k", a}, {"get", "k"}, {"set", "k", b}, {"get", "k"},
+                                         {"del", "k"}, {"get", "k"}, {"set", "k", a}});
+    std::thread writer([&] { send_all(fd, buf.data(), buf.size()); });
+    EXPECT_EQ(recv_response(fd), str_body("OK"));
+    EXPECT_EQ(recv_response(fd), str_body(a));
+    EXPECT_EQ(recv_response(fd), str_body("OK"));
+    EXPECT_EQ(recv_response(fd), str_body(b));
+    recv_response(fd);
+    EXPECT_EQ(recv_response(fd), std::string(1, (char)SER_NIL));
+    EXPECT_EQ(recv_response(fd), str_body("OK"));
+    writer.join();
+    ::close(fd);
+}
+
+TEST(LargeFrames, FramesOverTheLimitOrMalformedCloseTheConnection) {
+    ServerConfig config;
+    config.max_frame = 64 * 1024;
+    ServerHarness harness(config);
+
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(send_request(fd, {"set", "k", std::string(60000, 'x')}));
+    EXPECT_EQ(recv_response(fd), str_body("OK"));
+    ASSERT_TRUE(send_request(fd, {"set", "k", std::string(70000, 'x')}));
+    EXPECT_EQ(recv_response(fd), "");
+    ::close(fd);
+
+    // An argument length running past the end of the frame.
+    fd = harness.connect();
+    ASSERT_GE(fd, 0);
+    std::vector<uint8_t> req;
+    serialize_request({"set", "k", std::string(10000, 'x')}, req);
+    uint32_t bogus = 20000;
+    std::memcpy(&req[4 + 4 + 4 + 3 + 4 + 1], &bogus, 4);
+    ASSERT_TRUE(send_all(fd, req.data(), req.size()));
+    EXPECT_EQ(recv_response(fd), "");
+    ::close(fd);
+}
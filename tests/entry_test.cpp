@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "server/entry.h"
+#include "server/slab.h"
+
+static char scratch[Entry::k_max_int_chars];
+
+TEST(Entry, ShortStringsLiveInTheRecord) {
+    std::unique_ptr<Entry> e(Entry::make_string("key:000000000001", "value:00"));
+    EXPECT_EQ(e->type(), Entry::STRING);
+    EXPECT_EQ(e->key(), "key:000000000001");
+    EXPECT_EQ(e->str_value(scratch), "value:00");
+    EXPECT_EQ(e->zset_value(), nullptr);
+    EXPECT_EQ(e->value_heap_bytes(), 0u);
+    EXPECT_EQ(e->record_bytes(), slab_object_size(sizeof(Entry) + 16 + 8));
+    EXPECT_EQ(e->expire_at, Entry::k_no_expiry);
+    EXPECT_EQ(e->heap_idx, Entry::k_no_heap_idx);
+}
+
+TEST(Entry, LongStringsGetTheirOwnBuffer) {
+    std::string big(Entry::k_max_inline_value + 1, 'x');
+    std::unique_ptr<Entry> e(Entry::make_string("k", big));
+    EXPECT_EQ(e->str_value(scratch), big);
+    EXPECT_GT(e->value_heap_bytes(), big.size());
+    EXPECT_EQ(e->record_bytes(), slab_object_size(sizeof(Entry) + 1));
+}
+
+TEST(Entry, AssignValueStaysInPlaceOnlyWithinTheSameSize) {
+    std::unique_ptr<Entry> e(Entry::make_string("k", "abc"));
+    // 32 + 1 + 3 rounds to 48, as does anything up to 15 value bytes.
+    EXPECT_TRUE(e->assign_value("abcdefghijklmno"));
+    EXPECT_EQ(e->str_value(scratch), "abcdefghijklmno");
+    EXPECT_TRUE(e->assign_value(""));
+    EXPECT_EQ(e->str_value(scratch), "");
+    EXPECT_FALSE(e->assign_value("abcdefghijklmnop"));
+    EXPECT_EQ(e->str_value(scratch), "");
+    // HEAP and INT values leave a 33-byte record, also 48.
+    EXPECT_TRUE(e->assign_value(std::string(100, 'y')));
+    EXPECT_EQ(e->encoding(), Entry::HEAP);
+    EXPECT_TRUE(e->assign_value("42"));
+    EXPECT_EQ(e->encoding(), Entry::INT);
+
+    std::unique_ptr<Entry> h(Entry::make_string("k", std::string(100, 'a')));
+    EXPECT_TRUE(h->assign_value(std::string(300, 'b')));
+    EXPECT_EQ(h->str_value(scratch), std::string(300, 'b'));
+    EXPECT_FALSE(h->assign_value(std::string(40, 'c')));
+    EXPECT_EQ(h->str_value(scratch), std::string(300, 'b'));
+}
+
+TEST(Entry, CanonicalIntegersAreIntEncoded) {
+    for (const char* v : {"0", "-1", "42", "9223372036854775807", "-9223372036854775808"}) {
+        std::unique_ptr<Entry> e(Entry::make_string("k", v));
+        EXPECT_EQ(e->encoding(), Entry::INT) << v;
+        EXPECT_EQ(e->str_value(scratch), v);
+        EXPECT_EQ(e->value_heap_bytes(), 0u);
+        EXPECT_EQ(e->record_bytes(), slab_object_size(sizeof(Entry) + 1));
+    }
+    EXPECT_EQ(std::unique_ptr<Entry>(Entry::make_string("k", "-7"))->int_value(), -7);
+
+    // Anything that would not print back identically stays a string.
+    for (const char* v : {"", "-", "-0", "007", "+5", " 5", "5 ", "1.0", "9223372036854775808", "1e3"}) {
+        std::unique_ptr<Entry> e(Entry::make_string("k", v));
+        EXPECT_EQ(e->encoding(), Entry::INLINE) << v;
+        EXPECT_EQ(e->str_value(scratch), v);
+    }
+}
+
+TEST(Entry, SetIntUpdatesInPlace) {
+    std::unique_ptr<Entry> e(Entry::make_int("counter", 10));
+    e->set_int(-3);
+    EXPECT_EQ(e->int_value(), -3);
+    EXPECT_EQ(e->str_value(scratch), "-3");
+    EXPECT_TRUE(e->assign_value("hello"));
+    EXPECT_EQ(e->encoding(), Entry::INLINE);
+    EXPECT_EQ(e->str_value(scratch), "hello");
+}
+
+TEST(Entry, ZSetEntriesOwnTheirSet) {
+    std::unique_ptr<Entry> e(Entry::make_zset("z"));
+    EXPECT_EQ(e->type(), Entry::ZSET);
+    EXPECT_EQ(e->key(), "z");
+    ASSERT_NE(e->zset_value(), nullptr);
+    EXPECT_TRUE(e->zset_value()->zadd("m", 1.0));
+    EXPECT_FALSE(e->assign_value("v"));
+    EXPECT_EQ(e->value_heap_bytes(), 0u);
+}
+
+TEST(Entry, LongKeysAreEmbeddedToo) {
+    std::string key(3000, 'k');
+    std::unique_ptr<Entry> e(Entry::make_string(key, "v"));
+    EXPECT_EQ(e->key(), key);
+    EXPECT_EQ(e->str_value(scratch), "v");
+    EXPECT_FALSE(e->assign_value("vv"));
+    EXPECT_TRUE(e->assign_value("w"));
+    EXPECT_EQ(e->str_value(scratch), "w");
+}
+
+TEST(Entry, HeapValuesTakeOverAnOwnedBuffer) {
+    auto buffer_of = [](std::string_view v) {
+        ValueBuffer* buf = ValueBuffer::create(v.size());
+        std::memcpy(buf->data(), v.data(), v.size());
+        return buf;
+    };
+    std::string big(1000, 'x');
+    ValueBuffer* owned = buffer_of(big);
+    std::unique_ptr<Entry> e(Entry::make_string("k", big, owned));
+    EXPECT_EQ(e->heap_buffer(), owned);
+    EXPECT_EQ(e->str_value(scratch), big);
+
+    std::string other(1000, 'y');
+    owned = buffer_of(other);
+    EXPECT_TRUE(e->assign_value(other, owned));
+    EXPECT_EQ(e->heap_buffer(), owned);
+    EXPECT_EQ(e->str_value(scratch), other);
+
+    // Values that are not stored on the heap drop the buffer instead.
+    EXPECT_TRUE(e->assign_value("42", buffer_of("42")));
+    EXPECT_TRUE(e->is_int());
+    EXPECT_EQ(e->heap_buffer(), nullptr);
+    std::unique_ptr<Entry> s(Entry::make_string("k", "abc", buffer_of("abc")));
+    EXPECT_EQ(s->encoding(), Entry::INLINE);
+}
+
+TEST(Entry, SharedHeapBuffersAreNotOverwritten) {
+    std::unique_ptr<Entry> e(Entry::make_string("k", std::string(100, 'a')));
+    ValueBuffer* sending = e->heap_buffer();
+    ValueBuffer::ref(sending);  // as a queued reply would
+
+    EXPECT_TRUE(e->assign_value(std::string(100, 'b')));
+    EXPECT_NE(e->heap_buffer(), sending);
+    EXPECT_EQ(std::string_view(sending->data(), 100), std::string(100, 'a'));
+    e.reset();
+    EXPECT_EQ(std::string_view(sending->data(), 100), std::string(100, 'a'));
+    ValueBuffer::unref(sending);
+
+    // Unshared, a same-sized buffer is reused.
+    std::unique_ptr<Entry> f(Entry::make_string("k", std::string(100, 'a')));
+    ValueBuffer* buf = f->heap_buffer();
+    EXPECT_TRUE(f->assign_value(std::string(100, 'c')));
+    EXPECT_EQ(f->heap_buffer(), buf);
+}
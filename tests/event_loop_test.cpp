@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "server/event_loop.h"
+#include "server_harness.h"
+
+class EventLoopBackend : public ::testing::TestWithParam<EventBackend> {};
+
+TEST_P(EventLoopBackend, ReportsReadableThenWritable) {
+    auto loop = EventLoop::create(GetParam());
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    loop->add(sv[0], Interest::READ);
+    std::vector<IoEvent> events;
+    EXPECT_EQ(loop->wait(events, 0), 0);
+
+    ASSERT_EQ(::write(sv[1], "x", 1), 1);
+    ASSERT_EQ(loop->wait(events, 1000), 1);
+    EXPECT_EQ(events[0].fd, sv[0]);
+    EXPECT_TRUE(events[0].readable);
+
+    char c;
+    ASSERT_EQ(::read(sv[0], &c, 1), 1);
+
+    loop->modify(sv[0], Interest::WRITE);
+    ASSERT_EQ(loop->wait(events, 1000), 1);
+    EXPECT_TRUE(events[0].writable);
+    EXPECT_FALSE(events[0].readable);
+
+    loop->remove(sv[0]);
+    ASSERT_EQ(::write(sv[1], "y", 1), 1);
+    EXPECT_EQ(loop->wait(events, 0), 0);
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
+
+TEST_P(EventLoopBackend, FlipBackToReadSeesDataThatArrivedMeanwhile) {
+    auto loop = EventLoop::create(GetParam());
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    loop->add(sv[0], Interest::WRITE);
+    ASSERT_EQ(::write(sv[1], "x", 1), 1);
+
+    std::vector<IoEvent> events;
+    loop->modify(sv[0], Interest::READ);
+    ASSERT_EQ(loop->wait(events, 1000), 1);
+    EXPECT_TRUE(events[0].readable);
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
+
+TEST_P(EventLoopBackend, ServerAnswersManyClients) {
+    ServerConfig config;
+    config.backend = GetParam();
+    ServerHarness harness(config);
+
+    std::vector<int> fds;
+    for (int i = 0; i < 20; ++i) {
+        int fd = harness.connect();
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    for (size_t i = 0; i < fds.size(); ++i) {
+        ASSERT_TRUE(send_request(fds[i], {"set", "k" + std::to_string(i), "v" + std::to_string(i)}));
+    }
+    for (int fd : fds) {
+        EXPECT_FALSE(recv_response(fd).empty());
+    }
+    for (size_t i = 0; i < fds.size(); ++i) {
+        ASSERT_TRUE(send_request(fds[i], {"get", "k" + std::to_string(i)}));
+        std::string body = recv_response(fds[i]);
+        std::string want = "v" + std::to_string(i);
+        ASSERT_EQ(body.size(), 5 + want.size());
+        EXPECT_EQ(body.substr(5), want);
+    }
+    for (int fd : fds) ::close(fd);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, EventLoopBackend,
+                         ::testing::Values(EventBackend::POLL, EventBackend::EPOLL),
+                         [](const ::testing::TestParamInfo<EventBackend>& info) {
+                             return info.param == EventBackend::POLL ? "Poll" : "Epoll";
+                         });
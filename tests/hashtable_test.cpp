@@ -0,0 +1,383 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "server/hashtable.h"
+#include "server/flat_hashtable.h"
+
+using Table = HashTable<std::string, int*>;
+
+// Both engines must be interchangeable behind the same interface.
+template <typename T>
+class HashTableInterface : public ::testing::Test {};
+
+using Engines = ::testing::Types<HashTable<std::string, int*>, FlatHashTable<std::string, int*>>;
+TYPED_TEST_SUITE(HashTableInterface, Engines);
+
+TYPED_TEST(HashTableInterface, MatchesReferenceUnderChurn) {
+    TypeParam t(16);
+    std::unordered_map<std::string, int> ref;
+    for (int i = 0; i < 20000; ++i) {
+        std::string k = "k" + std::to_string((i * 7919) % 5000);
+        if (i % 3 == 2) {
+            EXPECT_EQ(t.remove(k), ref.erase(k) == 1);
+        } else {
+            t.put(k, new int(i));
+            ref[k] = i;
+        }
+    }
+    ASSERT_EQ(t.size(), ref.size());
+    for (int i = 0; i < 5000; ++i) {
+        std::string k = "k" + std::to_string(i);
+        auto it = ref.find(k);
+        int* v = t.get(k);
+        if (it == ref.end()) {
+            EXPECT_EQ(v, nullptr);
+            EXPECT_FALSE(t.contains(k));
+        } else {
+            ASSERT_NE(v, nullptr);
+            EXPECT_EQ(*v, it->second);
+        }
+    }
+    std::vector<std::string> keys = t.keys();
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::string> want;
+    for (const auto& kv : ref) want.push_back(kv.first);
+    std::sort(want.begin(), want.end());
+    EXPECT_EQ(keys, want);
+}
+
+TYPED_TEST(HashTableInterface, TombstonesDoNotBreakLookups) {
+    TypeParam t(16);
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 200; ++i) t.put("r" + std::to_string(round) + ":" + std::to_string(i), new int(i));
+        for (int i = 0; i < 200; ++i) ASSERT_TRUE(t.remove("r" + std::to_string(round) + ":" + std::to_string(i)));
+        t.put("keep" + std::to_string(round), new int(round));
+    }
+    EXPECT_EQ(t.size(), 50u);
+    for (int round = 0; round < 50; ++round) {
+        int* v = t.get("keep" + std::to_string(round));
+        ASSERT_NE(v, nullptr);
+        EXPECT_EQ(*v, round);
+    }
+}
+
+TYPED_TEST(HashTableInterface, BatchLookupsAndInsertsMatchSingleOnes) {
+    TypeParam t(16);
+    t.reserve(3000);
+    unsigned int buckets = t.bucket_count();
+    std::vector<std::string> keys;
+    std::vector<int*> values;
+    for (int i = 0; i < 3000; ++i) {
+        keys.push_back("k" + std::to_string(i));
+        values.push_back(new int(i));
+    }
+    keys.push_back("k7");  // repeats one already in this batch
+    values.push_back(new int(-1));
+    std::vector<char> inserted(keys.size());
+    t.insert_many(keys.data(), values.data(), keys.size(), reinterpret_cast<bool*>(inserted.data()));
+    EXPECT_EQ(t.size(), 3000u);
+    EXPECT_EQ(t.bucket_count(), buckets);
+    for (int i = 0; i < 3000; ++i) ASSERT_TRUE(inserted[i]);
+    EXPECT_FALSE(inserted.back());
+    delete values.back();
+
+    int* other = new int(-2);
+    EXPECT_FALSE(t.insert("k9", other));
+    EXPECT_TRUE(t.insert("new", other));
+
+    std::vector<std::string> probes;
+    for (int i = 0; i < 3100; i += 7) probes.push_back("k" + std::to_string(i));
+    probes.push_back("new");
+    std::vector<int*> found(probes.size());
+    t.get_many(probes.data(), probes.size(), found.data());
+    for (size_t i = 0; i < probes.size(); ++i) EXPECT_EQ(found[i], t.get(probes[i])) << probes[i];
+    EXPECT_EQ(*found[1], 7);
+    EXPECT_EQ(found.back(), other);
+    EXPECT_FALSE(t.is_rehashing());
+}
+
+TYPED_TEST(HashTableInterface, WalksSeeOnlyAndAllLiveEntries) {
+    TypeParam t(16);
+    std::unordered_map<std::string, int> ref;
+    for (int i = 0; i < 2000; ++i) {
+        std::string k = "k" + std::to_string(i);
+        t.put(k, new int(i));
+        if (i % 2) t.remove(k);
+        else ref[k] = i;
+    }
+    size_t visited = 0;
+    t.for_each([&](const std::string& key, int* value) {
+        EXPECT_EQ(ref.at(key), *value);
+        visited++;
+    });
+    EXPECT_EQ(visited, ref.size());
+
+    for (uint64_t seed = 0; seed < 100; ++seed) {
+        unsigned int n = t.sample(seed * 7919, 5, [&](const std::string& key, int* value) {
+            EXPECT_EQ(ref.at(key), *value);
+        });
+        EXPECT_EQ(n, 5u);
+    }
+
+    // Keys present for the whole walk are all seen, though it grows.
+    std::set<std::string> seen;
+    size_t cursor = 0;
+    int calls = 0;
+    do {
+        cursor = t.scan(cursor, [&](const std::string& key, int*) { seen.insert(key); });
+        if (++calls == 10) {
+            for (int i = 2000; i < 10000; ++i) t.put("n" + std::to_string(i), new int(i));
+        }
+        t.rehash_step(1);
+    } while (cursor != 0);
+    for (const auto& [key, value] : ref) EXPECT_TRUE(seen.count(key)) << key;
+}
+
+TEST(FlatHashTable, ServesAsTheKeyspaceTable) {
+    // Keyed by views into the values, probed with other strings, as
+    // Server::db_ is.
+    FlatHashTable<std::string_view, std::string*, StringHash> t(16);
+    std::string* a = new std::string("alpha");
+    t.put(*a, a);
+    EXPECT_EQ(t.get(std::string("alpha")), a);
+    EXPECT_TRUE(t.contains(std::string_view("alpha")));
+    // Replacing the value moves the key's view to it.
+    std::string* b = new std::string("alpha");
+    t.put(*b, b);
+    std::vector<std::string_view> keys = t.keys();
+    ASSERT_EQ(keys.size(), 1u);
+    EXPECT_EQ(keys[0].data(), b->data());
+    EXPECT_FALSE(t.rehash_step(1));
+    EXPECT_TRUE(t.remove(std::string("alpha")));
+    EXPECT_EQ(t.size(), 0u);
+}
+
+static void expect_matches(const Table& t, const std::unordered_map<std::string, int>& ref) {
+    ASSERT_EQ(t.size(), ref.size());
+    for (const auto& kv : ref) {
+        int* v = t.get(kv.first);
+        ASSERT_NE(v, nullptr) << kv.first;
+        EXPECT_EQ(*v, kv.second) << kv.first;
+    }
+    std::vector<std::string> keys = t.keys();
+    ASSERT_EQ(keys.size(), ref.size());
+    std::sort(keys.begin(), keys.end());
+    EXPECT_TRUE(std::adjacent_find(keys.begin(), keys.end()) == keys.end());
+    for (const std::string& k : keys) {
+        EXPECT_EQ(ref.count(k), 1u) << k;
+    }
+}
+
+TEST(HashTable, PutGetRemoveBasics) {
+    Table t;
+    EXPECT_EQ(t.get("a"), nullptr);
+    t.put("a", new int(1));
+    t.put("b", new int(2));
+    EXPECT_EQ(*t.get("a"), 1);
+    t.put("a", new int(3));
+    EXPECT_EQ(*t.get("a"), 3);
+    EXPECT_EQ(t.size(), 2u);
+    EXPECT_TRUE(t.remove("a"));
+    EXPECT_FALSE(t.remove("a"));
+    EXPECT_FALSE(t.contains("a"));
+    EXPECT_TRUE(t.contains("b"));
+    EXPECT_EQ(t.size(), 1u);
+}
+
+TEST(HashTable, StaysCorrectMidGrowMigration) {
+    Table t(16);
+    std::unordered_map<std::string, int> ref;
+
+    int i = 0;
+    while (!t.is_rehashing()) {
+        std::string k = "k" + std::to_string(i);
+        t.put(k, new int(i));
+        ref[k] = i++;
+    }
+    expect_matches(t, ref);
+
+    // Mix of overwrites, removes and fresh inserts while buckets are still
+    // split across both arrays.
+    for (int j = 0; j < i && t.is_rehashing(); j += 3) {
+        std::string k = "k" + std::to_string(j);
+        t.put(k, new int(-j));
+        ref[k] = -j;
+        std::string gone = "k" + std::to_string(j + 1);
+        EXPECT_EQ(t.remove(gone), ref.erase(gone) == 1);
+        std::string fresh = "n" + std::to_string(j);
+        t.put(fresh, new int(j));
+        ref[fresh] = j;
+        expect_matches(t, ref);
+    }
+
+    while (t.rehash_step(1)) {}
+    EXPECT_FALSE(t.is_rehashing());
+    expect_matches(t, ref);
+}
+
+TEST(HashTable, ShrinksIncrementallyAfterMassDelete) {
+    Table t(16);
+    std::unordered_map<std::string, int> ref;
+    for (int i = 0; i < 4096; ++i) {
+        std::string k = "k" + std::to_string(i);
+        t.put(k, new int(i));
+        ref[k] = i;
+    }
+    while (t.rehash_step(100)) {}
+    unsigned int grown = t.bucket_count();
+
+    bool saw_shrink = false;
+    for (int i = 0; i < 4090; ++i) {
+        std::string k = "k" + std::to_string(i);
+        ASSERT_TRUE(t.remove(k));
+        ref.erase(k);
+        if (t.is_rehashing()) {
+            saw_shrink = true;
+            expect_matches(t, ref);
+        }
+    }
+    EXPECT_TRUE(saw_shrink);
+    while (t.rehash_step(100)) {}
+    EXPECT_LT(t.bucket_count(), grown);
+    EXPECT_GE(t.bucket_count(), 16u);
+    expect_matches(t, ref);
+}
+
+TEST(HashTable, SampleVisitsOnlyLiveEntries) {
+    Table t(16);
+    std::unordered_map<std::string, int> ref;
+    for (int i = 0; i < 1000; ++i) {
+        std::string k = "k" + std::to_string(i);
+        t.put(k, new int(i));
+        ref[k] = i;
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        std::string k = "k" + std::to_string(i);
+        t.remove(k);
+        ref.erase(k);
+    }
+    ASSERT_TRUE(t.is_rehashing() || t.bucket_count() > 0);
+
+    for (uint64_t seed = 0; seed < 200; ++seed) {
+        unsigned int seen = 0;
+        unsigned int n = t.sample(seed * 7919, 5, [&](const std::string& key, int* value) {
+            auto it = ref.find(key);
+            ASSERT_NE(it, ref.end());
+            EXPECT_EQ(*value, it->second);
+            seen++;
+        });
+        EXPECT_EQ(n, seen);
+        EXPECT_LE(n, 5u);
+    }
+
+    Table empty(16);
+    EXPECT_EQ(empty.sample(42, 5, [](const std::string&, int*) { FAIL(); }), 0u);
+}
+
+TEST(HashTable, GetManyMatchesGetMidMigration) {
+    Table t(16);
+    std::vector<int*> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(new int(i));
+        t.put("k" + std::to_string(i), values.back());
+    }
+    // Keep some buckets in each array.
+    while (!t.is_rehashing()) {
+        int i = static_cast<int>(values.size());
+        values.push_back(new int(i));
+        t.put("k" + std::to_string(i), values.back());
+    }
+    ASSERT_TRUE(t.is_rehashing());
+
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < values.size() + 50; i += 3) keys.push_back("k" + std::to_string(i));
+    keys.push_back("k0");  // a repeat
+    std::vector<int*> found(keys.size());
+    t.get_many(keys.data(), keys.size(), found.data());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(found[i], t.get(keys[i])) << keys[i];
+    }
+    EXPECT_EQ(found.back(), values[0]);
+
+    t.get_many(keys.data(), 0, found.data());
+}
+
+TEST(HashTable, ScanVisitsEveryKeyAcrossResizes) {
+    Table t(16);
+    std::unordered_map<std::string, int> ref;
+    for (int i = 0; i < 2000; ++i) {
+        std::string k = "k" + std::to_string(i);
+        t.put(k, new int(i));
+        ref[k] = i;
+    }
+
+    // Grow, then shrink, while a walk is in progress. Keys present for the
+    // whole walk must all be seen.
+    std::set<std::string> seen;
+    size_t cursor = 0;
+    int calls = 0;
+    do {
+        cursor = t.scan(cursor, [&](const std::string& key, int*) { seen.insert(key); });
+        ++calls;
+        if (calls == 20) {
+            for (int i = 2000; i < 8000; ++i) t.put("k" + std::to_string(i), new int(i));
+        } else if (calls == 200) {
+            for (int i = 2000; i < 8000; ++i) t.remove("k" + std::to_string(i));
+            for (int i = 0; i < 1500; ++i) {
+                std::string k = "k" + std::to_string(i);
+                t.remove(k);
+                ref.erase(k);
+            }
+        }
+        if (calls % 7 == 0) t.rehash_step(3);
+    } while (cursor != 0);
+
+    for (const auto& [key, value] : ref) EXPECT_TRUE(seen.count(key)) << key;
+    EXPECT_GE(calls, 200);
+
+    // One call per bucket, each in reverse-binary order.
+    Table empty(16);
+    std::vector<size_t> cursors{0};
+    do {
+        cursors.push_back(empty.scan(cursors.back(), [](const std::string&, int*) { FAIL(); }));
+    } while (cursors.back() != 0);
+    EXPECT_EQ(cursors.size(), 17u);
+    EXPECT_EQ(cursors[1], 8u);
+    EXPECT_EQ(cursors[2], 4u);
+    EXPECT_EQ(cursors[3], 12u);
+}
+
+TEST(HashTable, InsertKeepsTheFirstValueAndReserveNeverResizes) {
+    Table t(16);
+    t.reserve(10000);
+    unsigned int buckets = t.bucket_count();
+    EXPECT_FALSE(t.is_rehashing());
+
+    std::vector<std::string> keys;
+    std::vector<int*> values;
+    for (int i = 0; i < 10000; ++i) {
+        keys.push_back("k" + std::to_string(i));
+        values.push_back(new int(i));
+    }
+    keys.push_back("k7");  // repeats one already in this batch
+    values.push_back(new int(-1));
+    std::vector<char> inserted(keys.size());
+    t.insert_many(keys.data(), values.data(), keys.size(), reinterpret_cast<bool*>(inserted.data()));
+    EXPECT_EQ(t.size(), 10000u);
+    EXPECT_EQ(t.bucket_count(), buckets);
+    EXPECT_FALSE(t.is_rehashing());
+    for (int i = 0; i < 10000; ++i) ASSERT_TRUE(inserted[i]);
+    EXPECT_FALSE(inserted.back());
+    EXPECT_EQ(*t.get(std::string("k7")), 7);
+    delete values.back();
+
+    int* other = new int(-2);
+    EXPECT_FALSE(t.insert("k9", other));
+    EXPECT_EQ(*t.get(std::string("k9")), 9);
+    EXPECT_TRUE(t.insert("new", other));
+    EXPECT_EQ(t.get(std::string("new")), other);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "server/output_queue.h"
+
+static ValueBuffer* buffer_of(const std::string& s) {
+    ValueBuffer* buf = ValueBuffer::create(s.size());
+    std::memcpy(buf->data(), s.data(), s.size());
+    return buf;
+}
+
+// Reads everything the peer has sent so far.
+static std::string drain(int fd) {
+    std::string out;
+    char buf[65536];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) out.append(buf, static_cast<size_t>(n));
+    return out;
+}
+
+TEST(OutputQueue, SplicesSharedValuesBetweenRingBytesInOrder) {
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    ::fcntl(sv[1], F_SETFL, O_NONBLOCK);
+
+    std::string big1(5000, 'x'), big2(6000, 'y');
+    ValueBuffer* b1 = buffer_of(big1);
+    ValueBuffer* b2 = buffer_of(big2);
+
+    OutputQueue q(16);
+    q.append("head", 4);
+    q.append_shared(b1, big1.size());
+    q.append_shared(b2, big2.size());  // two values back to back
+    q.append("mid", 3);
+    q.append_shared(b1, 100);          // short: copied
+    q.append("tail", 4);
+    EXPECT_EQ(q.size(), 4 + 5000 + 6000 + 3 + 100 + 4u);
+    EXPECT_TRUE(b1->shared() && b2->shared());
+
+    // The queue keeps its references, so the owner may let go.
+    ValueBuffer::unref(b2);
+    while (!q.empty()) ASSERT_GT(q.write_to(sv[0]), 0);
+    EXPECT_FALSE(b1->shared());
+    ValueBuffer::unref(b1);
+
+    EXPECT_EQ(drain(sv[1]), "head" + big1 + big2 + "mid" + big1.substr(0, 100) + "tail");
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
+
+TEST(OutputQueue, ResumesPartialWritesAndLongSharedRuns) {
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    int small = 4096;
+    ::setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    ::fcntl(sv[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(sv[1], F_SETFL, O_NONBLOCK);
+
+    // More shared values than one writev takes, each behind a ring byte.
+    std::string expected;
+    OutputQueue q(16);
+    for (int i = 0; i < 100; ++i) {
+        std::string value(OutputQueue::k_min_shared + i, static_cast<char>('a' + i % 26));
+        ValueBuffer* buf = buffer_of(value);
+        char tag = static_cast<char>('0' + i % 10);
+        q.append(&tag, 1);
+        q.append_shared(buf, value.size());
+        ValueBuffer::unref(buf);
+        expected += tag;
+        expected += value;
+    }
+    q.append("end", 3);
+    expected += "end";
+
+    std::string got;
+    while (!q.empty()) {
+        ssize_t n = q.write_to(sv[0]);
+        ASSERT_TRUE(n > 0 || errno == EAGAIN);
+        got += drain(sv[1]);
+    }
+    got += drain(sv[1]);
+    EXPECT_EQ(got, expected);
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
+
+TEST(OutputQueue, FramesAreLengthPrefixedAfterTheFact) {
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    ::fcntl(sv[1], F_SETFL, O_NONBLOCK);
+
+    std::string big(10000, 'z');
+    ValueBuffer* buf = buffer_of(big);
+    OutputQueue q(16);
+    q.append("xxxxxxxxxxxx", 12);
+    ASSERT_GT(q.write_to(sv[0]), 0);  // move the ring head so the prefix wraps
+
+    OutputQueue::FrameMark mark = q.begin_frame();
+    q.append("ab", 2);
+    q.append_shared(buf, big.size());
+    q.end_frame(mark);
+    ValueBuffer::unref(buf);
+    while (!q.empty()) ASSERT_GT(q.write_to(sv[0]), 0);
+
+    std::string got = drain(sv[1]);
+    ASSERT_EQ(got.size(), 12 + 4 + 2 + big.size());
+    uint32_t len = 0;
+    std::memcpy(&len, &got[12], 4);
+    EXPECT_EQ(len, 2 + big.size());
+    EXPECT_EQ(got.substr(16), "ab" + big);
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
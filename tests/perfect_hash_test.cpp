@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <string>
+#include <string_view>
+#include "server/perfect_hash.h"
+
+static constexpr std::array<std::string_view, 8> k_keys = {
+    "get", "set", "del", "zadd", "zrank", "zrevrank", "incr", "incrby",
+};
+static constexpr PerfectHash<k_keys.size()> k_index(k_keys);
+
+static_assert(k_index.find("zrevrank") == 5);
+static_assert(k_index.find("zrevran") == -1);
+static_assert(PerfectHash<k_keys.size()>::k_slots == 16);
+static_assert(PerfectHash<1>(std::array<std::string_view, 1>{"only"}).find("only") == 0);
+
+TEST(PerfectHash, FindsEveryKeyAndNothingElse) {
+    for (size_t i = 0; i < k_keys.size(); ++i) {
+        EXPECT_EQ(k_index.find(k_keys[i]), static_cast<int>(i)) << k_keys[i];
+        // Built at runtime, so not the same pointer.
+        EXPECT_EQ(k_index.find(std::string(k_keys[i])), static_cast<int>(i));
+    }
+    for (std::string_view miss : {"", "g", "GET", "gets", "incrbyfloat", "zadd ", "de"}) {
+        EXPECT_EQ(k_index.find(miss), -1) << miss;
+    }
+}
+
+TEST(PerfectHash, SeparatesManyKeys) {
+    std::array<std::string_view, 200> keys{};
+    static std::array<std::string, 200> storage;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        storage[i] = "key:" + std::to_string(i);
+        keys[i] = storage[i];
+    }
+    PerfectHash<200> index(keys);
+    for (size_t i = 0; i < keys.size(); ++i) EXPECT_EQ(index.find(keys[i]), static_cast<int>(i));
+    EXPECT_EQ(index.find("key:200"), -1);
+}
+
+TEST(PerfectHash, RefusesADuplicateKey) {
+    std::array<std::string_view, 3> keys = {"get", "set", "get"};
+    EXPECT_ANY_THROW(PerfectHash<3> index(keys));
+}
@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include "server/replication.h"
+#include "server_harness.h"
+
+// Polls until `done` holds, for up to ten seconds.
+static bool eventually(const std::function<bool()>& done) {
+    for (int i = 0; i < 1000; ++i) {
+        if (done()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// A snapshot path, plus the files a full sync leaves beside it if a test
+// fails halfway through one.
+static TempPath snapshot_path(const std::string& name) {
+    std::string pid = std::to_string(::getpid());
+    return TempPath(name, {".sync." + pid, ".replica." + pid});
+}
+
+static ServerConfig config_for(const TempPath& path) {
+    ServerConfig config;
+    config.snapshot_path = path.str();
+    return config;
+}
+
+// Forwards loopback connections to a server, so a test can cut the link
+// between a replica and its primary, and refuse new ones for a while.
+class LinkProxy {
+public:
+    explicit LinkProxy(uint16_t target) : target_(target) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listen_fd_, (sockaddr*)&addr, sizeof(addr));
+        ::listen(listen_fd_, SOMAXCONN);
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd_, (sockaddr*)&addr, &len);
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~LinkProxy() {
+        stop_ = true;
+        thread_.join();
+        ::close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+
+    void cut(bool refuse) {
+        refuse_ = refuse;
+        cuts_++;
+        while (cuts_done_ != cuts_) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    void allow() { refuse_ = false; }
+
+private:
+    void run() {
+        std::vector<std::pair<int, int>> pairs;
+        auto close_all = [&] {
+            for (auto& p : pairs) {
+                ::close(p.first);
+                ::close(p.second);
+            }
+            pairs.clear();
+        };
+        std::vector<char> buf(64 * 1024);
+        while (!stop_) {
+            if (cuts_done_ != cuts_) {
+                close_all();
+                cuts_done_ = cuts_.load();
+            }
+            std::vector<pollfd> fds{{listen_fd_, POLLIN, 0}};
+            for (auto& p : pairs) {
+                fds.push_back({p.first, POLLIN, 0});
+                fds.push_back({p.second, POLLIN, 0});
+            }
+            if (::poll(fds.data(), fds.size(), 5) <= 0) continue;
+            if (fds[0].revents & POLLIN) {
+                int client = ::accept(listen_fd_, nullptr, nullptr);
+                if (refuse_) {
+                    ::close(client);
+                } else {
+                    int server = ::socket(AF_INET, SOCK_STREAM, 0);
+                    sockaddr_in addr{};
+                    addr.sin_family = AF_INET;
+                    addr.sin_port = htons(target_);
+                    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                    ::connect(server, (sockaddr*)&addr, sizeof(addr));
+                    pairs.emplace_back(client, server);
+                }
+            }
+            std::vector<size_t> broken;
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                auto& p = pairs[(i - 1) / 2];
+                int to = fds[i].fd == p.first ? p.second : p.first;
+                ssize_t n = ::read(fds[i].fd, buf.data(), buf.size());
+                if (n <= 0 || !send_all(to, reinterpret_cast<uint8_t*>(buf.data()), static_cast<size_t>(n))) {
+                    broken.push_back((i - 1) / 2);
+                }
+            }
+            for (size_t k = broken.size(); k-- > 0;) {
+                if (k + 1 < broken.size() && broken[k] == broken[k + 1]) continue;
+                auto& p = pairs[broken[k]];
+                ::close(p.first);
+                ::close(p.second);
+                pairs.erase(pairs.begin() + static_cast<long>(broken[k]));
+            }
+        }
+        close_all();
+    }
+
+    uint16_t target_;
+    int listen_fd_;
+    uint16_t port_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> refuse_{false};
+    std::atomic<int> cuts_{0};
+    std::atomic<int> cuts_done_{0};
+    std::thread thread_;
+};
+
+TEST(ReplBacklog, KeepsTheLastBytesAcrossTheWrap) {
+    ReplBacklog backlog(8);
+    EXPECT_TRUE(backlog.covers(0));
+    backlog.append("abcdef");
+    EXPECT_EQ(backlog.start_offset(), 0u);
+    backlog.append("ghij");
+    EXPECT_EQ(backlog.end_offset(), 10u);
+    EXPECT_EQ(backlog.start_offset(), 2u);
+    EXPECT_FALSE(backlog.covers(1));
+    EXPECT_TRUE(backlog.covers(10));
+    EXPECT_FALSE(backlog.covers(11));
+    std::string out;
+    backlog.copy_from(3, out);
+    EXPECT_EQ(out, "defghij");
+    backlog.append("0123456789");  // longer than the ring
+    out.clear();
+    backlog.copy_from(backlog.start_offset(), out);
+    EXPECT_EQ(out, "23456789");
+    EXPECT_EQ(backlog.end_offset(), 20u);
+}
+
+TEST(Replication, FullSyncThenStreamToAReadOnlyReplica) {
+    TempPath primary_path = snapshot_path("primary.cdb");
+    ServerHarness primary(config_for(primary_path));
+    int p = primary.connect();
+    ASSERT_GE(p, 0);
+    for (int i = 0; i < 500; ++i) request(p, {"set", "k" + std::to_string(i), "v" + std::to_string(i)});
+    request(p, {"incrby", "n", "41"});
+    request(p, {"zadd", "z", "1.5", "a"});
+    request(p, {"zadd", "z", "2.5", "b"});
+    request(p, {"set", "ttl", "x"});
+    request(p, {"pexpire", "ttl", "100000"});
+
+    TempPath replica_path = snapshot_path("replica.cdb");
+    ServerHarness replica(config_for(replica_path));
+    int r = replica.connect();
+    ASSERT_GE(r, 0);
+    EXPECT_EQ(request(r, {"replicaof", "127.0.0.1", std::to_string(primary.port())}), str_reply("OK"));
+    ASSERT_TRUE(eventually([&] { return info_field(request(r, {"info"}), "primary_link_status") == "up"; }));
+
+    // The snapshot.
+    EXPECT_EQ(request(r, {"get", "k499"}), str_reply("v499"));
+    EXPECT_EQ(request(r, {"get", "n"}), str_reply("41"));
+    EXPECT_EQ(request(r, {"zrank", "z", "b"}), request(p, {"zrank", "z", "b"}));
+    EXPECT_NE(request(r, {"pttl", "ttl"}), request(r, {"pttl", "k0"}));  // a TTL, not -1
+
+    // The stream, including deletes the primary makes on its own.
+    request(p, {"set", "late", "1"});
+    request(p, {"del", "k0"});
+    request(p, {"incr", "n"});
+    request(p, {"set", "short", "x"});
+    request(p, {"pexpire", "short", "20"});
+    // The INCR follows the DEL in the stream, so once it shows the DEL has
+    // been applied too.
+    ASSERT_TRUE(eventually([&] { return request(r, {"get", "n"}) == str_reply("42"); }));
+    EXPECT_EQ(request(r, {"get", "late"}), str_reply("1"));
+    EXPECT_EQ(request(r, {"get", "k0"})[0], SER_NIL);
+    // Gone from the replica's TTL index only once the primary's DEL arrived.
+    ASSERT_TRUE(eventually([&] {
+        return info_field(request(p, {"info"}), "expires") == "1" && info_field(request(r, {"info"}), "expires") == "1";
+    }));
+    EXPECT_EQ(request(r, {"get", "short"})[0], SER_NIL);
+    EXPECT_EQ(info_field(request(r, {"info"}), "keys"), info_field(request(p, {"info"}), "keys"));
+
+    // Replicas serve reads only.
+    std::string refused = request(r, {"set", "late", "2"});
+    ASSERT_EQ(refused[0], SER_ERR);
+    EXPECT_NE(refused.find("READONLY"), std::string::npos);
+    EXPECT_EQ(request(r, {"get", "late"}), str_reply("1"));
+
+    std::string info = request(r, {"info"});
+    EXPECT_EQ(info_field(info, "role"), "replica");
+    EXPECT_EQ(info_field(info, "primary_full_syncs"), "1");
+    // Caught up, and acknowledged so.
+    ASSERT_TRUE(eventually([&] {
+        std::string pinfo = request(p, {"info"});
+        std::string rinfo = request(r, {"info"});
+        return info_field(pinfo, "repl_offset") == info_field(rinfo, "primary_repl_offset") &&
+               info_field(pinfo, "replica0").find(",lag=0,") != std::string::npos;
+    }));
+    info = request(p, {"info"});
+    EXPECT_EQ(info_field(info, "role"), "primary");
+    EXPECT_EQ(info_field(info, "connected_replicas"), "1");
+    EXPECT_EQ(info_field(info, "replica0").substr(0, 12), "state=online");
+
+    // Promoted, it takes writes again.
+    EXPECT_EQ(request(r, {"replicaof", "no", "one"}), str_reply("OK"));
+    EXPECT_EQ(request(r, {"set", "late", "2"}), str_reply("OK"));
+    EXPECT_EQ(info_field(request(r, {"info"}), "role"), "primary");
+    ::close(r);
+    ::close(p);
+}
+
+TEST(Replication, ReconnectResumesFromTheBacklogOrResyncs) {
+    TempPath ppath = snapshot_path("primary-backlog.cdb");
+    ServerConfig pconfig = config_for(ppath);
+    pconfig.repl_backlog_size = 4096;
+    ServerHarness primary(pconfig);
+    LinkProxy proxy(primary.port());
+    int p = primary.connect();
+    ASSERT_GE(p, 0);
+    request(p, {"set", "a", "1"});
+
+    TempPath rpath = snapshot_path("replica-backlog.cdb");
+    ServerConfig rconfig = config_for(rpath);
+    rconfig.replicaof_host = "127.0.0.1";
+    rconfig.replicaof_port = proxy.port();
+    ServerHarness replica(rconfig);
+    int r = replica.connect();
+    ASSERT_GE(r, 0);
+    ASSERT_TRUE(eventually([&] { return request(r, {"get", "a"}) == str_reply("1"); }));
+
+    // Writes made while the link is down fit in the backlog.
+    proxy.cut(true);
+    for (int i = 0; i < 10; ++i) request(p, {"set", "b" + std::to_string(i), "x"});
+    proxy.allow();
+    ASSERT_TRUE(eventually([&] { return request(r, {"get", "b9"}) == str_reply("x"); }));
+    std::string info = request(r, {"info"});
+    EXPECT_EQ(info_field(info, "primary_full_syncs"), "1");
+    EXPECT_EQ(info_field(info, "primary_partial_syncs"), "1");
+
+    // These overrun it.
+    proxy.cut(true);
+    std::string value(100, 'v');
+    for (int i = 0; i < 100; ++i) request(p, {"set", "c" + std::to_string(i), value});
+    proxy.allow();
+    ASSERT_TRUE(eventually([&] { return request(r, {"get", "c99"}) == str_reply(value); }));
+    info = request(r, {"info"});
+    EXPECT_EQ(info_field(info, "primary_full_syncs"), "2");
+    EXPECT_EQ(info_field(info, "primary_partial_syncs"), "1");
+    EXPECT_EQ(request(r, {"get", "b0"}), str_reply("x"));
+    EXPECT_EQ(info_field(request(p, {"info"}), "repl_full_syncs_served"), "2");
+    ::close(r);
+    ::close(p);
+}
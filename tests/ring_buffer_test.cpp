@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "server/ring_buffer.h"
+
+static std::string contents(const RingBuffer& rb) {
+    std::string s(rb.size(), '\0');
+    rb.peek(0, &s[0], rb.size());
+    return s;
+}
+
+TEST(RingBuffer, AppendPeekConsumeAcrossWrap) {
+    RingBuffer rb(16);
+    EXPECT_EQ(rb.capacity(), 16u);
+
+    rb.append("0123456789", 10);
+    rb.consume(8);
+    rb.append("abcdefghij", 10);  // wraps: 6 bytes at the end, 4 at the front
+    EXPECT_EQ(rb.size(), 12u);
+    EXPECT_EQ(contents(rb), "89abcdefghij");
+
+    EXPECT_NE(rb.contiguous(0, 8), nullptr);
+    EXPECT_EQ(rb.contiguous(0, 9), nullptr);
+    EXPECT_EQ(std::memcmp(rb.contiguous(8, 4), "ghij", 4), 0);
+
+    char buf[4];
+    rb.peek(6, buf, 4);
+    EXPECT_EQ(std::string(buf, 4), "efgh");
+}
+
+TEST(RingBuffer, GrowsOnlyWhenDataDoesNotFit) {
+    RingBuffer rb(16);
+    rb.append("0123456789", 10);
+    rb.consume(6);
+    rb.append("abcdefghijkl", 12);
+    EXPECT_EQ(rb.capacity(), 16u);
+
+    rb.append("XYZ", 3);  // 19 bytes no longer fit
+    EXPECT_EQ(rb.capacity(), 32u);
+    EXPECT_EQ(contents(rb), "6789abcdefghijklXYZ");
+    EXPECT_NE(rb.contiguous(0, rb.size()), nullptr);
+}
+
+TEST(RingBuffer, ReadvAndWritevUseBothRegions) {
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+    RingBuffer in(16);
+    in.append("xxxxxxxxxxAB", 12);
+    in.consume(10);  // "AB" left at 10..11, so the free space wraps
+
+    ASSERT_EQ(::write(sv[1], "0123456789abcd", 14), 14);
+    EXPECT_EQ(in.read_from(sv[0]), 14);
+    EXPECT_EQ(in.free_space(), 0u);
+    EXPECT_EQ(contents(in), "AB0123456789abcd");
+    EXPECT_EQ(in.contiguous(0, 16), nullptr);
+
+    EXPECT_EQ(in.write_to(sv[1]), 16);
+    EXPECT_TRUE(in.empty());
+    char buf[16];
+    ASSERT_EQ(::read(sv[0], buf, 16), 16);
+    EXPECT_EQ(std::string(buf, 16), "AB0123456789abcd");
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "server/score_btree.h"
+
+using Key = std::pair<double, std::string>;
+
+static void expect_matches(const ScoreBTree& tree, const std::set<Key>& model) {
+    ASSERT_EQ(tree.size(), model.size());
+    std::vector<std::pair<std::string, double>> all;
+    tree.range(0, model.size(), all);
+    ASSERT_EQ(all.size(), model.size());
+    size_t i = 0;
+    for (const Key& k : model) {
+        ASSERT_EQ(all[i].first, k.second);
+        ASSERT_DOUBLE_EQ(all[i].second, k.first);
+        ++i;
+    }
+}
+
+// Enough entries for three levels, then removal back to empty, so leaf and
+// inner splits, merges and borrows all run; ranks are checked along the way.
+TEST(ScoreBTree, MatchesOrderedModelThroughGrowthAndShrink) {
+    ScoreBTree tree;
+    std::set<Key> model;
+    srand(11);
+
+    for (int i = 0; i < 60000; ++i) {
+        // Few distinct scores, so member tie-breaking is exercised too.
+        Key k{(double)(rand() % 500), "m" + std::to_string(rand())};
+        if (model.insert(k).second) tree.insert(k.first, k.second);
+    }
+    expect_matches(tree, model);
+
+    std::vector<Key> keys(model.begin(), model.end());
+    for (size_t i = 0; i < keys.size(); i += 1013) {
+        EXPECT_EQ(tree.count_less(keys[i].first, keys[i].second), i);
+    }
+    EXPECT_FALSE(tree.remove(-1.0, "absent"));
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(5));
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_TRUE(tree.remove(keys[i].first, keys[i].second));
+        model.erase(keys[i]);
+        if (i % 15000 == 0) expect_matches(tree, model);
+    }
+    EXPECT_EQ(tree.size(), 0u);
+    EXPECT_EQ(tree.count_less(1e9, ""), 0u);
+}
+
+TEST(ScoreBTree, RangeFromMiddleCrossesLeaves) {
+    ScoreBTree tree;
+    for (int i = 0; i < 1000; ++i) tree.insert(i, "m" + std::to_string(i));
+
+    std::vector<std::pair<std::string, double>> out;
+    tree.range(495, 100, out);
+    ASSERT_EQ(out.size(), 100u);
+    for (int i = 0; i < 100; ++i) EXPECT_DOUBLE_EQ(out[i].second, 495 + i);
+
+    out.clear();
+    tree.range(990, 100, out);
+    EXPECT_EQ(out.size(), 10u);
+
+    out.clear();
+    tree.range(1000, 10, out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(ScoreBTree, EmptyTree) {
+    ScoreBTree tree;
+    std::vector<std::pair<std::string, double>> out;
+    tree.range(0, 10, out);
+    EXPECT_TRUE(out.empty());
+    EXPECT_EQ(tree.count_less(0, "a"), 0u);
+    EXPECT_FALSE(tree.remove(0, "a"));
+}
+
+// A tree built bottom up must behave like one grown by inserts: ranks, then
+// inserts that split its full nodes and removals that merge them.
+TEST(ScoreBTree, LoadSortedThenChurn) {
+    for (size_t n : {1, 32, 33, 1024, 1025, 40000}) {
+        std::set<Key> model;
+        for (size_t i = 0; i < n; ++i) model.insert({(double)(i / 3), "m" + std::to_string(i)});
+        std::vector<std::pair<std::string_view, double>> items;
+        for (const Key& k : model) items.emplace_back(k.second, k.first);
+        ScoreBTree tree;
+        tree.load_sorted(items.data(), items.size());
+        expect_matches(tree, model);
+
+        std::vector<Key> keys(model.begin(), model.end());
+        for (size_t i = 0; i < keys.size(); i += 7) {
+            ASSERT_EQ(tree.count_less(keys[i].first, keys[i].second), i);
+        }
+        for (size_t i = 0; i < n; i += 2) {
+            Key k{(double)(i / 3), "x" + std::to_string(i)};
+            model.insert(k);
+            tree.insert(k.first, k.second);
+        }
+        expect_matches(tree, model);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(3));
+        for (const Key& k : keys) {
+            ASSERT_TRUE(tree.remove(k.first, k.second));
+            model.erase(k);
+        }
+        expect_matches(tree, model);
+    }
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "server/server.h"
+#include "server/shard.h"
+#include "server/snapshot.h"
+#include "client/protocol.h"
+
+// Runs a Server on an ephemeral loopback port in a background thread so tests
+// can talk to it over real sockets.
+class ServerHarness {
+public:
+    explicit ServerHarness(const ServerConfig& config = ServerConfig())
+        : server_(config) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int val = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = 0;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listen_fd_, (sockaddr*)&addr, sizeof(addr));
+        ::listen(listen_fd_, SOMAXCONN);
+
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd_, (sockaddr*)&addr, &len);
+        port_ = ntohs(addr.sin_port);
+
+        thread_ = std::thread([this] { server_.run(listen_fd_); });
+    }
+
+    ~ServerHarness() {
+        server_.stop();
+        thread_.join();
+        ::close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+
+    // Blocking client socket connected to the server.
+    int connect() const {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+private:
+    Server server_;
+    int listen_fd_;
+    uint16_t port_;
+    std::thread thread_;
+};
+
+// Runs an N-shard ShardGroup on one loopback port (SO_REUSEPORT listeners).
+class ShardedHarness {
+public:
+    ShardedHarness(unsigned int shards, const ServerConfig& config = ServerConfig())
+        : group_(config, shards) {
+        port_ = 0;
+        for (unsigned int i = 0; i < shards; ++i) {
+            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            int val = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(val));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port_);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            ::bind(fd, (sockaddr*)&addr, sizeof(addr));
+            ::listen(fd, SOMAXCONN);
+            socklen_t len = sizeof(addr);
+            ::getsockname(fd, (sockaddr*)&addr, &len);
+            port_ = ntohs(addr.sin_port);
+            listen_fds_.push_back(fd);
+        }
+        thread_ = std::thread([this] { group_.run(listen_fds_); });
+    }
+
+    ~ShardedHarness() {
+        group_.stop();
+        thread_.join();
+        for (int fd : listen_fds_) ::close(fd);
+    }
+
+    ShardGroup& group() { return group_; }
+
+    int connect() const {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+private:
+    ShardGroup group_;
+    std::vector<int> listen_fds_;
+    uint16_t port_;
+    std::thread thread_;
+};
+
+inline bool send_all(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool recv_all(int fd, uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::read(fd, data, len);
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool send_request(int fd, const std::vector<std::string>& cmd) {
+    std::vector<uint8_t> req;
+    serialize_request(cmd, req);
+    return send_all(fd, req.data(), req.size());
+}
+
+// Reads one framed response and returns its body (empty on EOF).
+inline std::string recv_response(int fd) {
+    uint8_t header[4];
+    if (!recv_all(fd, header, 4)) return std::string();
+    uint32_t len = 0;
+    std::memcpy(&len, header, 4);
+    std::string body(len, '\0');
+    if (!recv_all(fd, reinterpret_cast<uint8_t*>(&body[0]), len)) return std::string();
+    return body;
+}
+
+inline std::string request(int fd, const std::vector<std::string>& cmd) {
+    if (!send_request(fd, cmd)) return "";
+    return recv_response(fd);
+}
+
+// Runs a command on a Server directly, without a connection.
+inline std::string run(Server& s, const std::vector<std::string_view>& cmd) {
+    std::string out;
+    s.handle_command(cmd, out);
+    return out;
+}
+
+inline std::string str_reply(std::string_view s) {
+    std::string out;
+    out_string(out, s);
+    return out;
+}
+
+inline std::string int_reply(int64_t v) {
+    std::string out;
+    out_int(out, v);
+    return out;
+}
+
+// The value of an INFO field; every line is its own string in the reply, so
+// a field name starts right after binary length bytes.
+inline std::string info_field(const std::string& info, const std::string& name) {
+    size_t pos = info.find(name + ":");
+    while (pos != std::string::npos && pos > 0 && info[pos - 1] >= ' ') pos = info.find(name + ":", pos + 1);
+    if (pos == std::string::npos) return "";
+    pos += name.size() + 1;
+    size_t end = pos;
+    while (end < info.size() && info[end] >= ' ') end++;
+    return info.substr(pos, end - pos);
+}
+
+// A fresh snapshot or log path under the test temp dir. Removes the file,
+// its per-shard files and the path plus each of `suffixes` (say, a log's
+// ".rewrite"), before the test and after it.
+class TempPath {
+public:
+    explicit TempPath(const std::string& name, std::vector<std::string> suffixes = {})
+        : path_(::testing::TempDir() + name + "." + std::to_string(::getpid())), suffixes_(std::move(suffixes)) {
+        clean();
+    }
+    ~TempPath() { clean(); }
+    TempPath(const TempPath&) = delete;
+    TempPath& operator=(const TempPath&) = delete;
+
+    const std::string& str() const { return path_; }
+
+private:
+    void clean() const {
+        std::remove(path_.c_str());
+        for (const std::string& suffix : suffixes_) std::remove((path_ + suffix).c_str());
+        for (int i = 0; i < 8; ++i) std::remove(snapshot_shard_path(path_, i).c_str());
+    }
+    std::string path_;
+    std::vector<std::string> suffixes_;
+};
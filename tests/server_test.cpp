@@ -2,8 +2,12 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <set>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <thread>
+#include <sys/mman.h>
 #include "server/server.h"
 #include "server/protocol.h"
 
@@ -284,6 +288,171 @@ TEST(ServerCommands, ZQueryPagingAndOrdering) {
     EXPECT_DOUBLE_EQ(q2.arr[3].d, 3.0);
 }
 
+TEST(ServerCommands, ZRankZRevRankZCard) {
+    Server s; std::string out;
+    s.handle_command({"zcard", "myz"}, out);
+    auto c0 = decode(out);
+    ASSERT_EQ(c0.kind, T_INT);
+    EXPECT_EQ(c0.i, 0);
+    out.clear();
+
+    s.handle_command({"zadd", "myz", "3.0", "c"}, out); out.clear();
+    s.handle_command({"zadd", "myz", "1.0", "a"}, out); out.clear();
+    s.handle_command({"zadd", "myz", "2.0", "b"}, out); out.clear();
+
+    s.handle_command({"zcard", "myz"}, out);
+    EXPECT_EQ(decode(out).i, 3);
+    out.clear();
+
+    s.handle_command({"zrank", "myz", "b"}, out);
+    auto r = decode(out);
+    ASSERT_EQ(r.kind, T_INT);
+    EXPECT_EQ(r.i, 1);
+    out.clear();
+
+    s.handle_command({"zrevrank", "myz", "a"}, out);
+    auto rr = decode(out);
+    ASSERT_EQ(rr.kind, T_INT);
+    EXPECT_EQ(rr.i, 2);
+    out.clear();
+
+    // Moving a member re-ranks it
+    s.handle_command({"zadd", "myz", "0.5", "c"}, out); out.clear();
+    s.handle_command({"zrank", "myz", "c"}, out);
+    EXPECT_EQ(decode(out).i, 0);
+    out.clear();
+
+    s.handle_command({"zrank", "myz", "nope"}, out);
+    EXPECT_EQ(decode(out).kind, T_NIL);
+    out.clear();
+
+    s.handle_command({"set", "str", "v"}, out); out.clear();
+    s.handle_command({"zcard", "str"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+}
+
+TEST(ServerCommands, ZRangeByRank) {
+    Server s; std::string out;
+    s.handle_command({"zadd", "myz", "1.0", "a"}, out); out.clear();
+    s.handle_command({"zadd", "myz", "2.0", "b"}, out); out.clear();
+    s.handle_command({"zadd", "myz", "3.0", "c"}, out); out.clear();
+    s.handle_command({"zadd", "myz", "4.0", "d"}, out); out.clear();
+
+    s.handle_command({"zrange", "myz", "1", "2"}, out);
+    auto q = decode(out);
+    ASSERT_EQ(q.kind, T_ARR);
+    ASSERT_EQ(q.arr.size(), 2u * 2u);
+    EXPECT_EQ(q.arr[0].s, "b");
+    EXPECT_DOUBLE_EQ(q.arr[1].d, 2.0);
+    EXPECT_EQ(q.arr[2].s, "c");
+    out.clear();
+
+    // Negative indexes count from the end; stop is clamped.
+    s.handle_command({"zrange", "myz", "-2", "100"}, out);
+    auto q2 = decode(out);
+    ASSERT_EQ(q2.arr.size(), 2u * 2u);
+    EXPECT_EQ(q2.arr[0].s, "c");
+    EXPECT_EQ(q2.arr[2].s, "d");
+    out.clear();
+
+    s.handle_command({"zrange", "myz", "3", "1"}, out);
+    auto empty = decode(out);
+    ASSERT_EQ(empty.kind, T_ARR);
+    EXPECT_TRUE(empty.arr.empty());
+}
+
+TEST(ServerCommands, PExpirePTtl) {
+    Server s; std::string out;
+    s.handle_command({"pexpire", "nokey", "1000"}, out);
+    EXPECT_EQ(decode(out).i, 0);
+    out.clear();
+    s.handle_command({"pttl", "nokey"}, out);
+    EXPECT_EQ(decode(out).i, -2);
+    out.clear();
+
+    s.handle_command({"set", "k", "v"}, out); out.clear();
+    s.handle_command({"pttl", "k"}, out);
+    EXPECT_EQ(decode(out).i, -1);
+    out.clear();
+
+    s.handle_command({"pexpire", "k", "60000"}, out);
+    auto set = decode(out);
+    ASSERT_EQ(set.kind, T_INT);
+    EXPECT_EQ(set.i, 1);
+    out.clear();
+    s.handle_command({"pttl", "k"}, out);
+    auto ttl = decode(out);
+    ASSERT_EQ(ttl.kind, T_INT);
+    EXPECT_GT(ttl.i, 59000);
+    EXPECT_LE(ttl.i, 60000);
+    out.clear();
+
+    // Overwriting the value clears the TTL.
+    s.handle_command({"set", "k", "v2"}, out); out.clear();
+    s.handle_command({"pttl", "k"}, out);
+    EXPECT_EQ(decode(out).i, -1);
+    out.clear();
+
+    // A TTL whose deadline overflows is refused, and the key stays.
+    s.handle_command({"pexpire", "k", "9223372036854775807"}, out);
+    auto e = decode(out);
+    ASSERT_EQ(e.kind, T_ERR);
+    EXPECT_EQ(e.s, "invalid expire time");
+    out.clear();
+    s.handle_command({"get", "k"}, out);
+    EXPECT_EQ(decode(out).kind, T_STR);
+    out.clear();
+
+    // A non-positive TTL deletes immediately.
+    s.handle_command({"pexpire", "k", "0"}, out); out.clear();
+    s.handle_command({"get", "k"}, out);
+    EXPECT_EQ(decode(out).kind, T_NIL);
+}
+
+TEST(ServerCommands, ExpiredKeysAreHiddenBeforeCollection) {
+    Server s; std::string out;
+    s.handle_command({"set", "short", "v"}, out); out.clear();
+    s.handle_command({"set", "long", "v"}, out); out.clear();
+    s.handle_command({"zadd", "z", "1", "m"}, out); out.clear();
+    s.handle_command({"pexpire", "short", "1"}, out); out.clear();
+    s.handle_command({"pexpire", "z", "1"}, out); out.clear();
+    s.handle_command({"pexpire", "long", "60000"}, out); out.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    s.handle_command({"keys"}, out);
+    auto k = decode(out);
+    ASSERT_EQ(k.arr.size(), 1u);
+    EXPECT_EQ(k.arr[0].s, "long");
+    out.clear();
+
+    s.handle_command({"get", "short"}, out);
+    EXPECT_EQ(decode(out).kind, T_NIL);
+    out.clear();
+    s.handle_command({"zscore", "z", "m"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+
+    // The key can be recreated with no TTL.
+    s.handle_command({"set", "short", "again"}, out); out.clear();
+    s.handle_command({"pttl", "short"}, out);
+    EXPECT_EQ(decode(out).i, -1);
+}
+
+TEST(ServerCommands, ActiveExpireIsBounded) {
+    Server s; std::string out;
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = "k" + std::to_string(i);
+        s.handle_command({"set", key, "v"}, out); out.clear();
+        s.handle_command({"pexpire", key, "1"}, out); out.clear();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    // A zero budget still makes progress, one clock sample's worth of keys.
+    EXPECT_EQ(s.active_expire(0), 32u);
+    EXPECT_EQ(s.active_expire(1000000), 1000u - 32u);
+    EXPECT_EQ(s.active_expire(1000000), 0u);
+}
+
 TEST(ServerCommands, ArityErrors) {
     Server s; std::string out;
 
@@ -303,4 +472,520 @@ TEST(ServerCommands, ArityErrors) {
     auto e3 = decode(out);
     ASSERT_EQ(e3.kind, T_ERR);
     EXPECT_NE(e3.s.find("Invalid number of arguments"), std::string::npos);
+    out.clear();
+
+    s.handle_command({"get", "k", "int", "extra"}, out);
+    auto e4 = decode(out);
+    ASSERT_EQ(e4.kind, T_ERR);
+    EXPECT_EQ(e4.s, "Invalid number of arguments for 'get'");
+    out.clear();
+
+    // PSYNC turns a client connection into a replica; there is none here.
+    s.handle_command({"psync", "?", "-1"}, out);
+    auto e5 = decode(out);
+    ASSERT_EQ(e5.kind, T_ERR);
+    EXPECT_NE(e5.s.find("client connection"), std::string::npos);
+}
+
+TEST(ServerCommands, MalformedNumbersAreErrors) {
+    Server s; std::string out;
+    s.handle_command({"zadd", "z", "1", "a"}, out);
+    s.handle_command({"set", "k", "v"}, out);
+    out.clear();
+
+    const std::vector<std::vector<std::string_view>> bad = {
+        {"zadd", "z", "abc", "b"},
+        {"zadd", "z", "1.5x", "b"},
+        {"zadd", "z", "nan", "b"},
+        {"zadd", "z", "", "b"},
+        {"zquery", "z", "x", "", "0", "10"},
+        {"zquery", "z", "0", "", "zero", "10"},
+        {"zquery", "z", "0", "", "0", "99999999999"},
+        {"zrange", "z", "0", "1e3"},
+        {"zrange", "z", "-", "1"},
+        {"pexpire", "k", "soon"},
+        {"pexpire", "k", "99999999999999999999"},
+    };
+    for (const auto& cmd : bad) {
+        s.handle_command(cmd, out);
+        EXPECT_EQ(decode(out).kind, T_ERR) << cmd[0] << " " << cmd[2];
+        out.clear();
+    }
+    // Nothing was changed.
+    s.handle_command({"zcard", "z"}, out);
+    EXPECT_EQ(decode(out).i, 1);
+    out.clear();
+    s.handle_command({"pttl", "k"}, out);
+    EXPECT_EQ(decode(out).i, -1);
+    out.clear();
+
+    // Infinite scores are scores.
+    s.handle_command({"zadd", "z", "-inf", "low"}, out);
+    EXPECT_EQ(decode(out).i, 1);
+    out.clear();
+    s.handle_command({"zquery", "z", "-inf", "", "0", "1"}, out);
+    auto v = decode(out);
+    ASSERT_EQ(v.kind, T_ARR);
+    ASSERT_EQ(v.arr.size(), 2u);
+    EXPECT_EQ(v.arr[0].s, "low");
+}
+
+TEST(ServerCommands, KeysLongerThanAnEntryHoldsAreRefused) {
+    // Untouched anonymous pages: only the length is ever looked at.
+    size_t len = Entry::k_max_key_len + 1;
+    void* mem = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    ASSERT_NE(mem, MAP_FAILED);
+    std::string_view huge(static_cast<const char*>(mem), len);
+
+    Server s; std::string out;
+    const std::vector<std::vector<std::string_view>> cmds = {
+        {"set", huge, "v"},
+        {"mset", "a", "1", huge, "2"},
+        {"incr", huge},
+        {"incrbyfloat", huge, "1.5"},
+        {"zadd", huge, "1", "m"},
+    };
+    for (const auto& cmd : cmds) {
+        s.handle_command(cmd, out);
+        auto v = decode(out);
+        ASSERT_EQ(v.kind, T_ERR) << cmd[0];
+        EXPECT_EQ(v.s, "key is too long");
+        out.clear();
+    }
+    s.handle_command({"keys"}, out);
+    EXPECT_TRUE(decode(out).arr.empty());  // not even MSET's first key
+    ::munmap(mem, len);
+}
+
+static ServerConfig limited_config(size_t maxmemory, EvictionPolicy policy) {
+    ServerConfig config;
+    config.maxmemory = maxmemory;
+    config.maxmemory_policy = policy;
+    return config;
+}
+
+static int count_present(Server& s, const std::string& prefix, int n) {
+    int present = 0;
+    std::string out;
+    for (int i = 0; i < n; ++i) {
+        s.handle_command({"get", prefix + std::to_string(i)}, out);
+        if (decode(out).kind == T_STR) present++;
+        out.clear();
+    }
+    return present;
+}
+
+TEST(ServerMemory, UsedMemoryTracksWritesAndDeletes) {
+    Server s; std::string out;
+    size_t empty = s.used_memory();
+
+    s.handle_command({"set", "k", std::string(1000, 'x')}, out); out.clear();
+    size_t with_string = s.used_memory();
+    EXPECT_GT(with_string, empty + 1000);
+
+    for (int i = 0; i < 100; ++i) {
+        s.handle_command({"zadd", "z", std::to_string(i), "m" + std::to_string(i)}, out); out.clear();
+    }
+    size_t with_zset = s.used_memory();
+    EXPECT_GT(with_zset, with_string);
+
+    s.handle_command({"del", "z"}, out); out.clear();
+    s.handle_command({"del", "k"}, out); out.clear();
+    EXPECT_EQ(s.used_memory(), empty);
+}
+
+TEST(ServerMemory, NoEvictionRefusesWrites) {
+    Server s(limited_config(64 * 1024, EvictionPolicy::NOEVICTION)); std::string out;
+    bool refused = false;
+    for (int i = 0; i < 1000 && !refused; ++i) {
+        s.handle_command({"set", "k" + std::to_string(i), std::string(100, 'v')}, out);
+        auto r = decode(out);
+        if (r.kind == T_ERR) {
+            EXPECT_NE(r.s.find("OOM"), std::string::npos);
+            refused = true;
+        }
+        out.clear();
+    }
+    EXPECT_TRUE(refused);
+
+    // Reads and deletes still work, and free up room for writes.
+    s.handle_command({"get", "k0"}, out);
+    EXPECT_EQ(decode(out).kind, T_STR);
+    out.clear();
+    for (int i = 0; i < 100; ++i) {
+        s.handle_command({"del", "k" + std::to_string(i)}, out); out.clear();
+    }
+    s.handle_command({"set", "again", "v"}, out);
+    EXPECT_EQ(decode(out).kind, T_STR);
+}
+
+TEST(ServerMemory, AllKeysLruKeepsRecentlyReadKeys) {
+    const size_t limit = 256 * 1024;
+    Server s(limited_config(limit, EvictionPolicy::ALLKEYS_LRU)); std::string out;
+    for (int i = 0; i < 50; ++i) {
+        s.handle_command({"set", "hot" + std::to_string(i), std::string(100, 'h')}, out); out.clear();
+    }
+    for (int i = 0; i < 5000; ++i) {
+        // Idle time has millisecond resolution.
+        if (i % 250 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        if (i % 50 == 0) count_present(s, "hot", 50);
+        s.handle_command({"set", "cold" + std::to_string(i), std::string(100, 'c')}, out);
+        ASSERT_EQ(decode(out).kind, T_STR);
+        out.clear();
+    }
+    // Eviction runs before each write, so the last write may overshoot.
+    EXPECT_LE(s.used_memory(), limit + 1024);
+    EXPECT_GE(count_present(s, "hot", 50), 45);
+    EXPECT_LT(count_present(s, "cold", 5000), 2500);
+}
+
+TEST(ServerMemory, AllKeysLfuKeepsFrequentlyReadKeys) {
+    const size_t limit = 256 * 1024;
+    Server s(limited_config(limit, EvictionPolicy::ALLKEYS_LFU)); std::string out;
+    for (int i = 0; i < 50; ++i) {
+        s.handle_command({"set", "hot" + std::to_string(i), std::string(100, 'h')}, out); out.clear();
+    }
+    for (int round = 0; round < 20; ++round) count_present(s, "hot", 50);
+    for (int i = 0; i < 5000; ++i) {
+        s.handle_command({"set", "cold" + std::to_string(i), std::string(100, 'c')}, out);
+        ASSERT_EQ(decode(out).kind, T_STR);
+        out.clear();
+    }
+    EXPECT_LE(s.used_memory(), limit + 1024);
+    EXPECT_GE(count_present(s, "hot", 50), 45);
+}
+
+TEST(ServerMemory, VolatileTtlEvictsSoonestExpiringFirst) {
+    Server s(limited_config(64 * 1024, EvictionPolicy::VOLATILE_TTL)); std::string out;
+    int i = 0;
+    // Later keys get shorter TTLs, so the most recent writes go first.
+    for (; i < 400; ++i) {
+        std::string key = "k" + std::to_string(i);
+        s.handle_command({"set", key, std::string(100, 'v')}, out);
+        ASSERT_EQ(decode(out).kind, T_STR);
+        out.clear();
+        s.handle_command({"pexpire", key, std::to_string(1000000 - i)}, out); out.clear();
+    }
+    s.handle_command({"get", "k0"}, out);
+    EXPECT_EQ(decode(out).kind, T_STR);
+    out.clear();
+    s.handle_command({"get", "k398"}, out);
+    EXPECT_EQ(decode(out).kind, T_NIL);
+    out.clear();
+
+    // Keys without a TTL are never evicted: once the volatile ones are gone,
+    // writes are refused.
+    Server p(limited_config(16 * 1024, EvictionPolicy::VOLATILE_TTL));
+    bool refused = false;
+    for (int j = 0; j < 1000 && !refused; ++j) {
+        p.handle_command({"set", "p" + std::to_string(j), std::string(100, 'v')}, out);
+        refused = decode(out).kind == T_ERR;
+        out.clear();
+    }
+    EXPECT_TRUE(refused);
+}
+
+static std::string info_field(Server& s, const std::string& name) {
+    std::string out;
+    s.handle_command({"info"}, out);
+    TVal v = decode(out);
+    EXPECT_EQ(v.kind, T_ARR);
+    for (const TVal& line : v.arr) {
+        if (line.s.compare(0, name.size() + 1, name + ":") == 0) return line.s.substr(name.size() + 1);
+    }
+    ADD_FAILURE() << "INFO has no field " << name;
+    return "";
+}
+
+TEST(ServerMemory, InfoReportsCategoriesAndKeyCounts) {
+    Server s; std::string out;
+    EXPECT_EQ(info_field(s, "keys"), "0");
+    EXPECT_EQ(info_field(s, "mem_entries"), "0");
+
+    s.handle_command({"set", "short", "v"}, out); out.clear();
+    s.handle_command({"set", std::string(40, 'k'), std::string(1000, 'v')}, out); out.clear();
+    s.handle_command({"zadd", "z", "1", "m"}, out); out.clear();
+    s.handle_command({"pexpire", "z", "100000"}, out); out.clear();
+
+    EXPECT_EQ(info_field(s, "keys"), "3");
+    EXPECT_EQ(info_field(s, "expires"), "1");
+    EXPECT_EQ(info_field(s, "table_rehashing"), "0");
+    EXPECT_GT(std::stoul(info_field(s, "mem_strings")), 1000u);
+    // Each key is stored once, inside its record.
+    EXPECT_EQ(std::stoul(info_field(s, "mem_keys")), 5u + 40u + 1u);
+    EXPECT_GT(std::stoul(info_field(s, "mem_zsets")), 0u);
+    EXPECT_GT(std::stod(info_field(s, "table_load_factor")), 0.0);
+
+    const MemoryStats& mem = s.memory_stats();
+    size_t sum = std::stoul(info_field(s, "mem_table_buckets")) + mem.table_nodes + mem.entries + mem.keys +
+                 mem.strings + mem.zsets + std::stoul(info_field(s, "mem_ttl_heap"));
+    EXPECT_EQ(std::stoul(info_field(s, "used_memory_dataset")), sum);
+    EXPECT_EQ(s.used_memory(), sum);
+}
+
+TEST(ServerMemory, MemoryUsageOfOneKey) {
+    Server s; std::string out;
+    s.handle_command({"memory", "usage", "nokey"}, out);
+    EXPECT_EQ(decode(out).kind, T_NIL);
+    out.clear();
+
+    s.handle_command({"set", "small", "v"}, out); out.clear();
+    s.handle_command({"set", "big", std::string(10000, 'v')}, out); out.clear();
+    s.handle_command({"memory", "usage", "small"}, out);
+    TVal small = decode(out);
+    out.clear();
+    s.handle_command({"memory", "usage", "big"}, out);
+    TVal big = decode(out);
+    out.clear();
+    ASSERT_EQ(small.kind, T_INT);
+    ASSERT_EQ(big.kind, T_INT);
+    EXPECT_GT(small.i, 0);
+    EXPECT_GE(big.i, small.i + 10000);
+
+    // Deleting the key gives back exactly what MEMORY USAGE reported.
+    size_t before = s.used_memory();
+    s.handle_command({"del", "big"}, out); out.clear();
+    EXPECT_EQ(before - s.used_memory(), static_cast<size_t>(big.i));
+
+    s.handle_command({"memory", "size", "small"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+}
+
+TEST(ServerCommands, OverwritesAcrossValueSizes) {
+    Server s; std::string out;
+    const std::vector<std::string> values = {"a", std::string(20, 'b'), std::string(500, 'c'), "d",
+                                             std::string(64, 'e'), std::string(65, 'f'), ""};
+    for (const std::string& v : values) {
+        s.handle_command({"set", "k", v}, out); out.clear();
+        s.handle_command({"pexpire", "k", "100000"}, out); out.clear();
+        s.handle_command({"set", "k", v}, out); out.clear();
+        s.handle_command({"get", "k"}, out);
+        TVal got = decode(out);
+        out.clear();
+        ASSERT_EQ(got.kind, T_STR);
+        EXPECT_EQ(got.s, v);
+        s.handle_command({"pttl", "k"}, out);
+        EXPECT_EQ(decode(out).i, -1);
+        out.clear();
+    }
+    s.handle_command({"keys"}, out);
+    EXPECT_EQ(decode(out).arr.size(), 1u);
+    out.clear();
+    s.handle_command({"del", "k"}, out); out.clear();
+    EXPECT_EQ(s.memory_stats().keyspace(), 0u);
+}
+
+TEST(ServerCommands, IncrDecrFamily) {
+    Server s; std::string out;
+    s.handle_command({"incr", "c"}, out);
+    EXPECT_EQ(decode(out).i, 1);
+    out.clear();
+    s.handle_command({"incrby", "c", "41"}, out);
+    EXPECT_EQ(decode(out).i, 42);
+    out.clear();
+    s.handle_command({"decr", "c"}, out);
+    EXPECT_EQ(decode(out).i, 41);
+    out.clear();
+    s.handle_command({"incrby", "c", "-50"}, out);
+    EXPECT_EQ(decode(out).i, -9);
+    out.clear();
+
+    s.handle_command({"get", "c"}, out);
+    TVal text = decode(out);
+    ASSERT_EQ(text.kind, T_STR);
+    EXPECT_EQ(text.s, "-9");
+    out.clear();
+    s.handle_command({"get", "c", "int"}, out);
+    TVal num = decode(out);
+    ASSERT_EQ(num.kind, T_INT);
+    EXPECT_EQ(num.i, -9);
+    out.clear();
+
+    // A SET of a canonical integer can be incremented too; other strings can't.
+    s.handle_command({"set", "n", "100"}, out); out.clear();
+    s.handle_command({"incr", "n"}, out);
+    EXPECT_EQ(decode(out).i, 101);
+    out.clear();
+    s.handle_command({"set", "str", "0100"}, out); out.clear();
+    s.handle_command({"incr", "str"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+    s.handle_command({"get", "str", "int"}, out);
+    EXPECT_EQ(decode(out).s, "0100");
+    out.clear();
+
+    s.handle_command({"incrby", "c", "x"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+    s.handle_command({"set", "max", "9223372036854775807"}, out); out.clear();
+    s.handle_command({"incr", "max"}, out);
+    TVal overflow = decode(out);
+    ASSERT_EQ(overflow.kind, T_ERR);
+    EXPECT_NE(overflow.s.find("overflow"), std::string::npos);
+    out.clear();
+    s.handle_command({"get", "max"}, out);
+    EXPECT_EQ(decode(out).s, "9223372036854775807");
+    out.clear();
+
+    s.handle_command({"zadd", "z", "1", "m"}, out); out.clear();
+    s.handle_command({"incr", "z"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+}
+
+TEST(ServerCommands, IncrKeepsTtl) {
+    Server s; std::string out;
+    s.handle_command({"set", "c", "5"}, out); out.clear();
+    s.handle_command({"pexpire", "c", "60000"}, out); out.clear();
+    s.handle_command({"incr", "c"}, out); out.clear();
+    s.handle_command({"incrbyfloat", "c", "0.5"}, out); out.clear();
+    s.handle_command({"pttl", "c"}, out);
+    EXPECT_GT(decode(out).i, 0);
+}
+
+TEST(ServerCommands, IncrByFloat) {
+    Server s; std::string out;
+    s.handle_command({"incrbyfloat", "f", "10.5"}, out);
+    EXPECT_EQ(decode(out).s, "10.5");
+    out.clear();
+    s.handle_command({"incrbyfloat", "f", "-0.5"}, out);
+    EXPECT_EQ(decode(out).s, "10");
+    out.clear();
+    // The integral result is INT-encoded again.
+    s.handle_command({"incr", "f"}, out);
+    EXPECT_EQ(decode(out).i, 11);
+    out.clear();
+    s.handle_command({"incrbyfloat", "f", "1e3"}, out);
+    EXPECT_EQ(decode(out).s, "1011");
+    out.clear();
+    s.handle_command({"incrbyfloat", "f", "nan"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+    s.handle_command({"set", "word", "abc"}, out); out.clear();
+    s.handle_command({"incrbyfloat", "word", "1"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+
+    // A long result moves the value out of the record.
+    s.handle_command({"set", "big", "1"}, out); out.clear();
+    s.handle_command({"incrbyfloat", "big", "1e100"}, out);
+    TVal big = decode(out);
+    ASSERT_EQ(big.kind, T_STR);
+    EXPECT_EQ(big.s.size(), 101u);
+    out.clear();
+    s.handle_command({"get", "big"}, out);
+    EXPECT_EQ(decode(out).s, big.s);
+}
+
+TEST(ServerMemory, IntegersTakeNoValueBytes) {
+    Server s; std::string out;
+    s.handle_command({"set", "a", "1234567890123456789"}, out); out.clear();
+    s.handle_command({"set", "b", "x234567890123456789"}, out); out.clear();
+    s.handle_command({"memory", "usage", "a"}, out);
+    int64_t as_int = decode(out).i;
+    out.clear();
+    s.handle_command({"memory", "usage", "b"}, out);
+    int64_t as_string = decode(out).i;
+    EXPECT_LT(as_int, as_string);
+    EXPECT_EQ(s.memory_stats().strings, 19u);
+}
+
+TEST(ServerCommands, MGetMSet) {
+    Server s; std::string out;
+    s.handle_command({"mset", "a", "1", "b", "two", "a", "3"}, out);
+    EXPECT_EQ(decode(out).kind, T_STR);
+    out.clear();
+
+    s.handle_command({"zadd", "z", "1", "m"}, out); out.clear();
+    s.handle_command({"set", "gone", "x"}, out); out.clear();
+    s.handle_command({"pexpire", "gone", "1"}, out); out.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+
+    s.handle_command({"mget", "a", "b", "missing", "z", "gone", "a"}, out);
+    TVal v = decode(out);
+    out.clear();
+    ASSERT_EQ(v.kind, T_ARR);
+    ASSERT_EQ(v.arr.size(), 6u);
+    EXPECT_EQ(v.arr[0].s, "3");
+    EXPECT_EQ(v.arr[1].s, "two");
+    EXPECT_EQ(v.arr[2].kind, T_NIL);
+    EXPECT_EQ(v.arr[3].kind, T_NIL);
+    EXPECT_EQ(v.arr[4].kind, T_NIL);
+    EXPECT_EQ(v.arr[5].s, "3");
+
+    // A wrong-typed key fails the whole MSET; an expired one is replaced.
+    s.handle_command({"mset", "a", "new", "z", "v"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+    s.handle_command({"get", "a"}, out);
+    EXPECT_EQ(decode(out).s, "3");
+    out.clear();
+    s.handle_command({"mset", "gone", "back"}, out); out.clear();
+    s.handle_command({"get", "gone"}, out);
+    EXPECT_EQ(decode(out).s, "back");
+    out.clear();
+
+    s.handle_command({"mget"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+    s.handle_command({"mset", "a"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+    out.clear();
+    s.handle_command({"mset", "a", "1", "b"}, out);
+    EXPECT_EQ(decode(out).kind, T_ERR);
+}
+
+TEST(ServerCommands, ScanWalksKeyspaceInBoundedSteps) {
+    Server s; std::string out;
+    for (int i = 0; i < 500; ++i) {
+        s.handle_command({"set", "user:" + std::to_string(i), "v"}, out); out.clear();
+    }
+    for (int i = 0; i < 50; ++i) {
+        s.handle_command({"zadd", "rank:" + std::to_string(i), "1", "m"}, out); out.clear();
+    }
+    s.handle_command({"set", "gone", "x"}, out); out.clear();
+    s.handle_command({"pexpire", "gone", "1"}, out); out.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+
+    auto walk = [&](std::vector<std::string_view> opts, size_t& calls) {
+        std::set<std::string> seen;
+        std::string cursor = "0";
+        calls = 0;
+        do {
+            std::vector<std::string_view> cmd{"scan", cursor};
+            cmd.insert(cmd.end(), opts.begin(), opts.end());
+            out.clear();
+            s.handle_command(cmd, out);
+            TVal v = decode(out);
+            EXPECT_EQ(v.kind, T_ARR);
+            if (v.kind != T_ARR || v.arr.size() != 2) break;
+            EXPECT_LE(v.arr[1].arr.size(), 100u);
+            for (const TVal& k : v.arr[1].arr) seen.insert(k.s);
+            cursor = v.arr[0].s;
+            ++calls;
+        } while (cursor != "0");
+        return seen;
+    };
+
+    size_t calls = 0;
+    std::set<std::string> all = walk({}, calls);
+    EXPECT_EQ(all.size(), 550u);
+    EXPECT_FALSE(all.count("gone"));
+    EXPECT_GT(calls, 20u);
+
+    std::set<std::string> ranks = walk({"match", "rank:[0-2]?", "count", "100"}, calls);
+    EXPECT_EQ(ranks.size(), 20u);
+    EXPECT_TRUE(ranks.count("rank:29") && !ranks.count("rank:3") && !ranks.count("user:10"));
+    EXPECT_LT(calls, 20u);
+
+    std::set<std::string> ones = walk({"match", "*1", "count", "1000"}, calls);
+    EXPECT_EQ(ones.size(), 55u);
+    EXPECT_TRUE(ones.count("user:1") && ones.count("rank:41"));
+
+    for (std::vector<std::string_view> bad : std::vector<std::vector<std::string_view>>{
+             {"scan"}, {"scan", "x"}, {"scan", "-1"}, {"scan", "0", "count"}, {"scan", "0", "count", "0"},
+             {"scan", "0", "type", "string"}, {"scan", "281474976710656"}}) {
+        out.clear();
+        s.handle_command(bad, out);
+        EXPECT_EQ(decode(out).kind, T_ERR) << bad.size();
+    }
 }
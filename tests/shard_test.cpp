@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "server/spsc_queue.h"
+#include "server_harness.h"
+
+static std::string str_body(const std::string& s) {
+    std::string body(1, (char)SER_STR);
+    uint32_t len = static_cast<uint32_t>(s.size());
+    body.append((const char*)&len, 4);
+    body.append(s);
+    return body;
+}
+
+TEST(SpscQueue, DeliversEverythingInOrderAcrossThreads) {
+    SpscQueue<int> q(64);
+    const int n = 200000;
+    std::thread producer([&] {
+        for (int i = 0; i < n; ++i) {
+            int v = i;
+            while (!q.push(std::move(v))) std::this_thread::yield();
+        }
+    });
+    int expected = 0;
+    while (expected < n) {
+        int v;
+        if (q.pop(v)) {
+            ASSERT_EQ(v, expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    int v;
+    EXPECT_FALSE(q.pop(v));
+}
+
+TEST(ShardGroup, SpreadsKeysAcrossAllShards) {
+    ShardGroup group(ServerConfig(), 4);
+    std::vector<int> counts(4, 0);
+    for (int i = 0; i < 4000; ++i) counts[group.shard_of("key:" + std::to_string(i))]++;
+    for (int c : counts) {
+        EXPECT_GT(c, 800);
+        EXPECT_LT(c, 1200);
+    }
+}
+
+TEST(ShardGroup, KeysWrittenOnOneConnectionAreVisibleFromAll) {
+    ShardedHarness harness(4);
+    std::vector<int> fds;
+    for (int i = 0; i < 8; ++i) {
+        int fd = harness.connect();
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+
+    // Pipelined writes from one connection: most keys live on other shards,
+    // and replies must still come back in request order.
+    std::vector<uint8_t> batch;
+    for (int i = 0; i < 200; ++i) {
+        std::vector<uint8_t> req;
+        serialize_request({"set", "key:" + std::to_string(i), "val:" + std::to_string(i)}, req);
+        batch.insert(batch.end(), req.begin(), req.end());
+        serialize_request({"get", "key:" + std::to_string(i)}, req);
+        batch.insert(batch.end(), req.begin(), req.end());
+    }
+    ASSERT_TRUE(send_all(fds[0], batch.data(), batch.size()));
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_EQ(recv_response(fds[0]), str_body("OK"));
+        ASSERT_EQ(recv_response(fds[0]), str_body("val:" + std::to_string(i)));
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        int fd = fds[i % fds.size()];
+        ASSERT_TRUE(send_request(fd, {"get", "key:" + std::to_string(i)}));
+        EXPECT_EQ(recv_response(fd), str_body("val:" + std::to_string(i)));
+    }
+    for (int fd : fds) ::close(fd);
+}
+
+TEST(ShardGroup, KeysFansOutAndGathersEveryShard) {
+    ShardedHarness harness(4);
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(send_request(fd, {"set", "k" + std::to_string(i), "v"}));
+        recv_response(fd);
+    }
+    ASSERT_TRUE(send_request(fd, {"keys"}));
+    std::string body = recv_response(fd);
+    ASSERT_GE(body.size(), 5u);
+    ASSERT_EQ(body[0], (char)SER_ARR);
+    uint32_t n = 0;
+    std::memcpy(&n, &body[1], 4);
+    EXPECT_EQ(n, 100u);
+
+    std::set<std::string> seen;
+    size_t pos = 5;
+    for (uint32_t i = 0; i < n; ++i) {
+        ASSERT_EQ(body[pos], (char)SER_STR);
+        uint32_t len = 0;
+        std::memcpy(&len, &body[pos + 1], 4);
+        seen.insert(body.substr(pos + 5, len));
+        pos += 5 + len;
+    }
+    EXPECT_EQ(pos, body.size());
+    EXPECT_EQ(seen.size(), 100u);
+    EXPECT_TRUE(seen.count("k0") && seen.count("k99"));
+    ::close(fd);
+}
+
+TEST(ShardGroup, MultiKeyCommandsSplitAcrossShards) {
+    ShardedHarness harness(4);
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    // Twenty keys over every shard, set in one MSET.
+    std::vector<std::string> mset = {"mset"};
+    for (int i = 0; i < 20; ++i) {
+        mset.push_back("k" + std::to_string(i));
+        mset.push_back("v" + std::to_string(i));
+    }
+    ASSERT_TRUE(send_request(fd, mset));
+    EXPECT_EQ(recv_response(fd), str_body("OK"));
+
+    // Replies come back in key order, a key asked twice included, and the
+    // next request's reply after them.
+    std::vector<std::string> mget = {"mget"};
+    std::string expected(1, (char)SER_ARR);
+    uint32_t n = 22;
+    expected.append((const char*)&n, 4);
+    for (int i = 19; i >= 0; --i) {
+        mget.push_back("k" + std::to_string(i));
+        expected += str_body("v" + std::to_string(i));
+        if (i == 10) {
+            mget.push_back("missing");
+            expected.push_back((char)SER_NIL);
+        }
+    }
+    mget.push_back("k19");
+    expected += str_body("v19");
+    ASSERT_TRUE(send_request(fd, mget));
+    ASSERT_TRUE(send_request(fd, {"get", "k0"}));
+    EXPECT_EQ(recv_response(fd), expected);
+    EXPECT_EQ(recv_response(fd), str_body("v0"));
+
+    // A key of the wrong type fails the MSET on its own shard only.
+    std::string zset;
+    std::string other;
+    for (int i = 0; zset.empty() || other.empty(); ++i) {
+        std::string k = "k" + std::to_string(i);
+        if (zset.empty()) zset = k;
+        else if (harness.group().shard_of(k) != harness.group().shard_of(zset)) other = k;
+    }
+    ASSERT_TRUE(send_request(fd, {"del", zset}));
+    recv_response(fd);
+    ASSERT_TRUE(send_request(fd, {"zadd", zset, "1", "m"}));
+    recv_response(fd);
+    ASSERT_TRUE(send_request(fd, {"mset", zset, "x", other, "y"}));
+    EXPECT_EQ(recv_response(fd)[0], (char)SER_ERR);
+    ASSERT_TRUE(send_request(fd, {"zcard", zset}));
+    EXPECT_EQ(recv_response(fd)[0], (char)SER_INT);
+    ASSERT_TRUE(send_request(fd, {"get", other}));
+    EXPECT_EQ(recv_response(fd), str_body("y"));
+
+    // A malformed MSET is refused whole.
+    ASSERT_TRUE(send_request(fd, {"mset", zset, "x", other}));
+    EXPECT_EQ(recv_response(fd)[0], (char)SER_ERR);
+    ::close(fd);
+}
+
+TEST(ShardGroup, ScanCursorWalksEveryShardInTurn) {
+    ShardedHarness harness(4);
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(send_request(fd, {"set", "k" + std::to_string(i), "v"}));
+        recv_response(fd);
+    }
+
+    // [cursor, [key, ...]]
+    auto read_str = [](const std::string& body, size_t& pos) {
+        EXPECT_EQ(body[pos], (char)SER_STR);
+        uint32_t len = 0;
+        std::memcpy(&len, &body[pos + 1], 4);
+        std::string s = body.substr(pos + 5, len);
+        pos += 5 + len;
+        return s;
+    };
+    std::set<std::string> seen;
+    std::set<uint64_t> shards;
+    std::string cursor = "0";
+    do {
+        ASSERT_TRUE(send_request(fd, {"scan", cursor, "count", "20"}));
+        std::string body = recv_response(fd);
+        ASSERT_GE(body.size(), 5u);
+        ASSERT_EQ(body[0], (char)SER_ARR);
+        size_t pos = 5;
+        cursor = read_str(body, pos);
+        ASSERT_EQ(body[pos], (char)SER_ARR);
+        uint32_t n = 0;
+        std::memcpy(&n, &body[pos + 1], 4);
+        pos += 5;
+        for (uint32_t i = 0; i < n; ++i) seen.insert(read_str(body, pos));
+        EXPECT_EQ(pos, body.size());
+        shards.insert(std::stoull(cursor) >> 48);
+    } while (cursor != "0");
+
+    EXPECT_EQ(seen.size(), 200u);
+    EXPECT_EQ(shards.size(), 4u);  // shards 1..3, plus the final 0
+
+    ASSERT_TRUE(send_request(fd, {"scan", std::to_string(uint64_t(9) << 48)}));
+    EXPECT_EQ(recv_response(fd)[0], (char)SER_ERR);
+    ::close(fd);
+}
+
+TEST(ShardGroup, SnapshotLoadsIntoADifferentShardCount) {
+    ServerConfig config;
+    config.snapshot_path = ::testing::TempDir() + "shards.cdb." + std::to_string(::getpid());
+    {
+        ShardedHarness harness(2, config);
+        int fd = harness.connect();
+        ASSERT_GE(fd, 0);
+        for (int i = 0; i < 200; ++i) {
+            ASSERT_TRUE(send_request(fd, {"set", "k" + std::to_string(i), "v" + std::to_string(i)}));
+            recv_response(fd);
+        }
+        ASSERT_TRUE(send_request(fd, {"save"}));
+        EXPECT_EQ(recv_response(fd), str_body("OK"));  // every shard wrote its file
+        ::close(fd);
+    }
+
+    ShardGroup group(config, 3);
+    SnapshotLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(group.load_snapshot(config.snapshot_path, stats, err)) << err;
+    EXPECT_EQ(stats.files, 2u);
+    EXPECT_EQ(stats.keys, 200u);
+    for (int i = 0; i < 200; ++i) {
+        std::string key = "k" + std::to_string(i);
+        std::string out;
+        group.shard(group.shard_of(key)).handle_command({"get", key}, out);
+        EXPECT_EQ(out, str_body("v" + std::to_string(i)));
+    }
+    for (int i = 0; i < 2; ++i) std::remove(snapshot_shard_path(config.snapshot_path, i).c_str());
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+#include "server/slab.h"
+
+struct Small : SlabAllocated {
+    uint64_t a, b, c;
+};
+
+struct Big : SlabAllocated {
+    char bytes[k_slab_max_object + 1];
+};
+
+TEST(Slab, ObjectSizesRoundToClasses) {
+    EXPECT_EQ(slab_object_size(1), 16u);
+    EXPECT_EQ(slab_object_size(16), 16u);
+    EXPECT_EQ(slab_object_size(17), 32u);
+    EXPECT_EQ(slab_object_size(104), 112u);
+}
+
+TEST(Slab, ObjectsAreDistinctAndAligned) {
+    std::vector<Small*> objs;
+    std::set<uintptr_t> seen;
+    // More than one slab's worth.
+    for (size_t i = 0; i < 2 * k_slab_bytes / sizeof(Small); ++i) {
+        Small* s = new Small{};
+        s->a = s->b = s->c = i;
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(s) % 16, 0u);
+        EXPECT_TRUE(seen.insert(reinterpret_cast<uintptr_t>(s)).second);
+        objs.push_back(s);
+    }
+    for (size_t i = 0; i < objs.size(); ++i) {
+        EXPECT_EQ(objs[i]->a, i);
+        EXPECT_EQ(objs[i]->c, i);
+    }
+    for (Small* s : objs) delete s;
+}
+
+TEST(Slab, FreedObjectsAreReusedFirst) {
+    Small* a = new Small{};
+    delete a;
+    Small* b = new Small{};
+    EXPECT_EQ(a, b);
+    delete b;
+}
+
+TEST(Slab, OversizedObjectsUseTheGlobalHeap) {
+    SlabFreeObject* largest_class = slab_free_lists[k_slab_classes - 1];
+    Big* big = new Big{};
+    big->bytes[k_slab_max_object] = 'x';
+    EXPECT_EQ(big->bytes[k_slab_max_object], 'x');
+    delete big;
+    // Neither the allocation nor the free touched the largest class.
+    EXPECT_EQ(slab_free_lists[k_slab_classes - 1], largest_class);
+}
+
+TEST(Slab, FreeListsArePerThread) {
+    Small* mine = new Small{};
+    delete mine;
+    Small* theirs = nullptr;
+    std::thread t([&] {
+        theirs = new Small{};
+        // Freed on its own thread's list, so it cannot be handed out here.
+        delete theirs;
+    });
+    t.join();
+    Small* again = new Small{};
+    EXPECT_EQ(again, mine);
+    EXPECT_NE(again, theirs);
+    delete again;
+
+    // Freeing another thread's object is allowed; this thread then reuses it.
+    Small* cross = nullptr;
+    std::thread u([&] { cross = new Small{}; });
+    u.join();
+    delete cross;
+    Small* reused = new Small{};
+    EXPECT_EQ(reused, cross);
+    delete reused;
+}
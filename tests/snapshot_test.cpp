@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "server/snapshot.h"
+#include "server_harness.h"
+
+TEST(Snapshot, Crc32cMatchesTheStandardCheckValue) {
+    EXPECT_EQ(crc32c(0, "123456789", 9), 0xE3069283u);
+    // Continuing across calls is the same as one pass.
+    EXPECT_EQ(crc32c(crc32c(0, "1234", 4), "56789", 5), 0xE3069283u);
+}
+
+TEST(Snapshot, SaveAndLoadRoundTripsEveryType) {
+    TempPath path("roundtrip.cdb");
+    ServerConfig config;
+    config.snapshot_path = path.str();
+
+    Server a(config);
+    std::string big(200000, 'x');
+    run(a, {"set", "short", "hello"});
+    run(a, {"set", "big", big});
+    run(a, {"set", "num", "-12345"});
+    run(a, {"set", "ttl", "soon"});
+    run(a, {"pexpire", "ttl", "100000"});
+    for (int i = 0; i < 200; ++i) {  // past the flat encoding
+        std::string member = "m" + std::to_string(i);
+        run(a, {"zadd", "tree", std::to_string(i * 0.5), member});
+    }
+    run(a, {"zadd", "flat", "2", "b"});
+    run(a, {"zadd", "flat", "1", "a"});
+    ASSERT_EQ(run(a, {"save"}), str_reply("OK"));
+
+    Server b(config);
+    SnapshotLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(b.load_snapshot(path.str(), stats, err)) << err;
+    EXPECT_EQ(stats.keys, 6u);
+    EXPECT_EQ(stats.files, 1u);
+
+    EXPECT_EQ(run(b, {"get", "short"}), str_reply("hello"));
+    EXPECT_EQ(run(b, {"get", "big"}), str_reply(big));
+    EXPECT_EQ(run(b, {"get", "num", "int"}), int_reply(-12345));
+    EXPECT_EQ(run(b, {"zcard", "tree"}), int_reply(200));
+    EXPECT_EQ(run(a, {"zrange", "tree", "0", "-1"}), run(b, {"zrange", "tree", "0", "-1"}));
+    EXPECT_EQ(run(a, {"zrange", "flat", "0", "-1"}), run(b, {"zrange", "flat", "0", "-1"}));
+
+    std::string pttl = run(b, {"pttl", "ttl"});
+    int64_t left = 0;
+    ASSERT_EQ(pttl.size(), 9u);
+    std::memcpy(&left, &pttl[1], 8);
+    EXPECT_GT(left, 90000);
+    EXPECT_LE(left, 100000);
+    // Loaded sets are packed tighter than grown ones, and every key is
+    // charged what deleting it gives back.
+    EXPECT_LE(b.memory_stats().keyspace(), a.memory_stats().keyspace());
+    for (const char* key : {"short", "big", "num", "ttl", "tree", "flat"}) run(b, {"del", key});
+    EXPECT_EQ(b.memory_stats().keyspace(), 0u);
+}
+
+TEST(Snapshot, ExpiredKeysAreNotLoaded) {
+    TempPath path("expired.cdb");
+    ServerConfig config;
+    config.snapshot_path = path.str();
+
+    Server a(config);
+    run(a, {"set", "gone", "v"});
+    run(a, {"pexpire", "gone", "20"});
+    run(a, {"set", "kept", "v"});
+    ASSERT_EQ(run(a, {"save"}), str_reply("OK"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+
+    Server b(config);
+    SnapshotLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(b.load_snapshot(path.str(), stats, err)) << err;
+    EXPECT_EQ(stats.keys, 1u);
+    EXPECT_EQ(stats.expired, 1u);
+    EXPECT_EQ(run(b, {"get", "kept"}), str_reply("v"));
+    std::string info = run(b, {"info"});
+    EXPECT_EQ(info_field(info, "keys"), "1");
+    EXPECT_EQ(info_field(info, "expires"), "0");
+}
+
+TEST(Snapshot, CorruptOrMissingFiles) {
+    TempPath path("corrupt.cdb");
+    ServerConfig config;
+    config.snapshot_path = path.str();
+
+    // No snapshot yet: nothing to load, and that is fine.
+    Server empty(config);
+    SnapshotLoadStats stats;
+    std::string err;
+    EXPECT_TRUE(empty.load_snapshot(path.str(), stats, err));
+    EXPECT_EQ(stats.files, 0u);
+
+    Server a(config);
+    run(a, {"set", "k", std::string(1000, 'v')});
+    ASSERT_EQ(run(a, {"save"}), str_reply("OK"));
+
+    // One flipped bit anywhere in the value fails the checksum.
+    int fd = ::open(path.str().c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    char byte;
+    ASSERT_EQ(::pread(fd, &byte, 1, 500), 1);
+    byte ^= 0x10;
+    ASSERT_EQ(::pwrite(fd, &byte, 1, 500), 1);
+    Server b(config);
+    EXPECT_FALSE(b.load_snapshot(path.str(), stats, err));
+    EXPECT_NE(err.find("checksum"), std::string::npos) << err;
+    EXPECT_EQ(run(b, {"keys"}), run(empty, {"keys"}));
+
+    // A version this build does not know is refused before anything else.
+    uint32_t version = k_snapshot_version + 1;
+    ASSERT_EQ(::pwrite(fd, &version, 4, 8), 4);
+    ::close(fd);
+    err.clear();
+    EXPECT_FALSE(b.load_snapshot(path.str(), stats, err));
+    EXPECT_NE(err.find("version"), std::string::npos) << err;
+}
+
+TEST(Snapshot, ManyChunksLoadOnSeveralThreads) {
+    TempPath path("chunks.cdb");
+    ServerConfig config;
+    config.snapshot_path = path.str();
+    config.load_threads = 4;
+
+    Server a(config);
+    std::string value(300, 'v');
+    for (int i = 0; i < 20000; ++i) run(a, {"set", "k" + std::to_string(i), value});
+    for (int i = 0; i < 100; ++i) run(a, {"zadd", "z", std::to_string(i % 10), "m" + std::to_string(i)});
+    run(a, {"pexpire", "k5", "100000"});
+    ASSERT_EQ(run(a, {"save"}), str_reply("OK"));
+
+    std::string err;
+    size_t file_size;
+    {
+        SnapshotReader reader;
+        ASSERT_TRUE(reader.open(path.str(), err)) << err;
+        EXPECT_GE(reader.chunk_count(), 4u);
+        file_size = reader.file_size();
+    }
+
+    Server b(config);
+    SnapshotLoadStats stats;
+    ASSERT_TRUE(b.load_snapshot(path.str(), stats, err)) << err;
+    EXPECT_EQ(stats.keys, 20001u);
+    EXPECT_EQ(stats.bytes, file_size);
+    std::string info = run(b, {"info"});
+    EXPECT_EQ(info_field(info, "keys"), "20001");
+    EXPECT_EQ(info_field(info, "expires"), "1");
+    EXPECT_EQ(run(b, {"get", "k19999"}), str_reply(value));
+    EXPECT_EQ(run(a, {"zrange", "z", "0", "-1"}), run(b, {"zrange", "z", "0", "-1"}));
+    EXPECT_EQ(b.memory_stats().keyspace(), a.memory_stats().keyspace() - a.memory_stats().zsets +
+                                               b.memory_stats().zsets);
+
+    // One bad chunk fails the whole load before any key is added.
+    int fd = ::open(path.str().c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    char byte;
+    off_t at = static_cast<off_t>(file_size / 2);
+    ASSERT_EQ(::pread(fd, &byte, 1, at), 1);
+    byte ^= 0x01;
+    ASSERT_EQ(::pwrite(fd, &byte, 1, at), 1);
+    ::close(fd);
+    Server c(config);
+    err.clear();
+    EXPECT_FALSE(c.load_snapshot(path.str(), stats, err));
+    EXPECT_NE(err.find("checksum mismatch in chunk"), std::string::npos) << err;
+    EXPECT_EQ(info_field(run(c, {"info"}), "keys"), "0");
+}
+
+TEST(Snapshot, BgsaveWritesWhileTheServerKeepsServing) {
+    TempPath path("bgsave.cdb");
+    ServerConfig config;
+    config.snapshot_path = path.str();
+    ServerHarness harness(config);
+    int fd = harness.connect();
+    ASSERT_GE(fd, 0);
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(send_request(fd, {"set", "k" + std::to_string(i), "v" + std::to_string(i)}));
+        recv_response(fd);
+    }
+    ASSERT_TRUE(send_request(fd, {"bgsave"}));
+    EXPECT_EQ(recv_response(fd), str_reply("Background saving started"));
+    // Writes after the fork are not in the snapshot.
+    ASSERT_TRUE(send_request(fd, {"set", "k0", "changed"}));
+    EXPECT_EQ(recv_response(fd), str_reply("OK"));
+
+    std::string info;
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        ASSERT_TRUE(send_request(fd, {"info"}));
+        info = recv_response(fd);
+        if (info_field(info, "rdb_bgsave_in_progress") == "0") break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(info_field(info, "rdb_bgsave_in_progress"), "0");
+    EXPECT_EQ(info_field(info, "rdb_last_save_status"), "ok");
+    EXPECT_NE(info_field(info, "rdb_last_save_bytes"), "0");
+    EXPECT_NE(info_field(info, "rdb_last_fork_usec"), "");
+    ::close(fd);
+
+    Server loaded(config);
+    SnapshotLoadStats stats;
+    std::string err;
+    ASSERT_TRUE(loaded.load_snapshot(path.str(), stats, err)) << err;
+    EXPECT_EQ(stats.keys, 1000u);
+    EXPECT_EQ(run(loaded, {"get", "k0"}), str_reply("v0"));
+    EXPECT_EQ(run(loaded, {"get", "k999"}), str_reply("v999"));
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "server/ttl_heap.h"
+
+static std::vector<int64_t> drain(TtlHeap& heap) {
+    std::vector<int64_t> order;
+    while (Entry* e = heap.top()) {
+        order.push_back(e->expire_at);
+        heap.remove(e);
+        EXPECT_EQ(e->heap_idx, Entry::k_no_heap_idx);
+    }
+    return order;
+}
+
+TEST(TtlHeap, PopsInDeadlineOrderAfterUpdatesAndRemovals) {
+    std::vector<std::unique_ptr<Entry>> entries;
+    TtlHeap heap;
+    srand(3);
+    for (int i = 0; i < 2000; ++i) {
+        entries.emplace_back(Entry::make_string("k", "v"));
+        entries.back()->expire_at = rand() % 100000;
+        heap.update(entries.back().get());
+    }
+    // Move some deadlines both ways, and drop some entries from the middle.
+    for (int i = 0; i < 2000; i += 3) {
+        entries[i]->expire_at = rand() % 100000;
+        heap.update(entries[i].get());
+    }
+    for (int i = 1; i < 2000; i += 7) heap.remove(entries[i].get());
+
+    std::vector<int64_t> order = drain(heap);
+    EXPECT_EQ(order.size(), 2000u - (2000 + 5) / 7);
+    EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+}
+
+TEST(TtlHeap, RemoveIsIdempotent) {
+    std::unique_ptr<Entry> a(Entry::make_string("a", "")), b(Entry::make_string("b", ""));
+    a->expire_at = 10;
+    b->expire_at = 5;
+    TtlHeap heap;
+    heap.update(a.get());
+    heap.update(b.get());
+    EXPECT_EQ(heap.top(), b.get());
+
+    heap.remove(b.get());
+    heap.remove(b.get());
+    EXPECT_EQ(heap.size(), 1u);
+    EXPECT_EQ(heap.top(), a.get());
+}
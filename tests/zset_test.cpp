@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "server/zset.h"
+
+// Reference model: (score, member) pairs in the same order as the score tree.
+using Model = std::vector<std::pair<double, std::string>>;
+
+static Model build_model(const std::map<std::string, double>& members) {
+    Model m;
+    for (const auto& [member, score] : members) m.emplace_back(score, member);
+    std::sort(m.begin(), m.end());
+    return m;
+}
+
+// Flat-encoding thresholds: always TREE, FLAT that converts part way, and
+// FLAT throughout.
+class ZSetEncodings : public ::testing::TestWithParam<size_t> {};
+
+INSTANTIATE_TEST_SUITE_P(Thresholds, ZSetEncodings,
+                         ::testing::Values(0, ZSet::k_max_flat_members, 100000),
+                         [](const ::testing::TestParamInfo<size_t>& info) {
+                             return info.param == 0 ? "Tree" : info.param == 100000 ? "Flat" : "Converting";
+                         });
+
+// Both encodings must agree with a sorted model through inserts, score
+// updates and removals. For TREE this also checks that subtree sizes survive
+// rotations, or ranks and offsets drift.
+TEST_P(ZSetEncodings, RanksAndOffsetsMatchSortedModel) {
+    ZSet z(GetParam());
+    std::map<std::string, double> members;
+    srand(7);
+    for (int i = 0; i < 5000; ++i) {
+        std::string member = "m" + std::to_string(rand() % 1500);
+        if (rand() % 4 == 0) {
+            EXPECT_EQ(z.zrem(member), members.erase(member) == 1);
+        } else {
+            double score = rand() % 200;
+            z.zadd(member, score);
+            members[member] = score;
+        }
+    }
+
+    Model model = build_model(members);
+    ASSERT_EQ(z.zcard(), model.size());
+    EXPECT_EQ(z.encoding_type(), GetParam() == 100000 ? ZSet::FLAT : ZSet::TREE);
+
+    double score = 0;
+    ASSERT_TRUE(z.zscore(model[0].second, score));
+    EXPECT_DOUBLE_EQ(score, model[0].first);
+    EXPECT_FALSE(z.zscore("absent", score));
+
+    for (size_t i = 0; i < model.size(); ++i) {
+        size_t rank = 0;
+        ASSERT_TRUE(z.zrank(model[i].second, rank));
+        ASSERT_EQ(rank, i);
+    }
+
+    // zquery from every 97th position with assorted offsets
+    for (size_t i = 0; i < model.size(); i += 97) {
+        for (int offset : {0, 1, 50, 1000}) {
+            auto got = z.zquery(model[i].first, model[i].second, offset, 5);
+            for (size_t k = 0; k < got.size(); ++k) {
+                ASSERT_LT(i + offset + k, model.size());
+                EXPECT_EQ(got[k].first, model[i + offset + k].second);
+                EXPECT_DOUBLE_EQ(got[k].second, model[i + offset + k].first);
+            }
+            size_t remaining = i + offset < model.size() ? model.size() - i - offset : 0;
+            EXPECT_EQ(got.size(), std::min<size_t>(5, remaining));
+        }
+    }
+}
+
+TEST_P(ZSetEncodings, ZQueryStartsBetweenMembers) {
+    ZSet z(GetParam());
+    z.zadd("a", 1.0);
+    z.zadd("c", 1.0);
+    z.zadd("e", 2.0);
+
+    // (1.0, "b") is not a member; the first member at or after it is "c".
+    auto got = z.zquery(1.0, "b", 0, 10);
+    ASSERT_EQ(got.size(), 2u);
+    EXPECT_EQ(got[0].first, "c");
+    EXPECT_EQ(got[1].first, "e");
+
+    EXPECT_TRUE(z.zquery(5.0, "", 0, 10).empty());
+    EXPECT_TRUE(z.zquery(0.0, "", 0, 0).empty());
+}
+
+TEST_P(ZSetEncodings, ZRangeFullAndEmpty) {
+    ZSet z(GetParam());
+    EXPECT_TRUE(z.zrange(0, -1).empty());
+    for (int i = 0; i < 100; ++i) z.zadd("m" + std::to_string(i), i);
+
+    auto all = z.zrange(0, -1);
+    ASSERT_EQ(all.size(), 100u);
+    for (int i = 0; i < 100; ++i) EXPECT_DOUBLE_EQ(all[i].second, i);
+
+    auto tail = z.zrange(-3, -1);
+    ASSERT_EQ(tail.size(), 3u);
+    EXPECT_EQ(tail[0].first, "m97");
+    EXPECT_TRUE(z.zrange(200, 300).empty());
+}
+
+TEST(ZSetFlatEncoding, ConvertsPastMemberCount) {
+    ZSet z(4);
+    for (int i = 0; i < 4; ++i) z.zadd("m" + std::to_string(i), 4 - i);
+    EXPECT_EQ(z.encoding_type(), ZSet::FLAT);
+
+    // Re-scoring an existing member does not grow the set.
+    z.zadd("m0", 0.5);
+    EXPECT_EQ(z.encoding_type(), ZSet::FLAT);
+
+    z.zadd("m4", 10);
+    EXPECT_EQ(z.encoding_type(), ZSet::TREE);
+    auto all = z.zrange(0, -1);
+    ASSERT_EQ(all.size(), 5u);
+    EXPECT_EQ(all[0].first, "m0");
+    EXPECT_EQ(all[4].first, "m4");
+}
+
+TEST(ZSetFlatEncoding, ConvertsOnLongMember) {
+    ZSet z;
+    z.zadd("short", 1);
+    EXPECT_EQ(z.encoding_type(), ZSet::FLAT);
+
+    std::string long_member(ZSet::k_max_flat_member_len + 1, 'x');
+    z.zadd(long_member, 2);
+    EXPECT_EQ(z.encoding_type(), ZSet::TREE);
+
+    size_t rank = 0;
+    ASSERT_TRUE(z.zrank(long_member, rank));
+    EXPECT_EQ(rank, 1u);
+    EXPECT_EQ(z.zcard(), 2u);
+}
+
+// A set loaded from sorted members must be the set the same zadd() calls
+// build, in the same encoding, and stay so through later changes.
+TEST(ZSetLoadSorted, MatchesOneByOneInserts) {
+    for (size_t n : {0, 1, 64, 65, 3000}) {
+        Model model;
+        for (size_t i = 0; i < n; ++i) model.emplace_back((double)(i / 4), "m" + std::to_string(n - i));
+        std::sort(model.begin(), model.end());
+        std::vector<std::pair<std::string_view, double>> sorted;
+        for (const auto& [score, member] : model) sorted.emplace_back(member, score);
+
+        ZSet added, loaded;
+        for (const auto& [score, member] : model) added.zadd(member, score);
+        loaded.load_sorted(sorted);
+        EXPECT_EQ(loaded.encoding_type(), added.encoding_type()) << n;
+        ASSERT_EQ(loaded.zrange(0, -1), added.zrange(0, -1)) << n;
+        for (size_t i = 0; i < n; i += 13) {
+            size_t a = 0, b = 0;
+            ASSERT_TRUE(loaded.zrank(model[i].second, b));
+            ASSERT_TRUE(added.zrank(model[i].second, a));
+            EXPECT_EQ(a, b);
+            double score = -1;
+            EXPECT_TRUE(loaded.zscore(model[i].second, score));
+            EXPECT_EQ(score, model[i].first);
+        }
+
+        for (size_t i = 0; i < n; i += 3) {
+            EXPECT_TRUE(loaded.zrem(model[i].second));
+            added.zrem(model[i].second);
+        }
+        for (size_t i = 0; i < n; i += 5) {
+            loaded.zadd(model[i].second, -(double)i);
+            added.zadd(model[i].second, -(double)i);
+        }
+        EXPECT_EQ(loaded.zrange(0, -1), added.zrange(0, -1)) << n;
+        EXPECT_EQ(loaded.zcard(), added.zcard());
+    }
+}
+
+TEST(ZSetLoadSorted, OutOfOrderOrRepeatedMembersStillLoad) {
+    ZSet z;
+    z.load_sorted({{"b", 2}, {"a", 1}, {"b", 3}});
+    auto all = z.zrange(0, -1);
+    ASSERT_EQ(all.size(), 2u);
+    EXPECT_EQ(all[0].first, "a");
+    EXPECT_EQ(all[1].first, "b");
+    EXPECT_EQ(all[1].second, 3);
+}